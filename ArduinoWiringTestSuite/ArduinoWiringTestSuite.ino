@@ -12,6 +12,19 @@
 // All tests are expected to Succeed.
 
 #include "spi.h"
+#include "I2c.h"
+#include "Wire.h"
+#include "eeprom.h"
+#include "BtI2cModel.h"
+#include "BcmI2cModel.h"
+#include "BcmSpiModel.h"
+#include "BtSpiModel.h"
+#include "PCA9685Support.h"
+#include "ADS1015Support.h"
+#include "MCP3008support.h"
+#include "AdcScanner.h"
+#include "SpiStreamer.h"
+#include "WS2812Support.h"
 
 unsigned int test_count = 0;
 unsigned int success_count = 0;
@@ -159,6 +172,2414 @@ void Test_serialPrint_P(void) {
     PostTestResult(true, __FUNCTIONW__);
 }
 
+// Run a chain of I2C transfers on a controller the way I2cTransactionClass does.
+HRESULT RunI2cTransfers(I2cControllerClass& controller, ULONG slaveAddress, ULONG clockHz, I2cTransferClass* pXfr)
+{
+    HRESULT hr = controller._initializeForTransaction(slaveAddress, clockHz);
+
+    controller.clearTransfersError();
+    while (SUCCEEDED(hr) && (pXfr != nullptr))
+    {
+        hr = controller._performContiguousTransfers(pXfr);
+    }
+    return hr;
+}
+
+// Write a register address and a block of data, then read the block back with a
+// write-restart-read, through the BayTrail controller running on a DesignWare model.
+bool BtI2cModelRoundTrip(BtI2cModelClass& model, ULONG blockBytes)
+{
+    BtI2cControllerClass controller;
+    I2cModelRegisterSlaveClass slave(256);
+    I2cTransferClass adrXfr;
+    I2cTransferClass dataXfr;
+    I2cTransferClass readXfr;
+    UCHAR address = 0;
+    std::vector<UCHAR> outData(blockBytes);
+    std::vector<UCHAR> inData(blockBytes, 0);
+    HRESULT hr = S_OK;
+    bool success = true;
+
+    model.attachSlave(0x50, &slave);
+    controller.setRegisterAccess(&model);
+
+    for (ULONG i = 0; i < blockBytes; i++)
+    {
+        outData[i] = (UCHAR)((i * 7) + 3);
+    }
+
+    // Register address, then the data.
+    adrXfr.setBuffer(&address, 1);
+    dataXfr.setBuffer(outData.data(), blockBytes);
+    adrXfr.chainNextTransfer(&dataXfr);
+    hr = RunI2cTransfers(controller, 0x50, 400000, &adrXfr);
+    success = success && SUCCEEDED(hr);
+
+    // The slave's register pointer wraps, so each register holds the last byte written to it.
+    for (ULONG i = (blockBytes > 256) ? (blockBytes - 256) : 0; success && (i < blockBytes); i++)
+    {
+        success = (slave.registers()[i % 256] == outData[i]);
+    }
+
+    // Register address, then a restart and the read.
+    adrXfr.clear();
+    adrXfr.setBuffer(&address, 1);
+    readXfr.setBuffer(inData.data(), blockBytes);
+    readXfr.markReadTransfer();
+    readXfr.markPreRestart();
+    adrXfr.chainNextTransfer(&readXfr);
+    hr = RunI2cTransfers(controller, 0x50, 400000, &adrXfr);
+    success = success && SUCCEEDED(hr);
+
+    for (ULONG i = 0; success && (i < blockBytes); i++)
+    {
+        success = (inData[i] == slave.registers()[i % 256]);
+    }
+
+    // The controller must never let the RX FIFO overflow.
+    success = success && (model.getRxOverflows() == 0);
+
+    controller.setRegisterAccess(nullptr);
+    return success;
+}
+
+void Test_BtI2cModelTransfers(void) {
+    ::test_count++;
+    bool success = true;
+
+    // Transfers shorter than, equal to and longer than the FIFOs.
+    for (ULONG blockBytes = 1; success && (blockBytes <= 200); blockBytes++)
+    {
+        BtI2cModelClass model;
+        success = BtI2cModelRoundTrip(model, blockBytes);
+    }
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+
+    // A controller that does not report its FIFO depths falls back to 16 entries.
+    ::test_count++;
+    {
+        BtI2cModelClass model(16, 16);
+        model.setReportParams(FALSE);
+        success = BtI2cModelRoundTrip(model, 1000) && (model.getMaxRxLevel() <= 16);
+    }
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+
+    // Read commands are limited so a small RX FIFO can not overflow while the
+    // TX FIFO is kept full, even when the bus runs ahead of the software.
+    ::test_count++;
+    {
+        BtI2cModelClass model(64, 8);
+        model.setAccessNs(20000);
+        success = BtI2cModelRoundTrip(model, 1000) && (model.getMaxRxLevel() <= 8);
+    }
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+
+    // Commands are pushed in bursts sized from the FIFO levels, so with register
+    // accesses slower than the bus (no time spent waiting on it) the accesses per
+    // byte stay well below one status read plus one data access.
+    ::test_count++;
+    {
+        BtI2cModelClass model;
+        model.setAccessNs(100000);
+        success = BtI2cModelRoundTrip(model, 256);
+        Log(L"BayTrail I2C model: %llu register accesses for %llu bus bytes\n",
+            model.getRegisterAccesses(), model.getBusBytes());
+        success = success && (model.getRegisterAccesses() < (2 * model.getBusBytes()));
+    }
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+void Test_BtI2cModelNack(void) {
+    ::test_count++;
+    bool success = false;
+
+    BtI2cModelClass model;
+    BtI2cControllerClass controller;
+    I2cModelRegisterSlaveClass slave(16);
+    I2cTransferClass xfr;
+    UCHAR data[4] = { 0, 1, 2, 3 };
+    HRESULT hr = S_OK;
+
+    model.attachSlave(0x50, &slave);
+    controller.setRegisterAccess(&model);
+
+    // No slave at this address.
+    xfr.setBuffer(data, sizeof(data));
+    hr = RunI2cTransfers(controller, 0x51, 100000, &xfr);
+    success = FAILED(hr) && (controller.getTransfersError() == I2cTransactionClass::ADR_NACK);
+
+    // The slave NACKs the third byte.
+    slave.setNackAfterBytes(3);
+    xfr.clear();
+    xfr.setBuffer(data, sizeof(data));
+    hr = RunI2cTransfers(controller, 0x50, 100000, &xfr);
+    success = success && FAILED(hr) && (controller.getTransfersError() == I2cTransactionClass::DATA_NACK);
+
+    // The next transfer succeeds once the slave behaves again.
+    slave.setNackAfterBytes(0);
+    xfr.clear();
+    xfr.setBuffer(data, sizeof(data));
+    hr = RunI2cTransfers(controller, 0x50, 100000, &xfr);
+    success = success && SUCCEEDED(hr) && (slave.registers()[1] == 2);
+
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Expected I2C clock register settings for a requested bus clock rate.
+typedef struct _I2C_CLOCK_CASE
+{
+    ULONG clockHz;          // Requested rate
+    ULONG bcmCdiv;          // BSC clock divider (250 MHz core clock)
+    ULONG bcmFedl;          // BSC falling edge delay
+    ULONG bcmRedl;          // BSC rising edge delay
+    ULONG bcmActualHz;      // BSC rate achieved
+    ULONG btSpeed;          // DesignWare IC_CON.SPEED
+    ULONG btHcnt;           // DesignWare SCL high count (100 MHz ic_clk)
+    ULONG btLcnt;           // DesignWare SCL low count
+    ULONG btActualHz;       // DesignWare rate achieved
+} I2C_CLOCK_CASE;
+
+// Check the clock registers both I2C controllers set for standard, fast and
+// Fast-mode Plus rates, and the rates they refuse.
+void Test_I2cClockRates(void) {
+    ::test_count++;
+    bool success = true;
+
+    const I2C_CLOCK_CASE cases[] = {
+        {   10000, 25000, 1562, 6250,   10000, 1, 4592, 5395,   10000 },
+        {  100000,  2500,  156,  625,  100000, 1,  454,  533,  100000 },
+        {  400000,   626,   39,  156,  399361, 2,   75,  162,  400000 },
+        { 1000000,   250,   15,   62, 1000000, 2,   30,   57, 1000000 },
+    };
+    const ULONG btSpkLen = 5;
+    HRESULT hr = S_OK;
+
+    for (ULONG i = 0; success && (i < ARRAYSIZE(cases)); i++)
+    {
+        BcmI2cModelClass bcmModel;
+        BcmI2cControllerClass bcmController;
+        BtI2cModelClass btModel;
+        BtI2cControllerClass btController;
+        ULONG del;
+        ULONG tLowNs;
+        ULONG tHighNs;
+
+        bcmController.setRegisterAccess(&bcmModel);
+        hr = bcmController._initializeForTransaction(0x50, cases[i].clockHz);
+        del = bcmModel.readRegister(BSC_DEL_OFFSET);
+        success = SUCCEEDED(hr) &&
+            ((bcmModel.readRegister(BSC_DIV_OFFSET) & 0xFFFF) == cases[i].bcmCdiv) &&
+            ((del >> 16) == cases[i].bcmFedl) && ((del & 0xFFFF) == cases[i].bcmRedl) &&
+            (bcmController.getActualClockRate() == cases[i].bcmActualHz) &&
+            (bcmController.getActualClockRate() <= cases[i].clockHz);
+        bcmController.setRegisterAccess(nullptr);
+
+        btController.setRegisterAccess(&btModel);
+        hr = btController._initializeForTransaction(0x50, cases[i].clockHz);
+        if (cases[i].btSpeed == 1)
+        {
+            success = success && SUCCEEDED(hr) &&
+                (btModel.readRegister(BT_IC_SS_SCL_HCNT_OFFSET) == cases[i].btHcnt) &&
+                (btModel.readRegister(BT_IC_SS_SCL_LCNT_OFFSET) == cases[i].btLcnt);
+        }
+        else
+        {
+            success = success && SUCCEEDED(hr) &&
+                (btModel.readRegister(BT_IC_FS_SCL_HCNT_OFFSET) == cases[i].btHcnt) &&
+                (btModel.readRegister(BT_IC_FS_SCL_LCNT_OFFSET) == cases[i].btLcnt);
+        }
+        success = success && (((btModel.readRegister(BT_IC_CON_OFFSET) >> 1) & 0x03) == cases[i].btSpeed) &&
+            (btController.getActualClockRate() == cases[i].btActualHz) &&
+            (btController.getActualClockRate() <= cases[i].clockHz);
+
+        // The SCL low and high times meet the I2C specification minimums for the mode.
+        tLowNs = (cases[i].btLcnt + 1) * 10;
+        tHighNs = (cases[i].btHcnt + btSpkLen + 7) * 10;
+        if (cases[i].clockHz <= I2C_STANDARD_MODE_HZ)
+        {
+            success = success && (tLowNs >= 4700) && (tHighNs >= 4000);
+        }
+        else if (cases[i].clockHz <= I2C_FAST_MODE_HZ)
+        {
+            success = success && (tLowNs >= 1300) && (tHighNs >= 600);
+        }
+        else
+        {
+            success = success && (tLowNs >= 500) && (tHighNs >= 260);
+        }
+        btController.setRegisterAccess(nullptr);
+    }
+
+    // Rates above Fast-mode Plus, and rates below what the dividers can reach, are refused.
+    {
+        BcmI2cModelClass bcmModel;
+        BcmI2cControllerClass bcmController;
+        BtI2cModelClass btModel;
+        BtI2cControllerClass btController;
+
+        bcmController.setRegisterAccess(&bcmModel);
+        btController.setRegisterAccess(&btModel);
+        success = success &&
+            (bcmController._initializeForTransaction(0x50, 0) == DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED) &&
+            (bcmController._initializeForTransaction(0x50, 1000001) == DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED) &&
+            (bcmController._initializeForTransaction(0x50, 3000) == DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED) &&
+            (btController._initializeForTransaction(0x50, 1000001) == DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED) &&
+            (btController._initializeForTransaction(0x50, 500) == DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED);
+        bcmController.setRegisterAccess(nullptr);
+        btController.setRegisterAccess(nullptr);
+    }
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+void Test_I2cControllerSpinTrace(void) {
+    ::test_count++;
+    bool success = false;
+
+    BtI2cModelClass model;
+    BtI2cControllerClass controller;
+    I2cModelRegisterSlaveClass slave(256);
+    I2cTransferClass xfr;
+    UCHAR data[64] = { 0 };
+    HRESULT hr = S_OK;
+
+    model.attachSlave(0x50, &slave);
+    controller.setRegisterAccess(&model);
+
+    // With tracing off the poll loops take no timestamps.
+    xfr.setBuffer(data, sizeof(data));
+    hr = RunI2cTransfers(controller, 0x50, 100000, &xfr);
+    success = SUCCEEDED(hr) && (controller.getTrace()->takeSpinTicks() == 0);
+
+    // With tracing on, waiting for a slow bus shows up as spin time.
+    controller.getTrace()->enable(TRUE);
+    xfr.clear();
+    xfr.setBuffer(data, sizeof(data));
+    hr = RunI2cTransfers(controller, 0x50, 100000, &xfr);
+    success = success && SUCCEEDED(hr) && (controller.getTrace()->takeSpinTicks() > 0);
+    controller.getTrace()->enable(FALSE);
+
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Write a register address and a block of data, then read the block back with a
+// write-restart-read, in I2C transactions on the BCM controller running on a BSC model.
+bool BcmI2cModelRoundTrip(BcmI2cControllerClass& controller, I2cModelRegisterSlaveClass& slave, ULONG blockBytes)
+{
+    I2cTransactionClass transaction;
+    UCHAR address = 0;
+    std::vector<UCHAR> outData(blockBytes);
+    std::vector<UCHAR> inData(blockBytes, 0);
+    HRESULT hr = S_OK;
+    bool success = true;
+
+    for (ULONG i = 0; i < blockBytes; i++)
+    {
+        outData[i] = (UCHAR)((i * 7) + 3);
+    }
+
+    hr = transaction.setAddress(0x50);
+    if (SUCCEEDED(hr))
+    {
+        transaction.useHighSpeed();
+        hr = transaction.queueWrite(&address, 1);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = transaction.queueWrite(outData.data(), blockBytes);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = transaction.execute(&controller);
+    }
+    success = SUCCEEDED(hr);
+
+    // The slave's register pointer wraps, so each register holds the last byte written to it.
+    for (ULONG i = (blockBytes > 256) ? (blockBytes - 256) : 0; success && (i < blockBytes); i++)
+    {
+        success = (slave.registers()[i % 256] == outData[i]);
+    }
+
+    transaction.reset();
+    hr = transaction.setAddress(0x50);
+    if (SUCCEEDED(hr))
+    {
+        transaction.useHighSpeed();
+        hr = transaction.queueWrite(&address, 1);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = transaction.queueRead(inData.data(), blockBytes, TRUE);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = transaction.execute(&controller);
+    }
+    success = success && SUCCEEDED(hr);
+
+    for (ULONG i = 0; success && (i < blockBytes); i++)
+    {
+        success = (inData[i] == slave.registers()[i % 256]);
+    }
+
+    return success;
+}
+
+void Test_BcmI2cModelTransfers(void) {
+    ::test_count++;
+    bool success = true;
+
+    BcmI2cModelClass model;
+    BcmI2cControllerClass controller;
+    I2cModelRegisterSlaveClass slave(256);
+    I2cTransactionClass transaction;
+    UCHAR address = 0;
+    std::vector<UCHAR> data(70000, 0x5A);
+    HRESULT hr = S_OK;
+
+    model.attachSlave(0x50, &slave);
+    controller.setRegisterAccess(&model);
+
+    // Transfers shorter than, equal to and longer than the FIFOs.
+    for (ULONG blockBytes = 1; success && (blockBytes <= 200); blockBytes++)
+    {
+        success = BcmI2cModelRoundTrip(controller, slave, blockBytes);
+    }
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+
+    // Reads longer than DLEN are split into segments joined by restarts.
+    ::test_count++;
+    for (ULONG i = 0; i < 256; i++)
+    {
+        slave.registers()[i] = (UCHAR)(i ^ 0x5A);
+    }
+    hr = transaction.setAddress(0x50);
+    if (SUCCEEDED(hr))
+    {
+        hr = transaction.queueWrite(&address, 1);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = transaction.queueRead(data.data(), (ULONG)data.size(), TRUE);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = transaction.execute(&controller);
+    }
+    success = SUCCEEDED(hr);
+    for (ULONG i = 0; success && (i < data.size()); i++)
+    {
+        success = (data[i] == (UCHAR)((i % 256) ^ 0x5A));
+    }
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+
+    // A write that follows a write-read in the same transaction is only started
+    // once the write-read has finished, so it reaches the slave intact.
+    ::test_count++;
+    {
+        UCHAR readBuf[4] = { 0 };
+        UCHAR writeBuf[5] = { 8, 0xC1, 0xC2, 0xC3, 0xC4 };
+
+        transaction.reset();
+        hr = transaction.setAddress(0x50);
+        if (SUCCEEDED(hr))
+        {
+            hr = transaction.queueWrite(&address, 1);
+        }
+        if (SUCCEEDED(hr))
+        {
+            hr = transaction.queueRead(readBuf, sizeof(readBuf), TRUE);
+        }
+        if (SUCCEEDED(hr))
+        {
+            hr = transaction.queueWrite(writeBuf, sizeof(writeBuf), TRUE);
+        }
+        if (SUCCEEDED(hr))
+        {
+            hr = transaction.execute(&controller);
+        }
+        success = SUCCEEDED(hr);
+        for (ULONG i = 0; success && (i < sizeof(readBuf)); i++)
+        {
+            success = (readBuf[i] == (UCHAR)(i ^ 0x5A));
+        }
+        for (ULONG i = 1; success && (i < sizeof(writeBuf)); i++)
+        {
+            success = (slave.registers()[7 + i] == writeBuf[i]);
+        }
+    }
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+
+    // Writes longer than DLEN are refused, since a restart would make a register
+    // addressed slave take the next byte as a new register address.
+    ::test_count++;
+    transaction.reset();
+    hr = transaction.setAddress(0x50);
+    if (SUCCEEDED(hr))
+    {
+        hr = transaction.queueWrite(data.data(), (ULONG)data.size());
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = transaction.execute(&controller);
+    }
+    success = (hr == DMAP_E_I2C_TRANSFER_LENGTH_OVER_MAX);
+
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Run a number of identical write or write-read transactions on a controller.
+HRESULT RunI2cBenchmarkTransactions(I2cControllerClass& controller, ULONG transactionCount, BOOL isRead, PUCHAR data, ULONG dataBytes)
+{
+    I2cTransactionClass transaction;
+    UCHAR address = 0;
+    HRESULT hr = S_OK;
+
+    for (ULONG i = 0; SUCCEEDED(hr) && (i < transactionCount); i++)
+    {
+        transaction.reset();
+        hr = transaction.setAddress(0x50);
+        if (SUCCEEDED(hr))
+        {
+            transaction.useHighSpeed();
+            hr = transaction.queueWrite(&address, 1);
+        }
+        if (SUCCEEDED(hr))
+        {
+            if (isRead)
+            {
+                hr = transaction.queueRead(data, dataBytes, TRUE);
+            }
+            else
+            {
+                hr = transaction.queueWrite(data, dataBytes);
+            }
+        }
+        if (SUCCEEDED(hr))
+        {
+            hr = transaction.execute(&controller);
+        }
+    }
+    return hr;
+}
+
+// Measure I2C transactions on the BCM controller running on a BSC model.  Time is
+// simulated, with each register access costing 100 ns, so the results are the same
+// on every machine the sketch runs on.  The controller polls the status register
+// while it waits for the bus, so the CPU time per byte is the register accesses per
+// byte times the access cost.  Because the polling hides any extra work, the test
+// also checks the accesses that are not status polls, and the time the bus is idle.
+void Test_BcmI2cModelBenchmark(void) {
+    ::test_count++;
+    bool success = true;
+
+    const ULONG transactionCount = 100;
+    const ULONG blockSizes[] = { 1, 4, 16, 64, 256 };
+    BcmI2cModelClass model;
+    BcmI2cControllerClass controller;
+    I2cModelRegisterSlaveClass slave(256);
+    std::vector<UCHAR> data(256, 0xA5);
+    ULONGLONG busNs;
+    ULONGLONG overheadNs;
+    ULONGLONG otherAccesses;
+    HRESULT hr = S_OK;
+
+    model.attachSlave(0x50, &slave);
+    controller.setRegisterAccess(&model);
+
+    for (ULONG size = 0; success && (size < ARRAYSIZE(blockSizes)); size++)
+    {
+        for (ULONG isRead = 0; success && (isRead < 2); isRead++)
+        {
+            model.resetCounters();
+            hr = RunI2cBenchmarkTransactions(controller, transactionCount, isRead, data.data(), blockSizes[size]);
+            success = SUCCEEDED(hr) && (model.getSimulatedNs() > 0) && (model.getBusBytes() > 0);
+
+            if (success)
+            {
+                // Time the bus needs for the bytes (nine clocks each), time lost around it,
+                // and the register accesses that are not status polls.
+                busNs = (model.getBusBytes() * 9 * 1000000000ULL) / controller.getActualClockRate();
+                overheadNs = (model.getSimulatedNs() > busNs) ? ((model.getSimulatedNs() - busNs) / transactionCount) : 0;
+                otherAccesses = (model.getRegisterAccesses() - model.getStatusReads()) / transactionCount;
+
+                Log(L"BCM I2C model, 400 kHz, %s %u bytes: %llu transactions/s, %llu register accesses (%llu ns CPU) per bus byte, "
+                    L"%llu ns overhead and %llu non-status accesses per transaction\n",
+                    (isRead ? L"write-read" : L"write"), blockSizes[size],
+                    (transactionCount * 1000000000ULL) / model.getSimulatedNs(),
+                    model.getRegisterAccesses() / model.getBusBytes(),
+                    (model.getRegisterAccesses() * 100) / model.getBusBytes(),
+                    overheadNs, otherAccesses);
+
+                // Apart from status polls, a transaction takes about 20 register accesses
+                // plus one FIFO access per data byte, and the bus is kept busy except for
+                // a few microseconds setting up each segment.
+                success = (otherAccesses <= (blockSizes[size] + 24)) &&
+                    (overheadNs <= (isRead ? 15000ULL : 10000ULL));
+            }
+        }
+    }
+
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Run the PCA9685 bulk update on the main I2C bus with a BSC model behind it.
+void Test_Pca9685ModelUpdate(void) {
+    ::test_count++;
+    bool success = false;
+
+    const ULONG pcaAddress = 0x47;
+    BcmI2cModelClass model;
+    BcmI2cControllerClass controller;
+    I2cModelRegisterSlaveClass pca(256);
+    ULONG dutyCycles[16];
+    HRESULT hr = S_OK;
+
+    // MODE1 comes out of reset with SLEEP set, so the chip gets initialized.
+    pca.registers()[0] = 0x11;
+    model.attachSlave(pcaAddress, &pca);
+    controller.setRegisterAccess(&model);
+    hr = g_i2c.useController(&controller);
+
+    for (ULONG i = 0; i < ARRAYSIZE(dutyCycles); i++)
+    {
+        dutyCycles[i] = 0x10000000 * (i + 1) - 1;
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = PCA9685Device::SetDutyCycles(pcaAddress, 0, ARRAYSIZE(dutyCycles), dutyCycles);
+    }
+
+    // Change every channel: one write of the register address and 64 LED registers.
+    for (ULONG i = 0; i < ARRAYSIZE(dutyCycles); i++)
+    {
+        dutyCycles[i] = dutyCycles[i] / 2;
+    }
+    model.resetCounters();
+    if (SUCCEEDED(hr))
+    {
+        hr = PCA9685Device::SetDutyCycles(pcaAddress, 0, ARRAYSIZE(dutyCycles), dutyCycles);
+    }
+    success = SUCCEEDED(hr) && (model.getBusBytes() == 66);
+    Log(L"PCA9685 16 channel update on BCM I2C model: %llu bus bytes in %llu us\n",
+        model.getBusBytes(), model.getSimulatedNs() / 1000);
+
+    // The same values again put nothing on the bus.
+    model.resetCounters();
+    if (SUCCEEDED(hr))
+    {
+        hr = PCA9685Device::SetDutyCycles(pcaAddress, 0, ARRAYSIZE(dutyCycles), dutyCycles);
+    }
+    success = success && SUCCEEDED(hr) && (model.getBusBytes() == 0);
+
+    g_i2c.useController(nullptr);
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// A simulated register slave that counts the STOPs that end its transactions.
+class StopCountingSlaveClass : public I2cModelRegisterSlaveClass
+{
+public:
+    StopCountingSlaveClass() :
+        I2cModelRegisterSlaveClass(256),
+        stops(0)
+    {
+    }
+
+    void stop() override
+    {
+        stops++;
+    }
+
+    ULONG stops;
+};
+
+// Commit a masked set of PCA9685 channels, the way the PWM provider commits deferred
+// changes, to a chip found already running with its outputs set to change on ACK.
+void Test_Pca9685MaskedCommit(void) {
+    ::test_count++;
+    bool success = false;
+
+    const ULONG pcaAddress = 0x46;
+    BcmI2cModelClass model;
+    BcmI2cControllerClass controller;
+    StopCountingSlaveClass pca;
+    ULONG dutyCycles[10];
+    HRESULT hr = S_OK;
+
+    // Running (SLEEP clear, auto-increment set), with OCH set in MODE2 and every LED
+    // register holding 0x55.
+    pca.registers()[0] = 0x21;
+    pca.registers()[1] = 0x0C;
+    for (ULONG i = 6; i < 70; i++)
+    {
+        pca.registers()[i] = 0x55;
+    }
+    model.attachSlave(pcaAddress, &pca);
+    controller.setRegisterAccess(&model);
+    hr = g_i2c.useController(&controller);
+
+    // Initialization switches the outputs to change on STOP.
+    if (SUCCEEDED(hr))
+    {
+        hr = PCA9685Device::SetDutyCycles(pcaAddress, 0, 1, dutyCycles, 0);
+    }
+    success = SUCCEEDED(hr) && (pca.registers()[1] == 0x04);
+
+    // Channels 0 and 9 change and those between are masked off.  The update is one
+    // write with one STOP, which resends the masked channels as they were.
+    for (ULONG i = 0; i < ARRAYSIZE(dutyCycles); i++)
+    {
+        dutyCycles[i] = 0;
+    }
+    pca.stops = 0;
+    if (SUCCEEDED(hr))
+    {
+        hr = PCA9685Device::SetDutyCycles(pcaAddress, 0, ARRAYSIZE(dutyCycles), dutyCycles, 0x201);
+    }
+    success = success && SUCCEEDED(hr) && (pca.stops == 1);
+    success = success && (pca.registers()[9] == 0) && (pca.registers()[6 + (9 * 4) + 3] == 0);
+    for (ULONG i = 6 + 4; success && (i < 6 + (9 * 4)); i++)
+    {
+        success = (pca.registers()[i] == 0x55);
+    }
+
+    g_i2c.useController(nullptr);
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Drive TwoWire's capacity limit and caller-buffer transfers on a BSC model.
+void Test_WireBuffers(void) {
+    ::test_count++;
+    bool success = false;
+
+    BcmI2cModelClass model;
+    BcmI2cControllerClass controller;
+    I2cModelRegisterSlaveClass slave(256);
+    uint8_t outData[41];
+    uint8_t inData[40] = { 0 };
+    uint8_t address = 0;
+    HRESULT hr = S_OK;
+
+    model.attachSlave(0x50, &slave);
+    controller.setRegisterAccess(&model);
+    hr = g_i2c.useController(&controller);
+    success = SUCCEEDED(hr);
+
+    if (success)
+    {
+        Wire.begin();
+
+        // With a capacity of 8 bytes, write() takes the register address and 7 bytes.
+        for (ULONG i = 0; i < sizeof(outData); i++)
+        {
+            outData[i] = (uint8_t)i;
+        }
+        Wire.setBufferCapacity(8);
+        Wire.beginTransmission(0x50);
+        success = (Wire.write(outData, 10) == 8);
+        success = success && (Wire.endTransmission() == TwoWire::SUCCESS);
+        success = success && (slave.registers()[6] == 7) && (slave.registers()[7] == 0);
+
+        // Caller buffers are not limited by the capacity.
+        outData[0] = 0;
+        Wire.beginTransmission(0x50);
+        success = success && (Wire.writeBuffer(outData, sizeof(outData)) == sizeof(outData));
+        success = success && (Wire.endTransmission() == TwoWire::SUCCESS);
+        success = success && (slave.registers()[39] == 40);
+
+        // Read the registers back into a caller buffer, after a restart.
+        Wire.beginTransmission(0x50);
+        Wire.write(&address, 1);
+        Wire.endTransmission(FALSE);
+        success = success && (Wire.requestFrom(0x50, inData, sizeof(inData)) == sizeof(inData));
+        for (ULONG i = 0; success && (i < sizeof(inData)); i++)
+        {
+            success = (inData[i] == (uint8_t)(i + 1));
+        }
+
+        // Reads into the TwoWire buffers are limited to the capacity.
+        Wire.beginTransmission(0x50);
+        Wire.write(&address, 1);
+        Wire.endTransmission(FALSE);
+        Wire.requestFrom(0x50, 20);
+        success = success && (Wire.available() == 8) && (Wire.read() == 1);
+
+        Wire.setBufferCapacity(0);
+        Wire.end();
+    }
+
+    g_i2c.useController(nullptr);
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// A simulated 24xx32 EEPROM: two address bytes, 32-byte write pages, and no
+// acknowledge of its address for a few polls after each page write.
+class EepromModelSlaveClass : public I2cModelSlaveClass
+{
+public:
+    EepromModelSlaveClass() :
+        memory(EEPROMClass::SIZE_BYTES, 0xFF),
+        bytesRead(0),
+        m_pointer(0),
+        m_addressBytes(0),
+        m_bytesWritten(0),
+        m_busyPolls(0)
+    {
+    }
+
+    BOOL start(BOOL isRead) override
+    {
+        if (m_busyPolls > 0)
+        {
+            m_busyPolls--;
+            return FALSE;
+        }
+        if (!isRead)
+        {
+            m_addressBytes = 0;
+            m_bytesWritten = 0;
+        }
+        return TRUE;
+    }
+
+    BOOL writeByte(UCHAR data) override
+    {
+        if (m_addressBytes < 2)
+        {
+            m_pointer = ((m_pointer << 8) | data) % memory.size();
+            m_addressBytes++;
+        }
+        else
+        {
+            // Writes wrap within the page.
+            memory[(m_pointer & ~31) | ((m_pointer + m_bytesWritten) & 31)] = data;
+            m_bytesWritten++;
+        }
+        return TRUE;
+    }
+
+    UCHAR readByte() override
+    {
+        UCHAR data = memory[m_pointer];
+        m_pointer = (m_pointer + 1) % memory.size();
+        bytesRead++;
+        return data;
+    }
+
+    void stop() override
+    {
+        if (m_bytesWritten > 0)
+        {
+            m_busyPolls = 3;
+            m_bytesWritten = 0;
+        }
+    }
+
+    std::vector<UCHAR> memory;
+    ULONG bytesRead;
+
+private:
+    ULONG m_pointer;
+    ULONG m_addressBytes;
+    ULONG m_bytesWritten;
+    ULONG m_busyPolls;
+};
+
+void Test_EepromBlocksAndCache(void) {
+    ::test_count++;
+    bool success = false;
+
+    BcmI2cModelClass model;
+    BcmI2cControllerClass controller;
+    EepromModelSlaveClass eeprom;
+    uint8_t outData[40];
+    uint8_t inData[100] = { 0 };
+    HRESULT hr = S_OK;
+
+    model.attachSlave(0x50, &eeprom);
+    controller.setRegisterAccess(&model);
+    hr = g_i2c.useController(&controller);
+    success = SUCCEEDED(hr);
+
+    for (ULONG i = 0; i < sizeof(outData); i++)
+    {
+        outData[i] = (uint8_t)(i + 1);
+    }
+
+    // A block write across two page boundaries lands where it was aimed.
+    success = success && (EEPROM.writeBlock(30, outData, sizeof(outData)) == sizeof(outData));
+    for (ULONG i = 0; success && (i < sizeof(outData)); i++)
+    {
+        success = (eeprom.memory[30 + i] == outData[i]);
+    }
+
+    // With the cache off (the default) every read goes to the EEPROM.
+    eeprom.bytesRead = 0;
+    success = success && (EEPROM.readBlock(0, inData, sizeof(inData)) == sizeof(inData));
+    success = success && (EEPROM.readBlock(0, inData, sizeof(inData)) == sizeof(inData));
+    success = success && (eeprom.bytesRead == (2 * sizeof(inData))) && (inData[30] == 1) && (inData[69] == 40);
+
+    // With the cache on, bytes already read are not read again.
+    EEPROM.enableCache(true);
+    eeprom.bytesRead = 0;
+    success = success && (EEPROM.readBlock(0, inData, sizeof(inData)) == sizeof(inData));
+    success = success && (EEPROM.readBlock(0, inData, sizeof(inData)) == sizeof(inData));
+    success = success && (EEPROM.read(50) == 21);
+    success = success && (eeprom.bytesRead == sizeof(inData)) && (inData[30] == 1) && (inData[69] == 40);
+
+    // Bytes changed behind the cache's back are only seen after it is invalidated.
+    eeprom.memory[50] = 0;
+    success = success && (EEPROM.read(50) == 21);
+    EEPROM.invalidateCache();
+    success = success && (EEPROM.read(50) == 0);
+    EEPROM.enableCache(false);
+
+    // Each EEPROM call closes the bus again, so the model can be detached.
+    hr = g_i2c.useController(nullptr);
+    success = success && SUCCEEDED(hr);
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Simulated ADS1015 ADC.  The first byte of each write sets the register pointer and
+// the next two bytes load the 16-bit register it addresses.  Each channel converts to
+// a fixed value, and the Configuration Register always reads back as conversion done.
+class Ads1015ModelSlaveClass : public I2cModelSlaveClass
+{
+public:
+    Ads1015ModelSlaveClass() :
+        m_pointer(0),
+        m_byteCount(0),
+        m_writeData(0),
+        m_failReads(FALSE),
+        m_pointerWrites(0),
+        m_configWrites(0)
+    {
+        m_registers[0] = 0x0000;
+        m_registers[1] = 0x8583;    // Power-on default
+        m_registers[2] = 0x8000;
+        m_registers[3] = 0x7FFF;
+        for (ULONG i = 0; i < ARRAYSIZE(m_channelCounts); i++)
+        {
+            m_channelCounts[i] = (USHORT)((i * 400) + 100);
+        }
+    }
+
+    /// Make the slave NACK reads, as if the ADC had stopped responding.
+    void setFailReads(BOOL fail)
+    {
+        m_failReads = fail;
+    }
+
+    /// Get the 11-bit conversion result the ADC returns for a channel.
+    USHORT getChannelCount(ULONG channel)
+    {
+        return m_channelCounts[channel];
+    }
+
+    /// Get the contents of one of the ADC registers.
+    USHORT getRegister(ULONG reg)
+    {
+        return m_registers[reg & 3];
+    }
+
+    /// Get the number of writes that set the register pointer.
+    ULONG getPointerWrites()
+    {
+        return m_pointerWrites;
+    }
+
+    /// Get the number of writes to the Configuration Register.
+    ULONG getConfigWrites()
+    {
+        return m_configWrites;
+    }
+
+    BOOL start(BOOL isRead) override
+    {
+        m_byteCount = 0;
+        return !(isRead && m_failReads);
+    }
+
+    BOOL writeByte(UCHAR data) override
+    {
+        if (m_byteCount == 0)
+        {
+            m_pointer = data & 3;
+            m_pointerWrites++;
+        }
+        else
+        {
+            m_writeData = (USHORT)((m_writeData << 8) | data);
+            if (m_byteCount == 2)
+            {
+                m_registers[m_pointer] = m_writeData;
+                if (m_pointer == 1)
+                {
+                    m_configWrites++;
+                }
+            }
+        }
+        m_byteCount++;
+        return TRUE;
+    }
+
+    UCHAR readByte() override
+    {
+        USHORT data = m_registers[m_pointer];
+        ULONG mux = (m_registers[1] >> 12) & 7;
+
+        if (m_pointer == 0)
+        {
+            // Single-ended inputs use mux values 4-7 for channels 0-3.
+            data = (mux >= 4) ? (USHORT)(m_channelCounts[mux - 4] << 4) : 0;
+        }
+        else if (m_pointer == 1)
+        {
+            data = data | 0x8000;
+        }
+        m_byteCount++;
+        return (m_byteCount & 1) ? (UCHAR)(data >> 8) : (UCHAR)data;
+    }
+
+private:
+    USHORT m_registers[4];
+    USHORT m_channelCounts[4];
+    ULONG m_pointer;
+    ULONG m_byteCount;
+    USHORT m_writeData;
+    BOOL m_failReads;
+    ULONG m_pointerWrites;
+    ULONG m_configWrites;
+};
+
+// Get the reading readValue() returns for an ADS1015 conversion result.
+ULONG Ads1015CountToValue(USHORT count)
+{
+    return ((count * 6144UL) + 2500) / 5000;
+}
+
+// Read the ADS1015 in continuous mode through the main I2C bus with a BSC model behind
+// it, and check the configuration and register pointer are only written when needed.
+void Test_Ads1015ContinuousMode(void) {
+    ::test_count++;
+    bool success = false;
+
+    BcmI2cModelClass model;
+    BcmI2cControllerClass controller;
+    Ads1015ModelSlaveClass adcSlave;
+    ADS1015Device adc;
+    ULONG value = 0;
+    ULONG bits = 0;
+    HRESULT hr = S_OK;
+
+    model.attachSlave(0x48, &adcSlave);
+    controller.setRegisterAccess(&model);
+    hr = g_i2c.useController(&controller);
+
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.begin();
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.setContinuousMode(TRUE);
+    }
+
+    // The first reading writes the configuration, then points back at the Conversion Register.
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.readValue(0, value, bits);
+    }
+    success = SUCCEEDED(hr) && (bits == 11) && (value == Ads1015CountToValue(adcSlave.getChannelCount(0))) &&
+        (adcSlave.getConfigWrites() == 1) && (adcSlave.getPointerWrites() == 2) &&
+        ((adcSlave.getRegister(1) & 0x7100) == 0x4000);
+
+    // Another reading of the same channel is just the two byte read, with no config write
+    // and no register address.
+    model.resetCounters();
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.readValue(0, value, bits);
+    }
+    success = success && SUCCEEDED(hr) && (value == Ads1015CountToValue(adcSlave.getChannelCount(0))) &&
+        (adcSlave.getConfigWrites() == 1) && (adcSlave.getPointerWrites() == 2) && (model.getBusBytes() == 3);
+
+    // Changing the channel rewrites the configuration once.
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.readValue(1, value, bits);
+    }
+    success = success && SUCCEEDED(hr) && (value == Ads1015CountToValue(adcSlave.getChannelCount(1))) &&
+        (adcSlave.getConfigWrites() == 2) && (adcSlave.getPointerWrites() == 4) &&
+        ((adcSlave.getRegister(1) & 0x7100) == 0x5000);
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.readValue(1, value, bits);
+    }
+    success = success && SUCCEEDED(hr) && (adcSlave.getConfigWrites() == 2) && (adcSlave.getPointerWrites() == 4);
+
+    // So does changing the data rate.
+    adc.setDataRate(1600);
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.readValue(1, value, bits);
+    }
+    success = success && SUCCEEDED(hr) && (adcSlave.getConfigWrites() == 3) && ((adcSlave.getRegister(1) & 0xE0) == 0x80);
+
+    // Leaving continuous mode puts the ADC back in single-shot mode.
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.setContinuousMode(FALSE);
+    }
+    success = success && SUCCEEDED(hr) && (adcSlave.getConfigWrites() == 4) && ((adcSlave.getRegister(1) & 0x0100) != 0);
+
+    adc.end();
+    hr = g_i2c.useController(nullptr);
+    success = success && SUCCEEDED(hr);
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Sample the ADS1015 on its ready signal, calling the ready interrupt callback directly
+// in place of the GPIO interrupt, and check the ring buffer and its counters.
+void Test_Ads1015ReadySampling(void) {
+    ::test_count++;
+    bool success = false;
+
+    const ULONG readyPin = 2;
+    BcmI2cModelClass model;
+    BcmI2cControllerClass controller;
+    Ads1015ModelSlaveClass adcSlave;
+    ADS1015Device adc;
+    DMAP_WAIT_INTERRUPT_NOTIFY_BUFFER info = { 0 };
+    std::vector<ADS1015_SAMPLE> samples(ADS1015_SAMPLE_RING_ENTRIES + 8);
+    ULONG sampleCount = 0;
+    ULONG pointerWrites = 0;
+    ULONG expected = Ads1015CountToValue(adcSlave.getChannelCount(2));
+    HRESULT hr = S_OK;
+
+    model.attachSlave(0x48, &adcSlave);
+    controller.setRegisterAccess(&model);
+    hr = g_i2c.useController(&controller);
+
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.begin();
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.startReadySampling(2, readyPin);
+    }
+
+    // Continuous conversions of AIN2, with the comparator pulsing ALERT/RDY after each one.
+    success = SUCCEEDED(hr) && adc.isReadySampling() &&
+        ((adcSlave.getRegister(1) & 0x71FF) == 0x60E0) &&
+        (adcSlave.getRegister(2) == 0x0000) && (adcSlave.getRegister(3) == 0x8000);
+    pointerWrites = adcSlave.getPointerWrites();
+
+    // Fill the ring and run past the end of it.  Each ready signal is a single read
+    // of the Conversion Register.
+    info.IntNo = readyPin;
+    for (ULONG i = 0; i < (ADS1015_SAMPLE_RING_ENTRIES + 3); i++)
+    {
+        info.EventTime = i + 1;
+        ADS1015Device::_readyInterrupt(&info, &adc);
+    }
+    success = success && (adc.getOverrunCount() == 3) && (adc.getMissedReadyCount() == 0) &&
+        (adcSlave.getPointerWrites() == pointerWrites);
+
+    // Ready signals the GPIO driver dropped are counted as missed.
+    info.DropCount = 2;
+    ADS1015Device::_readyInterrupt(&info, &adc);
+    info.DropCount = 0;
+    success = success && (adc.getOverrunCount() == 4) && (adc.getMissedReadyCount() == 2);
+
+    // The ring holds the oldest samples, in order.
+    hr = adc.getSamples(samples.data(), (ULONG)samples.size(), sampleCount);
+    success = success && SUCCEEDED(hr) && (sampleCount == ADS1015_SAMPLE_RING_ENTRIES);
+    for (ULONG i = 0; success && (i < sampleCount); i++)
+    {
+        success = (samples[i].eventTime == (i + 1)) && (samples[i].channel == 2) && (samples[i].value == expected);
+    }
+
+    // A failed read is counted as missed and stores no sample.  The next read sends
+    // the register address again.
+    adcSlave.setFailReads(TRUE);
+    ADS1015Device::_readyInterrupt(&info, &adc);
+    adcSlave.setFailReads(FALSE);
+    success = success && (adc.getMissedReadyCount() == 3);
+    ADS1015Device::_readyInterrupt(&info, &adc);
+    success = success && (adcSlave.getPointerWrites() == (pointerWrites + 1));
+    hr = adc.getSamples(samples.data(), (ULONG)samples.size(), sampleCount);
+    success = success && SUCCEEDED(hr) && (sampleCount == 1) && (samples[0].value == expected);
+
+    // Stopping restores the power-on comparator settings, and later callbacks do nothing.
+    hr = adc.stopReadySampling();
+    success = success && SUCCEEDED(hr) && !adc.isReadySampling() &&
+        (adcSlave.getRegister(1) == 0x01E3) && (adcSlave.getRegister(2) == 0x8000) && (adcSlave.getRegister(3) == 0x7FFF);
+    ADS1015Device::_readyInterrupt(&info, &adc);
+    hr = adc.getSamples(samples.data(), (ULONG)samples.size(), sampleCount);
+    success = success && SUCCEEDED(hr) && (sampleCount == 0) && (adc.getMissedReadyCount() == 3);
+
+    adc.end();
+    hr = g_i2c.useController(nullptr);
+    success = success && SUCCEEDED(hr);
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+void Test_AdcScanner(void) {
+    ::test_count++;
+    bool success = false;
+
+    AdcScannerClass scanner;
+    const ULONG channels[] = { 3, 5 };
+    ULONG readCounts[8] = { 0 };
+    ADC_SCAN_SAMPLE samples[64];
+    ULONG sampleCount = 0;
+    HRESULT hr = S_OK;
+
+    // Fake ADC: each reading is the channel number times 1000 plus the reading count.
+    AdcReadFunction readChannel = [&readCounts](ULONG channel, ULONG & value, ULONG & bits) -> HRESULT
+    {
+        if (channel >= ARRAYSIZE(readCounts))
+        {
+            return DMAP_E_ADC_DOES_NOT_HAVE_REQUESTED_CHANNEL;
+        }
+        value = (channel * 1000) + readCounts[channel]++;
+        bits = 10;
+        return S_OK;
+    };
+
+    // A channel that can't be read is reported by start() and no thread is left running.
+    const ULONG badChannels[] = { 3, 9 };
+    hr = scanner.start(readChannel, badChannels, ARRAYSIZE(badChannels), 1000);
+    success = FAILED(hr) && !scanner.isRunning() && (scanner.getChannelCount() == 0);
+
+    hr = scanner.start(readChannel, channels, ARRAYSIZE(channels), 1000);
+    success = success && SUCCEEDED(hr) && scanner.isRunning() && (scanner.getChannelCount() == 2);
+    Sleep(50);
+    scanner.stop();
+    success = success && !scanner.isRunning() && (scanner.getReadErrorCount() == 0);
+
+    // Each slot has samples from its own channel, in order, with rising timestamps.
+    for (ULONG slot = 0; success && (slot < ARRAYSIZE(channels)); slot++)
+    {
+        success = (scanner.getBits(slot) == 10) && (scanner.available(slot) > 10);
+        hr = scanner.readSamples(slot, samples, ARRAYSIZE(samples), sampleCount);
+        success = success && SUCCEEDED(hr) && (sampleCount > 10);
+        for (ULONG i = 0; success && (i < sampleCount); i++)
+        {
+            success = ((samples[i].value / 1000) == channels[slot]);
+            if (success && (i > 0))
+            {
+                success = (samples[i].value == (samples[i - 1].value + 1)) &&
+                    (samples[i].timestamp > samples[i - 1].timestamp);
+            }
+        }
+    }
+
+    success = success && (scanner.readSamples(2, samples, ARRAYSIZE(samples), sampleCount) == E_INVALIDARG);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Simulated SPI slave that answers each byte with the next value of a sequence that
+// depends on the bytes it has been sent, so any dropped, repeated or reordered byte
+// shows up in the data read back.
+class SequenceSpiSlaveClass : public SpiModelSlaveClass
+{
+public:
+    SequenceSpiSlaveClass() :
+        m_next(0x5A)
+    {
+    }
+
+    UCHAR transferByte(UCHAR mosi) override
+    {
+        UCHAR miso = m_next;
+        m_next = (UCHAR)((m_next * 7) + mosi + 1);
+        return miso;
+    }
+
+private:
+    UCHAR m_next;
+};
+
+// Transfer a buffer on the BCM SPI controller running on an SPI0 model, and check
+// the bytes the slave saw and the bytes read back.
+bool BcmSpiModelRoundTrip(BcmSpiModelClass& model, BcmSpiControllerClass& controller, SequenceSpiSlaveClass& slave,
+    size_t bufferBytes, bool useOut, bool useIn, bool hardwareCs)
+{
+    bool success = false;
+    std::vector<BYTE> outData(bufferBytes);
+    std::vector<BYTE> inData(bufferBytes, 0xEE);
+    std::vector<BYTE> expected(bufferBytes);
+    SequenceSpiSlaveClass reference = slave;
+    ULONG dataIn = 0;
+    HRESULT hr = S_OK;
+
+    for (size_t i = 0; i < bufferBytes; i++)
+    {
+        outData[i] = (BYTE)((i * 13) ^ (i >> 8));
+        expected[i] = reference.transferByte(useOut ? outData[i] : 0);
+    }
+
+    model.resetCounters();
+    hr = controller.transferBuffer(useOut ? outData.data() : nullptr, useIn ? inData.data() : nullptr, bufferBytes);
+    success = SUCCEEDED(hr) && (model.getBusBytes() == bufferBytes) && (model.getMosiBytes().size() == bufferBytes);
+
+    for (size_t i = 0; success && (i < bufferBytes); i++)
+    {
+        success = (model.getMosiBytes()[i] == (useOut ? outData[i] : 0));
+    }
+    for (size_t i = 0; success && useIn && (i < bufferBytes); i++)
+    {
+        success = (inData[i] == expected[i]);
+    }
+
+    // Hardware chip select frames the whole buffer once, however many blocks it took.
+    if (success && hardwareCs)
+    {
+        success = (model.getChipSelectFrames() == 1) && !model.isChipSelectAsserted() && (model.getChipSelectLine() == 0);
+    }
+
+    // The controller is left ready for single byte transfers.
+    if (success)
+    {
+        UCHAR expectedByte = reference.transferByte(0x3C);
+        hr = controller._transfer(0x3C, dataIn, 8);
+        success = SUCCEEDED(hr) && (dataIn == expectedByte);
+    }
+
+    return success;
+}
+
+void Test_BcmSpiModelTransfers(void) {
+    const size_t longSizes[] = { 256, 4096, BCM_SPI_MAX_PACKED_BLOCK_BYTES, BCM_SPI_MAX_PACKED_BLOCK_BYTES + 1, 70001 };
+
+    for (ULONG hardwareCs = 0; hardwareCs < 2; hardwareCs++)
+    {
+        ::test_count++;
+        bool success = false;
+
+        BcmSpiModelClass model;
+        BcmSpiControllerClass controller;
+        SequenceSpiSlaveClass slave;
+        HRESULT hr = S_OK;
+
+        model.attachSlave(&slave);
+        controller.setRegisterAccess(&model);
+        hr = controller.begin(EXTERNAL_SPI_BUS, 0, 4000, 8);
+        if (SUCCEEDED(hr) && hardwareCs)
+        {
+            // Board pin 24 carries CS0 on the Raspberry Pi 2.
+            hr = controller.setHardwareChipSelect(0, 24, FALSE);
+        }
+        success = SUCCEEDED(hr);
+
+        // Short buffers, buffers that end in a partial FIFO word, and buffers longer
+        // than one DLEN block, with and without each of the data buffers.
+        for (size_t bufferBytes = 1; success && (bufferBytes < 200); bufferBytes++)
+        {
+            success = BcmSpiModelRoundTrip(model, controller, slave, bufferBytes, true, true, hardwareCs != 0) &&
+                BcmSpiModelRoundTrip(model, controller, slave, bufferBytes, (bufferBytes & 2) == 0, (bufferBytes & 1) != 0, hardwareCs != 0);
+        }
+        for (ULONG size = 0; success && (size < ARRAYSIZE(longSizes)); size++)
+        {
+            success = BcmSpiModelRoundTrip(model, controller, slave, longSizes[size], true, true, hardwareCs != 0);
+        }
+
+        controller.end();
+
+        ::success_count += (success ? 1 : 0);
+        PostTestResult(success, __FUNCTIONW__);
+    }
+}
+
+// Transfer buffers shorter than, equal to and longer than the 16-word SSP FIFOs on
+// the BayTrail SPI controller running on a register model.  With a slow bus the TX
+// FIFO must be kept full, and with a fast bus the RX FIFO must never overrun.
+void Test_BtSpiModelTransfers(void) {
+    const size_t sizes[] = { 1, 2, 15, 16, 17, 31, 32, 33, 100, 1000 };
+    const ULONG clocksKhz[] = { 1000, 15000 };
+    const ULONG accessNs[] = { 100, 2000 };
+
+    for (ULONG speed = 0; speed < ARRAYSIZE(clocksKhz); speed++)
+    {
+        ::test_count++;
+        bool success = false;
+
+        BtSpiModelClass model;
+        BtSpiControllerClass controller;
+        SequenceSpiSlaveClass slave;
+        HRESULT hr = S_OK;
+
+        model.attachSlave(&slave);
+        model.setAccessNs(accessNs[speed]);
+        controller.setRegisterAccess(&model);
+        hr = controller.begin(EXTERNAL_SPI_BUS, 0, clocksKhz[speed], 8);
+        success = SUCCEEDED(hr);
+
+        for (ULONG size = 0; success && (size < ARRAYSIZE(sizes)); size++)
+        {
+            size_t bufferBytes = sizes[size];
+            std::vector<BYTE> outData(bufferBytes);
+            std::vector<BYTE> inData(bufferBytes + 1, 0xEE);
+            std::vector<BYTE> expected(bufferBytes);
+            SequenceSpiSlaveClass reference = slave;
+
+            for (size_t i = 0; i < bufferBytes; i++)
+            {
+                outData[i] = (BYTE)((i * 13) ^ (i >> 8));
+                expected[i] = reference.transferByte(outData[i]);
+            }
+
+            model.resetCounters();
+            hr = controller.transferBuffer(outData.data(), inData.data(), bufferBytes);
+            success = SUCCEEDED(hr) &&
+                (model.getBusWords() == bufferBytes) &&
+                (model.getMosiBytes().size() == bufferBytes) &&
+                (model.getTxOverflows() == 0) &&
+                (model.getRxOverruns() == 0) &&
+                (inData[bufferBytes] == 0xEE);
+
+            for (size_t i = 0; success && (i < bufferBytes); i++)
+            {
+                success = (model.getMosiBytes()[i] == outData[i]) && (inData[i] == expected[i]);
+            }
+
+            // When the bus is slower than the register accesses, the TX FIFO is filled.
+            if (success && (speed == 0))
+            {
+                success = (model.getMaxTxLevel() == ((bufferBytes < 16) ? bufferBytes : 16));
+            }
+
+            // The controller is left ready for single byte transfers.
+            if (success)
+            {
+                ULONG dataIn = 0;
+                UCHAR expectedByte = reference.transferByte(0x3C);
+                hr = controller._transfer(0x3C, dataIn, 8);
+                success = SUCCEEDED(hr) && (dataIn == expectedByte);
+            }
+        }
+
+        controller.end();
+
+        ::success_count += (success ? 1 : 0);
+        PostTestResult(success, __FUNCTIONW__);
+    }
+}
+
+// Set BCM SPI clock rates and check the divisor written to CLK and the rate reported.
+// The divisor is the core clock over the rate, rounded up to an even value, so the
+// clock is never faster than requested.
+void Test_BcmSpiModelClock(void) {
+    ::test_count++;
+    bool success = false;
+
+    // Requested khz, expected CDIV.
+    const ULONG rates[][2] = {
+        { 10000, 26 },          // 25 exactly, odd: rounded up to 26
+        { 9500, 28 },           // 26.3 rounds up to 27, then to 28
+        { 7000, 36 },           // 35.7 rounds up to 36
+        { 1000, 250 },          // 250 exactly, even: used as is
+        { 31, 8066 },           // 8064.5 rounds up to 8065, then to 8066
+        { 125000, 2 },          // Fastest clock
+        { 200000, 2 },          // Faster than the fastest clock: 1.25 rounds up to 2
+        { 0xFFFFFFFF, 2 },      // Must not overflow working out the divisor
+        { 4, 62500 },           // Slowest rate that can be requested
+    };
+
+    BcmSpiModelClass model;
+    BcmSpiControllerClass controller;
+    HRESULT hr = S_OK;
+
+    controller.setRegisterAccess(&model);
+    hr = controller.begin(EXTERNAL_SPI_BUS, 0, 4000, 8);
+    success = SUCCEEDED(hr);
+
+    for (ULONG i = 0; success && (i < ARRAYSIZE(rates)); i++)
+    {
+        hr = controller.setClock(rates[i][0]);
+        success = SUCCEEDED(hr) &&
+            (model.readRegister(BCM_SPI_CLK_OFFSET) == rates[i][1]) &&
+            (controller.getActualClockHz() == ((BCM_SPI_CORE_CLOCK_KHZ * 1000) / rates[i][1]));
+        if (success && (rates[i][0] <= BCM_SPI_CORE_CLOCK_KHZ))
+        {
+            success = (controller.getActualClockHz() <= (rates[i][0] * 1000ULL));
+        }
+    }
+
+    // Below 4 khz the divisor would be more than 65536, the largest CLK can hold, so the
+    // request fails and leaves the clock as it was.
+    if (success)
+    {
+        hr = controller.setClock(3);
+        success = (hr == DMAP_E_SPI_SPEED_SPECIFIED_IS_INVALID) &&
+            (model.readRegister(BCM_SPI_CLK_OFFSET) == 62500) &&
+            (controller.getActualClockHz() == 4000);
+    }
+    if (success)
+    {
+        hr = controller.setClock(0);
+        success = (hr == DMAP_E_SPI_SPEED_SPECIFIED_IS_INVALID) && (controller.getActualClockHz() == 4000);
+    }
+
+    // The model shifts bytes at the rate set by the divisor: 8 bits at 4 khz is 2 ms.
+    if (success)
+    {
+        BYTE data[2] = { 0x12, 0x34 };
+        model.resetCounters();
+        hr = controller.transferBuffer(data, data, sizeof(data));
+        success = SUCCEEDED(hr) && (model.getSimulatedNs() >= 4000000) && (model.getSimulatedNs() < 4100000);
+    }
+
+    controller.end();
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Get a byte of an LSB first word as it appears on the wire, where bit 0 of the word
+// is shifted first and the model records each byte most significant bit first.
+BYTE LsbFirstWireByte(ULONG word, ULONG byteIndex)
+{
+    BYTE wireByte = 0;
+
+    for (ULONG bit = 0; bit < 8; bit++)
+    {
+        if ((word >> ((byteIndex * 8) + bit)) & 1)
+        {
+            wireByte |= (BYTE)(0x80 >> bit);
+        }
+    }
+    return wireByte;
+}
+
+// Get the bits of an LSB first word received from a byte seen on the wire.
+ULONG LsbFirstWordBits(BYTE wireByte, ULONG byteIndex)
+{
+    ULONG word = 0;
+
+    for (ULONG bit = 0; bit < 8; bit++)
+    {
+        if (wireByte & (0x80 >> bit))
+        {
+            word |= 1UL << ((byteIndex * 8) + bit);
+        }
+    }
+    return word;
+}
+
+// Check an LSB first buffer transfer against the bytes seen on the wire.
+bool LsbFirstBufferRoundTrip(const std::vector<UCHAR>& mosiBytes, SequenceSpiSlaveClass& reference,
+    const std::vector<BYTE>& outData, const std::vector<BYTE>& inData)
+{
+    bool success = (mosiBytes.size() == outData.size());
+
+    for (size_t i = 0; success && (i < outData.size()); i++)
+    {
+        success = (mosiBytes[i] == LsbFirstWireByte(outData[i], 0)) &&
+            (inData[i] == (BYTE)LsbFirstWordBits(reference.transferByte(mosiBytes[i]), 0));
+    }
+    return success;
+}
+
+// Send LSB first data through the BCM byte and packed buffer paths, transferN() with
+// 8 to 32 bit words, and the BayTrail buffer path, and check the bit order on the wire.
+void Test_SpiModelLsbFirst(void) {
+    ::test_count++;
+    bool success = false;
+
+    const size_t sizes[] = { 1, 2, 3, 4, 5, 7, 8, 9, 64, 257 };
+    const ULONG words[] = { 0x00000001, 0x00000080, 0x12345678, 0xA5C3F00F, 0x80000000 };
+
+    BcmSpiModelClass model;
+    BcmSpiControllerClass controller;
+    SequenceSpiSlaveClass slave;
+    BtSpiModelClass btModel;
+    BtSpiControllerClass btController;
+    SequenceSpiSlaveClass btSlave;
+    HRESULT hr = S_OK;
+
+    model.attachSlave(&slave);
+    controller.setRegisterAccess(&model);
+    hr = controller.begin(EXTERNAL_SPI_BUS, 0, 4000, 8);
+    controller.setLsbFirstBitOrder();
+    success = SUCCEEDED(hr);
+
+    // Buffers under BCM_SPI_PACKED_MIN_BYTES take the byte path, the rest are packed.
+    for (ULONG size = 0; success && (size < ARRAYSIZE(sizes)); size++)
+    {
+        std::vector<BYTE> outData(sizes[size]);
+        std::vector<BYTE> inData(sizes[size]);
+        SequenceSpiSlaveClass reference = slave;
+
+        for (size_t i = 0; i < outData.size(); i++)
+        {
+            outData[i] = (BYTE)((i * 29) + 1);
+        }
+        std::vector<BYTE> outCopy = outData;
+
+        model.resetCounters();
+        hr = controller.transferBuffer(outData.data(), inData.data(), outData.size());
+        success = SUCCEEDED(hr) && (outData == outCopy) &&
+            LsbFirstBufferRoundTrip(model.getMosiBytes(), reference, outData, inData);
+    }
+
+    // Words of one to four bytes go out bit 0 first, lowest byte first.
+    for (ULONG bits = 8; success && (bits <= 32); bits += 8)
+    {
+        for (ULONG w = 0; success && (w < ARRAYSIZE(words)); w++)
+        {
+            ULONG mask = 0xFFFFFFFF >> (32 - bits);
+            ULONG expectedIn = 0;
+            ULONG dataIn = 0;
+            SequenceSpiSlaveClass reference = slave;
+
+            model.resetCounters();
+            hr = controller.transferN(words[w], dataIn, bits);
+            success = SUCCEEDED(hr) && (model.getMosiBytes().size() == (bits / 8));
+            for (ULONG b = 0; success && (b < (bits / 8)); b++)
+            {
+                success = (model.getMosiBytes()[b] == LsbFirstWireByte(words[w] & mask, b));
+                expectedIn |= LsbFirstWordBits(reference.transferByte(model.getMosiBytes()[b]), b);
+            }
+            success = success && (dataIn == expectedIn);
+        }
+    }
+
+    // Going back to MSB first sends the word as it is, most significant byte first.
+    if (success)
+    {
+        ULONG dataIn = 0;
+        controller.setMsbFirstBitOrder();
+        model.resetCounters();
+        hr = controller.transferN(0x12345678, dataIn, 16);
+        success = SUCCEEDED(hr) && (model.getMosiBytes().size() == 2) &&
+            (model.getMosiBytes()[0] == 0x56) && (model.getMosiBytes()[1] == 0x78);
+    }
+
+    controller.end();
+
+    // The BayTrail controller reverses each byte as it moves through the SSP FIFOs.
+    if (success)
+    {
+        btModel.attachSlave(&btSlave);
+        btController.setRegisterAccess(&btModel);
+        hr = btController.begin(EXTERNAL_SPI_BUS, 0, 4000, 8);
+        btController.setLsbFirstBitOrder();
+        success = SUCCEEDED(hr);
+    }
+    for (ULONG size = 0; success && (size < ARRAYSIZE(sizes)); size++)
+    {
+        std::vector<BYTE> outData(sizes[size]);
+        std::vector<BYTE> inData(sizes[size]);
+        SequenceSpiSlaveClass reference = btSlave;
+
+        for (size_t i = 0; i < outData.size(); i++)
+        {
+            outData[i] = (BYTE)((i * 29) + 1);
+        }
+
+        btModel.resetCounters();
+        hr = btController.transferBuffer(outData.data(), inData.data(), outData.size());
+        success = SUCCEEDED(hr) && LsbFirstBufferRoundTrip(btModel.getMosiBytes(), reference, outData, inData);
+    }
+
+    btController.end();
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Send a three segment message: a command held into a data block at a slower clock,
+// then a block of 16-bit words in a second chip select frame.
+void Test_BcmSpiModelMessage(void) {
+    ::test_count++;
+    bool success = false;
+
+    BcmSpiModelClass model;
+    BcmSpiControllerClass controller;
+    SequenceSpiSlaveClass slave;
+    SequenceSpiSlaveClass reference;
+    SPI_MESSAGE_SEGMENT segments[3];
+    BYTE command[3] = { 0x0B, 0x12, 0x34 };
+    BYTE commandIn[3];
+    BYTE dataOut[100];
+    BYTE dataIn[100];
+    USHORT wordsOut[4] = { 0x1234, 0xABCD, 0x0F0F, 0x8001 };
+    USHORT wordsIn[4];
+    std::vector<BYTE> mosi;
+    std::vector<BYTE> miso;
+    ULONG clockHz = 0;
+    HRESULT hr = S_OK;
+
+    for (ULONG i = 0; i < sizeof(dataOut); i++)
+    {
+        dataOut[i] = (BYTE)((i * 3) + 1);
+    }
+
+    ZeroMemory(segments, sizeof(segments));
+    segments[0].dataOut = command;
+    segments[0].dataIn = commandIn;
+    segments[0].bufferBytes = sizeof(command);
+    segments[0].csHold = TRUE;
+    segments[1].dataOut = dataOut;
+    segments[1].dataIn = dataIn;
+    segments[1].bufferBytes = sizeof(dataOut);
+    segments[1].clockKhz = 1000;
+    segments[1].delayUs = 5;
+    segments[2].dataOut = (PBYTE)wordsOut;
+    segments[2].dataIn = (PBYTE)wordsIn;
+    segments[2].bufferBytes = sizeof(wordsOut);
+    segments[2].bitsPerWord = 16;
+    segments[2].csHold = TRUE;
+
+    model.attachSlave(&slave);
+    controller.setRegisterAccess(&model);
+    hr = controller.begin(EXTERNAL_SPI_BUS, 0, 4000, 8);
+    if (SUCCEEDED(hr))
+    {
+        // Board pin 24 carries CS0 on the Raspberry Pi 2.
+        hr = controller.setHardwareChipSelect(0, 24, FALSE);
+    }
+    clockHz = controller.getActualClockHz();
+
+    model.resetCounters();
+    if (SUCCEEDED(hr))
+    {
+        hr = controller.transferMessage(segments, ARRAYSIZE(segments));
+    }
+    success = SUCCEEDED(hr);
+
+    // The 16-bit words go out MS byte first.
+    mosi.insert(mosi.end(), command, command + sizeof(command));
+    mosi.insert(mosi.end(), dataOut, dataOut + sizeof(dataOut));
+    for (ULONG i = 0; i < ARRAYSIZE(wordsOut); i++)
+    {
+        mosi.push_back((BYTE)(wordsOut[i] >> 8));
+        mosi.push_back((BYTE)(wordsOut[i] & 0xFF));
+    }
+    for (size_t i = 0; i < mosi.size(); i++)
+    {
+        miso.push_back(reference.transferByte(mosi[i]));
+    }
+    success = success && (model.getMosiBytes() == mosi);
+
+    for (ULONG i = 0; success && (i < sizeof(command)); i++)
+    {
+        success = (commandIn[i] == miso[i]);
+    }
+    for (ULONG i = 0; success && (i < sizeof(dataIn)); i++)
+    {
+        success = (dataIn[i] == miso[sizeof(command) + i]);
+    }
+    for (ULONG i = 0; success && (i < ARRAYSIZE(wordsIn)); i++)
+    {
+        size_t index = sizeof(command) + sizeof(dataOut) + (i * 2);
+        success = (wordsIn[i] == ((miso[index] << 8) | miso[index + 1]));
+    }
+
+    // Chip select is released after the second segment and at the end of the message,
+    // and the clock rate the message changed is put back.
+    success = success && (model.getChipSelectFrames() == 2) && !model.isChipSelectAsserted() &&
+        (controller.getActualClockHz() == clockHz);
+
+    controller.end();
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Measure BCM SPI buffer transfers on an SPI0 model at 10 MHz.  Time is simulated,
+// and each register access costs 2 us, so the controller, not the bus, sets the
+// pace.  Buffers of 1 and 3 bytes go through the byte at a time loop, so the
+// difference between them is the loop's cost per byte.
+void Test_BcmSpiModelBenchmark(void) {
+    ::test_count++;
+    bool success = false;
+
+    const size_t bufferBytes = 70001;
+    const ULONG accessNs = 2000;
+    BcmSpiModelClass model;
+    BcmSpiControllerClass controller;
+    std::vector<BYTE> outData(bufferBytes, 0xA5);
+    std::vector<BYTE> inData(bufferBytes);
+    ULONGLONG accesses[2];
+    ULONGLONG statusReads[2];
+    ULONGLONG fifoAccesses[2];
+    HRESULT hr = S_OK;
+
+    model.setAccessNs(accessNs);
+    controller.setRegisterAccess(&model);
+    hr = controller.begin(EXTERNAL_SPI_BUS, 0, 10000, 8);
+
+    for (ULONG i = 0; SUCCEEDED(hr) && (i < 2); i++)
+    {
+        model.resetCounters();
+        hr = controller.transferBuffer(outData.data(), inData.data(), (i == 0) ? 1 : 3);
+        accesses[i] = model.getRegisterAccesses();
+        statusReads[i] = model.getStatusReads();
+        fifoAccesses[i] = model.getFifoAccesses();
+    }
+    success = SUCCEEDED(hr);
+
+    if (success)
+    {
+        Log(L"BCM SPI model, 10 MHz, byte loop: %llu register accesses (%llu FIFO, %llu status) per byte\n",
+            (accesses[1] - accesses[0]) / 2, (fifoAccesses[1] - fifoAccesses[0]) / 2, (statusReads[1] - statusReads[0]) / 2);
+
+        model.resetCounters();
+        hr = controller.transferBuffer(outData.data(), inData.data(), bufferBytes);
+        success = SUCCEEDED(hr) && (model.getBusBytes() == bufferBytes);
+    }
+
+    if (success)
+    {
+        Log(L"BCM SPI model, 10 MHz, packed %u bytes: %llu.%02llu register accesses (%llu.%02llu FIFO, %llu.%02llu status) per byte, %llu ns per byte\n",
+            (ULONG)bufferBytes,
+            model.getRegisterAccesses() / bufferBytes, ((model.getRegisterAccesses() * 100) / bufferBytes) % 100,
+            model.getFifoAccesses() / bufferBytes, ((model.getFifoAccesses() * 100) / bufferBytes) % 100,
+            model.getStatusReads() / bufferBytes, ((model.getStatusReads() * 100) / bufferBytes) % 100,
+            model.getSimulatedNs() / bufferBytes);
+
+        // Packed mode moves four bytes per FIFO access and reads the status once per 48 bytes.
+        success = ((model.getFifoAccesses() * 2) <= (bufferBytes + 8)) &&
+            ((model.getStatusReads() * 10) < bufferBytes) &&
+            ((model.getRegisterAccesses() * 4) < ((accesses[1] - accesses[0]) / 2) * bufferBytes);
+    }
+
+    controller.end();
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Stream buffers to an SPI0 model and check they reach the bus complete and in order.
+void Test_SpiStreamer(void) {
+    ::test_count++;
+    bool success = false;
+
+    const size_t frameBytes = 4096;
+    const ULONG frameCount = 50;
+    BcmSpiModelClass model;
+    BcmSpiControllerClass controller;
+    SpiStreamerClass streamer;
+    ULONG completions = 0;
+    PBYTE buffer = nullptr;
+    PBYTE buffer2 = nullptr;
+    HRESULT hr = S_OK;
+
+    controller.setRegisterAccess(&model);
+    hr = controller.begin(EXTERNAL_SPI_BUS, 0, 10000, 8);
+    success = SUCCEEDED(hr) && (streamer.start(&controller, 1, frameBytes) == E_INVALIDARG);
+
+    // The completion function runs on the stream thread, and only after the buffer has been sent.
+    hr = streamer.start(&controller, 3, frameBytes, [&completions, frameBytes](PBYTE sentBuffer, size_t sentBytes, HRESULT sendResult)
+    {
+        if (SUCCEEDED(sendResult) && (sentBytes == frameBytes))
+        {
+            completions++;
+        }
+    });
+    success = success && SUCCEEDED(hr) && streamer.isRunning();
+
+    for (ULONG frame = 0; success && (frame < frameCount); frame++)
+    {
+        hr = streamer.acquireBuffer(buffer, 2000);
+        success = SUCCEEDED(hr);
+        for (size_t i = 0; success && (i < frameBytes); i++)
+        {
+            buffer[i] = (BYTE)(frame + (i * 7));
+        }
+
+        // Starve the stream thread once, so it records an underrun.
+        if (frame == (frameCount / 2))
+        {
+            Sleep(20);
+        }
+
+        success = success && SUCCEEDED(streamer.submitBuffer(frameBytes));
+    }
+
+    hr = streamer.waitForIdle(5000);
+    success = success && SUCCEEDED(hr) && (model.getMosiBytes().size() == (frameBytes * frameCount));
+    for (ULONG frame = 0; success && (frame < frameCount); frame++)
+    {
+        for (size_t i = 0; success && (i < frameBytes); i++)
+        {
+            success = (model.getMosiBytes()[(frame * frameBytes) + i] == (BYTE)(frame + (i * 7)));
+        }
+    }
+    success = success && (completions == frameCount) && (streamer.getBuffersSent() == frameCount) &&
+        (streamer.getUnderrunCount() >= 1) && (streamer.getTransferErrorCount() == 0);
+
+    // A buffer that has been acquired but not submitted is returned again.
+    success = success && SUCCEEDED(streamer.acquireBuffer(buffer, 100)) &&
+        SUCCEEDED(streamer.acquireBuffer(buffer2, 100)) && (buffer == buffer2);
+
+    streamer.stop();
+    success = success && !streamer.isRunning() && (streamer.acquireBuffer(buffer, 10) == DMAP_E_SPI_STREAM_NOT_RUNNING);
+
+    controller.end();
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Transfer arrays of 16-bit words through SPIClass on an SPI0 model that loops MOSI back to MISO.
+void Test_SpiTransfer16(void) {
+    ::test_count++;
+    bool success = false;
+
+    const size_t wordCount = 37;
+    BcmSpiModelClass model;
+    BcmSpiControllerClass controller;
+    SPIClass spi;
+    uint16_t words[wordCount];
+    uint16_t received[wordCount];
+    HRESULT hr = S_OK;
+
+    for (size_t i = 0; i < wordCount; i++)
+    {
+        words[i] = (uint16_t)((i * 0x1357) + 0x0102);
+    }
+
+    controller.setRegisterAccess(&model);
+    hr = controller.begin(EXTERNAL_SPI_BUS, 0, 4000, 8);
+    success = SUCCEEDED(hr);
+    spi.useController(&controller);
+
+    // Words go out MS byte first, and come back unchanged.
+    model.resetCounters();
+    spi.transfer16(words, received, wordCount);
+    success = success && (model.getMosiBytes().size() == (wordCount * 2));
+    for (size_t i = 0; success && (i < wordCount); i++)
+    {
+        success = (model.getMosiBytes()[i * 2] == (words[i] >> 8)) &&
+            (model.getMosiBytes()[(i * 2) + 1] == (words[i] & 0xFF)) &&
+            (received[i] == words[i]);
+    }
+
+    // With no words to send, zeros are sent.
+    model.resetCounters();
+    spi.transfer16(nullptr, received, wordCount);
+    success = success && (model.getMosiBytes().size() == (wordCount * 2));
+    for (size_t i = 0; success && (i < wordCount); i++)
+    {
+        success = (model.getMosiBytes()[i * 2] == 0) && (model.getMosiBytes()[(i * 2) + 1] == 0) && (received[i] == 0);
+    }
+
+    model.resetCounters();
+    spi.transfer16(nullptr, nullptr, 5);
+    success = success && (model.getMosiBytes().size() == 10) && (model.getMosiBytes()[9] == 0);
+
+    spi.setBitOrder(LSBFIRST);
+    spi.transfer16(words, received, wordCount);
+    for (size_t i = 0; success && (i < wordCount); i++)
+    {
+        success = (received[i] == words[i]);
+    }
+
+    spi.useController(nullptr);
+    controller.end();
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Decode the color bytes from a WS2812 SPI bit stream.  Each LED bit must start high
+// and end low, and is a 1 if more than one of its SPI bits is high.
+bool DecodeWs2812Stream(const std::vector<UCHAR>& mosi, ULONG spiBitsPerLedBit, PBYTE colors, ULONG colorBytes)
+{
+    bool success = (mosi.size() >= (colorBytes * spiBitsPerLedBit));
+    size_t bit = 0;
+    auto mosiBit = [&mosi](size_t index) { return (mosi[index / 8] >> (7 - (index % 8))) & 1; };
+
+    for (ULONG i = 0; success && (i < colorBytes); i++)
+    {
+        colors[i] = 0;
+        for (ULONG j = 0; success && (j < 8); j++)
+        {
+            ULONG highBits = 0;
+            for (ULONG k = 0; k < spiBitsPerLedBit; k++)
+            {
+                highBits += mosiBit(bit + k);
+            }
+            success = (mosiBit(bit) == 1) && (mosiBit(bit + spiBitsPerLedBit - 1) == 0);
+            colors[i] = (BYTE)((colors[i] << 1) | ((highBits > 1) ? 1 : 0));
+            bit += spiBitsPerLedBit;
+        }
+    }
+
+    return success;
+}
+
+// Send frames to a strip of two WS2812 LEDs on an SPI0 model, and decode what reached MOSI.
+void Test_WS2812Strip(void) {
+    for (ULONG spiBitsPerLedBit = 3; spiBitsPerLedBit <= 4; spiBitsPerLedBit++)
+    {
+        ::test_count++;
+        bool success = false;
+
+        BcmSpiModelClass model;
+        BcmSpiControllerClass controller;
+        WS2812Device strip;
+        // The LEDs take the colors in green, red, blue order.
+        const BYTE expected[6] = { 0xA5, 0x00, 0xFF, 0x01, 0x80, 0x00 };
+        BYTE colors[6];
+        size_t frameBytes = 0;
+        HRESULT hr = S_OK;
+
+        controller.setRegisterAccess(&model);
+        hr = controller.begin(EXTERNAL_SPI_BUS, 0, 1000, 8);
+        if (SUCCEEDED(hr))
+        {
+            hr = strip.begin(&controller, 2, spiBitsPerLedBit);
+        }
+        success = SUCCEEDED(hr) && (strip.getPixelCount() == 2) && (strip.setPixel(2, 1, 2, 3) == E_INVALIDARG);
+
+        // The SPI clock is within tolerance of the LED bit rate times the bits per LED bit.
+        success = success &&
+            ((controller.getActualClockHz() * 100) >= (WS2812_BIT_RATE * spiBitsPerLedBit * (100 - WS2812_CLOCK_TOLERANCE_PERCENT))) &&
+            ((controller.getActualClockHz() * 100) <= (WS2812_BIT_RATE * spiBitsPerLedBit * (100 + WS2812_CLOCK_TOLERANCE_PERCENT)));
+
+        success = success && SUCCEEDED(strip.setPixel(0, 0x00, 0xA5, 0xFF)) && SUCCEEDED(strip.setPixel(1, 0x80, 0x01, 0x00));
+        model.resetCounters();
+        success = success && SUCCEEDED(strip.show());
+        success = success && DecodeWs2812Stream(model.getMosiBytes(), spiBitsPerLedBit, colors, sizeof(colors));
+        for (ULONG i = 0; success && (i < sizeof(colors)); i++)
+        {
+            success = (colors[i] == expected[i]);
+        }
+
+        // The frame is followed by at least the reset time of low output.
+        frameBytes = sizeof(colors) * spiBitsPerLedBit;
+        success = success &&
+            (((model.getMosiBytes().size() - frameBytes) * 8 * 1000000ULL) >= ((ULONGLONG)WS2812_RESET_US * controller.getActualClockHz()));
+        for (size_t i = frameBytes; success && (i < model.getMosiBytes().size()); i++)
+        {
+            success = (model.getMosiBytes()[i] == 0);
+        }
+
+        // At zero brightness every LED bit is sent as a 0.
+        strip.setBrightness(0);
+        model.resetCounters();
+        success = success && SUCCEEDED(strip.show());
+        success = success && DecodeWs2812Stream(model.getMosiBytes(), spiBitsPerLedBit, colors, sizeof(colors));
+        for (ULONG i = 0; success && (i < sizeof(colors)); i++)
+        {
+            success = (colors[i] == 0);
+        }
+
+        controller.end();
+
+        ::success_count += (success ? 1 : 0);
+        PostTestResult(success, __FUNCTIONW__);
+    }
+}
+
+// Count SPIClass transfers on an SPI0 model with the controller driving chip select.
+void Test_SpiCounters(void) {
+    ::test_count++;
+    bool success = false;
+
+    BcmSpiModelClass model;
+    BcmSpiControllerClass controller;
+    SPIClass spi;
+    SPI_BUS_COUNTERS counters;
+    BYTE buffer[1000] = { 0 };
+    HRESULT hr = S_OK;
+
+    controller.setRegisterAccess(&model);
+    hr = controller.begin(EXTERNAL_SPI_BUS, 0, 4000, 8);
+    if (SUCCEEDED(hr))
+    {
+        // Board pin 24 carries CS0 on the Raspberry Pi 2.
+        hr = controller.setHardwareChipSelect(0, 24, FALSE);
+    }
+    success = SUCCEEDED(hr);
+    spi.useController(&controller);
+
+    // Nothing is counted until counting is turned on.
+    spi.transfer(buffer, sizeof(buffer));
+    spi.enableCounters(TRUE);
+    for (ULONG i = 0; i < 5; i++)
+    {
+        spi.transfer(buffer, sizeof(buffer));
+        spi.transfer(buffer, nullptr, 10);
+    }
+    spi.transfer(0x01);
+
+    spi.getCounters(counters);
+    success = success && (counters.transfers == 11) && (counters.failedTransfers == 0) &&
+        (counters.bytesTransferred == ((5 * (sizeof(buffer) + 10)) + 1)) &&
+        (counters.chipSelectFrames == 11) && (counters.clockHz == controller.getActualClockHz()) &&
+        (counters.maxTransferUs <= counters.totalTransferUs) && (counters.totalSpinUs <= counters.totalTransferUs);
+
+    // Reset zeroes the counters, and nothing is counted once counting is off again.
+    spi.resetCounters();
+    spi.enableCounters(FALSE);
+    spi.transfer(0x01);
+    spi.getCounters(counters);
+    success = success && (counters.transfers == 0) && (counters.bytesTransferred == 0) && (counters.chipSelectFrames == 0);
+
+    spi.useController(nullptr);
+    controller.end();
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Bus counters are kept by the bus object, so tracing can be turned on before the
+// bus is opened and the counts build up across closing and reopening it.
+void Test_I2cBusCounters(void) {
+    ::test_count++;
+    bool success = false;
+
+    I2cClass bus(SECOND_EXTERNAL_I2C_BUS);
+    BcmI2cModelClass model;
+    BcmI2cControllerClass controller;
+    I2cModelRegisterSlaveClass slave(256);
+    I2C_BUS_COUNTERS counters;
+    HRESULT hr = S_OK;
+
+    model.attachSlave(0x50, &slave);
+    controller.setRegisterAccess(&model);
+
+    hr = bus.enableTracing(TRUE);
+    success = SUCCEEDED(hr) && SUCCEEDED(bus.useController(&controller));
+
+    // Two sessions of one round trip (a write and a write-read) each.
+    for (ULONG session = 0; success && (session < 2); session++)
+    {
+        success = SUCCEEDED(bus.begin()) && BcmI2cModelRoundTrip(controller, slave, 16);
+        bus.end();
+    }
+
+    success = success && SUCCEEDED(bus.getCounters(counters)) &&
+        (counters.transactions == 4) && (counters.failedTransactions == 0) &&
+        (counters.bytesWritten == (2 * (17 + 1))) && (counters.bytesRead == (2 * 16));
+
+    // Once the controller is handed back, its transactions are no longer counted for the bus.
+    success = success && SUCCEEDED(bus.useController(nullptr)) && BcmI2cModelRoundTrip(controller, slave, 16);
+    success = success && SUCCEEDED(bus.getCounters(counters)) && (counters.transactions == 4);
+
+    success = success && SUCCEEDED(bus.resetCounters()) && SUCCEEDED(bus.getCounters(counters)) &&
+        (counters.transactions == 0) && (counters.bytesWritten == 0);
+    bus.enableTracing(FALSE);
+
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Simulated MCP3008 ADC.  Each conversion is a frame of three bytes sent with chip
+// select asserted: the start bit in the last bit of the first byte, then the single-ended
+// bit and channel number in the top four bits of the second byte.  The 10-bit result
+// comes back after a null bit, in the last two bits of the second byte and the third byte.
+class Mcp3008ModelSlaveClass : public SpiModelSlaveClass
+{
+public:
+    Mcp3008ModelSlaveClass() :
+        m_selected(FALSE),
+        m_frameByte(0),
+        m_channel(0),
+        m_frames(0),
+        m_badFrames(0)
+    {
+    }
+
+    /// Get the 10-bit result the ADC returns for a channel.
+    static ULONG channelValue(ULONG channel)
+    {
+        return ((channel * 131) + 37) & 0x3FF;
+    }
+
+    /// Get the number of complete, correctly formed frames received.
+    ULONG getFrames()
+    {
+        return m_frames;
+    }
+
+    /// Get the number of frames that were malformed or sent without chip select.
+    ULONG getBadFrames()
+    {
+        return m_badFrames;
+    }
+
+    UCHAR transferByte(UCHAR mosi) override
+    {
+        UCHAR miso = 0xFF;
+
+        if (!m_selected)
+        {
+            m_badFrames++;
+            return miso;
+        }
+
+        switch (m_frameByte)
+        {
+        case 0:
+            if (mosi != 0x01)
+            {
+                m_badFrames++;
+            }
+            break;
+        case 1:
+            if ((mosi & 0x80) == 0)
+            {
+                m_badFrames++;
+            }
+            m_channel = (mosi >> 4) & 0x07;
+            miso = (UCHAR)(0xF8 | (channelValue(m_channel) >> 8));
+            break;
+        case 2:
+            miso = (UCHAR)channelValue(m_channel);
+            m_frames++;
+            break;
+        default:
+            m_badFrames++;
+        }
+        m_frameByte++;
+
+        return miso;
+    }
+
+    void chipSelect(BOOL asserted) override
+    {
+        // The ADC needs chip select raised after each conversion.
+        if (!asserted && (m_frameByte != 3))
+        {
+            m_badFrames++;
+        }
+        m_selected = asserted;
+        m_frameByte = 0;
+    }
+
+private:
+    BOOL m_selected;
+    ULONG m_frameByte;
+    ULONG m_channel;
+    ULONG m_frames;
+    ULONG m_badFrames;
+};
+
+// Read the MCP3008 through the BCM SPI controller running on an SPI0 model, with the
+// controller driving chip select.
+void Test_Mcp3008ModelRead(void) {
+    ::test_count++;
+    bool success = false;
+
+    BcmSpiModelClass model;
+    BcmSpiControllerClass controller;
+    Mcp3008ModelSlaveClass adcSlave;
+    MCP3008Device adc;
+    ULONG channels[MCP3008_BLOCK_CONVERSIONS + 8];
+    ULONG values[MCP3008_BLOCK_CONVERSIONS + 8];
+    ULONG value = 0;
+    ULONG bits = 0;
+    HRESULT hr = S_OK;
+
+    controller.setRegisterAccess(&model);
+    hr = controller.begin(EXTERNAL_SPI_BUS, MCP3008_SPI_MODE, MCP3008_MAX_SPI_KHZ, MCP3008_SPI_TRANSFER_BITS);
+    if (SUCCEEDED(hr))
+    {
+        // Board pin 24 carries CS0 on the Raspberry Pi 2.
+        hr = controller.setHardwareChipSelect(0, PI2_SPI_CS_PIN, FALSE);
+    }
+    adc.useController(&controller);
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.begin();
+    }
+    model.attachSlave(&adcSlave);
+    model.resetCounters();
+
+    // One conversion is one frame.
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.readValue(5, value, bits);
+    }
+    success = SUCCEEDED(hr) && (value == Mcp3008ModelSlaveClass::channelValue(5)) && (bits == 10) &&
+        (adcSlave.getFrames() == 1) && (model.getChipSelectFrames() == 1);
+
+    // A block longer than the frames built at a time, with every channel and repeats.
+    for (ULONG i = 0; i < ARRAYSIZE(channels); i++)
+    {
+        channels[i] = (i * 3) % 8;
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.readBlock(channels, ARRAYSIZE(channels), values);
+    }
+    success = success && SUCCEEDED(hr) && (adcSlave.getFrames() == (ARRAYSIZE(channels) + 1)) &&
+        (model.getChipSelectFrames() == (ARRAYSIZE(channels) + 1));
+    for (ULONG i = 0; success && (i < ARRAYSIZE(channels)); i++)
+    {
+        success = (values[i] == Mcp3008ModelSlaveClass::channelValue(channels[i]));
+    }
+
+    // Channel numbers are checked before anything is sent.
+    channels[3] = 8;
+    hr = adc.readBlock(channels, ARRAYSIZE(channels), values);
+    success = success && (hr == DMAP_E_ADC_DOES_NOT_HAVE_REQUESTED_CHANNEL) &&
+        (adcSlave.getFrames() == (ARRAYSIZE(channels) + 1)) && (adcSlave.getBadFrames() == 0);
+
+    adc.end();
+    adc.useController(nullptr);
+    controller.end();
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
+// Stream MCP3008 readings through the scan sequencer, as the ADC provider does, with
+// the ADC on an SPI0 model.  Complete scans are retrieved in blocks, and samples that
+// are not retrieved in time are counted as overruns.
+void Test_Mcp3008Streaming(void) {
+    ::test_count++;
+    bool success = false;
+
+    BcmSpiModelClass model;
+    BcmSpiControllerClass controller;
+    Mcp3008ModelSlaveClass adcSlave;
+    MCP3008Device adc;
+    AdcScannerClass scanner;
+    const ULONG channels[] = { 6, 1, 4 };
+    const ULONG scanCount = 50;
+    ULONG values[scanCount * ARRAYSIZE(channels)];
+    ULONGLONG timestamps[scanCount];
+    ULONG overruns = 0;
+    ULONG waiting = 0;
+    LARGE_INTEGER frequency;
+    HRESULT hr = S_OK;
+
+    controller.setRegisterAccess(&model);
+    hr = controller.begin(EXTERNAL_SPI_BUS, MCP3008_SPI_MODE, MCP3008_MAX_SPI_KHZ, MCP3008_SPI_TRANSFER_BITS);
+    if (SUCCEEDED(hr))
+    {
+        hr = controller.setHardwareChipSelect(0, PI2_SPI_CS_PIN, FALSE);
+    }
+    adc.useController(&controller);
+    if (SUCCEEDED(hr))
+    {
+        hr = adc.begin();
+    }
+    model.attachSlave(&adcSlave);
+
+    AdcReadFunction readChannel = [&adc](ULONG channel, ULONG & value, ULONG & bits) -> HRESULT
+    {
+        return adc.readValue(channel, value, bits);
+    };
+
+    // Take a block of scans at 2000 scans per second.
+    if (SUCCEEDED(hr))
+    {
+        hr = scanner.start(readChannel, channels, ARRAYSIZE(channels), 2000);
+    }
+    for (ULONG wait = 0; SUCCEEDED(hr) && (wait < 100); wait++)
+    {
+        Sleep(10);
+        hr = scanner.readScans(scanCount, values, timestamps);
+        if (hr == S_OK)
+        {
+            break;
+        }
+    }
+    scanner.stop();
+    success = (hr == S_OK) && (scanner.getReadErrorCount() == 0) && (adcSlave.getBadFrames() == 0);
+
+    // The readings are ordered by scan and then by slot, and the scans are evenly spaced.
+    for (ULONG i = 0; success && (i < ARRAYSIZE(values)); i++)
+    {
+        success = (values[i] == Mcp3008ModelSlaveClass::channelValue(channels[i % ARRAYSIZE(channels)]));
+    }
+    for (ULONG i = 1; success && (i < scanCount); i++)
+    {
+        success = (timestamps[i] > timestamps[i - 1]);
+    }
+    QueryPerformanceFrequency(&frequency);
+    success = success && ((timestamps[scanCount - 1] - timestamps[0]) >= (ULONGLONG)(((scanCount - 1) * frequency.QuadPart) / 4000));
+
+    // Nothing is removed unless all the scans asked for are complete.
+    waiting = scanner.available(0);
+    hr = scanner.readScans(waiting + 1, values, nullptr);
+    success = success && (hr == S_FALSE) && (scanner.available(0) == waiting);
+
+    // Scans that are not retrieved fill the rings, and the rest are counted as overruns.
+    hr = scanner.start(readChannel, channels, ARRAYSIZE(channels), 10000);
+    for (ULONG wait = 0; SUCCEEDED(hr) && (wait < 300) && (scanner.getTotalOverrunCount() == 0); wait++)
+    {
+        Sleep(10);
+    }
+    scanner.stop();
+    for (ULONG slot = 0; slot < ARRAYSIZE(channels); slot++)
+    {
+        overruns += scanner.getOverrunCount(slot);
+        success = success && (scanner.available(slot) == ADC_SCAN_RING_ENTRIES);
+    }
+    success = success && SUCCEEDED(hr) && (overruns > 0) && (scanner.getTotalOverrunCount() == overruns);
+
+    adc.end();
+    adc.useController(nullptr);
+    controller.end();
+    controller.setRegisterAccess(nullptr);
+
+    ::success_count += (success ? 1 : 0);
+    PostTestResult(success, __FUNCTIONW__);
+}
+
 void setup(void) {
 
     Test_memchr_P();
@@ -166,6 +2587,32 @@ void setup(void) {
     Test_strchrnul_P();
     Test_strcasestr_P();
     Test_serialPrint_P();
+    Test_BtI2cModelTransfers();
+    Test_BtI2cModelNack();
+    Test_I2cClockRates();
+    Test_I2cControllerSpinTrace();
+    Test_I2cBusCounters();
+    Test_BcmI2cModelTransfers();
+    Test_BcmI2cModelBenchmark();
+    Test_Pca9685ModelUpdate();
+    Test_Pca9685MaskedCommit();
+    Test_WireBuffers();
+    Test_EepromBlocksAndCache();
+    Test_Ads1015ContinuousMode();
+    Test_Ads1015ReadySampling();
+    Test_AdcScanner();
+    Test_BcmSpiModelTransfers();
+    Test_BtSpiModelTransfers();
+    Test_BcmSpiModelClock();
+    Test_SpiModelLsbFirst();
+    Test_BcmSpiModelMessage();
+    Test_BcmSpiModelBenchmark();
+    Test_SpiStreamer();
+    Test_SpiTransfer16();
+    Test_WS2812Strip();
+    Test_SpiCounters();
+    Test_Mcp3008ModelRead();
+    Test_Mcp3008Streaming();
 
     Log(L"\n%u/%u TEST PASSED\n", ::success_count, ::test_count);
 }
@@ -5,6 +5,7 @@
 #include "boardpins.h"
 
 using namespace Microsoft::IoT::Lightning::Providers;
+using namespace Windows::System::Threading;
 
 #pragma region LightningAdcProvider
 
@@ -47,16 +48,176 @@ void LightningMCP3008AdcControllerProvider::ReleaseChannel(int channel)
 
 int LightningMCP3008AdcControllerProvider::ReadValue(int channelNumber)
 {
-    if (!_channelsAcquired[channelNumber])
-    {
-        throw ref new Platform::AccessDeniedException(L"Channel not acquired");
-    }
+    CheckChannelAcquired(channelNumber);
 
     ULONG value = 0;;
     ULONG bits = 0;
-    _addOnAdc->readValue(channelNumber, value, bits);
+    {
+        std::lock_guard<std::mutex> lock(_adcLock);
+        _addOnAdc->readValue(channelNumber, value, bits);
+    }
+
+    return ScaleValue(value, bits);
+}
+
+void LightningMCP3008AdcControllerProvider::ReadValues(const Platform::Array<int>^ channelNumbers, Platform::WriteOnlyArray<int>^ values)
+{
+    if (channelNumbers == nullptr || values == nullptr || values->Length < channelNumbers->Length)
+    {
+        throw ref new Platform::InvalidArgumentException(L"The values array must be at least as long as the channel array");
+    }
+
+    std::vector<ULONG> channels(channelNumbers->Length);
+    std::vector<ULONG> readings(channelNumbers->Length);
+    for (unsigned int i = 0; i < channelNumbers->Length; i++)
+    {
+        CheckChannelAcquired(channelNumbers[i]);
+        channels[i] = channelNumbers[i];
+    }
+
+    if (channels.empty())
+    {
+        return;
+    }
+
+    HRESULT hr;
+    {
+        std::lock_guard<std::mutex> lock(_adcLock);
+        hr = _addOnAdc->readBlock(channels.data(), (ULONG)channels.size(), readings.data());
+    }
+
+    if (FAILED(hr))
+    {
+        LightningProvider::ThrowError(hr, L"An error occurred reading the ADC.");
+    }
+
+    for (unsigned int i = 0; i < channelNumbers->Length; i++)
+    {
+        values[i] = ScaleValue(readings[i], MCP3008_ADC_BIT_RESOLUTION);
+    }
+}
+
+void LightningMCP3008AdcControllerProvider::StartStreaming(const Platform::Array<int>^ channelNumbers, double scansPerSecond, int scansPerBlock)
+{
+    if (channelNumbers == nullptr || channelNumbers->Length == 0 || channelNumbers->Length > ADC_SCAN_MAX_CHANNELS)
+    {
+        throw ref new Platform::InvalidArgumentException(L"Between 1 and 8 channels can be streamed");
+    }
+
+    if (scansPerSecond < 1 || scansPerBlock < 1 || scansPerBlock > (ADC_SCAN_RING_ENTRIES / 2))
+    {
+        throw ref new Platform::InvalidArgumentException(L"Invalid streaming rate or block size");
+    }
+
+    ULONG channels[ADC_SCAN_MAX_CHANNELS];
+    for (unsigned int i = 0; i < channelNumbers->Length; i++)
+    {
+        CheckChannelAcquired(channelNumbers[i]);
+        channels[i] = channelNumbers[i];
+    }
+
+    StopStreaming();
+
+    MCP3008Device* adc = _addOnAdc.get();
+    std::mutex* adcLock = &_adcLock;
+    HRESULT hr = _scanner.start(
+        [adc, adcLock](ULONG channel, ULONG & value, ULONG & bits)
+        {
+            std::lock_guard<std::mutex> lock(*adcLock);
+            return adc->readValue(channel, value, bits);
+        },
+        channels,
+        channelNumbers->Length,
+        (ULONG)(scansPerSecond + 0.5));
+
+    if (FAILED(hr))
+    {
+        LightningProvider::ThrowError(hr, L"An error occurred starting ADC streaming.");
+    }
+
+    _scansPerBlock = scansPerBlock;
+
+    // Check for complete blocks twice per block period, so a block waits at most half a
+    // period before it is delivered.
+    TimeSpan period;
+    period.Duration = (long long)((10000000.0 * scansPerBlock) / (scansPerSecond * 2));   // 100ns units
+    if (period.Duration < 10000)
+    {
+        period.Duration = 10000;
+    }
+
+    // Hold only a weak reference, so the timer does not keep the provider alive.
+    Platform::WeakReference weakThis(this);
+    _deliveryTimer = ThreadPoolTimer::CreatePeriodicTimer(ref new TimerElapsedHandler([weakThis](ThreadPoolTimer^ timer)
+    {
+        auto provider = weakThis.Resolve<LightningMCP3008AdcControllerProvider>();
+        if (provider == nullptr)
+        {
+            timer->Cancel();
+            return;
+        }
+
+        provider->DeliverBlocks();
+    }), period);
+}
+
+void LightningMCP3008AdcControllerProvider::StopStreaming()
+{
+    if (_deliveryTimer != nullptr)
+    {
+        _deliveryTimer->Cancel();
+        _deliveryTimer = nullptr;
+    }
+
+    // Wait for any delivery in progress on another thread (a SamplesAvailable handler
+    // may itself call StopStreaming).
+    std::lock_guard<std::recursive_mutex> lock(_deliveryLock);
+    _scanner.stop();
+}
+
+int LightningMCP3008AdcControllerProvider::StreamingOverrunCount::get()
+{
+    return (int)_scanner.getTotalOverrunCount();
+}
+
+// Raise SamplesAvailable for each complete block of scans the scanner has taken.
+void LightningMCP3008AdcControllerProvider::DeliverBlocks()
+{
+    ULONG channelCount = _scanner.getChannelCount();
+    ULONG scansPerBlock = (ULONG)_scansPerBlock;
+    std::vector<ULONG> readings(channelCount * scansPerBlock);
+    std::vector<ULONGLONG> timestamps(scansPerBlock);
+    LARGE_INTEGER frequency;
+
+    // Timer callbacks can overlap when a handler is slow; only one may drain the rings.
+    std::unique_lock<std::recursive_mutex> lock(_deliveryLock, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        return;
+    }
+
+    QueryPerformanceFrequency(&frequency);
 
-    // Scale the digitized analog value to the currently set analog read resolution.
+    while (_scanner.readScans(scansPerBlock, readings.data(), timestamps.data()) == S_OK)
+    {
+        auto values = ref new Platform::Array<int>(channelCount * scansPerBlock);
+        auto times = ref new Platform::Array<int64>(scansPerBlock);
+        for (ULONG scan = 0; scan < scansPerBlock; scan++)
+        {
+            for (ULONG slot = 0; slot < channelCount; slot++)
+            {
+                values[(scan * channelCount) + slot] = ScaleValue(readings[(scan * channelCount) + slot], _scanner.getBits(slot));
+            }
+            times[scan] = (int64)timestamps[scan];
+        }
+
+        SamplesAvailable(this, ref new LightningAdcSampleBlock(channelCount, scansPerBlock, values, times, frequency.QuadPart));
+    }
+}
+
+// Scale the digitized analog value to the currently set analog read resolution.
+int LightningMCP3008AdcControllerProvider::ScaleValue(ULONG value, ULONG bits)
+{
     if (_resolutionInBits > (int)bits)
     {
         value = value << (_resolutionInBits - (int)bits);
@@ -69,14 +230,29 @@ int LightningMCP3008AdcControllerProvider::ReadValue(int channelNumber)
     return (int)value;
 }
 
+void LightningMCP3008AdcControllerProvider::CheckChannelAcquired(int channelNumber)
+{
+    if (channelNumber < 0 || channelNumber >= MCP3008_ADC_CHANNEL_COUNT)
+    {
+        throw ref new Platform::InvalidArgumentException(L"Invalid channel number");
+    }
+
+    if (!_channelsAcquired[channelNumber])
+    {
+        throw ref new Platform::AccessDeniedException(L"Channel not acquired");
+    }
+}
+
 LightningMCP3008AdcControllerProvider::LightningMCP3008AdcControllerProvider() :
-    _resolutionInBits(MCP3008_ADC_BIT_RESOLUTION)
+    _resolutionInBits(MCP3008_ADC_BIT_RESOLUTION),
+    _scansPerBlock(0)
 {
     Initialize();
 }
 
 LightningMCP3008AdcControllerProvider::~LightningMCP3008AdcControllerProvider()
 {
+    StopStreaming();
     _addOnAdc->end();
 }
 
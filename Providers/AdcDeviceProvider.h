@@ -1,7 +1,9 @@
 // Copyright (c) Microsoft. All rights reserved.
 #pragma once
 
+#include <mutex>
 #include <MCP3008support.h>
+#include <AdcScanner.h>
 
 #define MCP3008_ADC_CHANNEL_COUNT 8
 #define MCP3008_ADC_MIN 0
@@ -26,6 +28,43 @@ namespace Microsoft {
                     static IAdcProvider^ providerSingleton;
                 };
 
+                // A block of samples taken by LightningMCP3008AdcControllerProvider::StartStreaming().
+                public ref class LightningAdcSampleBlock sealed
+                {
+                public:
+                    // The number of channels sampled in each scan.
+                    property int ChannelCount { int get() { return _channelCount; } }
+
+                    // The number of scans in the block.
+                    property int ScanCount { int get() { return _scanCount; } }
+
+                    // The number of timestamp counts per second.
+                    property int64 TimestampFrequency { int64 get() { return _timestampFrequency; } }
+
+                    // The readings, ordered by scan and then by the channel order given to StartStreaming().
+                    Platform::Array<int>^ GetValues() { return _values; }
+
+                    // The high resolution timer (QueryPerformanceCounter) reading at the start of each scan.
+                    Platform::Array<int64>^ GetTimestamps() { return _timestamps; }
+
+                internal:
+                    LightningAdcSampleBlock(int channelCount, int scanCount, Platform::Array<int>^ values, Platform::Array<int64>^ timestamps, int64 timestampFrequency) :
+                        _channelCount(channelCount),
+                        _scanCount(scanCount),
+                        _values(values),
+                        _timestamps(timestamps),
+                        _timestampFrequency(timestampFrequency)
+                    {
+                    }
+
+                private:
+                    int _channelCount;
+                    int _scanCount;
+                    Platform::Array<int>^ _values;
+                    Platform::Array<int64>^ _timestamps;
+                    int64 _timestampFrequency;
+                };
+
                 public ref class LightningMCP3008AdcControllerProvider sealed : public IAdcControllerProvider
                 {
                 public:
@@ -73,6 +112,21 @@ namespace Microsoft {
 
                     virtual int ReadValue(int channelNumber);
 
+                    // Read several acquired channels with one call, in one burst of SPI transfers.
+                    void ReadValues(const Platform::Array<int>^ channelNumbers, Platform::WriteOnlyArray<int>^ values);
+
+                    // Sample acquired channels at a fixed rate on a background thread, raising
+                    // SamplesAvailable each time scansPerBlock scans have been taken.
+                    void StartStreaming(const Platform::Array<int>^ channelNumbers, double scansPerSecond, int scansPerBlock);
+
+                    // Stop the sampling started by StartStreaming().
+                    void StopStreaming();
+
+                    // The number of samples dropped because blocks were not delivered in time.
+                    property int StreamingOverrunCount { int get(); }
+
+                    event TypedEventHandler<LightningMCP3008AdcControllerProvider^, LightningAdcSampleBlock^>^ SamplesAvailable;
+
                     virtual ~LightningMCP3008AdcControllerProvider();
 
                 internal:
@@ -84,7 +138,16 @@ namespace Microsoft {
                     int _resolutionInBits;
                     ProviderAdcChannelMode _channelMode;
 
+                    std::mutex _adcLock;            // Serializes use of _addOnAdc
+                    AdcScannerClass _scanner;
+                    int _scansPerBlock;
+                    std::recursive_mutex _deliveryLock;     // Held while blocks are being delivered
+                    Windows::System::Threading::ThreadPoolTimer^ _deliveryTimer;
+
                     void Initialize();
+                    int ScaleValue(ULONG value, ULONG bits);
+                    void CheckChannelAcquired(int channelNumber);
+                    void DeliverBlocks();
 
                 };
             }
@@ -259,12 +259,7 @@ void LightningPCA9685PwmControllerProvider::EnablePin(int pin)
 
     // Set the PWM duty cycle.
     ULONGLONG scaledDutyCycle = scaleDutyCycle(pwmPin->DutyCycle, pwmPin->InvertPolarity);
-    HRESULT hr = g_pins.setPwmDutyCycle(GetIoPin(pin), (ULONG)scaledDutyCycle);
-
-    if (FAILED(hr))
-    {
-        LightningProvider::ThrowError(hr, L"Could not enable PWM pin.");
-    }
+    WriteDutyCycle(pin, (ULONG)scaledDutyCycle, L"Could not enable PWM pin.");
 }
 
 void LightningPCA9685PwmControllerProvider::DisablePin(int pin)
@@ -273,32 +268,143 @@ void LightningPCA9685PwmControllerProvider::DisablePin(int pin)
     {
         throw ref new Platform::AccessDeniedException(L"Pin was not acquired");
     }
-    HRESULT hr = g_pins.setPwmDutyCycle(GetIoPin(pin), 0);
-    if (FAILED(hr))
-    {
-        LightningProvider::ThrowError(hr, L"Could not disable PWM pin.");
-    }
+    WriteDutyCycle(pin, 0, L"Could not disable PWM pin.");
 }
 
 void LightningPCA9685PwmControllerProvider::SetPulseParameters(int pin, double dutyCycle, bool invertPolarity)
 {
     // Set the PWM duty cycle.
     ULONGLONG scaledDutyCycle = scaleDutyCycle(dutyCycle, invertPolarity);
-    HRESULT hr = g_pins.setPwmDutyCycle(GetIoPin(pin), (ULONG)scaledDutyCycle);
+    WriteDutyCycle(pin, (ULONG)scaledDutyCycle, L"Could not set PWM pulse parameters.");
+
+    auto pwmPin = _pins->GetAt(pin);
+    pwmPin->DutyCycle = dutyCycle;
+    pwmPin->InvertPolarity = invertPolarity;
+}
+
+void LightningPCA9685PwmControllerProvider::DeferCommits::set(bool value)
+{
+    std::lock_guard<std::mutex> lock(_stagedLock);
+
+    _deferCommits = value;
+
+    // Anything staged is written when deferral is turned off.
+    if (!_deferCommits)
+    {
+        CommitStaged();
+    }
+}
+
+void LightningPCA9685PwmControllerProvider::Commit()
+{
+    std::lock_guard<std::mutex> lock(_stagedLock);
+    CommitStaged();
+}
+
+void LightningPCA9685PwmControllerProvider::SetAutoCommitRate(double commitsPerSecond)
+{
+    std::lock_guard<std::mutex> lock(_stagedLock);
+
+    if (_autoCommitTimer != nullptr)
+    {
+        _autoCommitTimer->Cancel();
+        _autoCommitTimer = nullptr;
+    }
+
+    if (commitsPerSecond > 0)
+    {
+        TimeSpan period;
+        period.Duration = (long long)(10000000.0 / commitsPerSecond);   // 100ns units
+        if (period.Duration < 1)
+        {
+            period.Duration = 1;
+        }
+
+        // Hold only a weak reference, so the timer does not keep the provider alive.
+        Platform::WeakReference weakThis(this);
+        _autoCommitTimer = ThreadPoolTimer::CreatePeriodicTimer(ref new TimerElapsedHandler([weakThis](ThreadPoolTimer^ timer)
+        {
+            auto provider = weakThis.Resolve<LightningPCA9685PwmControllerProvider>();
+            if (provider == nullptr)
+            {
+                timer->Cancel();
+                return;
+            }
+
+            try
+            {
+                provider->Commit();
+            }
+            catch (Platform::Exception^)
+            {
+                // The changes stay staged, and are retried on the next tick.
+            }
+        }), period);
+    }
+}
+
+// Set the duty cycle of a pin now, or stage it if commits are being deferred.
+void LightningPCA9685PwmControllerProvider::WriteDutyCycle(int pin, ULONG scaledDutyCycle, LPCWSTR errorMessage)
+{
+    std::lock_guard<std::mutex> lock(_stagedLock);
+
+    _dutyCycles[pin] = scaledDutyCycle;
+
+    if (_deferCommits)
+    {
+        _dirtyChannels |= (1UL << pin);
+    }
+    else
+    {
+        HRESULT hr = g_pins.setPwmDutyCycle(GetIoPin(pin), scaledDutyCycle);
+
+        if (FAILED(hr))
+        {
+            LightningProvider::ThrowError(hr, errorMessage);
+        }
+        _dirtyChannels &= ~(1UL << pin);
+    }
+}
+
+// Write the staged duty cycles to the chip.  The caller must hold _stagedLock.
+void LightningPCA9685PwmControllerProvider::CommitStaged()
+{
+    ULONG first = 0;
+    ULONG last = PCA9685_PIN_COUNT - 1;
+
+    if (_dirtyChannels == 0)
+    {
+        return;
+    }
+
+    // Cover every changed channel with one write.  Channels in the range that have not
+    // changed are masked off, so the chip driver leaves them alone, and the whole
+    // commit is one I2C transaction ending in a single STOP.
+    while ((_dirtyChannels & (1UL << first)) == 0)
+    {
+        first++;
+    }
+    while ((_dirtyChannels & (1UL << last)) == 0)
+    {
+        last--;
+    }
+
+    HRESULT hr = g_pins.setPwmDutyCycles(GetIoPin(first), last - first + 1, &_dutyCycles[first], _dirtyChannels >> first);
 
     if (FAILED(hr))
     {
-        LightningProvider::ThrowError(hr, L"Could not set PWM pulse parameters.");
+        LightningProvider::ThrowError(hr, L"Could not commit PWM pulse parameters.");
     }
 
-    auto pwmPin = _pins->GetAt(pin);
-    pwmPin->DutyCycle = dutyCycle;
-    pwmPin->InvertPolarity = invertPolarity;
+    _dirtyChannels = 0;
 }
 
 LightningPCA9685PwmControllerProvider::LightningPCA9685PwmControllerProvider() :
-    _desiredFrequency(MinFrequency)
+    _desiredFrequency(MinFrequency),
+    _deferCommits(false),
+    _dirtyChannels(0)
 {
+    ZeroMemory(_dutyCycles, sizeof(_dutyCycles));
     Initialize();
 }
 
@@ -1,6 +1,8 @@
 // Copyright (c) Microsoft. All rights reserved.
 #pragma once
 
+#include <mutex>
+
 using namespace Windows::Devices::Pwm::Provider;
 using namespace Windows::Devices::Gpio::Provider;
 
@@ -149,6 +151,22 @@ namespace Microsoft {
                     virtual void DisablePin(int pin);
                     virtual void SetPulseParameters(int pin, double dutyCycle, bool invertPolarity);
 
+                    // When true, pulse parameter changes are staged until Commit() is called
+                    // (or the auto-commit timer fires), then written to the chip in one I2C
+                    // transaction.  The chip updates its outputs on the STOP that ends the
+                    // transaction, so the staged changes all take effect together.
+                    property bool DeferCommits
+                    {
+                        bool get() { return _deferCommits; }
+                        void set(bool value);
+                    }
+
+                    // Write all staged pulse parameter changes to the chip in one I2C transaction.
+                    void Commit();
+
+                    // Commit staged changes automatically at the given rate (0 to stop).
+                    void SetAutoCommitRate(double commitsPerSecond);
+
                 internal:
                     LightningPCA9685PwmControllerProvider();
 
@@ -156,6 +174,12 @@ namespace Microsoft {
                     double _desiredFrequency;
                     Platform::Collections::Vector<LightningPCA9685PwmPin^>^ _pins;
 
+                    bool _deferCommits;
+                    ULONG _dutyCycles[PCA9685_PIN_COUNT];   // Latest scaled duty cycle of each channel
+                    ULONG _dirtyChannels;                   // Bit set for each channel not yet committed
+                    std::mutex _stagedLock;
+                    Windows::System::Threading::ThreadPoolTimer^ _autoCommitTimer;
+
                     property double Period
                     {
                         double get() { return 1000.0 / ActualFrequency; }
@@ -172,6 +196,9 @@ namespace Microsoft {
                         return (ULONGLONG)((invertPolarity ? 1 - dutyCycle : dutyCycle) * 0xFFFFFFFF);
                     }
 
+                    void WriteDutyCycle(int pin, ULONG scaledDutyCycle, LPCWSTR errorMessage);
+                    void CommitStaged();
+
                 };
             }
         }
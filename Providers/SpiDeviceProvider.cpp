@@ -12,6 +12,7 @@ using namespace Microsoft::IoT::Lightning::Providers;
 #pragma region LightningSpiProvider
 
 ISpiProvider^ LightningSpiProvider::providerSingleton = nullptr;
+bool LightningSpiProvider::hardwareChipSelectEnabled = false;
 
 ISpiProvider ^ LightningSpiProvider::GetSpiProvider()
 {
@@ -121,10 +122,21 @@ LightningSpiDeviceProvider::LightningSpiDeviceProvider(ProviderSpiConnectionSett
         }
     }
 
-    // Open the chip select pin
-    auto gpioControllerProvider = ref new LightningGpioControllerProvider();
-    _chipSelectPin = gpioControllerProvider->OpenPinProviderNoMapping(settings->ChipSelectLine, spiChipSelectPinMapped, ProviderGpioSharingMode::Exclusive);
-    _chipSelectPin->SetDriveMode(ProviderGpioPinDriveMode::Output);
+    // If asked to, have the SPI controller drive chip select itself if it can, so no
+    // GPIO calls are needed around each transfer.
+    bool hardwareChipSelect = false;
+    if (LightningSpiProvider::UseHardwareChipSelect)
+    {
+        hardwareChipSelect = SUCCEEDED(_SpiController->setHardwareChipSelect(settings->ChipSelectLine, spiChipSelectPinMapped, FALSE));
+    }
+
+    if (!hardwareChipSelect)
+    {
+        // Open the chip select pin
+        auto gpioControllerProvider = ref new LightningGpioControllerProvider();
+        _chipSelectPin = gpioControllerProvider->OpenPinProviderNoMapping(settings->ChipSelectLine, spiChipSelectPinMapped, ProviderGpioSharingMode::Exclusive);
+        _chipSelectPin->SetDriveMode(ProviderGpioPinDriveMode::Output);
+    }
 }
 
 
@@ -170,18 +182,23 @@ void LightningSpiDeviceProvider::TransferSequential(const Platform::Array<unsign
         throw ref new Platform::InvalidArgumentException(L"read or write buffer cannot be null.");
     }
 
-    HRESULT hr = TransferFullDuplexInternal(writeBuffer, nullptr);
+    // Send the write and the read as one message, so chip select stays asserted
+    // between them.
+    SPI_MESSAGE_SEGMENT segments[2];
+    ZeroMemory(segments, sizeof(segments));
 
-    if (FAILED(hr))
-    {
-        LightningProvider::ThrowError(hr, L"Could not write data to SPI device.");
-    }
+    segments[0].dataOut = writeBuffer->Data;
+    segments[0].bufferBytes = writeBuffer->Length;
+    segments[0].csHold = TRUE;
 
-    hr = TransferFullDuplexInternal(nullptr, readBuffer);
+    segments[1].dataIn = readBuffer->Data;
+    segments[1].bufferBytes = readBuffer->Length;
+
+    HRESULT hr = TransferMessageInternal(segments, ARRAYSIZE(segments));
 
     if (FAILED(hr))
     {
-        LightningProvider::ThrowError(hr, L"Could not read data from SPI device.");
+        LightningProvider::ThrowError(hr, L"Could not transfer data from SPI device.");
     }
 }
 
@@ -206,14 +223,54 @@ HRESULT LightningSpiDeviceProvider::TransferFullDuplexInternal(const Platform::A
     //  1) At least one of writeBuffer or ReadBuffer is valid
     //  2) If both read and write buffers are provided, they must have equal sizes
 
-    // Take the chip select low to select the device
-    _chipSelectPin->Write(ProviderGpioPinValue::Low);
+    // Take the chip select low to select the device (unless the controller does it)
+    if (_chipSelectPin != nullptr)
+    {
+        _chipSelectPin->Write(ProviderGpioPinValue::Low);
+    }
 
     UINT bufferLength = writeBuffer ? writeBuffer->Length : readBuffer->Length;
     HRESULT hr = _SpiController->transferBuffer(writeBuffer? writeBuffer->Data : nullptr, readBuffer ? readBuffer->Data : nullptr, bufferLength);
 
      //Regardless of the return result, take the chip select high to de-select the device
-    _chipSelectPin->Write(ProviderGpioPinValue::High);
+    if (_chipSelectPin != nullptr)
+    {
+        _chipSelectPin->Write(ProviderGpioPinValue::High);
+    }
+
+    return hr;
+}
+
+HRESULT LightningSpiDeviceProvider::TransferMessageInternal(const SPI_MESSAGE_SEGMENT* segments, ULONG segmentCount)
+{
+    HRESULT hr = S_OK;
+    ULONG frameStart = 0;
+    ULONG frameEnd;
+
+    // If the controller drives chip select, it handles the whole message.
+    if (_chipSelectPin == nullptr)
+    {
+        return _SpiController->transferMessage(segments, segmentCount);
+    }
+
+    // Otherwise send each run of segments that holds chip select as a separate
+    // message, with the chip select pin low for the duration of the run.
+    while (SUCCEEDED(hr) && (frameStart < segmentCount))
+    {
+        frameEnd = frameStart;
+        while ((frameEnd < (segmentCount - 1)) && segments[frameEnd].csHold)
+        {
+            frameEnd++;
+        }
+
+        _chipSelectPin->Write(ProviderGpioPinValue::Low);
+
+        hr = _SpiController->transferMessage(&segments[frameStart], (frameEnd - frameStart) + 1);
+
+        _chipSelectPin->Write(ProviderGpioPinValue::High);
+
+        frameStart = frameEnd + 1;
+    }
 
     return hr;
 }
@@ -16,9 +16,19 @@ namespace Microsoft {
                 public:
                     virtual IAsyncOperation<IVectorView<ISpiControllerProvider^>^>^ GetControllersAsync();
                     static ISpiProvider^ GetSpiProvider();
+
+                    // Set to true to have SPI devices opened after this use the controller's
+                    // own chip select line where the board supports it.  By default chip
+                    // select is driven as a GPIO pin.
+                    static property bool UseHardwareChipSelect
+                    {
+                        bool get() { return hardwareChipSelectEnabled; }
+                        void set(bool value) { hardwareChipSelectEnabled = value; }
+                    }
                 private:
                     LightningSpiProvider() { }
                     static ISpiProvider^ providerSingleton;
+                    static bool hardwareChipSelectEnabled;
                 };
 
                 public ref class LightningSpiControllerProvider sealed : public ISpiControllerProvider
@@ -65,6 +75,7 @@ namespace Microsoft {
                     IGpioPinProvider^ _chipSelectPin;
 
                     HRESULT TransferFullDuplexInternal(const Platform::Array<unsigned char> ^writeBuffer, Platform::WriteOnlyArray<unsigned char> ^readBuffer);
+                    HRESULT TransferMessageInternal(const SPI_MESSAGE_SEGMENT* segments, ULONG segmentCount);
 
                     inline USHORT flipShort(USHORT dataOut)
                     {
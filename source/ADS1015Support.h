@@ -10,18 +10,48 @@
 #include "I2c.h"
 #include "I2cTransaction.h"
 #include "I2cController.h"
+#include "HiResTimer.h"
+#include "BoardPins.h"
+
+/// The number of samples held for the caller while sampling on the ready signal.
+#define ADS1015_SAMPLE_RING_ENTRIES 512
+
+/// A reading taken when the ADC signaled a conversion was ready.
+typedef struct _ADS1015_SAMPLE
+{
+    ULONGLONG eventTime;        ///< High resolution timer captured shortly after the ready signal
+    ULONG channel;              ///< Number of the channel that was converted
+    ULONG value;                ///< The value read from the ADC, scaled as by readValue()
+} ADS1015_SAMPLE, *PADS1015_SAMPLE;
 
 class ADS1015Device
 {
 public:
     /// Constructor.
-    ADS1015Device()
+    ADS1015Device() :
+        m_continuous(FALSE),
+        m_dataRate(DR_MAX_SPS),
+        m_configValid(FALSE),
+        m_pointerAtConversion(FALSE),
+        m_readySampling(FALSE),
+        m_readyPin(0),
+        m_readyChannel(0),
+        m_nextSample(0),
+        m_sampleCount(0),
+        m_overrunCount(0),
+        m_missedReadyCount(0)
     {
+        m_configH.ALL_BITS = CONFIG_REG_INIT_H;
+        m_configL.ALL_BITS = CONFIG_REG_INIT_L;
+        InitializeCriticalSection(&m_lock);
+        InitializeCriticalSection(&m_sampleLock);
     }
 
     /// Destructor.
     virtual ~ADS1015Device()
     {
+        DeleteCriticalSection(&m_sampleLock);
+        DeleteCriticalSection(&m_lock);
     }
 
     /// Prepare to use this ADC.
@@ -36,118 +66,572 @@ public:
         
         hr = g_i2c.begin();
 
+        // Nothing is known about the ADC state until it has been written.
+        EnterCriticalSection(&m_lock);
+        m_configValid = FALSE;
+        m_pointerAtConversion = FALSE;
+        LeaveCriticalSection(&m_lock);
+
         return hr;
     }
 
     /// Release the ADC.
     inline void end()
     {
+        stopReadySampling();
+
+        EnterCriticalSection(&m_lock);
+
+        // If the ADC is converting continuously, return it to power-down (single-shot) mode.
+        if (m_continuous)
+        {
+            _stopContinuousConversions();
+        }
+        m_configValid = FALSE;
+        m_pointerAtConversion = FALSE;
+
+        LeaveCriticalSection(&m_lock);
+
         // Release the I2C controller.
         g_i2c.end();
     }
 
+    /// Select single-shot or continuous conversion mode.
+    /**
+    In single-shot mode (the default) each reading starts a conversion, waits for it
+    to complete, and then reads the result.  In continuous mode the channel and data
+    rate are programmed once and the ADC converts back-to-back, so a reading of the same
+    channel as the previous reading is a single read of the conversion register.  Changing
+    channels in continuous mode rewrites the configuration and waits for a conversion on
+    the new channel to complete.
+    \param[in] continuous TRUE to convert continuously, FALSE for single-shot conversions.
+    \return HRESULT success or error code.
+    */
+    inline HRESULT setContinuousMode(BOOL continuous)
+    {
+        HRESULT hr = S_OK;
+
+        EnterCriticalSection(&m_lock);
+
+        if (m_readySampling)
+        {
+            hr = DMAP_E_ADC_READY_SAMPLING_ACTIVE;
+        }
+        else if (continuous != m_continuous)
+        {
+            // Stop the conversions in progress when leaving continuous mode.
+            if (m_continuous)
+            {
+                hr = _stopContinuousConversions();
+            }
+            m_continuous = continuous;
+            m_configValid = FALSE;
+        }
+
+        LeaveCriticalSection(&m_lock);
+
+        return hr;
+    }
+
+    /// Determine whether the ADC is in continuous conversion mode.
+    inline BOOL isContinuousMode()
+    {
+        return m_continuous;
+    }
+
+    /// Set the rate at which the ADC performs conversions.
+    /**
+    The ADC supports only a fixed set of data rates (128 to 3300 samples per second).
+    The slowest supported rate that is at least as fast as the requested rate is used, 
+    or 3300 samples per second if the requested rate is higher than that.  The new rate
+    takes effect with the next conversion that is started, or the next time sampling on
+    the ready signal is started.
+    \param[in] samplesPerSecond The desired conversion rate.
+    */
+    inline void setDataRate(ULONG samplesPerSecond)
+    {
+        BYTE dataRate = DR_MAX_SPS;
+
+        for (BYTE dr = 0; dr < DR_MAX_SPS; dr++)
+        {
+            if (DATA_RATES[dr] >= samplesPerSecond)
+            {
+                dataRate = dr;
+                break;
+            }
+        }
+
+        EnterCriticalSection(&m_lock);
+        if (dataRate != m_dataRate)
+        {
+            m_dataRate = dataRate;
+            m_configValid = FALSE;
+        }
+        LeaveCriticalSection(&m_lock);
+    }
+
+    /// Get the rate at which the ADC performs conversions, in samples per second.
+    inline ULONG getDataRate()
+    {
+        return DATA_RATES[m_dataRate];
+    }
+
     /// Take a reading with the ADC used on the Ika Lure board.
     /**
     \param[in] channel Number of channel on ADC to read.
     \param[out] value The value read from the ADC.
     \param[out] bits The size of the reading in "value" in bits.
     \return HRESULT success or error code.
-    \note This routine is not multi-thread safe.  If two or more threads access the 
-    ADC at the same time, each thread could be changing the other thread's configuration 
-    (such as channel number).  A global mutex could be added to fix this.
+    \note Access to the ADC is serialized, so this routine can be called from more than
+    one thread.  It fails with DMAP_E_ADC_READY_SAMPLING_ACTIVE while the ADC is
+    sampling on its ready signal; use getSamples() instead.
     */
     inline HRESULT readValue(ULONG channel, ULONG & value, ULONG & bits)
     {
         HRESULT hr = S_OK;
         
-        BOOL conversionDone = FALSE;
+        BYTE mux = 0;
+        BYTE conversionData[2] = { 0 };
+
+        switch (channel)
+        {
+        case 0:
+            mux = ANI0;
+            break;
+        case 1:
+            mux = ANI1;
+            break;
+        case 2:
+            mux = ANI2;
+            break;
+        case 3:
+            mux = ANI3;
+            break;
+        default:
+            hr = DMAP_E_ADC_DOES_NOT_HAVE_REQUESTED_CHANNEL;
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            EnterCriticalSection(&m_lock);
+
+            if (m_readySampling)
+            {
+                hr = DMAP_E_ADC_READY_SAMPLING_ACTIVE;
+            }
+            else if (m_continuous)
+            {
+                hr = _readContinuous(mux, conversionData);
+            }
+            else
+            {
+                hr = _readSingleShot(mux, conversionData);
+            }
+
+            // After an error, the state of the ADC is unknown.
+            if (FAILED(hr) && (hr != DMAP_E_ADC_READY_SAMPLING_ACTIVE))
+            {
+                m_configValid = FALSE;
+                m_pointerAtConversion = FALSE;
+            }
+
+            LeaveCriticalSection(&m_lock);
+        }
+        
+        if (SUCCEEDED(hr))
+        {
+            value = _conversionToValue(conversionData);
+            bits = ADC_BITS;
+        }
+
+        
+        return hr;
+    }
+
+    /// Start sampling a channel each time the ADC signals a conversion is ready.
+    /**
+    The ADC comparator is configured as a conversion ready signal on its ALERT/RDY
+    pin, and the ADC converts the channel continuously at the current data rate.  Each
+    falling edge on the ready pin triggers a read of the Conversion Register (a single
+    two byte I2C read) from the GPIO interrupt callback, so the I2C bus is not used to
+    poll for completed conversions.  The samples are held in a ring buffer until they
+    are retrieved with getSamples().
+    \param[in] channel Number of channel on ADC to sample.
+    \param[in] readyPin Number of the board pin connected to the ADC ALERT/RDY pin.
+    \return HRESULT success or error code.
+    */
+    inline HRESULT startReadySampling(ULONG channel, ULONG readyPin)
+    {
+        HRESULT hr = S_OK;
+
+        BYTE mux = 0;
         CONFIG_REG_H configH;
         CONFIG_REG_L configL;
         I2cTransactionClass transaction;
-        BYTE configRegAdr[1] = { 1 };
-        BYTE configData[2] = { 0 };
-        BYTE conversionRegAdr[1] = { 0 };
-        BYTE conversionData[2] = { 0 };
-
-        //
-        // Build the Configuration Register contents.
-        //
+        BYTE hiThreshWrite[3] = { HI_THRESH_REG_ADR, 0x80, 0x00 };   // MSB set: ready mode
+        BYTE loThreshWrite[3] = { LO_THRESH_REG_ADR, 0x00, 0x00 };   // MSB clear: ready mode
+        BYTE configWrite[3] = { CONFIG_REG_ADR, 0, 0 };
+        BYTE conversionRegAdr[1] = { CONVERSION_REG_ADR };
+        BOOL attached = FALSE;
 
-        configH.ALL_BITS = CONFIG_REG_INIT_H;
-        configL.ALL_BITS = CONFIG_REG_INIT_L;
         switch (channel)
         {
         case 0:
-            configH.MUX = ANI0;
+            mux = ANI0;
             break;
         case 1:
-            configH.MUX = ANI1;
+            mux = ANI1;
             break;
         case 2:
-            configH.MUX = ANI2;
+            mux = ANI2;
             break;
         case 3:
-            configH.MUX = ANI3;
+            mux = ANI3;
             break;
         default:
             hr = DMAP_E_ADC_DOES_NOT_HAVE_REQUESTED_CHANNEL;
         }
 
+        if (SUCCEEDED(hr) && (readyPin > 0xFF))
+        {
+            hr = DMAP_E_PIN_NUMBER_TOO_LARGE_FOR_BOARD;
+        }
+
         if (SUCCEEDED(hr))
         {
-            configH.OS = 1;     // Signal to start a conversion
+            stopReadySampling();
+
+            EnterCriticalSection(&m_lock);
+
+            // Discard samples left from any previous sampling.
+            EnterCriticalSection(&m_sampleLock);
+            m_nextSample = 0;
+            m_sampleCount = 0;
+            m_overrunCount = 0;
+            m_missedReadyCount = 0;
+            LeaveCriticalSection(&m_sampleLock);
+
+            m_readyChannel = channel;
+            m_readyPin = readyPin;
+            m_readySampling = TRUE;
+
+            // Attach the interrupt before starting conversions so the first ready
+            // pulse is not missed.  The callback waits on m_lock until the ADC is set up.
+            hr = g_pins.attachInterruptContext((uint8_t)readyPin, _readyInterrupt, this, FALLING);
+
+            if (SUCCEEDED(hr))
+            {
+                attached = TRUE;
+
+                configH.ALL_BITS = CONFIG_REG_INIT_H;
+                configH.MODE = 0;       // Continuous conversion mode
+                configH.MUX = mux;
+                configL.ALL_BITS = CONFIG_REG_INIT_L;
+                configL.DR = m_dataRate;
+                configL.COMP_MODE = 0;  // Traditional comparator
+                configL.COMP_POL = 0;   // ALERT/RDY pulses low when a conversion is ready
+                configL.COMP_LAT = 0;   // Non-latching
+                configL.COMP_QUE = 0;   // Assert after every conversion
+                configWrite[1] = configH.ALL_BITS;
+                configWrite[2] = configL.ALL_BITS;
+
+                // Set the thresholds, start the conversions and leave the register
+                // pointer at the Conversion Register, all in one transaction.
+                hr = transaction.setAddress(ADC_I2C_ADR);
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                hr = transaction.queueWrite(hiThreshWrite, sizeof(hiThreshWrite));
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                hr = transaction.queueWrite(loThreshWrite, sizeof(loThreshWrite), TRUE);
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                hr = transaction.queueWrite(configWrite, sizeof(configWrite), TRUE);
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                hr = transaction.queueWrite(conversionRegAdr, 1, TRUE);
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                hr = transaction.execute(g_i2c.getController());
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                m_configH.ALL_BITS = configH.ALL_BITS;
+                m_configL.ALL_BITS = configL.ALL_BITS;
+                m_configValid = FALSE;      // Comparator settings differ from readValue()'s
+                m_pointerAtConversion = TRUE;
+            }
+            else
+            {
+                m_readySampling = FALSE;
+                m_configValid = FALSE;
+                m_pointerAtConversion = FALSE;
+            }
+
+            LeaveCriticalSection(&m_lock);
+
+            if (FAILED(hr) && attached)
+            {
+                g_pins.detachInterrupt((uint8_t)readyPin);
+            }
         }
 
-        //
-        // Send the configuration information to the ADC to start the conversion.
-        //
+        return hr;
+    }
 
-        if (SUCCEEDED(hr))
+    /// Stop sampling on the ADC ready signal.
+    /**
+    The ready interrupt is detached and the ADC is returned to single-shot mode with
+    the comparator disabled.  Samples that have not been retrieved remain available
+    from getSamples().
+    \return HRESULT success or error code.
+    */
+    inline HRESULT stopReadySampling()
+    {
+        HRESULT hr = S_OK;
+
+        BOOL wasSampling;
+        ULONG readyPin;
+        I2cTransactionClass transaction;
+        BYTE hiThreshWrite[3] = { HI_THRESH_REG_ADR, 0x7F, 0xFF };   // Power-on default
+        BYTE loThreshWrite[3] = { LO_THRESH_REG_ADR, 0x80, 0x00 };   // Power-on default
+        BYTE configWrite[3] = { CONFIG_REG_ADR, CONFIG_REG_INIT_H, CONFIG_REG_INIT_L };
+
+        // Mark sampling stopped first, so a callback that is already queued does nothing.
+        EnterCriticalSection(&m_lock);
+        wasSampling = m_readySampling;
+        readyPin = m_readyPin;
+        m_readySampling = FALSE;
+        LeaveCriticalSection(&m_lock);
+
+        if (wasSampling)
         {
-            hr = transaction.setAddress(ADC_I2C_ADR);
+            hr = g_pins.detachInterrupt((uint8_t)readyPin);
+
+            EnterCriticalSection(&m_lock);
+
+            HRESULT hr2 = transaction.setAddress(ADC_I2C_ADR);
+
+            if (SUCCEEDED(hr2))
+            {
+                hr2 = transaction.queueWrite(configWrite, sizeof(configWrite));
+            }
+
+            if (SUCCEEDED(hr2))
+            {
+                hr2 = transaction.queueWrite(hiThreshWrite, sizeof(hiThreshWrite), TRUE);
+            }
+
+            if (SUCCEEDED(hr2))
+            {
+                hr2 = transaction.queueWrite(loThreshWrite, sizeof(loThreshWrite), TRUE);
+            }
+
+            if (SUCCEEDED(hr2))
+            {
+                hr2 = transaction.execute(g_i2c.getController());
+            }
+
+            m_configValid = FALSE;
+            m_pointerAtConversion = FALSE;
+
+            LeaveCriticalSection(&m_lock);
+
+            if (SUCCEEDED(hr))
+            {
+                hr = hr2;
+            }
         }
 
-        if (SUCCEEDED(hr))
+        return hr;
+    }
+
+    /// Determine whether the ADC is sampling on its ready signal.
+    inline BOOL isReadySampling()
+    {
+        return m_readySampling;
+    }
+
+    /// Retrieve samples taken on the ADC ready signal, oldest first.
+    /**
+    \param[out] samples Buffer to receive the samples.
+    \param[in] maxSamples The number of samples the buffer can hold.
+    \param[out] sampleCount The number of samples placed in the buffer.
+    \return HRESULT success or error code.
+    */
+    inline HRESULT getSamples(PADS1015_SAMPLE samples, ULONG maxSamples, ULONG & sampleCount)
+    {
+        HRESULT hr = S_OK;
+
+        ULONG oldest;
+
+        sampleCount = 0;
+
+        if ((samples == nullptr) && (maxSamples > 0))
         {
-            // Send the address of the register we want to write.
-            hr = transaction.queueWrite(configRegAdr, 1);
+            hr = E_INVALIDARG;
         }
 
         if (SUCCEEDED(hr))
         {
-            configData[0] = configH.ALL_BITS;
-            configData[1] = configL.ALL_BITS;
+            EnterCriticalSection(&m_sampleLock);
+
+            oldest = (m_nextSample + ADS1015_SAMPLE_RING_ENTRIES - m_sampleCount) % ADS1015_SAMPLE_RING_ENTRIES;
+            while ((sampleCount < maxSamples) && (sampleCount < m_sampleCount))
+            {
+                samples[sampleCount] = m_samples[(oldest + sampleCount) % ADS1015_SAMPLE_RING_ENTRIES];
+                sampleCount++;
+            }
+            m_sampleCount -= sampleCount;
 
-            hr = transaction.queueWrite(configData, 2);
+            LeaveCriticalSection(&m_sampleLock);
         }
-        
-        if (SUCCEEDED(hr))
+
+        return hr;
+    }
+
+    /// Get the number of samples discarded because the ring buffer was full.
+    inline ULONG getOverrunCount()
+    {
+        return m_overrunCount;
+    }
+
+    /// Get the number of ready signals for which no sample could be read.
+    /**
+    This counts interrupts the driver reported as dropped, and ready signals for 
+    which the Conversion Register read failed.
+    */
+    inline ULONG getMissedReadyCount()
+    {
+        return m_missedReadyCount;
+    }
+
+    /// Callback for the falling edge of the ADC ALERT/RDY signal.
+    /**
+    \param[in] info Information about the interrupt from the GPIO driver.
+    \param[in] context Pointer to the ADS1015Device object that attached the interrupt.
+    \note This is attached to the ready pin by startReadySampling().  It is public so
+    it can also be called directly, to drive sampling without a GPIO interrupt.
+    */
+    static void _readyInterrupt(PDMAP_WAIT_INTERRUPT_NOTIFY_BUFFER info, PVOID context)
+    {
+        HRESULT hr = S_OK;
+
+        ADS1015Device* device = (ADS1015Device*)context;
+        BYTE conversionData[2] = { 0 };
+        ADS1015_SAMPLE sample;
+
+        EnterCriticalSection(&device->m_lock);
+
+        if (device->m_readySampling)
         {
-            hr = transaction.execute(g_i2c.getController());
+            hr = device->_readConversionRegister(conversionData);
+            if (FAILED(hr))
+            {
+                device->m_pointerAtConversion = FALSE;
+            }
+
+            EnterCriticalSection(&device->m_sampleLock);
+
+            device->m_missedReadyCount += info->DropCount;
+            if (FAILED(hr))
+            {
+                device->m_missedReadyCount++;
+            }
+            else if (device->m_sampleCount >= ADS1015_SAMPLE_RING_ENTRIES)
+            {
+                device->m_overrunCount++;
+            }
+            else
+            {
+                sample.eventTime = info->EventTime;
+                sample.channel = device->m_readyChannel;
+                sample.value = device->_conversionToValue(conversionData);
+                device->m_samples[device->m_nextSample] = sample;
+                device->m_nextSample = (device->m_nextSample + 1) % ADS1015_SAMPLE_RING_ENTRIES;
+                device->m_sampleCount++;
+            }
+
+            LeaveCriticalSection(&device->m_sampleLock);
         }
 
+        LeaveCriticalSection(&device->m_lock);
+    }
+
+private:
+
+    /// Start a single-shot conversion, wait for it to complete and read the result.
+    /**
+    \param[in] mux The input multiplexer value for the channel to read.
+    \param[out] conversionData The two bytes read from the Conversion Register.
+    \return HRESULT success or error code.
+    */
+    inline HRESULT _readSingleShot(BYTE mux, BYTE (&conversionData)[2])
+    {
+        HRESULT hr = S_OK;
+
+        BOOL conversionDone = FALSE;
+        CONFIG_REG_H configH;
+        CONFIG_REG_L configL;
+        I2cTransactionClass transaction;
+        BYTE configWrite[3] = { CONFIG_REG_ADR, 0, 0 };
+        BYTE configData[2] = { 0 };
+
+        configH.ALL_BITS = CONFIG_REG_INIT_H;
+        configH.MUX = mux;
+        configH.OS = 1;     // Signal to start a conversion
+        configL.ALL_BITS = CONFIG_REG_INIT_L;
+        configL.DR = m_dataRate;
+
         //
-        // Wait for the conversion to complete.
+        // Send the configuration information to the ADC to start the conversion.
         //
 
+        hr = transaction.setAddress(ADC_I2C_ADR);
+
         if (SUCCEEDED(hr))
         {
-            transaction.reset();
-            // Send the address of the register we want to read.
-            hr = transaction.queueWrite(configRegAdr, 1);
-            
+            configWrite[1] = configH.ALL_BITS;
+            configWrite[2] = configL.ALL_BITS;
+            hr = transaction.queueWrite(configWrite, sizeof(configWrite));
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            hr = transaction.execute(g_i2c.getController());
         }
 
         if (SUCCEEDED(hr))
         {
+            m_pointerAtConversion = FALSE;
+            m_configValid = FALSE;
+        }
+
+        //
+        // Wait for the conversion to complete.  The register pointer was left at the 
+        // Configuration Register by the write above, so each poll is a two byte read.
+        //
+
+        if (SUCCEEDED(hr))
+        {
+            transaction.reset();
             hr = transaction.queueRead(configData, 2);
-            
         }
 
         while (SUCCEEDED(hr) && !conversionDone)
         {
             hr = transaction.execute(g_i2c.getController());
-            
 
             if (SUCCEEDED(hr))
             {
@@ -165,46 +649,182 @@ public:
 
         if (SUCCEEDED(hr))
         {
-            transaction.reset();
+            hr = _readConversionRegister(conversionData);
+        }
+
+        return hr;
+    }
+
+    /// Read the latest result of continuous conversions on a channel.
+    /**
+    The configuration is only written when the channel or data rate has changed since
+    it was last written, in which case this method waits for a conversion on the new
+    channel to complete before reading the result.
+    \param[in] mux The input multiplexer value for the channel to read.
+    \param[out] conversionData The two bytes read from the Conversion Register.
+    \return HRESULT success or error code.
+    */
+    inline HRESULT _readContinuous(BYTE mux, BYTE (&conversionData)[2])
+    {
+        HRESULT hr = S_OK;
+
+        CONFIG_REG_H configH;
+        CONFIG_REG_L configL;
+        I2cTransactionClass transaction;
+        BYTE configWrite[3] = { CONFIG_REG_ADR, 0, 0 };
+        BYTE conversionRegAdr[1] = { CONVERSION_REG_ADR };
+        HiResTimerClass timer;
+
+        configH.ALL_BITS = CONFIG_REG_INIT_H;
+        configH.MODE = 0;   // Continuous conversion mode
+        configH.MUX = mux;
+        configL.ALL_BITS = CONFIG_REG_INIT_L;
+        configL.DR = m_dataRate;
+
+        if (!m_configValid ||
+            (configH.ALL_BITS != m_configH.ALL_BITS) ||
+            (configL.ALL_BITS != m_configL.ALL_BITS))
+        {
+            // Write the new configuration, then point back at the Conversion Register
+            // so following readings don't need to send a register address.
+            hr = transaction.setAddress(ADC_I2C_ADR);
+
+            if (SUCCEEDED(hr))
+            {
+                configWrite[1] = configH.ALL_BITS;
+                configWrite[2] = configL.ALL_BITS;
+                hr = transaction.queueWrite(configWrite, sizeof(configWrite));
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                hr = transaction.queueWrite(conversionRegAdr, 1, TRUE);
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                hr = transaction.execute(g_i2c.getController());
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                m_configH.ALL_BITS = configH.ALL_BITS;
+                m_configL.ALL_BITS = configL.ALL_BITS;
+                m_configValid = TRUE;
+                m_pointerAtConversion = TRUE;
+
+                // The Conversion Register still holds a result from the previous
+                // configuration until a full conversion on the new channel completes.
+                timer.StartTimeout(_conversionSettleMicroseconds());
+                while (!timer.TimeIsUp())
+                {
+                }
+            }
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            hr = _readConversionRegister(conversionData);
+        }
+
+        return hr;
+    }
+
+    /// Read the Conversion Register.
+    /**
+    The register address is only sent if the register pointer is not already
+    pointing at the Conversion Register.
+    \param[out] conversionData The two bytes read from the Conversion Register.
+    \return HRESULT success or error code.
+    */
+    inline HRESULT _readConversionRegister(BYTE (&conversionData)[2])
+    {
+        HRESULT hr = S_OK;
+
+        I2cTransactionClass transaction;
+        BYTE conversionRegAdr[1] = { CONVERSION_REG_ADR };
+
+        hr = transaction.setAddress(ADC_I2C_ADR);
+
+        if (SUCCEEDED(hr) && !m_pointerAtConversion)
+        {
             // Send the address of the register we want to read.
             hr = transaction.queueWrite(conversionRegAdr, 1);
-            
         }
 
         if (SUCCEEDED(hr))
         {
             hr = transaction.queueRead(conversionData, 2);
-            
         }
 
         if (SUCCEEDED(hr))
         {
             hr = transaction.execute(g_i2c.getController());
-            
         }
-        
+
         if (SUCCEEDED(hr))
         {
-            value = conversionData[0] << 8;
-            value = value | conversionData[1];
-            // Extract the reading from the data sent back from the ADC.
-            value = value >> DATA_SHIFT;
-            // This is a signed ADC, so make sure the result is not negative.
-            if ((value & (1 << ADC_BITS)) != 0)
-            {
-                value = 0;
-            }
-            // Scale the ADC for its full-scale value not being 5.000 volts.
-            value = ((value * FULL_SCALE) + 2500) / 5000;
+            m_pointerAtConversion = TRUE;
+        }
 
-            bits = ADC_BITS;
+        return hr;
+    }
+
+    /// Convert the contents of the Conversion Register to a reading.
+    inline ULONG _conversionToValue(const BYTE (&conversionData)[2])
+    {
+        ULONG value;
+
+        value = conversionData[0] << 8;
+        value = value | conversionData[1];
+        // Extract the reading from the data sent back from the ADC.
+        value = value >> DATA_SHIFT;
+        // This is a signed ADC, so make sure the result is not negative.
+        if ((value & (1 << ADC_BITS)) != 0)
+        {
+            value = 0;
         }
+        // Scale the ADC for its full-scale value not being 5.000 volts.
+        value = ((value * FULL_SCALE) + 2500) / 5000;
+
+        return value;
+    }
+
+    /// Return the ADC to single-shot mode, which powers down between conversions.
+    inline HRESULT _stopContinuousConversions()
+    {
+        HRESULT hr = S_OK;
+
+        I2cTransactionClass transaction;
+        BYTE configWrite[3] = { CONFIG_REG_ADR, CONFIG_REG_INIT_H, CONFIG_REG_INIT_L };
+
+        hr = transaction.setAddress(ADC_I2C_ADR);
+
+        if (SUCCEEDED(hr))
+        {
+            hr = transaction.queueWrite(configWrite, sizeof(configWrite));
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            hr = transaction.execute(g_i2c.getController());
+        }
+
+        m_configValid = FALSE;
+        m_pointerAtConversion = FALSE;
 
-        
         return hr;
     }
 
-private:
+    /// Get the time to wait after a configuration change for a valid conversion.
+    /**
+    This allows for the power-up time plus one full conversion period at the current
+    data rate, with a 10% margin for the tolerance of the ADC's internal oscillator.
+    */
+    inline ULONG _conversionSettleMicroseconds()
+    {
+        return 25 + ((1100000 + DATA_RATES[m_dataRate] - 1) / DATA_RATES[m_dataRate]);
+    }
 
     /// Struct for ADC Config Register (MSByte) contents.
     typedef union {
@@ -262,6 +882,70 @@ private:
     /// The mux value for single-ended input on AIN3.
     const BYTE ANI3 = 7;
 
+    /// The address of the Conversion Register.
+    static const BYTE CONVERSION_REG_ADR = 0;
+
+    /// The address of the Configuration Register.
+    static const BYTE CONFIG_REG_ADR = 1;
+
+    /// The address of the Lo_thresh Register.
+    static const BYTE LO_THRESH_REG_ADR = 2;
+
+    /// The address of the Hi_thresh Register.
+    static const BYTE HI_THRESH_REG_ADR = 3;
+
+    /// The data rate field value for the fastest rate (matches CONFIG_REG_INIT_L).
+    static const BYTE DR_MAX_SPS = 7;
+
+    /// The conversion rate in samples per second for each data rate field value.
+    const ULONG DATA_RATES[8] = { 128, 250, 490, 920, 1600, 2400, 3300, 3300 };
+
+    /// TRUE if the ADC is used in continuous conversion mode.
+    BOOL m_continuous;
+
+    /// The data rate field value used for conversions.
+    BYTE m_dataRate;
+
+    /// The continuous mode configuration last written to the ADC.
+    CONFIG_REG_H m_configH;
+    CONFIG_REG_L m_configL;
+
+    /// TRUE if m_configH and m_configL match what is programmed into the ADC.
+    BOOL m_configValid;
+
+    /// TRUE if the ADC register pointer is known to address the Conversion Register.
+    BOOL m_pointerAtConversion;
+
+    /// TRUE while the ADC is sampling on its ready signal.
+    BOOL m_readySampling;
+
+    /// The board pin connected to the ADC ALERT/RDY pin while sampling on it.
+    ULONG m_readyPin;
+
+    /// The channel sampled on the ready signal.
+    ULONG m_readyChannel;
+
+    /// Ring of samples taken on the ready signal.
+    ADS1015_SAMPLE m_samples[ADS1015_SAMPLE_RING_ENTRIES];
+
+    /// Index in m_samples where the next sample will be stored.
+    ULONG m_nextSample;
+
+    /// The number of samples in m_samples waiting to be retrieved.
+    ULONG m_sampleCount;
+
+    /// The number of samples discarded because m_samples was full.
+    ULONG m_overrunCount;
+
+    /// The number of ready signals for which no sample was read.
+    ULONG m_missedReadyCount;
+
+    /// Lock used to serialize access to the ADC and the cached state above.
+    RTL_CRITICAL_SECTION m_lock;
+
+    /// Lock used to serialize access to the sample ring and its counters.
+    RTL_CRITICAL_SECTION m_sampleLock;
+
 };
 
 #endif  // _ADS1015_SUPPORT_H_
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <Windows.h>
 #include "ADS1015Support.h"
 #include "MCP3008support.h"
+#include "AdcScanner.h"
 
 class AdcClass
 {
@@ -16,11 +17,14 @@ public:
     AdcClass()
     {
         m_boardType = BoardPinsClass::BOARD_TYPE::NOT_SET;
+        InitializeCriticalSection(&m_lock);
     }
 
     /// Destructor.
     virtual ~AdcClass()
     {
+        m_scanner.stop();
+
         if (m_boardType == BoardPinsClass::BOARD_TYPE::MBM_IKA_LURE)
         {
             m_ikaLureAdc.end();
@@ -33,6 +37,8 @@ public:
         {
             m_addOnAdc.end();
         }
+
+        DeleteCriticalSection(&m_lock);
     }
 
     /// Take a reading with the ADC on the board.
@@ -61,23 +67,80 @@ public:
  
         if (SUCCEEDED(hr))
         {
-            if (m_boardType == BoardPinsClass::BOARD_TYPE::MBM_IKA_LURE)
-            {
-                hr = m_ikaLureAdc.readValue(channel, value, bits);
-            }
-            else if (m_boardType == BoardPinsClass::BOARD_TYPE::MBM_BARE)
+            hr = _readChannel(channel, value, bits);
+        }
+        
+        return hr;
+    }
+
+    /// Start sampling a list of analog pins at a fixed rate on a background thread.
+    /**
+    Each scan reads the pins in the order given, and the scans are evenly spaced at
+    the requested rate.  The samples for each entry in the pin list are retrieved from
+    getScanner() by the index of the entry in the list.  Calls to readValue() can still
+    be made while scanning, and are interleaved with the scan reads.
+    \param[in] pins The analog pins (A0, A1, etc.) to read in each scan.
+    \param[in] pinCount The number of pins in the list (up to ADC_SCAN_MAX_CHANNELS).
+    \param[in] scansPerSecond The number of times per second to scan the pin list.
+    \return HRESULT success or error code.
+    */
+    inline HRESULT startScan(const ULONG* pins, ULONG pinCount, ULONG scansPerSecond)
+    {
+        HRESULT hr = S_OK;
+
+        ULONG channels[ADC_SCAN_MAX_CHANNELS];
+
+        if ((pins == nullptr) || (pinCount == 0) || (pinCount > ADC_SCAN_MAX_CHANNELS))
+        {
+            hr = E_INVALIDARG;
+        }
+
+        for (ULONG i = 0; SUCCEEDED(hr) && (i < pinCount); i++)
+        {
+            if (pins[i] < A0)
             {
-                hr = m_addOnAdc.readValue(channel, value, bits);
+                hr = DMAP_E_ADC_DOES_NOT_HAVE_REQUESTED_CHANNEL;
             }
-            else if (m_boardType == BoardPinsClass::BOARD_TYPE::PI2_BARE)
+            else
             {
-                hr = m_addOnAdc.readValue(channel, value, bits);
+                channels[i] = pins[i] - A0;
             }
         }
-        
+
+        if (SUCCEEDED(hr))
+        {
+            hr = _verifyAdcInitialized();
+        }
+
+        if (SUCCEEDED(hr) && (m_boardType == BoardPinsClass::BOARD_TYPE::NOT_SET))
+        {
+            hr = DMAP_E_BOARD_TYPE_NOT_RECOGNIZED;
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            hr = m_scanner.start(
+                [this](ULONG channel, ULONG & value, ULONG & bits) { return _readChannel(channel, value, bits); },
+                channels,
+                pinCount,
+                scansPerSecond);
+        }
+
         return hr;
     }
 
+    /// Stop the background sampling started by startScan().
+    inline void stopScan()
+    {
+        m_scanner.stop();
+    }
+
+    /// Get the scan sequencer, to retrieve its samples and counters.
+    inline AdcScannerClass & getScanner()
+    {
+        return m_scanner;
+    }
+
 private:
 
     /// The board type for which this object has been initialized.
@@ -95,6 +158,37 @@ private:
 
     MCP3008Device m_addOnAdc;
 
+    /// The scan sequencer used for background sampling.
+    AdcScannerClass m_scanner;
+
+    /// Lock used to serialize reads from the scan thread and other threads.
+    RTL_CRITICAL_SECTION m_lock;
+
+    /// Take a reading on an ADC channel with the ADC for this board.
+    inline HRESULT _readChannel(ULONG channel, ULONG & value, ULONG & bits)
+    {
+        HRESULT hr = S_OK;
+
+        EnterCriticalSection(&m_lock);
+
+        if (m_boardType == BoardPinsClass::BOARD_TYPE::MBM_IKA_LURE)
+        {
+            hr = m_ikaLureAdc.readValue(channel, value, bits);
+        }
+        else if (m_boardType == BoardPinsClass::BOARD_TYPE::MBM_BARE)
+        {
+            hr = m_addOnAdc.readValue(channel, value, bits);
+        }
+        else if (m_boardType == BoardPinsClass::BOARD_TYPE::PI2_BARE)
+        {
+            hr = m_addOnAdc.readValue(channel, value, bits);
+        }
+
+        LeaveCriticalSection(&m_lock);
+
+        return hr;
+    }
+
     /// Initialize this object if it has not already been done.
     inline HRESULT _verifyAdcInitialized()
     {
@@ -112,6 +206,13 @@ private:
                 if (m_boardType == BoardPinsClass::BOARD_TYPE::MBM_IKA_LURE)
                 {
                     hr = m_ikaLureAdc.begin();
+
+                    // Convert continuously so repeated readings of a channel are
+                    // a single I2C read.
+                    if (SUCCEEDED(hr))
+                    {
+                        hr = m_ikaLureAdc.setContinuousMode(TRUE);
+                    }
                 }
                 else if (m_boardType == BoardPinsClass::BOARD_TYPE::MBM_BARE)
                 {
@@ -0,0 +1,312 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "AdcScanner.h"
+#include "ErrorCodes.h"
+
+#if !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)  // If building a UWP app
+using namespace Windows::Foundation;
+using namespace Windows::System::Threading;
+#endif  // !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+
+// Time left before a scan (in microseconds) above which the scan thread waits on a
+// high resolution timer rather than spinning.  The timer is set to expire this long
+// before the scan, and the rest of the time is spent spinning.
+#define ADC_SCAN_SLEEP_THRESHOLD_US 2000
+
+// Time left before a scan (in microseconds) above which the scan thread calls Sleep()
+// when no high resolution timer is available.  Sleep() can last a full system timer
+// tick (15.6 ms by default), so it is only used when at least that much time is left.
+#define ADC_SCAN_TICK_SLEEP_THRESHOLD_US 20000
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+AdcScannerClass::AdcScannerClass() :
+    m_channelCount(0),
+    m_scansPerSecond(0),
+    m_rings(new AdcSampleRingClass[ADC_SCAN_MAX_CHANNELS]),
+    m_running(FALSE),
+    m_stopRequested(FALSE),
+    m_lateScans(0),
+    m_readErrors(0)
+{
+    m_hThreadDone = CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_ALL_ACCESS);
+}
+
+AdcScannerClass::~AdcScannerClass()
+{
+    stop();
+
+    if (m_hThreadDone != nullptr)
+    {
+        CloseHandle(m_hThreadDone);
+        m_hThreadDone = nullptr;
+    }
+}
+
+/**
+\param[in] readChannel Function used to read an ADC channel.
+\param[in] channels The ADC channel numbers to read in each scan.
+\param[in] channelCount The number of entries in the channel list.
+\param[in] scansPerSecond The number of times per second to scan the channel list.
+\return HRESULT success or error code.
+*/
+HRESULT AdcScannerClass::start(AdcReadFunction readChannel, const ULONG* channels, ULONG channelCount, ULONG scansPerSecond)
+{
+    HRESULT hr = S_OK;
+    ULONG value;
+
+    if (!readChannel || (channels == nullptr) || (channelCount == 0) ||
+        (channelCount > ADC_SCAN_MAX_CHANNELS) || (scansPerSecond == 0))
+    {
+        hr = E_INVALIDARG;
+    }
+
+    if (SUCCEEDED(hr) && (m_hThreadDone == nullptr))
+    {
+        hr = HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        stop();
+
+        m_readChannel = readChannel;
+        m_channelCount = channelCount;
+        m_scansPerSecond = scansPerSecond;
+        m_lateScans = 0;
+        m_readErrors = 0;
+
+        // Read each channel once to verify it and learn its reading size.
+        for (ULONG slot = 0; SUCCEEDED(hr) && (slot < channelCount); slot++)
+        {
+            m_channels[slot] = channels[slot];
+            m_rings[slot].reset();
+            hr = m_readChannel(m_channels[slot], value, m_bits[slot]);
+        }
+
+        if (FAILED(hr))
+        {
+            m_channelCount = 0;
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        m_stopRequested = FALSE;
+        m_running = TRUE;
+        ResetEvent(m_hThreadDone);
+
+#if !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)  // If building a UWP app
+        auto workItem = ref new WorkItemHandler([this](IAsyncAction^ workItem)
+        {
+            _scanLoop();
+        });
+
+        try
+        {
+            ThreadPool::RunAsync(workItem, WorkItemPriority::High, WorkItemOptions::TimeSliced);
+        }
+        catch (Platform::Exception^ e)
+        {
+            hr = e->HResult;
+            m_running = FALSE;
+        }
+#else
+        HANDLE hThread = CreateThread(nullptr, 0, [](LPVOID param) -> DWORD
+        {
+            ((AdcScannerClass*)param)->_scanLoop();
+            return 0;
+        }, this, 0, nullptr);
+
+        if (hThread == nullptr)
+        {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+            m_running = FALSE;
+        }
+        else
+        {
+            SetThreadPriority(hThread, THREAD_PRIORITY_HIGHEST);
+            CloseHandle(hThread);
+        }
+#endif  // !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    }
+
+    return hr;
+}
+
+void AdcScannerClass::stop()
+{
+    if (m_running)
+    {
+        m_stopRequested = TRUE;
+        WaitForSingleObjectEx(m_hThreadDone, INFINITE, FALSE);
+        m_running = FALSE;
+    }
+}
+
+/**
+Every slot is read in each scan, so a scan is complete once each slot has a sample
+for it.  Nothing is removed unless all the requested scans are complete.  The scans
+must only be retrieved by one thread at a time.
+\param[in] scanCount The number of scans to retrieve.
+\param[out] values Buffer for scanCount * getChannelCount() readings, ordered by scan
+and then by slot.
+\param[out] timestamps Buffer for the time each scan started, or nullptr.
+\return S_OK if the scans were retrieved, S_FALSE if fewer than scanCount complete
+scans are waiting, or an error code.
+*/
+HRESULT AdcScannerClass::readScans(ULONG scanCount, PULONG values, PULONGLONG timestamps)
+{
+    HRESULT hr = S_OK;
+    ADC_SCAN_SAMPLE sample;
+
+    if ((m_channelCount == 0) || (scanCount == 0) || (values == nullptr))
+    {
+        hr = E_INVALIDARG;
+    }
+
+    for (ULONG slot = 0; (hr == S_OK) && (slot < m_channelCount); slot++)
+    {
+        if (m_rings[slot].available() < scanCount)
+        {
+            hr = S_FALSE;
+        }
+    }
+
+    for (ULONG scan = 0; (hr == S_OK) && (scan < scanCount); scan++)
+    {
+        for (ULONG slot = 0; slot < m_channelCount; slot++)
+        {
+            m_rings[slot].pop(&sample, 1);
+            values[(scan * m_channelCount) + slot] = sample.value;
+            if ((slot == 0) && (timestamps != nullptr))
+            {
+                timestamps[scan] = sample.timestamp;
+            }
+        }
+    }
+
+    return hr;
+}
+
+// Scan the channel list at the requested rate until asked to stop.
+void AdcScannerClass::_scanLoop()
+{
+    HRESULT hr;
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    LONGLONG period;
+    LONGLONG nextScan;
+    LONGLONG behind;
+    LONGLONG sleepThreshold;
+    LARGE_INTEGER dueTime;
+    HANDLE hTimer;
+    ADC_SCAN_SAMPLE sample;
+    ULONG bits;
+
+    // Waits on a high resolution timer end within a fraction of a millisecond of the
+    // requested time.  Older versions of Windows don't have them.
+    hTimer = CreateWaitableTimerEx(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+    QueryPerformanceFrequency(&frequency);
+    if (hTimer != nullptr)
+    {
+        sleepThreshold = (ADC_SCAN_SLEEP_THRESHOLD_US * frequency.QuadPart) / 1000000LL;
+    }
+    else
+    {
+        sleepThreshold = (ADC_SCAN_TICK_SLEEP_THRESHOLD_US * frequency.QuadPart) / 1000000LL;
+    }
+
+    period = (frequency.QuadPart + (m_scansPerSecond / 2)) / m_scansPerSecond;
+    if (period == 0)
+    {
+        period = 1;
+    }
+
+    QueryPerformanceCounter(&now);
+    nextScan = now.QuadPart;
+
+    while (!m_stopRequested)
+    {
+        // Wait for the start time of the next scan.
+        QueryPerformanceCounter(&now);
+        while ((now.QuadPart < nextScan) && !m_stopRequested)
+        {
+            if ((nextScan - now.QuadPart) > sleepThreshold)
+            {
+                if (hTimer != nullptr)
+                {
+                    // Wake up the threshold time before the scan, or after 10 ms so a
+                    // stop request is seen promptly.  The due time is in 100 ns units,
+                    // negative for a relative time.
+                    dueTime.QuadPart = ((nextScan - now.QuadPart - sleepThreshold) * 10000000LL) / frequency.QuadPart;
+                    if (dueTime.QuadPart > 100000LL)
+                    {
+                        dueTime.QuadPart = 100000LL;
+                    }
+                    dueTime.QuadPart = -dueTime.QuadPart;
+                    if (SetWaitableTimer(hTimer, &dueTime, 0, nullptr, nullptr, FALSE))
+                    {
+                        WaitForSingleObjectEx(hTimer, INFINITE, FALSE);
+                    }
+                }
+                else
+                {
+                    Sleep(1);
+                }
+            }
+            else
+            {
+                YieldProcessor();
+            }
+            QueryPerformanceCounter(&now);
+        }
+
+        if (m_stopRequested)
+        {
+            break;
+        }
+
+        // Read each channel in the list.
+        for (ULONG slot = 0; slot < m_channelCount; slot++)
+        {
+            QueryPerformanceCounter(&now);
+            sample.timestamp = now.QuadPart;
+
+            hr = m_readChannel(m_channels[slot], sample.value, bits);
+
+            if (SUCCEEDED(hr))
+            {
+                m_rings[slot].push(sample);
+            }
+            else
+            {
+                m_readErrors++;
+            }
+        }
+
+        // Schedule the next scan, skipping any that can no longer be done on time.
+        nextScan += period;
+        QueryPerformanceCounter(&now);
+        behind = now.QuadPart - nextScan;
+        if (behind >= period)
+        {
+            m_lateScans += (ULONG)(behind / period);
+            nextScan += (behind / period) * period;
+        }
+    }
+
+    if (hTimer != nullptr)
+    {
+        CloseHandle(hTimer);
+    }
+
+    SetEvent(m_hThreadDone);
+}
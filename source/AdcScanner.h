@@ -0,0 +1,301 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#ifndef _ADC_SCANNER_H_
+#define _ADC_SCANNER_H_
+
+#include <Windows.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "Lightning.h"
+
+/// The maximum number of entries in the channel list of a scan.
+#define ADC_SCAN_MAX_CHANNELS 8
+
+/// The number of samples each channel's ring buffer holds (must be a power of two).
+#define ADC_SCAN_RING_ENTRIES 1024
+
+/// A sample taken by the ADC scan sequencer.
+typedef struct _ADC_SCAN_SAMPLE
+{
+    ULONGLONG timestamp;        ///< High resolution timer reading just before the conversion
+    ULONG value;                ///< The value read from the ADC
+} ADC_SCAN_SAMPLE, *PADC_SCAN_SAMPLE;
+
+/// Function used by the scan sequencer to take a reading on one ADC channel.
+/**
+The parameters and return value are the same as the readValue() method of the ADC
+device classes, for example MCP3008Device and ADS1015Device.
+*/
+typedef std::function<HRESULT(ULONG channel, ULONG & value, ULONG & bits)> AdcReadFunction;
+
+/// Ring of samples written by the scan thread and read by one consumer thread.
+/**
+No lock is used: the scan thread only advances m_head and the consumer only advances
+m_tail.  When the ring is full, new samples are discarded and counted as overruns.
+*/
+class AdcSampleRingClass
+{
+public:
+    /// Constructor.
+    AdcSampleRingClass() :
+        m_head(0),
+        m_tail(0),
+        m_overruns(0)
+    {
+    }
+
+    /// Discard all samples and zero the overrun count.
+    /**
+    Must not be called while the scan thread is running.
+    */
+    inline void reset()
+    {
+        m_head.store(0);
+        m_tail.store(0);
+        m_overruns.store(0);
+    }
+
+    /// Add a sample to the ring (scan thread only).
+    /**
+    \param[in] sample The sample to add.
+    \return TRUE if the sample was added, FALSE if the ring was full.
+    */
+    inline BOOL push(const ADC_SCAN_SAMPLE & sample)
+    {
+        ULONG head = m_head.load(std::memory_order_relaxed);
+        ULONG tail = m_tail.load(std::memory_order_acquire);
+
+        if ((head - tail) >= ADC_SCAN_RING_ENTRIES)
+        {
+            m_overruns.fetch_add(1, std::memory_order_relaxed);
+            return FALSE;
+        }
+
+        m_samples[head & (ADC_SCAN_RING_ENTRIES - 1)] = sample;
+        m_head.store(head + 1, std::memory_order_release);
+        return TRUE;
+    }
+
+    /// Remove samples from the ring, oldest first (consumer thread only).
+    /**
+    \param[out] samples Buffer to receive the samples.
+    \param[in] maxSamples The number of samples the buffer can hold.
+    \return The number of samples placed in the buffer.
+    */
+    inline ULONG pop(PADC_SCAN_SAMPLE samples, ULONG maxSamples)
+    {
+        ULONG tail = m_tail.load(std::memory_order_relaxed);
+        ULONG head = m_head.load(std::memory_order_acquire);
+        ULONG count = head - tail;
+
+        if (count > maxSamples)
+        {
+            count = maxSamples;
+        }
+
+        for (ULONG i = 0; i < count; i++)
+        {
+            samples[i] = m_samples[(tail + i) & (ADC_SCAN_RING_ENTRIES - 1)];
+        }
+
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    /// Get the number of samples waiting in the ring.
+    inline ULONG available() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    /// Get the number of samples discarded because the ring was full.
+    inline ULONG overruns() const
+    {
+        return m_overruns.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    /// Count of samples ever added.
+    std::atomic<ULONG> m_head;
+
+    /// Count of samples ever removed.
+    std::atomic<ULONG> m_tail;
+
+    /// Count of samples discarded because the ring was full.
+    std::atomic<ULONG> m_overruns;
+
+    /// The sample storage.
+    ADC_SCAN_SAMPLE m_samples[ADC_SCAN_RING_ENTRIES];
+};
+
+/// Class that samples a list of ADC channels at a fixed rate on a dedicated thread.
+/**
+Each scan reads every channel in the list in order.  Scans start at evenly spaced
+times derived from the high resolution timer, so the sample spacing does not drift
+with the time taken by the reads.  If a scan starts more than one scan period late,
+the scans that could not be performed are skipped and counted rather than run
+back-to-back.  Each entry in the channel list (a "slot") has its own ring buffer.
+*/
+class AdcScannerClass
+{
+public:
+    /// Constructor.
+    LIGHTNING_DLL_API AdcScannerClass();
+
+    /// Destructor.
+    LIGHTNING_DLL_API virtual ~AdcScannerClass();
+
+    /// Start scanning.
+    /**
+    Each channel is read once before the scan thread is started, to check that the
+    channel exists and to learn the size of its readings.
+    \param[in] readChannel Function used to read an ADC channel.
+    \param[in] channels The ADC channel numbers to read in each scan.
+    \param[in] channelCount The number of entries in the channel list.
+    \param[in] scansPerSecond The number of times per second to scan the channel list.
+    \return HRESULT success or error code.
+    */
+    LIGHTNING_DLL_API HRESULT start(AdcReadFunction readChannel, const ULONG* channels, ULONG channelCount, ULONG scansPerSecond);
+
+    /// Stop scanning and wait for the scan thread to exit.
+    /**
+    Samples that have not been read remain available until scanning is started again.
+    */
+    LIGHTNING_DLL_API void stop();
+
+    /// Determine whether the scan thread is running.
+    inline BOOL isRunning() const
+    {
+        return m_running.load();
+    }
+
+    /// Get the number of entries in the channel list.
+    inline ULONG getChannelCount() const
+    {
+        return m_channelCount;
+    }
+
+    /// Get the ADC channel number read in a slot of the channel list.
+    inline ULONG getChannel(ULONG slot) const
+    {
+        return (slot < m_channelCount) ? m_channels[slot] : 0;
+    }
+
+    /// Get the size in bits of the readings in a slot.
+    inline ULONG getBits(ULONG slot) const
+    {
+        return (slot < m_channelCount) ? m_bits[slot] : 0;
+    }
+
+    /// Retrieve samples taken for one slot of the channel list, oldest first.
+    /**
+    Samples for a given slot must only be retrieved by one thread at a time.
+    \param[in] slot The index of the entry in the channel list.
+    \param[out] samples Buffer to receive the samples.
+    \param[in] maxSamples The number of samples the buffer can hold.
+    \param[out] sampleCount The number of samples placed in the buffer.
+    \return HRESULT success or error code.
+    */
+    inline HRESULT readSamples(ULONG slot, PADC_SCAN_SAMPLE samples, ULONG maxSamples, ULONG & sampleCount)
+    {
+        sampleCount = 0;
+
+        if ((slot >= m_channelCount) || ((samples == nullptr) && (maxSamples > 0)))
+        {
+            return E_INVALIDARG;
+        }
+
+        sampleCount = m_rings[slot].pop(samples, maxSamples);
+        return S_OK;
+    }
+
+    /// Get the number of samples waiting to be retrieved for a slot.
+    inline ULONG available(ULONG slot) const
+    {
+        return (slot < m_channelCount) ? m_rings[slot].available() : 0;
+    }
+
+    /// Retrieve complete scans, oldest first.
+    LIGHTNING_DLL_API HRESULT readScans(ULONG scanCount, PULONG values, PULONGLONG timestamps);
+
+    /// Get the number of samples discarded for a slot because its ring buffer was full.
+    inline ULONG getOverrunCount(ULONG slot) const
+    {
+        return (slot < m_channelCount) ? m_rings[slot].overruns() : 0;
+    }
+
+    /// Get the number of samples discarded for all slots because their ring buffers were full.
+    inline ULONG getTotalOverrunCount() const
+    {
+        ULONG overruns = 0;
+
+        for (ULONG slot = 0; slot < m_channelCount; slot++)
+        {
+            overruns += m_rings[slot].overruns();
+        }
+        return overruns;
+    }
+
+    /// Get the number of scans skipped because the scan thread fell behind.
+    inline ULONG getLateScanCount() const
+    {
+        return m_lateScans.load();
+    }
+
+    /// Get the number of channel reads that failed during scanning.
+    inline ULONG getReadErrorCount() const
+    {
+        return m_readErrors.load();
+    }
+
+    /// Get the scan rate in use, in scans per second.
+    inline ULONG getScanRate() const
+    {
+        return m_scansPerSecond;
+    }
+
+private:
+
+    /// The function used to read a channel.
+    AdcReadFunction m_readChannel;
+
+    /// The channel list.
+    ULONG m_channels[ADC_SCAN_MAX_CHANNELS];
+
+    /// The size in bits of the readings for each slot.
+    ULONG m_bits[ADC_SCAN_MAX_CHANNELS];
+
+    /// The number of entries in the channel list.
+    ULONG m_channelCount;
+
+    /// The scan rate in scans per second.
+    ULONG m_scansPerSecond;
+
+    /// The sample ring for each slot.
+    std::unique_ptr<AdcSampleRingClass[]> m_rings;
+
+    /// TRUE while the scan thread is running.
+    std::atomic<BOOL> m_running;
+
+    /// Set to ask the scan thread to exit.
+    std::atomic<BOOL> m_stopRequested;
+
+    /// Count of scans skipped because the scan thread fell behind.
+    std::atomic<ULONG> m_lateScans;
+
+    /// Count of failed channel reads.
+    std::atomic<ULONG> m_readErrors;
+
+    /// Event signaled when the scan thread exits.
+    HANDLE m_hThreadDone;
+
+    /// The body of the scan thread.
+    void _scanLoop();
+};
+
+#endif  // _ADC_SCANNER_H_
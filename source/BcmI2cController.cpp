@@ -51,63 +51,99 @@ HRESULT BcmI2cControllerClass::configurePins(ULONG sdaPin, ULONG sclPin)
 }
 
 // Method to initialize the I2C Controller at the start of a transaction.
-HRESULT BcmI2cControllerClass::_initializeForTransaction(ULONG slaveAddress, BOOL useHighSpeed)
+HRESULT BcmI2cControllerClass::_initializeForTransaction(ULONG slaveAddress, ULONG clockHz)
 {
+    HRESULT hr = S_OK;
     _C controlReg;
     _S statusReg;
     _DIV divReg;
+    _DEL delReg;
     _A addressReg;
     _CLKT clktReg;
+    ULONG cdiv = 0;
+    ULONG fedl = 0;
+    ULONG redl = 0;
+
+
+    // Calculate the smallest even divider that does not exceed the requested clock rate.
+    if ((clockHz == 0) || (clockHz > I2C_FAST_MODE_PLUS_HZ))
+    {
+        hr = DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        cdiv = (BSC_CORE_CLOCK_HZ + clockHz - 1) / clockHz;
+        cdiv = (cdiv + 1) & ~1UL;
+        if (cdiv > CDIV_MAX)
+        {
+            hr = DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED;
+        }
+    }
+
+    if (FAILED(hr))
+    {
+        return hr;
+    }
 
+    // Sample and drive data a fixed fraction of an SCL period from the clock
+    // edges, so the data timing scales with the selected clock rate.
+    fedl = cdiv / 16;
+    if (fedl == 0)
+    {
+        fedl = 1;
+    }
+    redl = cdiv / 4;
+    if (redl == 0)
+    {
+        redl = 1;
+    }
 
     // Disable the controller and controller interrupts.
     controlReg.ALL_BITS = 0;
-    m_registers->C.ALL_BITS = controlReg.ALL_BITS;
+    _writeReg(BSC_C_OFFSET, controlReg.ALL_BITS);
 
     // Clear status bits that may be set from a previous transaction.
     statusReg.ALL_BITS = 0;
     statusReg.CLKT = 1;
     statusReg.ERR = 1;
     statusReg.DONE = 1;
-    m_registers->S.ALL_BITS = statusReg.ALL_BITS;
+    _writeReg(BSC_S_OFFSET, statusReg.ALL_BITS);
 
     // Clear the RX and TX FIFOS.
     controlReg.CLEAR = 3;
-    m_registers->C.ALL_BITS = controlReg.ALL_BITS;
+    _writeReg(BSC_C_OFFSET, controlReg.ALL_BITS);
 
     // Wait for the controller to go idle.
-    while (m_registers->S.TA == 1);
+    _waitForStatus([](_S status) { return status.TA == 0; });
 
     // Set the desired I2C Clock speed.
-    if (useHighSpeed)
-    {
-        divReg.ALL_BITS = m_registers->DIV.ALL_BITS;
-        divReg.ALL_BITS &= _DIV_USED_MASK;
-        divReg.CDIV = CDIV_400KHZ;
-        m_registers->DIV.ALL_BITS = divReg.ALL_BITS;
-    }
-    else
-    {
-        divReg.ALL_BITS = m_registers->DIV.ALL_BITS;
-        divReg.ALL_BITS &= _DIV_USED_MASK;
-        divReg.CDIV = CDIV_100KHZ;
-        m_registers->DIV.ALL_BITS = divReg.ALL_BITS;
-    }
+    divReg.ALL_BITS = _readReg(BSC_DIV_OFFSET);
+    divReg.ALL_BITS &= _DIV_USED_MASK;
+    divReg.CDIV = cdiv;
+    _writeReg(BSC_DIV_OFFSET, divReg.ALL_BITS);
+
+    delReg.ALL_BITS = 0;
+    delReg.FEDL = fedl;
+    delReg.REDL = redl;
+    _writeReg(BSC_DEL_OFFSET, delReg.ALL_BITS);
+
+    m_actualClockHz = BSC_CORE_CLOCK_HZ / cdiv;
 
     // Set the address of the slave this tranaction affects.
-    addressReg.ALL_BITS = m_registers->A.ALL_BITS;
+    addressReg.ALL_BITS = _readReg(BSC_A_OFFSET);
     addressReg.ALL_BITS &= _A_USED_MASK;
     addressReg.ADDR = slaveAddress & 0x7F;
-    m_registers->A.ALL_BITS = addressReg.ALL_BITS;
+    _writeReg(BSC_A_OFFSET, addressReg.ALL_BITS);
 
     // Disable bus slave timeouts.
     clktReg.ALL_BITS = 0;
-    m_registers->CLKT.ALL_BITS = clktReg.ALL_BITS;
+    _writeReg(BSC_CLKT_OFFSET, clktReg.ALL_BITS);
 
     // Enable the controller.
     controlReg.ALL_BITS = 0;
     controlReg.I2CEN = 1;
-    m_registers->C.ALL_BITS = controlReg.ALL_BITS;
+    _writeReg(BSC_C_OFFSET, controlReg.ALL_BITS);
 
     return S_OK;
 }
@@ -120,6 +156,12 @@ HRESULT BcmI2cControllerClass::_mapController()
     PWCHAR deviceName = nullptr;
 
 
+    // There is nothing to map if the controller is being run against a register model.
+    if (m_registerAccess != nullptr)
+    {
+        return S_OK;
+    }
+
     if (SUCCEEDED(hr))
     {
         switch (m_busNumber)
@@ -218,9 +260,8 @@ HRESULT BcmI2cControllerClass::_performWrites(I2cTransferClass* & pXfr)
     I2cTransferClass* cmdXfr = nullptr;
     I2cTransferClass* tmpXfr = nullptr;
     LONG cmdsOutstanding = 0;
-    UCHAR outByte;
+    UCHAR lastByte;
     _S sReg;
-    _C cReg;
 
 
     // Calculate the total number of bytes we will be writing in this set of transfers.
@@ -240,6 +281,8 @@ HRESULT BcmI2cControllerClass::_performWrites(I2cTransferClass* & pXfr)
         tmpXfr = tmpXfr->getNextTransfer();
     }
 
+    // A write can't be split into segments: the restart would re-send the slave
+    // address and the slave would take the next bytes as a new register address.
     if (cmdsOutstanding > m_maxTransferBytes)
     {
         hr = DMAP_E_I2C_TRANSFER_LENGTH_OVER_MAX;
@@ -250,66 +293,17 @@ HRESULT BcmI2cControllerClass::_performWrites(I2cTransferClass* & pXfr)
         // Prepare to access the cmd buffer.
         cmdXfr->resetCmd();
 
-        // Tell the controller how many bytes we expect to write.
-        m_registers->DLEN.ALL_BITS = cmdsOutstanding;
-
-        // Prepare for the writes.
-        sReg.ALL_BITS = 0;
-        sReg.CLKT = 1;
-        sReg.DONE = 1;
-        sReg.ERR = 1;
-        m_registers->S.ALL_BITS = sReg.ALL_BITS;
-
-        // Slave address has already been set.
-        cReg.ALL_BITS = m_registers->C.ALL_BITS;
-        cReg.ALL_BITS &= _C_USED_MASK;
-        cReg.READ = 0;
-        m_registers->C.ALL_BITS = cReg.ALL_BITS;
-
-        // Start the transfer.
-        cReg.ST = 1;
-        m_registers->C.ALL_BITS = cReg.ALL_BITS;
-    }
-
-    // While we have more bytes to write:
-    while (SUCCEEDED(hr) && (cmdXfr != nullptr) && (cmdsOutstanding > 0))
-    {
-        while (SUCCEEDED(hr) && (cmdXfr->getNextCmd(outByte)))
-        {
-            // Wait for at least one empty space in the TX FIFO.
-            while (SUCCEEDED(hr) && txFifoFull())
-            {
-                sReg.ALL_BITS = m_registers->S.ALL_BITS;
-                if (sReg.ERR == 1)
-                {
-                    hr = E_FAIL;
-                }
-            }
-
-            if (SUCCEEDED(hr))
-            {
-                // Write the byte.
-                m_registers->FIFO.ALL_BITS = outByte;
-
-                // Count the byte we sent.
-                cmdsOutstanding--;
-            }
-        }
+        // Start the write.
+        _startSegment(cmdsOutstanding, FALSE);
 
-        if (SUCCEEDED(hr))
-        {
-            // Get the next transfer in the transaction if there is one.
-            cmdXfr = cmdXfr->getNextTransfer();
-        }
+        // Write the bytes.
+        hr = _writeBytes(cmdXfr, cmdsOutstanding, FALSE, lastByte);
     }
 
     if (SUCCEEDED(hr))
     {
         // Wait for the writes to complete.
-        do
-        {
-            sReg.ALL_BITS = m_registers->S.ALL_BITS;
-        } while (sReg.DONE == 0);
+        sReg = _waitForStatus([](_S status) { return status.DONE == 1; });
     }
 
     // Determine if an error occurred.
@@ -343,11 +337,8 @@ HRESULT BcmI2cControllerClass::_performReads(I2cTransferClass* & pXfr)
     HRESULT hr = S_OK;
     I2cTransferClass* tmpXfr = nullptr;
     I2cTransferClass* readXfr = nullptr;
-    PUCHAR readPtr = nullptr;
     LONG cmdsOutstanding = 0;
-    UCHAR inByte;
     _S sReg;
-    _C cReg;
 
     // Calculate the total number of bytes we will be reading in this set of transfers.
     readXfr = pXfr;
@@ -366,83 +357,24 @@ HRESULT BcmI2cControllerClass::_performReads(I2cTransferClass* & pXfr)
         tmpXfr = tmpXfr->getNextTransfer();
     }
     // tmpXfr is left with the address of the terminating transfer (if any).
-    
-    if (cmdsOutstanding > m_maxTransferBytes)
-    {
-        hr = DMAP_E_I2C_TRANSFER_LENGTH_OVER_MAX;
-    }
 
     if (SUCCEEDED(hr))
     {
         // Prepare to access the read buffer.
         readXfr->resetRead();
-        readPtr = readXfr->getNextReadLocation();
-
-        // Tell the controller how many bytes we expect to read.
-        m_registers->DLEN.ALL_BITS = cmdsOutstanding;
-
-        // Prepare for the reads.
-        sReg.ALL_BITS = 0;
-        sReg.CLKT = 1;
-        sReg.DONE = 1;
-        sReg.ERR = 1;
-        m_registers->S.ALL_BITS = sReg.ALL_BITS;
-
-        // Slave address has already been set.
-        cReg.ALL_BITS = m_registers->C.ALL_BITS;
-        cReg.ALL_BITS &= _C_USED_MASK;
-        cReg.READ = 1;
-        m_registers->C.ALL_BITS = cReg.ALL_BITS;
-
-        // Start the transfer.
-        cReg.ST = 1;
-        m_registers->C.ALL_BITS = cReg.ALL_BITS;
-    }
-
-    // While we have more bytes to read:
-    while (SUCCEEDED(hr) && (readXfr != nullptr) && (cmdsOutstanding > 0))
-    {
-        // Wait for at least one byte to be available in the RX FIFO.
-        while (SUCCEEDED(hr) && rxFifoEmpty())
-        {
-            sReg.ALL_BITS = m_registers->S.ALL_BITS;
-            if (sReg.ERR == 1)
-            {
-                hr = E_FAIL;
-            }
-        }
 
-        if (SUCCEEDED(hr))
-        {
-            // Read a byte from the I2C Controller.
-            inByte = readByte();
-            cmdsOutstanding--;
+        // Start the first (and usually only) segment of the read.
+        _startSegment(_segmentLength(cmdsOutstanding), TRUE);
 
-            // Store the byte if we have a place for it.
-            if (readPtr != nullptr)
-            {
-                *readPtr = inByte;
-
-                // Figure out where the next byte should go.
-                readPtr = readXfr->getNextReadLocation();
-                while ((readPtr == nullptr) && (readXfr->getNextTransfer() != nullptr))
-                {
-                    readXfr = readXfr->getNextTransfer();
-                    readXfr->resetRead();
-                    readPtr = readXfr->getNextReadLocation();
-                }
-            }
-        }
+        // Read the bytes, chaining on further segments as needed.
+        hr = _readSegments(readXfr, cmdsOutstanding);
     }
 
     if (SUCCEEDED(hr))
     {
-        // Wait for the reads to complete.
-        do
-        {
-            sReg.ALL_BITS = m_registers->S.ALL_BITS;
-        }
-        while (sReg.DONE == 0);
+        // Wait for the reads to complete.  DONE may also have been set at a segment
+        // boundary, so wait for the transfer to go inactive as well.
+        sReg = _waitForStatus([](_S status) { return (status.DONE == 1) && (status.TA == 0); });
     }
 
     // Determine if an error occurred.
@@ -476,13 +408,10 @@ HRESULT BcmI2cControllerClass::_performWriteRead(I2cTransferClass* & pXfr)
     HRESULT hr = S_OK;
     I2cTransferClass* cmdXfr = nullptr;
     I2cTransferClass* tmpXfr = nullptr;
-    PUCHAR readPtr = nullptr;
     LONG writesOutstanding = 0;
     LONG readsOutstanding = 0;
     UCHAR outByte;
-    UCHAR inByte;
     _S sReg;
-    _C cReg;
 
 
     cmdXfr = pXfr;
@@ -513,7 +442,8 @@ HRESULT BcmI2cControllerClass::_performWriteRead(I2cTransferClass* & pXfr)
         hr = DMAP_E_DMAP_INTERNAL_ERROR;
     }
 
-    if ((writesOutstanding > m_maxTransferBytes) || (readsOutstanding > m_maxTransferBytes))
+    // Only the read part of the sequence can be split into segments.
+    if (SUCCEEDED(hr) && (writesOutstanding > m_maxTransferBytes))
     {
         hr = DMAP_E_I2C_TRANSFER_LENGTH_OVER_MAX;
     }
@@ -524,66 +454,14 @@ HRESULT BcmI2cControllerClass::_performWriteRead(I2cTransferClass* & pXfr)
 
     if (SUCCEEDED(hr))
     {
-        // Tell the controller the number of bytes we expect to write.
-        m_registers->DLEN.ALL_BITS = writesOutstanding;
-
-        // Prepare for the write transfer.
-        sReg.ALL_BITS = 0;
-        sReg.CLKT = 1;
-        sReg.DONE = 1;
-        sReg.ERR = 1;
-        m_registers->S.ALL_BITS = sReg.ALL_BITS;
-        // Slave address has already been set.
-        cReg.ALL_BITS = m_registers->C.ALL_BITS;
-        cReg.ALL_BITS &= _C_USED_MASK;
-        cReg.READ = 0;
-        m_registers->C.ALL_BITS = cReg.ALL_BITS;
-
-        // Start the transfer.
-        cReg.ST = 1;
-        m_registers->C.ALL_BITS = cReg.ALL_BITS;
+        // Start the write.
+        _startSegment(writesOutstanding, FALSE);
 
         // Wait for the transfer to be active.
-        while (m_registers->S.TA == 0);
-
-        // While we have more bytes to write:
-        while (SUCCEEDED(hr) && (cmdXfr != nullptr) && (writesOutstanding > 0))
-        {
-            while (SUCCEEDED(hr) && (cmdXfr->getNextCmd(outByte)))
-            {
-                // If this is not the last byte to write:
-                if (writesOutstanding > 1)
-                {
-                    // Wait for at least one empty space in the TX FIFO.
-                    while (SUCCEEDED(hr) && txFifoFull())
-                    {
-                        sReg.ALL_BITS = m_registers->S.ALL_BITS;
-                        if (sReg.ERR == 1)
-                        {
-                            hr = E_FAIL;
-                        }
-                    }
-
-                    if (SUCCEEDED(hr))
-                    {
-                        // Write the byte.
-                        m_registers->FIFO.ALL_BITS = outByte;
-                    }
-                }
-
-                if (SUCCEEDED(hr))
-                {
-                    // Count the byte as sent.
-                    writesOutstanding--;
-                }
-            }
+        _waitForStatus([](_S status) { return status.TA == 1; });
 
-            if (SUCCEEDED(hr))
-            {
-                // Get the next transfer in the transaction, there should be one.
-                cmdXfr = cmdXfr->getNextTransfer();
-            }
-        }
+        // Write all but the last byte.
+        hr = _writeBytes(cmdXfr, writesOutstanding, TRUE, outByte);
     }
     // At this point, on success, outByte contains the last byte to write and cmdXfr
     // has the addresss of the first read transfer that follows the writes.
@@ -594,94 +472,251 @@ HRESULT BcmI2cControllerClass::_performWriteRead(I2cTransferClass* & pXfr)
 
     if (SUCCEEDED(hr))
     {
-        // Tell the controller the number of bytes we expect to read.
-        m_registers->DLEN.ALL_BITS = readsOutstanding;
-
-        // Prepare and start the read transfer.
-        cReg.ALL_BITS = m_registers->C.ALL_BITS;
-        cReg.ALL_BITS &= _C_USED_MASK;
-        cReg.READ = 1;
-        cReg.ST = 1;
-        m_registers->C.ALL_BITS = cReg.ALL_BITS;
+        // Queue the first read segment so it follows the writes with a restart.
+        _chainSegment(_segmentLength(readsOutstanding), TRUE);
 
         // Wait for at least one empty space in the TX FIFO.
-        while (SUCCEEDED(hr) && txFifoFull())
-        {
-            sReg.ALL_BITS = m_registers->S.ALL_BITS;
-            if (sReg.ERR == 1)
-            {
-                hr = E_FAIL;
-            }
-        }
+        hr = _waitForTxSpace();
 
         // Write the last byte so the write phase completes.
         if (SUCCEEDED(hr))
         {
             // Write the byte.
-            m_registers->FIFO.ALL_BITS = outByte;
+            _writeReg(BSC_FIFO_OFFSET, outByte);
 
             // Indicate the current transfer is the first to read into.
             cmdXfr->resetRead();
-            readPtr = cmdXfr->getNextReadLocation();
 
             // Wait for the controller to enter a read state.
-            do
-            {
-                sReg.ALL_BITS = m_registers->S.ALL_BITS;
-            }
-            while (sReg.TA == 1);
+            _waitForStatus([](_S status) { return status.TA == 0; });
 
             // Clear the DONE status for cleanliness.
             sReg.ALL_BITS = 0;
             sReg.DONE = 1;
-            m_registers->S.ALL_BITS = sReg.ALL_BITS;
+            _writeReg(BSC_S_OFFSET, sReg.ALL_BITS);
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            hr = _readSegments(cmdXfr, readsOutstanding);
         }
 
-        while (SUCCEEDED(hr) && (readsOutstanding > 0))
+        if (SUCCEEDED(hr))
+        {
+            // Wait for the reads to complete, so the STOP has been sent before any
+            // following transfer is started.  DONE may also have been set at a read
+            // segment boundary, so wait for the transfer to go inactive as well.
+            sReg = _waitForStatus([](_S status) { return (status.DONE == 1) && (status.TA == 0); });
+        }
+    }
+
+    // Determine if an error occured on this transaction.
+    if (SUCCEEDED(hr))
+    {
+        hr = _handleErrors();
+    }
+
+    // Pass the next transfer pointer back to the caller.
+    pXfr = tmpXfr;
+
+    return hr;
+}
+
+// Clear status and start a new transfer segment on the I2C bus.
+void BcmI2cControllerClass::_startSegment(LONG byteCount, BOOL isRead)
+{
+    _S sReg;
+
+    // Prepare for the transfer.
+    sReg.ALL_BITS = 0;
+    sReg.CLKT = 1;
+    sReg.DONE = 1;
+    sReg.ERR = 1;
+    _writeReg(BSC_S_OFFSET, sReg.ALL_BITS);
+
+    // Tell the controller the number of bytes to transfer, and start the transfer.
+    // Slave address has already been set.
+    _chainSegment(byteCount, isRead);
+}
+
+/**
+Queue a transfer segment to follow the current one.  If a segment is still in
+progress, the controller ends it with a restart rather than a STOP, and the new
+segment begins immediately.  This must only be called while the current segment
+is stalled waiting for the caller (TX FIFO empty with bytes still to send, or RX
+FIFO full with bytes still to receive), so it can not complete before the new
+length has been set.
+\param[in] byteCount Number of bytes in the new segment.
+\param[in] isRead TRUE for a read segment, FALSE for a write segment.
+*/
+void BcmI2cControllerClass::_chainSegment(LONG byteCount, BOOL isRead)
+{
+    _C cReg;
+
+    // Tell the controller the number of bytes to transfer.
+    _writeReg(BSC_DLEN_OFFSET, byteCount);
+
+    // Set the transfer direction and start the transfer.
+    cReg.ALL_BITS = _readReg(BSC_C_OFFSET);
+    cReg.ALL_BITS &= _C_USED_MASK;
+    cReg.READ = isRead ? 1 : 0;
+    _writeReg(BSC_C_OFFSET, cReg.ALL_BITS);
+    cReg.ST = 1;
+    _writeReg(BSC_C_OFFSET, cReg.ALL_BITS);
+}
+
+/**
+Write bytes from a chain of transfers to the TX FIFO.  The write must already have
+been started, with no more bytes than DLEN can describe.
+\param[in,out] cmdXfr The first transfer to write from.  On return, the transfer
+that follows the last one written.
+\param[in,out] writesOutstanding Number of bytes to write.  On return, the number
+of bytes not written (zero on success).
+\param[in] holdLastByte TRUE to return the final byte instead of writing it.
+\param[out] lastByte The final byte, if holdLastByte is TRUE.
+\return HRESULT success or error code.
+*/
+HRESULT BcmI2cControllerClass::_writeBytes(I2cTransferClass* & cmdXfr, LONG & writesOutstanding, BOOL holdLastByte, UCHAR & lastByte)
+{
+    HRESULT hr = S_OK;
+    UCHAR outByte;
+
+    // While we have more bytes to write:
+    while (SUCCEEDED(hr) && (cmdXfr != nullptr) && (writesOutstanding > 0))
+    {
+        while (SUCCEEDED(hr) && (cmdXfr->getNextCmd(outByte)))
         {
-            // Wait for at least one byte to be available in the RX FIFO.
-            while (SUCCEEDED(hr) && rxFifoEmpty())
+            if (holdLastByte && (writesOutstanding == 1))
+            {
+                // Keep the last byte for the caller, which stalls the controller.
+                lastByte = outByte;
+            }
+            else
             {
-                sReg.ALL_BITS = m_registers->S.ALL_BITS;
-                if (sReg.ERR == 1)
+                // Wait for at least one empty space in the TX FIFO.
+                hr = _waitForTxSpace();
+
+                if (SUCCEEDED(hr))
                 {
-                    hr = E_FAIL;
+                    // Write the byte.
+                    _writeReg(BSC_FIFO_OFFSET, outByte);
                 }
             }
 
             if (SUCCEEDED(hr))
             {
-                // Read a byte from the I2C Controller.
-                inByte = readByte();
-                readsOutstanding--;
+                // Count the byte as sent.
+                writesOutstanding--;
+            }
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            // Get the next transfer in the transaction if there is one.
+            cmdXfr = cmdXfr->getNextTransfer();
+        }
+    }
+
+    return hr;
+}
+
+/**
+Read bytes from the RX FIFO directly into a chain of read transfers.  The first
+segment must already have been started.  Reads longer than DLEN can describe are
+split into segments, each joined to the one before it with a restart that sends
+the slave address again.  This suits slaves that carry on a sequential read from
+where the last one stopped (EEPROMs and most register-addressed devices), but a
+slave that restarts its data on each read will return the start of its data again
+at each segment boundary.
+\param[in] readXfr The first transfer to read into, with its read location reset.
+\param[in,out] readsOutstanding Number of bytes to read.  On return, the number of
+bytes not read (zero on success).
+\return HRESULT success or error code.
+*/
+HRESULT BcmI2cControllerClass::_readSegments(I2cTransferClass* readXfr, LONG & readsOutstanding)
+{
+    HRESULT hr = S_OK;
+    LONG segmentOutstanding = _segmentLength(readsOutstanding);
+    LONG nextSegment = 0;
+    PUCHAR readPtr = readXfr->getNextReadLocation();
+    UCHAR inByte;
+    _S sReg;
+
+    // While we have more bytes to read:
+    while (SUCCEEDED(hr) && (readXfr != nullptr) && (readsOutstanding > 0))
+    {
+        // If more bytes follow this segment, leave the RX FIFO full so the controller
+        // stalls short of the end of the segment, then queue the next segment.
+        if ((nextSegment == 0) && (segmentOutstanding == (BSC_FIFO_BYTES + 1)) && (readsOutstanding > segmentOutstanding))
+        {
+            sReg = _waitForStatus([](_S status) { return (status.RXF == 1) || (status.ERR == 1); });
+            if (sReg.ERR == 1)
+            {
+                hr = E_FAIL;
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                nextSegment = _segmentLength(readsOutstanding - segmentOutstanding);
+                _chainSegment(nextSegment, TRUE);
+            }
+        }
+
+        // Wait for at least one byte to be available in the RX FIFO.
+        if (SUCCEEDED(hr))
+        {
+            sReg = _waitForStatus([](_S status) { return (status.RXD == 1) || (status.ERR == 1); });
+            if (sReg.RXD == 0)
+            {
+                hr = E_FAIL;
+            }
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            // Read a byte from the I2C Controller.
+            inByte = readByte();
+            readsOutstanding--;
+
+            // Move on to the next segment when this one is done.
+            segmentOutstanding--;
+            if (segmentOutstanding == 0)
+            {
+                segmentOutstanding = nextSegment;
+                nextSegment = 0;
+            }
 
-                // Store the byte if we have a place for it.
-                if (readPtr != nullptr)
+            // Store the byte if we have a place for it.
+            if (readPtr != nullptr)
+            {
+                *readPtr = inByte;
+
+                // Figure out where the next byte should go.
+                readPtr = readXfr->getNextReadLocation();
+                while ((readPtr == nullptr) && (readXfr->getNextTransfer() != nullptr))
                 {
-                    *readPtr = inByte;
-
-                    // Figure out where the next byte should go.
-                    readPtr = cmdXfr->getNextReadLocation();
-                    while ((readPtr == nullptr) && (cmdXfr->getNextTransfer() != nullptr))
-                    {
-                        cmdXfr = cmdXfr->getNextTransfer();
-                        cmdXfr->resetRead();
-                        readPtr = cmdXfr->getNextReadLocation();
-                    }
+                    readXfr = readXfr->getNextTransfer();
+                    readXfr->resetRead();
+                    readPtr = readXfr->getNextReadLocation();
                 }
             }
         }
     }
 
-    // Determine if an error occured on this transaction.
-    if (SUCCEEDED(hr))
+    return hr;
+}
+
+// Wait for at least one empty space in the TX FIFO.
+HRESULT BcmI2cControllerClass::_waitForTxSpace()
+{
+    HRESULT hr = S_OK;
+    _S sReg;
+
+    sReg = _waitForStatus([](_S status) { return (status.TXD == 1) || (status.ERR == 1); });
+    if (sReg.TXD == 0)
     {
-        hr = _handleErrors();
+        hr = E_FAIL;
     }
 
-    // Pass the next transfer pointer back to the caller.
-    pXfr = tmpXfr;
-
     return hr;
 }
-
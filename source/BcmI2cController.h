@@ -11,6 +11,34 @@
 #include "I2cTransfer.h"
 #include "I2cController.h"
 
+// Byte offsets of the BCM2836 I2C (BSC) Controller registers.
+#define BSC_C_OFFSET    0x00
+#define BSC_S_OFFSET    0x04
+#define BSC_DLEN_OFFSET 0x08
+#define BSC_A_OFFSET    0x0C
+#define BSC_FIFO_OFFSET 0x10
+#define BSC_DIV_OFFSET  0x14
+#define BSC_DEL_OFFSET  0x18
+#define BSC_CLKT_OFFSET 0x1C
+
+//
+// Interface used to substitute a software model for the BCM2836 I2C Controller
+// registers, so the controller code can be run and measured without hardware.
+//
+class BcmI2cRegisterAccessClass
+{
+public:
+    virtual ~BcmI2cRegisterAccessClass()
+    {
+    }
+
+    /// Method to read the 32-bit register at a byte offset from the controller base.
+    virtual ULONG readRegister(ULONG offset) = 0;
+
+    /// Method to write the 32-bit register at a byte offset from the controller base.
+    virtual void writeRegister(ULONG offset, ULONG value) = 0;
+};
+
 //
 // Class that is used to interact with the BCM2836 I2C Controller hardware.
 //
@@ -18,7 +46,8 @@ class BcmI2cControllerClass : public I2cControllerClass
 {
 public:
     BcmI2cControllerClass() :
-        m_registers(nullptr)
+        m_registers(nullptr),
+        m_registerAccess(nullptr)
     {
     }
 
@@ -46,7 +75,24 @@ public:
     LIGHTNING_DLL_API HRESULT configurePins(ULONG sdaPin, ULONG sclPin) override;
 
     // Method to initialize the I2C Controller at the start of a transaction.
-    LIGHTNING_DLL_API HRESULT _initializeForTransaction(ULONG slaveAddress, BOOL useHighSpeed) override;
+    LIGHTNING_DLL_API HRESULT _initializeForTransaction(ULONG slaveAddress, ULONG clockHz) override;
+
+    /// Method to run this controller against a software register model.
+    /**
+    When a register model is set, all register reads and writes go to the model
+    instead of the controller hardware, and the hardware is not mapped.
+    \param[in] registerAccess The register model, or nullptr to use the hardware.
+    */
+    void setRegisterAccess(BcmI2cRegisterAccessClass* registerAccess)
+    {
+        m_registerAccess = registerAccess;
+    }
+
+    /// Determine whether this controller is running against a software register model.
+    BOOL hasRegisterModel() const override
+    {
+        return (m_registerAccess != nullptr);
+    }
 
     //
     // I2C Controller accessor methods.  These methods assume the I2C Controller
@@ -55,34 +101,46 @@ public:
 
     BOOL txFifoFull() const override
     {
-        return (m_registers->S.TXD == 0);
+        _S sReg;
+        sReg.ALL_BITS = _readReg(BSC_S_OFFSET);
+        return (sReg.TXD == 0);
     }
 
     BOOL txFifoEmpty() const override
     {
-        return (m_registers->S.TXE == 1);
+        _S sReg;
+        sReg.ALL_BITS = _readReg(BSC_S_OFFSET);
+        return (sReg.TXE == 1);
     }
 
     BOOL rxFifoNotEmtpy() const override
     {
-        return (m_registers->S.RXD == 1);
+        _S sReg;
+        sReg.ALL_BITS = _readReg(BSC_S_OFFSET);
+        return (sReg.RXD == 1);
     }
 
     BOOL rxFifoEmpty() const override
     {
-        return (m_registers->S.RXD == 0);
+        _S sReg;
+        sReg.ALL_BITS = _readReg(BSC_S_OFFSET);
+        return (sReg.RXD == 0);
     }
 
     LIGHTNING_DLL_API HRESULT _performContiguousTransfers(I2cTransferClass* & pXfr) override;
 
     UCHAR readByte() override
     {
-        return (m_registers->FIFO.DATA);
+        _FIFO fifoReg;
+        fifoReg.ALL_BITS = _readReg(BSC_FIFO_OFFSET);
+        return (UCHAR)fifoReg.DATA;
     }
 
     BOOL isActive() const override
     {
-        return (m_registers->S.TA == 1);
+        _S sReg;
+        sReg.ALL_BITS = _readReg(BSC_S_OFFSET);
+        return (sReg.TA == 1);
     }
 
     /// Determine whether a TX Error has occurred or not.
@@ -94,7 +152,7 @@ public:
     BOOL errorOccurred() override
     {
         _S sReg;
-        sReg.ALL_BITS = m_registers->S.ALL_BITS;
+        sReg.ALL_BITS = _readReg(BSC_S_OFFSET);
         return (sReg.ERR == 1);
     }
 
@@ -107,7 +165,9 @@ public:
     */
     BOOL addressWasNacked() override
     {
-        return (m_registers->S.ERR == 1);
+        _S sReg;
+        sReg.ALL_BITS = _readReg(BSC_S_OFFSET);
+        return (sReg.ERR == 1);
     }
 
     /// Determine if I2C data was sent but not acknowledged by a slave.
@@ -171,7 +231,7 @@ public:
         statusReg.ALL_BITS = 0;
         statusReg.CLKT = 1;
         statusReg.ERR = 1;
-        m_registers->S.ALL_BITS = statusReg.ALL_BITS;
+        _writeReg(BSC_S_OFFSET, statusReg.ALL_BITS);
     }
 
 private:
@@ -257,15 +317,15 @@ private:
     typedef union {
         ULONG ALL_BITS;
         struct {
-            ULONG CDIV : 16;            // Clock divider: SCL = 150mhz / CDIV
+            ULONG CDIV : 16;            // Clock divider: SCL = 250mhz / CDIV, rounded down to even
             ULONG _rsv : 16;            // Reserved
         };
     } _DIV;
     const ULONG _DIV_USED_MASK = 0x0000FFFF;  // Mask of non-reserved bits in the Clock Divider Register
 
-    // Standard (100khz) and high (400khz) divider values.
-    const ULONG CDIV_100KHZ = 2500;
-    const ULONG CDIV_400KHZ = 626;
+    // Core clock that feeds the I2C clock divider, and the largest usable divider.
+    const ULONG BSC_CORE_CLOCK_HZ = 250000000;
+    const ULONG CDIV_MAX = 0xFFFE;
 
     // I2C Data Delay Register.
     typedef union {
@@ -309,6 +369,55 @@ private:
     // they are mapped into this process' address space.
     PI2C_CONTROLLER m_registers;
 
+    // Software register model used in place of the hardware, if any.
+    BcmI2cRegisterAccessClass* m_registerAccess;
+
+    // Read a controller register.
+    ULONG _readReg(ULONG offset) const
+    {
+        if (m_registerAccess != nullptr)
+        {
+            return m_registerAccess->readRegister(offset);
+        }
+        return *((volatile ULONG*)(((PUCHAR)m_registers) + offset));
+    }
+
+    // Write a controller register.
+    void _writeReg(ULONG offset, ULONG value)
+    {
+        if (m_registerAccess != nullptr)
+        {
+            m_registerAccess->writeRegister(offset, value);
+        }
+        else
+        {
+            *((volatile ULONG*)(((PUCHAR)m_registers) + offset)) = value;
+        }
+    }
+
+    /// Read the status register until it shows the controller is ready.
+    /**
+    If tracing is on, the time spent polling after the first read is counted as spin time.
+    \param[in] ready Function that returns TRUE for a status register value that shows
+    the controller is ready.
+    \return The status register value that showed the controller is ready.
+    */
+    template <typename READY>
+    inline _S _waitForStatus(READY ready)
+    {
+        _S sReg;
+        LONGLONG spinStart;
+
+        sReg.ALL_BITS = _readReg(BSC_S_OFFSET);
+        if (!ready(sReg))
+        {
+            m_trace->startTiming(spinStart);
+            do { sReg.ALL_BITS = _readReg(BSC_S_OFFSET); } while (!ready(sReg));
+            m_trace->recordSpin(spinStart);
+        }
+        return sReg;
+    }
+
     // Method to map the I2C controller into this process' virtual address space.
     LIGHTNING_DLL_API HRESULT _mapController() override;
 
@@ -321,8 +430,32 @@ private:
     // Perform a Write-Restart-Read sequence of transfers.
     HRESULT _performWriteRead(I2cTransferClass* &pXfr);
 
-    // The maximum length of a transfer.
+    // Clear status and start a new transfer segment on the I2C bus.
+    void _startSegment(LONG byteCount, BOOL isRead);
+
+    // Queue a transfer segment to follow the current one with a restart.
+    void _chainSegment(LONG byteCount, BOOL isRead);
+
+    // Write bytes from a chain of transfers to the TX FIFO.
+    HRESULT _writeBytes(I2cTransferClass* & cmdXfr, LONG & writesOutstanding, BOOL holdLastByte, UCHAR & lastByte);
+
+    // Read bytes into a chain of transfers, splitting long reads into segments.
+    HRESULT _readSegments(I2cTransferClass* readXfr, LONG & readsOutstanding);
+
+    // Wait for at least one empty space in the TX FIFO.
+    HRESULT _waitForTxSpace();
+
+    // Get the length of the next segment of a transfer with a given number of bytes left.
+    LONG _segmentLength(LONG bytesOutstanding) const
+    {
+        return (bytesOutstanding > m_maxTransferBytes) ? m_maxTransferBytes : bytesOutstanding;
+    }
+
+    // The maximum length of a transfer segment (the size of the DLEN field).
     const LONG m_maxTransferBytes = 0xFFFF;
+
+    // The depth of the TX and RX FIFOs.
+    const LONG BSC_FIFO_BYTES = 16;
 };
 
 #endif // _BCM_I2C_CONTROLLER_H_
\ No newline at end of file
@@ -0,0 +1,540 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#ifndef _BCM_I2C_MODEL_H_
+#define _BCM_I2C_MODEL_H_
+
+#include <Windows.h>
+#include <deque>
+#include <map>
+
+#include "BcmI2cController.h"
+#include "I2cModelSlave.h"
+
+//
+// Cycle-approximate software model of the BCM2836 I2C (BSC) Controller.
+//
+// The model implements the controller registers, the 16-byte TX and RX FIFOs,
+// DLEN countdown, the TA, DONE, TXW, RXR, TXD, RXD, TXE, RXF, ERR and CLKT status
+// bits, restarts queued by setting ST while a transfer is active, and clock
+// stretch timeouts.  Time is simulated: each register access advances the model
+// clock by a fixed cost, and the bus moves a byte for every nine SCL periods
+// (plus any clock stretching) that have elapsed.  Like the hardware, the bus
+// stalls with SCL held low when the TX FIFO is empty during a write or the RX
+// FIFO is full during a read.
+//
+// Because the controller spins on status registers, the model counters measure
+// the controller's software cost: register accesses per byte and simulated time
+// per transaction.
+//
+class BcmI2cModelClass : public BcmI2cRegisterAccessClass
+{
+public:
+    BcmI2cModelClass() :
+        m_accessNs(100),
+        m_nowNs(0),
+        m_busCreditNs(0),
+        m_registerAccesses(0),
+        m_statusReads(0),
+        m_busBytes(0)
+    {
+        _reset();
+    }
+
+    virtual ~BcmI2cModelClass()
+    {
+    }
+
+    /// Attach a simulated slave to the bus at a 7-bit address.
+    void attachSlave(ULONG address, I2cModelSlaveClass* slave)
+    {
+        m_slaves[address & 0x7F] = slave;
+    }
+
+    /// Set the simulated time cost of one register access, in nanoseconds.
+    void setAccessNs(ULONG accessNs)
+    {
+        m_accessNs = accessNs;
+    }
+
+    /// Get the simulated time that has elapsed, in nanoseconds.
+    ULONGLONG getSimulatedNs() const
+    {
+        return m_nowNs;
+    }
+
+    /// Get the number of register reads and writes performed.
+    ULONGLONG getRegisterAccesses() const
+    {
+        return m_registerAccesses;
+    }
+
+    /// Get the number of reads of the status register.
+    ULONGLONG getStatusReads() const
+    {
+        return m_statusReads;
+    }
+
+    /// Get the number of address and data bytes moved on the bus.
+    ULONGLONG getBusBytes() const
+    {
+        return m_busBytes;
+    }
+
+    /// Zero the time and access counters.
+    void resetCounters()
+    {
+        m_nowNs = 0;
+        m_registerAccesses = 0;
+        m_statusReads = 0;
+        m_busBytes = 0;
+    }
+
+    ULONG readRegister(ULONG offset) override
+    {
+        ULONG value = 0;
+
+        _access();
+
+        switch (offset)
+        {
+        case BSC_C_OFFSET:
+            value = m_c;
+            break;
+        case BSC_S_OFFSET:
+            m_statusReads++;
+            value = _status();
+            break;
+        case BSC_DLEN_OFFSET:
+            value = m_ta ? m_remaining : m_dlen;
+            break;
+        case BSC_A_OFFSET:
+            value = m_a;
+            break;
+        case BSC_FIFO_OFFSET:
+            if (!m_rxFifo.empty())
+            {
+                value = m_rxFifo.front();
+                m_rxFifo.pop_front();
+            }
+            break;
+        case BSC_DIV_OFFSET:
+            value = m_div;
+            break;
+        case BSC_DEL_OFFSET:
+            value = m_del;
+            break;
+        case BSC_CLKT_OFFSET:
+            value = m_clkt;
+            break;
+        }
+
+        return value;
+    }
+
+    void writeRegister(ULONG offset, ULONG value) override
+    {
+        _access();
+
+        switch (offset)
+        {
+        case BSC_C_OFFSET:
+            _writeControl(value);
+            break;
+        case BSC_S_OFFSET:
+            // DONE, ERR and CLKT are cleared by writing 1 to them.
+            if (value & S_DONE)
+            {
+                m_done = FALSE;
+            }
+            if (value & S_ERR)
+            {
+                m_err = FALSE;
+            }
+            if (value & S_CLKT)
+            {
+                m_clktErr = FALSE;
+            }
+            break;
+        case BSC_DLEN_OFFSET:
+            m_dlen = value & 0xFFFF;
+            break;
+        case BSC_A_OFFSET:
+            m_a = value & 0x7F;
+            break;
+        case BSC_FIFO_OFFSET:
+            if (m_txFifo.size() < FIFO_DEPTH)
+            {
+                m_txFifo.push_back((UCHAR)value);
+            }
+            break;
+        case BSC_DIV_OFFSET:
+            m_div = value & 0xFFFE;
+            break;
+        case BSC_DEL_OFFSET:
+            m_del = value;
+            break;
+        case BSC_CLKT_OFFSET:
+            m_clkt = value & 0xFFFF;
+            break;
+        }
+    }
+
+private:
+
+    // Control and status register bits.
+    static const ULONG C_READ = 0x0001;
+    static const ULONG C_CLEAR = 0x0030;
+    static const ULONG C_ST = 0x0080;
+    static const ULONG C_I2CEN = 0x8000;
+    static const ULONG S_TA = 0x0001;
+    static const ULONG S_DONE = 0x0002;
+    static const ULONG S_TXW = 0x0004;
+    static const ULONG S_RXR = 0x0008;
+    static const ULONG S_TXD = 0x0010;
+    static const ULONG S_RXD = 0x0020;
+    static const ULONG S_TXE = 0x0040;
+    static const ULONG S_RXF = 0x0080;
+    static const ULONG S_ERR = 0x0100;
+    static const ULONG S_CLKT = 0x0200;
+
+    // Depth of the TX and RX FIFOs.
+    static const size_t FIFO_DEPTH = 16;
+
+    // Core clock that feeds the clock divider, in MHz.
+    static const ULONG CORE_CLOCK_MHZ = 250;
+
+    // Bus phases.
+    enum BUS_PHASE {
+        IDLE,               // No transfer active
+        ADDRESS,            // START (or restart) and slave address
+        DATA,               // Data bytes
+        RESTART_GAP         // Between a finished segment and a queued restart
+    };
+
+    /// Put the registers in their reset state.
+    void _reset()
+    {
+        m_c = 0;
+        m_dlen = 0;
+        m_a = 0;
+        m_div = 0x05DC;
+        m_del = 0x00300030;
+        m_clkt = 0x40;
+        m_ta = FALSE;
+        m_done = FALSE;
+        m_err = FALSE;
+        m_clktErr = FALSE;
+        m_phase = IDLE;
+        m_isRead = FALSE;
+        m_remaining = 0;
+        m_restartPending = FALSE;
+        m_restartIsRead = FALSE;
+        m_slave = nullptr;
+        m_txFifo.clear();
+        m_rxFifo.clear();
+    }
+
+    /// Account for one register access and let the bus catch up.
+    void _access()
+    {
+        m_registerAccesses++;
+        m_nowNs += m_accessNs;
+        _advance(m_accessNs);
+    }
+
+    /// Get the length of one SCL period in nanoseconds.
+    ULONGLONG _sclPeriodNs() const
+    {
+        ULONG cdiv = (m_div == 0) ? 0x8000 : m_div;
+        return (ULONGLONG)cdiv * 1000 / CORE_CLOCK_MHZ;
+    }
+
+    /// Compose the status register.
+    ULONG _status() const
+    {
+        ULONG status = 0;
+
+        if (m_ta)
+        {
+            status |= S_TA;
+            if (!m_isRead && (m_txFifo.size() < FIFO_DEPTH))
+            {
+                status |= S_TXW;
+            }
+            if (m_isRead && (m_rxFifo.size() >= ((FIFO_DEPTH * 3) / 4)))
+            {
+                status |= S_RXR;
+            }
+        }
+        if (m_done)
+        {
+            status |= S_DONE;
+        }
+        if (m_txFifo.size() < FIFO_DEPTH)
+        {
+            status |= S_TXD;
+        }
+        if (!m_rxFifo.empty())
+        {
+            status |= S_RXD;
+        }
+        if (m_txFifo.empty())
+        {
+            status |= S_TXE;
+        }
+        if (m_rxFifo.size() >= FIFO_DEPTH)
+        {
+            status |= S_RXF;
+        }
+        if (m_err)
+        {
+            status |= S_ERR;
+        }
+        if (m_clktErr)
+        {
+            status |= S_CLKT;
+        }
+        return status;
+    }
+
+    /// Handle a write to the control register.
+    void _writeControl(ULONG value)
+    {
+        m_c = value & ~(C_ST | C_CLEAR);
+
+        if (value & C_CLEAR)
+        {
+            m_txFifo.clear();
+            m_rxFifo.clear();
+        }
+
+        if ((value & C_I2CEN) == 0)
+        {
+            // Disabling the controller abandons any transfer in progress.
+            if (m_phase != IDLE)
+            {
+                _endTransfer();
+            }
+            return;
+        }
+
+        if (value & C_ST)
+        {
+            if (m_phase == IDLE)
+            {
+                _startSegment((value & C_READ) != 0);
+            }
+            else
+            {
+                // A start during a transfer becomes a restart once the current
+                // segment has finished.
+                m_restartPending = TRUE;
+                m_restartIsRead = ((value & C_READ) != 0);
+            }
+        }
+    }
+
+    /// Begin a new segment with a START or restart and the slave address.
+    void _startSegment(BOOL isRead)
+    {
+        std::map<ULONG, I2cModelSlaveClass*>::iterator slave = m_slaves.find(m_a);
+
+        m_slave = (slave == m_slaves.end()) ? nullptr : slave->second;
+        m_isRead = isRead;
+        m_remaining = m_dlen;
+        m_phase = ADDRESS;
+        m_ta = TRUE;
+        m_done = FALSE;
+        m_busCreditNs = 0;
+    }
+
+    /// End the transfer with a STOP.
+    void _endTransfer()
+    {
+        if (m_slave != nullptr)
+        {
+            m_slave->stop();
+        }
+        m_phase = IDLE;
+        m_ta = FALSE;
+        m_done = TRUE;
+        m_restartPending = FALSE;
+        m_busCreditNs = 0;
+    }
+
+    /// Move the bus forward by an amount of simulated time.
+    void _advance(ULONGLONG ns)
+    {
+        ULONGLONG period = _sclPeriodNs();
+        ULONGLONG cost = 0;
+        ULONG stretch = 0;
+        BOOL stalled = FALSE;
+
+        if (m_phase == IDLE)
+        {
+            return;
+        }
+
+        m_busCreditNs += ns;
+
+        while ((m_phase != IDLE) && !stalled)
+        {
+            // Clock stretching by the slave delays each address and data byte.
+            stretch = (m_slave == nullptr) ? 0 : m_slave->stretchClocks();
+
+            switch (m_phase)
+            {
+            case ADDRESS:
+                cost = (10 + stretch) * period;
+                if (m_busCreditNs < cost)
+                {
+                    stalled = TRUE;
+                    break;
+                }
+                m_busCreditNs -= cost;
+                m_busBytes++;
+
+                if ((m_clkt != 0) && (stretch > m_clkt))
+                {
+                    m_clktErr = TRUE;
+                    _endTransfer();
+                }
+                else if ((m_slave == nullptr) || !m_slave->start(m_isRead))
+                {
+                    m_err = TRUE;
+                    _endTransfer();
+                }
+                else
+                {
+                    m_phase = DATA;
+                }
+                break;
+
+            case DATA:
+                if (m_remaining == 0)
+                {
+                    if (m_restartPending)
+                    {
+                        // The segment ends without a STOP and TA drops until the
+                        // restart condition has been set up.
+                        m_restartPending = FALSE;
+                        m_ta = FALSE;
+                        m_done = TRUE;
+                        m_phase = RESTART_GAP;
+                    }
+                    else
+                    {
+                        cost = period;
+                        if (m_busCreditNs < cost)
+                        {
+                            stalled = TRUE;
+                            break;
+                        }
+                        m_busCreditNs -= cost;
+                        _endTransfer();
+                    }
+                    break;
+                }
+
+                // The bus holds SCL low while it waits for the software.
+                if ((!m_isRead && m_txFifo.empty()) || (m_isRead && (m_rxFifo.size() >= FIFO_DEPTH)))
+                {
+                    m_busCreditNs = 0;
+                    stalled = TRUE;
+                    break;
+                }
+
+                cost = (9 + stretch) * period;
+                if (m_busCreditNs < cost)
+                {
+                    stalled = TRUE;
+                    break;
+                }
+                m_busCreditNs -= cost;
+                m_busBytes++;
+
+                if ((m_clkt != 0) && (stretch > m_clkt))
+                {
+                    m_clktErr = TRUE;
+                    _endTransfer();
+                }
+                else if (m_isRead)
+                {
+                    m_rxFifo.push_back(m_slave->readByte());
+                    m_remaining--;
+                }
+                else
+                {
+                    UCHAR data = m_txFifo.front();
+                    m_txFifo.pop_front();
+                    m_remaining--;
+                    if (!m_slave->writeByte(data))
+                    {
+                        m_err = TRUE;
+                        _endTransfer();
+                    }
+                }
+                break;
+
+            case RESTART_GAP:
+                cost = period;
+                if (m_busCreditNs < cost)
+                {
+                    stalled = TRUE;
+                    break;
+                }
+                m_busCreditNs -= cost;
+                _startSegment(m_restartIsRead);
+                break;
+
+            default:
+                stalled = TRUE;
+                break;
+            }
+        }
+    }
+
+    //
+    // Register state.
+    //
+
+    ULONG m_c;                  // Control register (ST and CLEAR read as zero)
+    ULONG m_dlen;               // Last value written to DLEN
+    ULONG m_a;                  // Slave address
+    ULONG m_div;                // Clock divider
+    ULONG m_del;                // Data delay
+    ULONG m_clkt;               // Clock stretch timeout, in SCL periods
+    BOOL m_ta;                  // Transfer active
+    BOOL m_done;                // Transfer done
+    BOOL m_err;                 // Slave NACKed address or data
+    BOOL m_clktErr;             // Clock stretch timeout occurred
+    std::deque<UCHAR> m_txFifo; // TX FIFO
+    std::deque<UCHAR> m_rxFifo; // RX FIFO
+
+    //
+    // Bus state.
+    //
+
+    BUS_PHASE m_phase;                      // Current bus phase
+    BOOL m_isRead;                          // Direction of the current segment
+    ULONG m_remaining;                      // Bytes left in the current segment
+    BOOL m_restartPending;                  // TRUE if ST was set during a transfer
+    BOOL m_restartIsRead;                   // Direction of the pending restart
+    I2cModelSlaveClass* m_slave;            // Slave addressed by the current segment
+    std::map<ULONG, I2cModelSlaveClass*> m_slaves;  // Attached slaves by address
+
+    //
+    // Simulated time and counters.
+    //
+
+    ULONG m_accessNs;                       // Simulated cost of a register access
+    ULONGLONG m_nowNs;                      // Simulated time
+    ULONGLONG m_busCreditNs;                // Time the bus has not used yet
+    ULONGLONG m_registerAccesses;           // Register reads and writes
+    ULONGLONG m_statusReads;                // Status register reads
+    ULONGLONG m_busBytes;                   // Address and data bytes on the bus
+};
+
+#endif  // _BCM_I2C_MODEL_H_
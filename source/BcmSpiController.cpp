@@ -53,29 +53,18 @@ HRESULT BcmSpiControllerClass::configurePins(ULONG misoPin, ULONG mosiPin, ULONG
 }
 
 /**
-Initialize member variables, including the SPI Clock rate variables.
+Initialize member variables.
 */
 BcmSpiControllerClass::BcmSpiControllerClass()
 {
     m_hController = INVALID_HANDLE_VALUE;
     m_registers = nullptr;
-
-    // Load values for the SPI clock generator divisors.
-    // SPI clock is 250mhz / Divisor.  Divisors must be even, and < 65536.
-    spiSpeed10mhz = 26;      // Fastest supported SPI clock on BCM2836 is 10mhz
-    spiSpeed8mhz = 32;
-    spiSpeed4mhz = 64;
-    spiSpeed2mhz = 126;
-    spiSpeed1mhz = 250;
-    spiSpeed500khz = 500;
-    spiSpeed250khz = 1000;
-    spiSpeed125khz = 2000;
-    spiSpeed50khz = 5000;
-    spiSpeed31k25hz = 8000;  // 31.25 khz for MIDI
-    spiSpeed25khz = 10000;
-    spiSpeed10khz = 25000;
-    spiSpeed5khz = 50000;
-    spiSpeed4khz = 62500;
+    m_registerAccess = nullptr;
+    m_clockPhase = 0;
+    m_clockPolarity = 0;
+    m_chipSelect = 0;
+    m_chipSelectActiveHigh = FALSE;
+    m_frameDepth = 0;
 }
 
 /**
@@ -110,7 +99,8 @@ HRESULT BcmSpiControllerClass::begin(ULONG busNumber, ULONG mode, ULONG clockKhz
             hr = DMAP_E_SPI_BUS_REQUESTED_DOES_NOT_EXIST;
         }
 
-        if (SUCCEEDED(hr))
+        // There is nothing to map if the controller is being run against a register model.
+        if (SUCCEEDED(hr) && (m_registerAccess == nullptr))
         {
             // Open the Dmap device for the SPI controller for exclusive access.
             hr = GetControllerBaseAddress(deviceName, m_hController, baseAddress);
@@ -136,12 +126,9 @@ HRESULT BcmSpiControllerClass::begin(ULONG busNumber, ULONG mode, ULONG clockKhz
 
         if (SUCCEEDED(hr))
         {
-            cs.ALL_BITS = 0;
-            cs.CPHA = m_clockPhase;
-            cs.CPOL = m_clockPolarity;
-            cs.CLEAR = 3;                       // Clear both FIFOs,
-            cs.TA = 1;                          //  then start transfers.
-            m_registers->CS.ALL_BITS = cs.ALL_BITS;
+            cs = _idleControl();                // Set mode and chip select,
+            cs.CLEAR = 3;                       //  clear both FIFOs, then start
+            _writeReg(BCM_SPI_CS_OFFSET, cs.ALL_BITS);  //  transfers if CS is not ours.
         }
     }
 
@@ -155,11 +142,11 @@ void BcmSpiControllerClass::end()
 {
     _CS cs;
 
-    if (m_registers != nullptr)
+    if (_registersAvailable())
     {
-        cs.ALL_BITS = m_registers->CS.ALL_BITS;
+        cs.ALL_BITS = _readReg(BCM_SPI_CS_OFFSET);
         cs.TA = 0;                              // No tranfer is active
-        m_registers->CS.ALL_BITS = cs.ALL_BITS;
+        _writeReg(BCM_SPI_CS_OFFSET, cs.ALL_BITS);
 
         m_registers = nullptr;
     }
@@ -208,93 +195,107 @@ HRESULT BcmSpiControllerClass::setMode(ULONG mode)
 }
 
 /**
-This method sets one of the SPI clock rates we support: 1 khz - 15 mhz.
-\param[in] clockKhz Desired clock rate in Khz.
+With hardware chip select, the transfer active (TA) bit is only set while a transfer
+method is running, so the controller asserts the chip select line just before the
+first clock and releases it after the last.  The chip select pin is switched to its
+SPI function and locked, unless the controller is running against a register model.
+\param[in] csLine The chip select line: 0 for CS0 or 1 for CS1.
+\param[in] csPin The board pin that carries the chip select line.
+\param[in] activeHigh TRUE if the chip select line is asserted high, FALSE if low.
 \return HRESULT success or error code.
 */
-HRESULT BcmSpiControllerClass::setClock(ULONG clockKhz)
+HRESULT BcmSpiControllerClass::setHardwareChipSelect(ULONG csLine, ULONG csPin, BOOL activeHigh)
 {
     HRESULT hr = S_OK;
-    ULONG speed = spiSpeed4mhz;
-    _CLK clk;
 
-    // If we don't have the controller registers mapped, fail.
-    if (m_registers == nullptr)
+    // Only CS0 and CS1 are brought out to the board pins.
+    if (csLine > 1)
     {
-        hr = DMAP_E_DMAP_INTERNAL_ERROR;
+        hr = DMAP_E_SPI_CHIP_SELECT_NOT_SUPPORTED;
     }
 
     if (SUCCEEDED(hr))
     {
-        // Round down to the closest clock rate we support.
-        if (clockKhz >= 9500)
-        {
-            speed = spiSpeed10mhz;
-        }
-        else if (clockKhz >= 8000)
-        {
-            speed = spiSpeed8mhz;
-        }
-        else if (clockKhz >= 4000)
-        {
-            speed = spiSpeed4mhz;
-        }
-        else if (clockKhz >= 2000)
-        {
-            speed = spiSpeed2mhz;
-        }
-        else if (clockKhz >= 1000)
-        {
-            speed = spiSpeed1mhz;
-        }
-        else if (clockKhz >= 500)
-        {
-            speed = spiSpeed500khz;
-        }
-        else if (clockKhz >= 250)
-        {
-            speed = spiSpeed250khz;
-        }
-        else if (clockKhz >= 125)
-        {
-            speed = spiSpeed125khz;
-        }
-        else if (clockKhz >= 50)
-        {
-            speed = spiSpeed50khz;
-        }
-        else if (clockKhz >= 31)
-        {
-            speed = spiSpeed31k25hz;
-        }
-        else if (clockKhz >= 25)
+        m_csPin = csPin;
+        m_chipSelect = csLine;
+        m_chipSelectActiveHigh = activeHigh;
+
+        // Release chip select before it is connected to the pin.
+        if (_registersAvailable())
         {
-            speed = spiSpeed25khz;
+            _writeReg(BCM_SPI_CS_OFFSET, _idleControl().ALL_BITS);
         }
-        else if (clockKhz >= 10)
+
+        // A register model has no pins to switch.
+        if (m_registerAccess == nullptr)
         {
-            speed = spiSpeed10khz;
+            hr = g_pins.verifyPinFunction(csPin, FUNC_SPI, BoardPinsClass::LOCK_FUNCTION);
         }
-        else if (clockKhz >= 5)
+
+        if (FAILED(hr))
         {
-            speed = spiSpeed5khz;
+            m_csPin = 0xFFFFFFFF;
+            m_chipSelect = 0;
+            m_chipSelectActiveHigh = FALSE;
+            if (_registersAvailable())
+            {
+                _writeReg(BCM_SPI_CS_OFFSET, _idleControl().ALL_BITS);
+            }
         }
-        else if (clockKhz >= 4)
+    }
+
+    return hr;
+}
+
+/**
+This method sets the fastest SPI clock rate the controller can generate that is not
+higher than the rate requested: 4 khz - 125 mhz.  The SPI clock is the core clock
+divided by an even divisor, so the rate set can be read back with getActualClockHz().
+\param[in] clockKhz Desired clock rate in Khz.
+\return HRESULT success or error code.
+*/
+HRESULT BcmSpiControllerClass::setClock(ULONG clockKhz)
+{
+    HRESULT hr = S_OK;
+    ULONG divisor = 0;
+    _CLK clk;
+
+    // If we don't have the controller registers mapped, fail.
+    if (!_registersAvailable())
+    {
+        hr = DMAP_E_DMAP_INTERNAL_ERROR;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        if (clockKhz == 0)
         {
-            speed = spiSpeed4khz;
+            hr = DMAP_E_SPI_SPEED_SPECIFIED_IS_INVALID;
         }
         else
         {
-            hr = DMAP_E_SPI_SPEED_SPECIFIED_IS_INVALID;
+            // Round the divisor up to the next even value, so the clock rate is rounded down.
+            divisor = (ULONG)(((ULONGLONG)BCM_SPI_CORE_CLOCK_KHZ + clockKhz - 1) / clockKhz);
+            divisor = (divisor + 1) & ~1UL;
+            if (divisor < BCM_SPI_MIN_CDIV)
+            {
+                divisor = BCM_SPI_MIN_CDIV;
+            }
+            if (divisor > BCM_SPI_MAX_CDIV)
+            {
+                hr = DMAP_E_SPI_SPEED_SPECIFIED_IS_INVALID;
+            }
         }
     }
 
     if (SUCCEEDED(hr))
     {
-        // Set the clock rate.
+        // Set the clock rate (a CDIV of 0 divides by 65536).
         clk.ALL_BITS = 0;
-        clk.CDIV = speed & 0xFFFF;
-        m_registers->CLK.ALL_BITS = clk.ALL_BITS;
+        clk.CDIV = divisor & 0xFFFF;
+        _writeReg(BCM_SPI_CLK_OFFSET, clk.ALL_BITS);
+        m_clockKhz = clockKhz;
+        m_actualClockHz = (ULONG)(((ULONGLONG)BCM_SPI_CORE_CLOCK_KHZ * 1000) / divisor);
     }
 
     return hr;
@@ -313,12 +314,12 @@ a number of bits that is not divisible by eight, this method returns an error.
 inline HRESULT BcmSpiControllerClass::_transfer(ULONG dataOut, ULONG & dataIn, ULONG bits)
 {
     HRESULT hr = S_OK;
-    _CS cs;
     BYTE* oneByte;
     int bytesRemaining;
+    LONGLONG startTicks;
 
 
-    if (m_registers == nullptr)
+    if (!_registersAvailable())
     {
         hr = DMAP_E_DMAP_INTERNAL_ERROR;
     }
@@ -331,26 +332,34 @@ inline HRESULT BcmSpiControllerClass::_transfer(ULONG dataOut, ULONG & dataIn, U
 
     if (SUCCEEDED(hr))
     {
+        m_counters.startTiming(startTicks);
+
         bytesRemaining = bits / 8;
         oneByte = (BYTE*)&dataOut;
         dataIn = 0;
 
+        _startChipSelectFrame();
+
         while (bytesRemaining > 0)
         {
             // Wait for an available space in the TX FIFO.
-            do { cs.ALL_BITS = m_registers->CS.ALL_BITS; } while (cs.TXD == 0);
+            _waitForStatus([](_CS cs) { return cs.TXD != 0; });
 
             // Send a byte of the data.
-            m_registers->FIFO.DATA_BYTE0 = oneByte[bytesRemaining - 1];
+            _writeReg(BCM_SPI_FIFO_OFFSET, oneByte[bytesRemaining - 1]);
 
             // Wait for the RX FIFO to have data.
-            do { cs.ALL_BITS = m_registers->CS.ALL_BITS; } while (cs.RXD == 0);
+            _waitForStatus([](_CS cs) { return cs.RXD != 0; });
 
             // Read the received data.
-            dataIn = (dataIn << 8) | (m_registers->FIFO.ALL_BITS & 0x000000FF);
+            dataIn = (dataIn << 8) | (_readReg(BCM_SPI_FIFO_OFFSET) & 0x000000FF);
 
             bytesRemaining--;
         }
+
+        _endChipSelectFrame();
+
+        m_counters.recordTransfer(startTicks, bits / 8, m_actualClockHz, hr);
     }
 
     return hr;
@@ -366,57 +375,250 @@ This method transfers a buffer of data on the bus.
 HRESULT BcmSpiControllerClass::transferBuffer(PBYTE dataOut, PBYTE dataIn, size_t bufferBytes)
 {
     HRESULT hr = S_OK;
+    LONGLONG startTicks;
+
+    if (!_registersAvailable())
+    {
+        hr = DMAP_E_DMAP_INTERNAL_ERROR;
+    }
+
+    if (SUCCEEDED(hr) && (bufferBytes > 0))
+    {
+        m_counters.startTiming(startTicks);
+
+        _startChipSelectFrame();
+
+        if (bufferBytes >= BCM_SPI_PACKED_MIN_BYTES)
+        {
+            hr = _transferPacked(dataOut, dataIn, bufferBytes);
+        }
+        else
+        {
+            hr = _transferBytes(dataOut, dataIn, bufferBytes);
+        }
+
+        _endChipSelectFrame();
+
+        m_counters.recordTransfer(startTicks, bufferBytes, m_actualClockHz, hr);
+    }
+
+    return hr;
+}
+
+/**
+Transfer a buffer one byte per FIFO access, checking the FIFO status before each byte.
+\param[in] dataOut The data to send on the SPI bus. If the parameter is NULL, 0's will be sent
+\param[in] datIn The data received on the SPI bus. If this parameter is NULL, data in will be ignored
+\param[in] bufferBytes the size of each of the buffers
+\return HRESULT success or error code.
+*/
+HRESULT BcmSpiControllerClass::_transferBytes(PBYTE dataOut, PBYTE dataIn, size_t bufferBytes)
+{
     size_t i = 0;
     size_t bytesRead = 0;
     _CS cs;
-    volatile ULONG tempDataIn = 0;
+    ULONG tempDataIn = 0;
+    BYTE tempDataOut;
+    BOOL lsbFirst = _isLsbFirst();
+    LONGLONG spinStart;
 
-    if (m_registers == nullptr)
+    for (i = 0; i < bufferBytes; i++)
     {
-        hr = DMAP_E_DMAP_INTERNAL_ERROR;
+        // Wait for an available space in the TX FIFO.
+        spinStart = 0;
+        do {
+            cs.ALL_BITS = _readReg(BCM_SPI_CS_OFFSET);
+            // If buffer is not empty, clear it
+            if (cs.RXD != 0)
+            {
+                // Read one byte from the buffer
+                tempDataIn = _readReg(BCM_SPI_FIFO_OFFSET);
+                if (dataIn)
+                {
+                    dataIn[bytesRead] = lsbFirst ? _reverseBits((BYTE)tempDataIn) : (BYTE)(tempDataIn & 0x000000FF);
+                }
+                bytesRead++;
+            }
+            else if ((cs.TXD == 0) && (spinStart == 0))
+            {
+                // Neither FIFO needs service, so time the wait for the bus.
+                m_counters.startTiming(spinStart);
+            }
+        } while (cs.TXD == 0);
+        m_counters.recordSpin(spinStart);
+
+        // Send a byte of the data.
+        tempDataOut = dataOut ? dataOut[i] : 0;
+        _writeReg(BCM_SPI_FIFO_OFFSET, lsbFirst ? _reverseBits(tempDataOut) : tempDataOut);
     }
 
-    if (SUCCEEDED(hr))
+    // Read any remaining bytes in the buffer
+    while (bytesRead < bufferBytes)
     {
-        for (i = 0; i < bufferBytes; i++)
+        // Wait for the RX FIFO to have data.
+        _waitForStatus([](_CS cs) { return cs.RXD != 0; });
+
+        // Read the received data.
+        tempDataIn = _readReg(BCM_SPI_FIFO_OFFSET);
+        if (dataIn)
         {
-            // Wait for an available space in the TX FIFO.
-            do {
-                cs.ALL_BITS = m_registers->CS.ALL_BITS;
-                // If buffer is not empty, clear it
-                if (cs.RXD != 0)
+            dataIn[bytesRead] = lsbFirst ? _reverseBits((BYTE)tempDataIn) : (BYTE)(tempDataIn & 0x000000FF);
+        }
+        bytesRead++;
+    }
+
+    return S_OK;
+}
+
+/**
+Transfer a buffer with the FIFOs in their DMA-style packed mode.  With DMAEN set, each
+FIFO write queues four bytes (least significant byte first) and each FIFO read returns
+four, and the controller stops after the number of bytes written to DLEN, discarding
+the padding in the last word.  No DMA channel is used, the FIFOs are serviced here.
+For LSB first transfers the bits of all four bytes of a word are reversed at once.
+
+The status register is only read to wait for RXR (RX FIFO 3/4 full).  Since no more than
+a FIFO's worth of words is in flight, RXR means the RX FIFO holds at least 12 words and
+the TX FIFO has room for 12 more, so that many words are moved each way without further
+status reads.  At the end of each block the remaining words are read after DONE is set.
+\param[in] dataOut The data to send on the SPI bus. If the parameter is NULL, 0's will be sent
+\param[in] datIn The data received on the SPI bus. If this parameter is NULL, data in will be ignored
+\param[in] bufferBytes the size of each of the buffers
+\return HRESULT success or error code.
+*/
+HRESULT BcmSpiControllerClass::_transferPacked(PBYTE dataOut, PBYTE dataIn, size_t bufferBytes)
+{
+    _CS csPacked;
+    _CS csRestore;
+    size_t blockStart = 0;
+    size_t blockBytes;
+    size_t words;
+    size_t wordsWritten;
+    size_t wordsRead;
+    size_t burstEnd;
+    size_t i;
+    BOOL lsbFirst = _isLsbFirst();
+
+    // Write the word of outgoing data at a word index in the current block.
+    auto writeWord = [&](size_t word)
+    {
+        size_t offset = blockStart + (word * 4);
+        size_t bytes = ((blockBytes - (word * 4)) < 4) ? (blockBytes - (word * 4)) : 4;
+        ULONG data = 0;
+
+        if (dataOut != nullptr)
+        {
+            if (bytes == 4)
+            {
+                memcpy(&data, &dataOut[offset], 4);
+            }
+            else
+            {
+                for (i = 0; i < bytes; i++)
                 {
-                    // Read one byte from the buffer
-                    tempDataIn = m_registers->FIFO.ALL_BITS;
-                    if (dataIn)
-                    {
-                        dataIn[bytesRead] = (BYTE)(tempDataIn & 0x000000FF);
-                    }
-                    bytesRead++;
+                    data |= ((ULONG)dataOut[offset + i]) << (i * 8);
                 }
-            } while (cs.TXD == 0);
+            }
+            if (lsbFirst)
+            {
+                data = _reverseBitsInBytes(data);
+            }
+        }
+        _writeReg(BCM_SPI_FIFO_OFFSET, data);
+    };
 
-            // Send a byte of the data.
-            m_registers->FIFO.DATA_BYTE0 = dataOut ? dataOut[i] : 0;
+    // Read the word of incoming data at a word index in the current block.
+    auto readWord = [&](size_t word)
+    {
+        size_t offset = blockStart + (word * 4);
+        size_t bytes = ((blockBytes - (word * 4)) < 4) ? (blockBytes - (word * 4)) : 4;
+        ULONG data = _readReg(BCM_SPI_FIFO_OFFSET);
+
+        if (dataIn != nullptr)
+        {
+            if (lsbFirst)
+            {
+                data = _reverseBitsInBytes(data);
+            }
+            if (bytes == 4)
+            {
+                memcpy(&dataIn[offset], &data, 4);
+            }
+            else
+            {
+                for (i = 0; i < bytes; i++)
+                {
+                    dataIn[offset + i] = (BYTE)(data >> (i * 8));
+                }
+            }
         }
+    };
+
+    csRestore.ALL_BITS = _readReg(BCM_SPI_CS_OFFSET);
+    csPacked.ALL_BITS = csRestore.ALL_BITS;
+    csPacked.CLEAR = 3;                     // Start with empty FIFOs
+    csPacked.DMAEN = 1;                     // Pack four bytes per FIFO access
+    csPacked.TA = 1;
 
-        // Read any remaining bytes in the buffer
-        while (bytesRead < bufferBytes)
+    while (blockStart < bufferBytes)
+    {
+        // DLEN is 16 bits, so long buffers are sent as several blocks of whole words.
+        blockBytes = bufferBytes - blockStart;
+        if (blockBytes > BCM_SPI_MAX_PACKED_BLOCK_BYTES)
         {
-            // Wait for the RX FIFO to have data.
-            do {
-                cs.ALL_BITS = m_registers->CS.ALL_BITS;
-            } while (cs.RXD == 0);
+            blockBytes = BCM_SPI_MAX_PACKED_BLOCK_BYTES;
+        }
+        words = (blockBytes + 3) / 4;
 
-            // Read the received data.
-            tempDataIn = m_registers->FIFO.ALL_BITS;
-            if (dataIn)
+        _writeReg(BCM_SPI_DLEN_OFFSET, (ULONG)blockBytes);
+        _writeReg(BCM_SPI_CS_OFFSET, csPacked.ALL_BITS);
+
+        // Fill the TX FIFO.
+        burstEnd = (words < BCM_SPI_FIFO_WORDS) ? words : BCM_SPI_FIFO_WORDS;
+        for (wordsWritten = 0; wordsWritten < burstEnd; wordsWritten++)
+        {
+            writeWord(wordsWritten);
+        }
+        wordsRead = 0;
+
+        // Each time the RX FIFO reaches 3/4 full, move that many words out of it and
+        // refill the TX FIFO by the same amount.
+        while (wordsWritten < words)
+        {
+            _waitForStatus([](_CS cs) { return cs.RXR != 0; });
+
+            burstEnd = wordsRead + BCM_SPI_FIFO_RXR_WORDS;
+            for (; wordsRead < burstEnd; wordsRead++)
+            {
+                readWord(wordsRead);
+            }
+
+            burstEnd = wordsWritten + BCM_SPI_FIFO_RXR_WORDS;
+            if (burstEnd > words)
             {
-                dataIn[bytesRead] = (BYTE)(tempDataIn & 0x000000FF);
+                burstEnd = words;
+            }
+            for (; wordsWritten < burstEnd; wordsWritten++)
+            {
+                writeWord(wordsWritten);
             }
-            bytesRead++;
         }
+
+        // Wait for DLEN bytes to be shifted, then collect the rest of the received data.
+        _waitForStatus([](_CS cs) { return cs.DONE != 0; });
+
+        for (; wordsRead < words; wordsRead++)
+        {
+            readWord(wordsRead);
+        }
+
+        blockStart += blockBytes;
     }
 
-    return hr;
+    // Return the FIFOs to one byte per access for _transfer().
+    csRestore.CLEAR = 3;
+    csRestore.DMAEN = 0;
+    _writeReg(BCM_SPI_CS_OFFSET, csRestore.ALL_BITS);
+
+    return S_OK;
 }
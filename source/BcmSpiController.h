@@ -10,6 +10,52 @@
 #include "DmapSupport.h"
 #include "BoardPins.h"
 
+// Byte offsets of the BCM2836 SPI Controller registers.
+#define BCM_SPI_CS_OFFSET   0x00
+#define BCM_SPI_FIFO_OFFSET 0x04
+#define BCM_SPI_CLK_OFFSET  0x08
+#define BCM_SPI_DLEN_OFFSET 0x0C
+#define BCM_SPI_LTOH_OFFSET 0x10
+#define BCM_SPI_DC_OFFSET   0x14
+
+/// Number of 32-bit words the BCM2836 SPI TX and RX FIFOs each hold.
+#define BCM_SPI_FIFO_WORDS 16
+
+/// Number of RX FIFO words at which the controller sets RXR (3/4 full).
+#define BCM_SPI_FIFO_RXR_WORDS 12
+
+/// Buffers of at least this many bytes are moved through the FIFOs a word at a time.
+#define BCM_SPI_PACKED_MIN_BYTES 4
+
+/// Frequency of the core clock the SPI clock is divided from, in khz.
+#define BCM_SPI_CORE_CLOCK_KHZ 250000
+
+/// Smallest SPI clock divisor (the divisor must be even).
+#define BCM_SPI_MIN_CDIV 2
+
+/// Largest SPI clock divisor (written to CDIV as 0).
+#define BCM_SPI_MAX_CDIV 65536
+
+/// Largest number of bytes moved in one packed block (DLEN is 16 bits, blocks are whole words).
+#define BCM_SPI_MAX_PACKED_BLOCK_BYTES 0xFFFC
+
+//
+// Interface used to substitute a software model for the BCM2836 SPI Controller
+// registers, so the controller code can be run and measured without hardware.
+//
+class BcmSpiRegisterAccessClass
+{
+public:
+    virtual ~BcmSpiRegisterAccessClass()
+    {
+    }
+
+    /// Method to read the 32-bit register at a byte offset from the controller base.
+    virtual ULONG readRegister(ULONG offset) = 0;
+
+    /// Method to write the 32-bit register at a byte offset from the controller base.
+    virtual void writeRegister(ULONG offset, ULONG value) = 0;
+};
 
 /// BCM2836 SPI Controller Class for use with Raspberry Pi 2.
 class BcmSpiControllerClass : public SpiControllerClass
@@ -43,12 +89,15 @@ public:
     /// Finish using an SPI controller.
     LIGHTNING_DLL_API void end() override;
 
-    /// Set the SPI clock rate to one of the values we support on this SPI controller.
+    /// Set the SPI clock rate to the closest rate the controller can generate.
     LIGHTNING_DLL_API HRESULT setClock(ULONG clockKhz) override;
 
     /// Set the SPI mode (clock polarity and phase).
     LIGHTNING_DLL_API HRESULT setMode(ULONG mode) override;
 
+    /// Have the controller drive chip select line CS0 or CS1 itself.
+    LIGHTNING_DLL_API HRESULT setHardwareChipSelect(ULONG csLine, ULONG csPin, BOOL activeHigh) override;
+
     /// Set the number of bits in an SPI transfer.
     HRESULT setDataWidth(ULONG bits) override
     {
@@ -77,6 +126,18 @@ public:
     */
     LIGHTNING_DLL_API HRESULT transferBuffer(PBYTE dataOut, PBYTE dataIn, size_t bufferBytes) override;
 
+    /// Method to run this controller against a software register model.
+    /**
+    When a register model is set, all register reads and writes go to the model
+    instead of the controller hardware, and the hardware is not mapped.  This must
+    be called before begin().
+    \param[in] registerAccess The register model, or nullptr to use the hardware.
+    */
+    void setRegisterAccess(BcmSpiRegisterAccessClass* registerAccess)
+    {
+        m_registerAccess = registerAccess;
+    }
+
 private:
 
 #pragma warning(push)
@@ -128,7 +189,7 @@ private:
     /// SPI Master Clock Divider Register
     typedef union {
         struct {
-            ULONG CDIV : 16;        ///< Clock Divider - power of 2 (SCLK = Core Clock / CDIV)
+            ULONG CDIV : 16;        ///< Clock Divider - even (SCLK = Core Clock / CDIV, 0 = 65536)
             ULONG _rsvd: 16;        // Reserved
         };
         ULONG ALL_BITS;
@@ -179,39 +240,137 @@ private:
 #pragma warning(push)
 #pragma warning(disable : 4201) // Ignore nameless struct/union warnings
 
-    // Spi bus speed values.
-    ULONG spiSpeed10mhz;               ///< Parameters for 10 mhz SPI bit clock
-    ULONG spiSpeed8mhz;                ///< Parameters for 8 mhz SPI bit clock
-    ULONG spiSpeed4mhz;                ///< Parameters for 4 mhz SPI bit clock
-    ULONG spiSpeed2mhz;                ///< Parameters for 2 mhz SPI bit clock
-    ULONG spiSpeed1mhz;                ///< Parameters for 1 mhz SPI bit clock
-    ULONG spiSpeed500khz;              ///< Parameters for 500 khz SPI bit clock
-    ULONG spiSpeed250khz;              ///< Parameters for 250 khz SPI bit clock
-    ULONG spiSpeed125khz;              ///< Parameters for 125 khz SPI bit clock
-    ULONG spiSpeed50khz;               ///< Parameters for 50 khz SPI bit clock
-    ULONG spiSpeed31k25hz;             ///< Parameters for 31.25 khz SPI bit clock
-    ULONG spiSpeed25khz;               ///< Parameters for 25 khz SPI bit clock
-    ULONG spiSpeed10khz;               ///< Parameters for 10 khz SPI bit clock
-    ULONG spiSpeed5khz;                ///< Parameters for 5 khz SPI bit clock
-    ULONG spiSpeed4khz;                ///< Parameters for 4 khz SPI bit clock
-
     /// Device handle used to map SPI controller registers into user-mode address space.
     HANDLE m_hController;
 
     /// Pointer to SPI controller registers mapped into this process' address space.
     PSPI_CONTROLLER m_registers;
 
+    /// Software register model used in place of the hardware, if any.
+    BcmSpiRegisterAccessClass* m_registerAccess;
+
     /// SPI clock phase.
     ULONG m_clockPhase;
 
     /// SPI clock polarity.
     ULONG m_clockPolarity;
 
+    /// Chip select line driven by the controller, if hardware chip select is used.
+    ULONG m_chipSelect;
+
+    /// TRUE if the hardware chip select line is asserted high.
+    BOOL m_chipSelectActiveHigh;
+
+    /// The number of chip select frames currently started and not yet ended.
+    ULONG m_frameDepth;
+
     /// The minimum width of a transfer on this controller.
     const UINT m_minTransferBits = 8;
 
     /// The maximum width of a transfer on this controller.
     const UINT m_maxTransferBits = 32;
+
+    /// Determine whether the controller registers can be accessed.
+    BOOL _registersAvailable() const
+    {
+        return (m_registers != nullptr) || (m_registerAccess != nullptr);
+    }
+
+    /// Read a controller register.
+    ULONG _readReg(ULONG offset) const
+    {
+        if (m_registerAccess != nullptr)
+        {
+            return m_registerAccess->readRegister(offset);
+        }
+        return *((volatile ULONG*)(((PUCHAR)m_registers) + offset));
+    }
+
+    /// Write a controller register.
+    void _writeReg(ULONG offset, ULONG value)
+    {
+        if (m_registerAccess != nullptr)
+        {
+            m_registerAccess->writeRegister(offset, value);
+        }
+        else
+        {
+            *((volatile ULONG*)(((PUCHAR)m_registers) + offset)) = value;
+        }
+    }
+
+    /// Get the control register settings used between transfers.
+    /**
+    Without hardware chip select, a transfer is left active all the time.  With it,
+    the transfer is only active (and chip select asserted) during each transfer call.
+    */
+    _CS _idleControl() const
+    {
+        _CS cs;
+
+        cs.ALL_BITS = 0;
+        cs.CPHA = m_clockPhase;
+        cs.CPOL = m_clockPolarity;
+        cs.CS = m_chipSelect;
+        cs.CSPOL = m_chipSelectActiveHigh ? 1 : 0;
+        cs.CSPOL0 = ((m_chipSelect == 0) && m_chipSelectActiveHigh) ? 1 : 0;
+        cs.CSPOL1 = ((m_chipSelect == 1) && m_chipSelectActiveHigh) ? 1 : 0;
+        cs.TA = hasHardwareChipSelect() ? 0 : 1;
+        return cs;
+    }
+
+    /// Read the control and status register until it shows the controller is ready.
+    /**
+    If counting is on, the time spent polling after the first read is counted as spin time.
+    \param[in] ready Function that returns TRUE for a register value that shows the
+    controller is ready.
+    \return The register value that showed the controller is ready.
+    */
+    template <typename READY>
+    inline _CS _waitForStatus(READY ready)
+    {
+        _CS cs;
+        LONGLONG spinStart;
+
+        cs.ALL_BITS = _readReg(BCM_SPI_CS_OFFSET);
+        if (!ready(cs))
+        {
+            m_counters.startTiming(spinStart);
+            do { cs.ALL_BITS = _readReg(BCM_SPI_CS_OFFSET); } while (!ready(cs));
+            m_counters.recordSpin(spinStart);
+        }
+        return cs;
+    }
+
+    /// Assert the hardware chip select line, if it is in use, to start a transfer.
+    void _startChipSelectFrame() override
+    {
+        _CS cs;
+
+        if (hasHardwareChipSelect() && (m_frameDepth++ == 0))
+        {
+            cs = _idleControl();
+            cs.TA = 1;
+            _writeReg(BCM_SPI_CS_OFFSET, cs.ALL_BITS);
+            m_counters.recordChipSelectFrame();
+        }
+    }
+
+    /// Wait for the last bit to be shifted and release the hardware chip select line.
+    void _endChipSelectFrame() override
+    {
+        if (hasHardwareChipSelect() && (m_frameDepth > 0) && (--m_frameDepth == 0))
+        {
+            _waitForStatus([](_CS cs) { return cs.DONE != 0; });
+            _writeReg(BCM_SPI_CS_OFFSET, _idleControl().ALL_BITS);
+        }
+    }
+
+    /// Transfer a buffer one byte per FIFO access.
+    HRESULT _transferBytes(PBYTE dataOut, PBYTE dataIn, size_t bufferBytes);
+
+    /// Transfer a buffer four bytes per FIFO access, using DLEN to set the length.
+    HRESULT _transferPacked(PBYTE dataOut, PBYTE dataIn, size_t bufferBytes);
 };
 
 #endif  // _BCM_SPI_CONTROLLER_H_
\ No newline at end of file
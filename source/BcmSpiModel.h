@@ -0,0 +1,490 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#ifndef _BCM_SPI_MODEL_H_
+#define _BCM_SPI_MODEL_H_
+
+#include <Windows.h>
+#include <deque>
+#include <vector>
+
+#include "BcmSpiController.h"
+#include "SpiModelSlave.h"
+
+//
+// Cycle-approximate software model of the BCM2836 SPI Controller (SPI0).
+//
+// The model implements the controller registers, the 64-byte TX and RX FIFOs, the
+// DONE, RXD, TXD, RXR and RXF status bits, and both FIFO access modes:
+// - With DMAEN clear, each FIFO access moves one byte and the transfer runs while
+//   there is data in the TX FIFO.
+// - With DMAEN set, each FIFO access moves four bytes (least significant byte first),
+//   the transfer stops after DLEN bytes, and the unused bytes of the last word are
+//   dropped.  A FIFO write while TA is clear loads DLEN and the low byte of CS from
+//   the written value, as DMA control blocks do.
+//
+// The chip select line selected by the CS field is asserted while TA is set, and
+// the attached slave is told when it changes.
+//
+// Time is simulated: each register access advances the model clock by a fixed cost,
+// and the bus moves a byte for every eight SCLK periods that have elapsed.  Like the
+// hardware, the bus stalls when the TX FIFO is empty or the RX FIFO is full.  If no
+// slave is attached, MISO is looped back from MOSI.
+//
+// Because the controller spins on the status register, the model counters measure
+// the controller's software cost: register accesses per byte and simulated time
+// per transfer.
+//
+class BcmSpiModelClass : public BcmSpiRegisterAccessClass
+{
+public:
+    BcmSpiModelClass() :
+        m_slave(nullptr),
+        m_accessNs(100),
+        m_nowNs(0),
+        m_busCreditNs(0),
+        m_registerAccesses(0),
+        m_statusReads(0),
+        m_fifoAccesses(0),
+        m_busBytes(0),
+        m_chipSelectFrames(0)
+    {
+        _reset();
+    }
+
+    virtual ~BcmSpiModelClass()
+    {
+    }
+
+    /// Attach a simulated slave to the bus, or nullptr to loop MOSI back to MISO.
+    void attachSlave(SpiModelSlaveClass* slave)
+    {
+        m_slave = slave;
+    }
+
+    /// Set the simulated time cost of one register access, in nanoseconds.
+    void setAccessNs(ULONG accessNs)
+    {
+        m_accessNs = accessNs;
+    }
+
+    /// Get the simulated time that has elapsed, in nanoseconds.
+    ULONGLONG getSimulatedNs() const
+    {
+        return m_nowNs;
+    }
+
+    /// Get the number of register reads and writes performed.
+    ULONGLONG getRegisterAccesses() const
+    {
+        return m_registerAccesses;
+    }
+
+    /// Get the number of reads of the control and status register.
+    ULONGLONG getStatusReads() const
+    {
+        return m_statusReads;
+    }
+
+    /// Get the number of FIFO register reads and writes performed.
+    ULONGLONG getFifoAccesses() const
+    {
+        return m_fifoAccesses;
+    }
+
+    /// Get the number of bytes shifted on the bus.
+    ULONGLONG getBusBytes() const
+    {
+        return m_busBytes;
+    }
+
+    /// Get the number of times chip select has been asserted.
+    ULONGLONG getChipSelectFrames() const
+    {
+        return m_chipSelectFrames;
+    }
+
+    /// Determine whether chip select is asserted.
+    BOOL isChipSelectAsserted() const
+    {
+        return (m_cs & CS_TA) != 0;
+    }
+
+    /// Get the chip select line selected by the CS field.
+    ULONG getChipSelectLine() const
+    {
+        return m_cs & 0x03;
+    }
+
+    /// Get the bytes the master has sent on MOSI since the counters were reset.
+    const std::vector<UCHAR> & getMosiBytes() const
+    {
+        return m_mosiBytes;
+    }
+
+    /// Zero the time and access counters and forget the MOSI bytes.
+    void resetCounters()
+    {
+        m_nowNs = 0;
+        m_registerAccesses = 0;
+        m_statusReads = 0;
+        m_fifoAccesses = 0;
+        m_busBytes = 0;
+        m_chipSelectFrames = 0;
+        m_mosiBytes.clear();
+    }
+
+    ULONG readRegister(ULONG offset) override
+    {
+        ULONG value = 0;
+
+        _access();
+
+        switch (offset)
+        {
+        case BCM_SPI_CS_OFFSET:
+            m_statusReads++;
+            value = _status();
+            break;
+        case BCM_SPI_FIFO_OFFSET:
+            m_fifoAccesses++;
+            value = _readFifo();
+            break;
+        case BCM_SPI_CLK_OFFSET:
+            value = m_clk;
+            break;
+        case BCM_SPI_DLEN_OFFSET:
+            value = m_dlen;
+            break;
+        case BCM_SPI_LTOH_OFFSET:
+            value = m_ltoh;
+            break;
+        case BCM_SPI_DC_OFFSET:
+            value = m_dc;
+            break;
+        }
+
+        return value;
+    }
+
+    void writeRegister(ULONG offset, ULONG value) override
+    {
+        _access();
+
+        switch (offset)
+        {
+        case BCM_SPI_CS_OFFSET:
+            _writeControl(value);
+            break;
+        case BCM_SPI_FIFO_OFFSET:
+            m_fifoAccesses++;
+            _writeFifo(value);
+            break;
+        case BCM_SPI_CLK_OFFSET:
+            m_clk = value & 0xFFFF;
+            break;
+        case BCM_SPI_DLEN_OFFSET:
+            m_dlen = value & 0xFFFF;
+            break;
+        case BCM_SPI_LTOH_OFFSET:
+            m_ltoh = value & 0x0F;
+            break;
+        case BCM_SPI_DC_OFFSET:
+            m_dc = value;
+            break;
+        }
+    }
+
+private:
+
+    // Control and status register bits.
+    static const ULONG CS_CLEAR_TX = 0x00000010;
+    static const ULONG CS_CLEAR_RX = 0x00000020;
+    static const ULONG CS_TA = 0x00000080;
+    static const ULONG CS_DMAEN = 0x00000100;
+    static const ULONG CS_DONE = 0x00010000;
+    static const ULONG CS_RXD = 0x00020000;
+    static const ULONG CS_TXD = 0x00040000;
+    static const ULONG CS_RXR = 0x00080000;
+    static const ULONG CS_RXF = 0x00100000;
+
+    // Control bits that can be written (the rest are status or self-clearing).
+    static const ULONG CS_WRITABLE = 0x03E03FCF;
+
+    // Depth of the TX and RX FIFOs in bytes.
+    static const size_t FIFO_BYTES = BCM_SPI_FIFO_WORDS * 4;
+
+    // Core clock that feeds the clock divider, in MHz.
+    static const ULONG CORE_CLOCK_MHZ = 250;
+
+    /// Put the registers in their reset state.
+    void _reset()
+    {
+        m_cs = 0;
+        m_clk = 0;
+        m_dlen = 0;
+        m_ltoh = 0x1;
+        m_dc = 0x30201020;
+        m_done = FALSE;
+        m_txFifo.clear();
+        m_rxFifo.clear();
+    }
+
+    /// Account for one register access and let the bus catch up.
+    void _access()
+    {
+        m_registerAccesses++;
+        m_nowNs += m_accessNs;
+        _advance(m_accessNs);
+    }
+
+    /// Determine whether the FIFOs are in packed (DMAEN) mode.
+    BOOL _packed() const
+    {
+        return (m_cs & CS_DMAEN) != 0;
+    }
+
+    /// Get the length of one SCLK period in nanoseconds.
+    ULONGLONG _sclkPeriodNs() const
+    {
+        // Odd divisors are rounded down, and zero means 65536.
+        ULONG cdiv = m_clk & 0xFFFE;
+        if (cdiv == 0)
+        {
+            cdiv = 0x10000;
+        }
+        return (ULONGLONG)cdiv * 1000 / CORE_CLOCK_MHZ;
+    }
+
+    /// Compose the control and status register.
+    ULONG _status() const
+    {
+        ULONG status = m_cs;
+        size_t accessBytes = _packed() ? 4 : 1;
+
+        if (m_done)
+        {
+            status |= CS_DONE;
+        }
+        if (!m_rxFifo.empty())
+        {
+            status |= CS_RXD;
+        }
+        if ((FIFO_BYTES - m_txFifo.size()) >= accessBytes)
+        {
+            status |= CS_TXD;
+        }
+        if ((m_cs & CS_TA) && (m_rxFifo.size() >= ((FIFO_BYTES * 3) / 4)))
+        {
+            status |= CS_RXR;
+        }
+        if (m_rxFifo.size() >= FIFO_BYTES)
+        {
+            status |= CS_RXF;
+        }
+        return status;
+    }
+
+    /// Handle a write to the control and status register.
+    void _writeControl(ULONG value)
+    {
+        BOOL wasActive = (m_cs & CS_TA) != 0;
+
+        m_cs = value & CS_WRITABLE;
+
+        if (value & CS_CLEAR_TX)
+        {
+            m_txFifo.clear();
+        }
+        if (value & CS_CLEAR_RX)
+        {
+            m_rxFifo.clear();
+        }
+
+        // Clearing TA ends the transfer and clears DONE.
+        if (!(m_cs & CS_TA))
+        {
+            m_done = FALSE;
+            m_busCreditNs = 0;
+        }
+        else if (!wasActive)
+        {
+            m_busCreditNs = 0;
+        }
+
+        _chipSelectChanged(wasActive);
+        _updateDone();
+    }
+
+    /// Handle a write to the FIFO register.
+    void _writeFifo(ULONG value)
+    {
+        if (_packed() && !(m_cs & CS_TA))
+        {
+            // With TA clear, the first word sets DLEN and the low byte of CS.
+            m_dlen = value >> 16;
+            m_cs = (m_cs & ~0xFF) | (value & 0xFF) | CS_TA;
+            m_busCreditNs = 0;
+            _chipSelectChanged(FALSE);
+            _updateDone();
+            return;
+        }
+
+        if (_packed())
+        {
+            if ((FIFO_BYTES - m_txFifo.size()) >= 4)
+            {
+                for (ULONG i = 0; i < 4; i++)
+                {
+                    m_txFifo.push_back((UCHAR)(value >> (i * 8)));
+                }
+            }
+        }
+        else if (m_txFifo.size() < FIFO_BYTES)
+        {
+            m_txFifo.push_back((UCHAR)value);
+        }
+
+        // Writing more data clears DONE.
+        m_done = FALSE;
+    }
+
+    /// Handle a read of the FIFO register.
+    ULONG _readFifo()
+    {
+        ULONG value = 0;
+        ULONG bytes = _packed() ? 4 : 1;
+
+        for (ULONG i = 0; (i < bytes) && !m_rxFifo.empty(); i++)
+        {
+            value |= ((ULONG)m_rxFifo.front()) << (i * 8);
+            m_rxFifo.pop_front();
+        }
+        return value;
+    }
+
+    /// Tell the slave when chip select has been asserted or released.
+    void _chipSelectChanged(BOOL wasActive)
+    {
+        BOOL isActive = (m_cs & CS_TA) != 0;
+
+        if (isActive != wasActive)
+        {
+            if (isActive)
+            {
+                m_chipSelectFrames++;
+            }
+            if (m_slave != nullptr)
+            {
+                m_slave->chipSelect(isActive);
+            }
+        }
+    }
+
+    /// Set DONE when the transfer has run out of work.
+    void _updateDone()
+    {
+        if (!(m_cs & CS_TA))
+        {
+            return;
+        }
+
+        if (_packed())
+        {
+            // In packed mode the transfer is done when DLEN bytes have been shifted.
+            if (m_dlen == 0)
+            {
+                m_done = TRUE;
+            }
+        }
+        else if (m_txFifo.empty())
+        {
+            m_done = TRUE;
+        }
+    }
+
+    /// Move the bus forward by an amount of simulated time.
+    void _advance(ULONGLONG ns)
+    {
+        ULONGLONG cost = 8 * _sclkPeriodNs();
+        UCHAR mosi;
+
+        if (!(m_cs & CS_TA))
+        {
+            return;
+        }
+
+        m_busCreditNs += ns;
+
+        for (;;)
+        {
+            // The bus stalls while there is nothing to send or nowhere to put the
+            // received byte.
+            if (m_txFifo.empty() || (m_rxFifo.size() >= FIFO_BYTES) || (_packed() && (m_dlen == 0)))
+            {
+                m_busCreditNs = 0;
+                break;
+            }
+
+            if (m_busCreditNs < cost)
+            {
+                break;
+            }
+            m_busCreditNs -= cost;
+
+            mosi = m_txFifo.front();
+            m_txFifo.pop_front();
+            m_mosiBytes.push_back(mosi);
+            m_rxFifo.push_back((m_slave == nullptr) ? mosi : m_slave->transferByte(mosi));
+            m_busBytes++;
+
+            if (_packed())
+            {
+                m_dlen--;
+                if (m_dlen == 0)
+                {
+                    // The padding in the last word is never sent.
+                    m_txFifo.clear();
+                }
+            }
+
+            _updateDone();
+        }
+    }
+
+    //
+    // Register state.
+    //
+
+    ULONG m_cs;                 // Control bits of the CS register
+    ULONG m_clk;                // Clock divider
+    ULONG m_dlen;               // Bytes left to transfer in packed mode
+    ULONG m_ltoh;               // LoSSI output hold delay
+    ULONG m_dc;                 // DMA DREQ controls
+    BOOL m_done;                // Transfer done
+    std::deque<UCHAR> m_txFifo; // TX FIFO
+    std::deque<UCHAR> m_rxFifo; // RX FIFO
+
+    //
+    // Bus state.
+    //
+
+    SpiModelSlaveClass* m_slave;            // Attached slave, or nullptr for loopback
+    std::vector<UCHAR> m_mosiBytes;         // Bytes sent on MOSI
+
+    //
+    // Simulated time and counters.
+    //
+
+    ULONG m_accessNs;                       // Simulated cost of a register access
+    ULONGLONG m_nowNs;                      // Simulated time
+    ULONGLONG m_busCreditNs;                // Time the bus has not used yet
+    ULONGLONG m_registerAccesses;           // Register reads and writes
+    ULONGLONG m_statusReads;                // Reads of the CS register
+    ULONGLONG m_fifoAccesses;               // Reads and writes of the FIFO register
+    ULONGLONG m_busBytes;                   // Bytes shifted on the bus
+    ULONGLONG m_chipSelectFrames;           // Times chip select was asserted
+};
+
+#endif  // _BCM_SPI_MODEL_H_
@@ -1057,6 +1057,49 @@ HRESULT BoardPinsClass::setPinState(ULONG pin, ULONG state)
     return hr;
 }
 
+/**
+Method to get the registers and values used to drive a GPIO output pin with
+setFastPinState(), which skips the pin number checks and board lookup that 
+setPinState() performs on every call.  The pin should be configured as an output, 
+and its configuration not changed, before this method is called.
+\param[in] pin The number of the pin in question.
+\param[out] fastPin The information used to drive the pin.
+\return HRESULT success or error code.
+*/
+HRESULT BoardPinsClass::getFastPin(ULONG pin, FAST_GPIO_PIN & fastPin)
+{
+    HRESULT hr = S_OK;
+
+    hr = _verifyBoardType();
+
+    if (SUCCEEDED(hr) && !pinNumberIsSafe(pin))
+    {
+        hr = DMAP_E_PIN_NUMBER_TOO_LARGE_FOR_BOARD;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Dispatch to the correct method according to the type of GPIO pin we are dealing with.
+        switch (m_PinAttributes[pin].gpioType)
+        {
+#if defined(_M_ARM)
+        case GPIO_BCM:
+            return g_bcmGpio.getFastPin(m_PinAttributes[pin].portBit, fastPin);
+#endif // defined(_M_ARM)
+#if defined(_M_IX86) || defined(_M_X64)
+        case GPIO_S0:
+            return g_btFabricGpio.getS0FastPin(m_PinAttributes[pin].portBit, fastPin);
+        case GPIO_S5:
+            return g_btFabricGpio.getS5FastPin(m_PinAttributes[pin].portBit, fastPin);
+#endif // defined(_M_IX86) || defined(_M_X64)
+        default:
+            hr = DMAP_E_DMAP_INTERNAL_ERROR;
+        }
+    }
+
+    return hr;
+}
+
 /**
 Method to read a GPIO input pin.
 \param[in] pin The number of the pin in question.
@@ -1155,6 +1198,67 @@ HRESULT BoardPinsClass::setPwmDutyCycle(ULONG pin, ULONG dutyCycle)
 }
 
 
+/**
+This method expects the call to have verified the pin numbers are in range, support
+PWM functions, and are in PWM mode.  Where the pins are consecutive channels of one
+PWM chip, all the duty cycles are set with a single I2C transaction.
+\param[in] firstPin The number of the first GPIO pin in question.
+\param[in] count The number of consecutive pins for which to set the duty-cycle.
+\param[in] dutyCycles Array of count duty-cycles (0-0xFFFFFFFF for 0-100%), one per pin.
+\param[in] pinMask Bit set for each pin in the range to set (bit 0 for firstPin).  Pins
+with a clear bit are left as they are.
+\return HRESULT success or error code.
+*/
+HRESULT BoardPinsClass::setPwmDutyCycles(ULONG firstPin, ULONG count, const ULONG* dutyCycles, ULONG pinMask)
+{
+    HRESULT hr = S_OK;
+    ULONG channel;
+
+
+    if (dutyCycles == nullptr)
+    {
+        hr = E_INVALIDARG;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hr = _verifyBoardType();
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        switch (m_boardType)
+        {
+        case BOARD_TYPE::MBM_IKA_LURE:
+            // The pins can be spread across PWM chips, set them one at a time.
+            for (ULONG i = 0; SUCCEEDED(hr) && (i < count); i++)
+            {
+                if ((pinMask & (1UL << i)) != 0)
+                {
+                    hr = setPwmDutyCycle(firstPin + i, dutyCycles[i]);
+                }
+            }
+            break;
+
+        case BOARD_TYPE::MBM_BARE:
+        case BOARD_TYPE::PI2_BARE:
+            // Conver the pseudo-pin number passed in to a channel number.
+            channel = firstPin - PWM0;
+
+            // If we have a PWM chip, it is external to the board.  The only one we
+            // currently support is the PCA9685.  Assume that is what we are using.
+            hr = PCA9685Device::SetDutyCycles(EXT_PCA9685_I2C_ADR, channel, count, dutyCycles, pinMask);
+            break;
+
+        default:
+            hr = DMAP_E_BOARD_TYPE_NOT_RECOGNIZED;
+        }
+    }
+
+    return hr;
+}
+
+
 /**
 This method expects the call to have verified the pin number is in range, supports
 PWM functions, and is in PWM mode.
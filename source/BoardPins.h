@@ -123,6 +123,26 @@ public:
     /// Method to read the state of an I/O pin.
     LIGHTNING_DLL_API HRESULT getPinState(ULONG pin, ULONG & state);
 
+    /// Method to get the information needed to drive a GPIO output pin directly.
+    LIGHTNING_DLL_API HRESULT getFastPin(ULONG pin, FAST_GPIO_PIN & fastPin);
+
+    /// Method to drive a GPIO output pin using information from getFastPin().
+    /**
+    \param[in] fastPin The information returned by getFastPin() for the pin.
+    \param[in] state The state to set the pin to: HIGH or LOW.
+    */
+    static inline void setFastPinState(const FAST_GPIO_PIN & fastPin, ULONG state)
+    {
+        if (state == 0)
+        {
+            *fastPin.clearRegister = fastPin.clearValue;
+        }
+        else
+        {
+            *fastPin.setRegister = fastPin.setValue;
+        }
+    }
+
     /// Method to set the direction of a pin (DIRECTION_IN or DIRECTION_OUT).
     LIGHTNING_DLL_API HRESULT setPinMode(ULONG pin, ULONG mode, BOOL pullUp);
 
@@ -132,6 +152,9 @@ public:
     /// Method to set the PWM duty cycle for a pin.
     LIGHTNING_DLL_API HRESULT setPwmDutyCycle(ULONG pin, ULONG dutyCycle);
 
+    /// Method to set the PWM duty cycles for a range of consecutive PWM pins.
+    LIGHTNING_DLL_API HRESULT setPwmDutyCycles(ULONG firstPin, ULONG count, const ULONG* dutyCycles, ULONG pinMask = 0xFFFFFFFF);
+
     /// Method to set the PWM pulse repetition frequency.
     LIGHTNING_DLL_API HRESULT setPwmFrequency(ULONG pin, ULONG frequency);
 
@@ -48,91 +48,211 @@ HRESULT BtI2cControllerClass::configurePins(ULONG sdaPin, ULONG sclPin)
 }
 
 // Method to initialize the I2C Controller at the start of a transaction.
-HRESULT BtI2cControllerClass::_initializeForTransaction(ULONG slaveAddress, BOOL useHighSpeed)
+HRESULT BtI2cControllerClass::_initializeForTransaction(ULONG slaveAddress, ULONG clockHz)
 {
+    HRESULT hr = S_OK;
     ULONGLONG waitStartTicks = 0;
-    BoardPinsClass::BOARD_TYPE board;
     _IC_CON icConReg;
+    _IC_TAR icTarReg;
+    _IC_ENABLE icEnableReg;
+    _IC_ENABLE_STATUS icEnableStatusReg;
+    ULONG hcnt = 0;
+    ULONG lcnt = 0;
+    ULONG speed = 0;
+
+    icTarReg.ALL_BITS = _readReg(BT_IC_TAR_OFFSET);
 
     // If we need to initialize, or re-initialize, the I2C Controller:
-    if (!isInitialized() || (m_registers->IC_TAR.IC_TAR != slaveAddress))
+    if (!isInitialized() || (icTarReg.IC_TAR != slaveAddress) || (m_configuredClockHz != clockHz))
     {
+        // Work out the SCL timing before touching the controller.
+        hr = _calculateSclCounts(clockHz, hcnt, lcnt, speed);
+
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
         // Disable the I2C controller.  This also clears the FIFOs.
-        m_registers->IC_ENABLE.ENABLE = 0;
+        icEnableReg.ALL_BITS = _readReg(BT_IC_ENABLE_OFFSET);
+        icEnableReg.ENABLE = 0;
+        _writeReg(BT_IC_ENABLE_OFFSET, icEnableReg.ALL_BITS);
 
         // Wait for the controller to go disabled, but only for 100 mS.
         // It can latch in a mode in which it does not go disabled, but appears 
         // to come out of this state when used again.
         waitStartTicks = GetTickCount64();
-        while ((m_registers->IC_ENABLE_STATUS.IC_EN == 1) && ((GetTickCount64() - waitStartTicks) < 100))
+        icEnableStatusReg.ALL_BITS = _readReg(BT_IC_ENABLE_STATUS_OFFSET);
+        while ((icEnableStatusReg.IC_EN == 1) && ((GetTickCount64() - waitStartTicks) < 100))
         {
             Sleep(0);       // Give the CPU to any thread that is waiting
+            icEnableStatusReg.ALL_BITS = _readReg(BT_IC_ENABLE_STATUS_OFFSET);
         }
 
-        // Set the desired I2C Clock speed.
-        g_pins.getBoardType(board);
-        if ((board == BoardPinsClass::BOARD_TYPE::MBM_BARE) ||
-            (board == BoardPinsClass::BOARD_TYPE::MBM_IKA_LURE))
+        // Set the desired I2C Clock speed.  Fast-mode Plus uses the fast speed registers.
+        if (speed == 1)
         {
-            if (useHighSpeed)
-            {
-                m_registers->IC_FS_SCL_HCNT.IC_FS_SCL_HCNT = 0x3C;
-                m_registers->IC_FS_SCL_LCNT.IC_FS_SCL_LCNT = 0x82;
-                m_registers->IC_CON.SPEED = 2;
-            }
-            else
-            {
-                m_registers->IC_SS_SCL_HCNT.IC_SS_SCL_HCNT = 0x190;
-                m_registers->IC_SS_SCL_LCNT.IC_SS_SCL_LCNT = 0x1D6;
-                m_registers->IC_CON.SPEED = 1;
-            }
+            _writeReg(BT_IC_SS_SCL_HCNT_OFFSET, hcnt & 0xFFFF);
+            _writeReg(BT_IC_SS_SCL_LCNT_OFFSET, lcnt & 0xFFFF);
         }
         else
         {
-            if (useHighSpeed)
-            {
-                m_registers->IC_FS_SCL_HCNT.IC_FS_SCL_HCNT = 0x14;
-                m_registers->IC_FS_SCL_LCNT.IC_FS_SCL_LCNT = 0x2E;
-                m_registers->IC_CON.SPEED = 2;
-            }
-            else
-            {
-                m_registers->IC_SS_SCL_HCNT.IC_SS_SCL_HCNT = 0x92;
-                m_registers->IC_SS_SCL_LCNT.IC_SS_SCL_LCNT = 0xAB;
-                m_registers->IC_CON.SPEED = 1;
-            }
+            _writeReg(BT_IC_FS_SCL_HCNT_OFFSET, hcnt & 0xFFFF);
+            _writeReg(BT_IC_FS_SCL_LCNT_OFFSET, lcnt & 0xFFFF);
         }
 
-        // Allow bus restarts.
-        m_registers->IC_CON.IC_RESTART_EN = 1;
-
-        // Set 7-bit addressing.
-        icConReg.ALL_BITS = m_registers->IC_CON.ALL_BITS;
+        // Set the speed, allow bus restarts and set 7-bit addressing.
+        icConReg.ALL_BITS = _readReg(BT_IC_CON_OFFSET);
+        icConReg.SPEED = speed;
+        icConReg.IC_RESTART_EN = 1;
         icConReg.IC_10BITADDR_MASTER = 0;
-        m_registers->IC_CON.ALL_BITS = icConReg.ALL_BITS;
+        _writeReg(BT_IC_CON_OFFSET, icConReg.ALL_BITS);
 
         // Set the address of the slave this tranaction affects.
         // All bits but the 7-bit address are intentionally cleared here.  This is needed
         // for Bay Trail, which supports additional bits (all of which we want clear).
-        m_registers->IC_TAR.ALL_BITS = (slaveAddress & 0x7F);
+        _writeReg(BT_IC_TAR_OFFSET, (slaveAddress & 0x7F));
 
         // Mask all interrupts.
-        m_registers->IC_INTR_MASK.ALL_BITS = 0;
+        _writeReg(BT_IC_INTR_MASK_OFFSET, 0);
 
         // Clear any outstanding interrupts.
-        ULONG dummy = m_registers->IC_CLR_INTR.ALL_BITS;
+        ULONG dummy = _readReg(BT_IC_CLR_INTR_OFFSET);
+
+        // Find out how much data the FIFOs can hold.
+        _readFifoDepths();
 
         // Enable the controller.
-        m_registers->IC_ENABLE.ENABLE = 1;
+        icEnableReg.ALL_BITS = _readReg(BT_IC_ENABLE_OFFSET);
+        icEnableReg.ENABLE = 1;
+        _writeReg(BT_IC_ENABLE_OFFSET, icEnableReg.ALL_BITS);
 
         // Indicate the I2C Controller is now initialized.
+        m_configuredClockHz = clockHz;
         setInitialized();
 
-    } // End - if (!isInitialized() || (getAddress() != m_slaveAddress))
+    } // End - if (!isInitialized() || (getAddress() != m_slaveAddress) || clock changed)
 
     return S_OK;
 }
 
+/**
+Calculate the SCL high and low period counts that produce the fastest bus clock
+that does not exceed the requested rate, while meeting the minimum SCL high and
+low times the I2C specification sets for the speed mode the rate falls in.
+The controller stretches the high period by the spike suppression length plus
+seven ic_clk cycles, and the low period by one cycle.
+\param[in] clockHz The desired I2C bus clock rate in Hz.
+\param[out] hcnt The value for the SCL high count register.
+\param[out] lcnt The value for the SCL low count register.
+\param[out] speed The IC_CON.SPEED value: 1 for standard mode, 2 for fast modes.
+\return HRESULT success or error code.
+*/
+HRESULT BtI2cControllerClass::_calculateSclCounts(ULONG clockHz, ULONG & hcnt, ULONG & lcnt, ULONG & speed)
+{
+    HRESULT hr = S_OK;
+    ULONG tLowMinNs = 0;
+    ULONG tHighMinNs = 0;
+    ULONG spkLen = 0;
+    _IC_FS_SPKLEN spkLenReg;
+    ULONG totalCycles = 0;
+    ULONG countCycles = 0;
+    ULONG lcntMin = 0;
+    ULONG hcntMin = 0;
+    ULONG highOverhead = 0;
+
+    if ((clockHz == 0) || (clockHz > I2C_FAST_MODE_PLUS_HZ))
+    {
+        hr = DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Minimum SCL low and high times from the I2C specification.
+        if (clockHz <= I2C_STANDARD_MODE_HZ)
+        {
+            tLowMinNs = 4700;
+            tHighMinNs = 4000;
+            speed = 1;
+        }
+        else if (clockHz <= I2C_FAST_MODE_HZ)
+        {
+            tLowMinNs = 1300;
+            tHighMinNs = 600;
+            speed = 2;
+        }
+        else
+        {
+            tLowMinNs = 500;
+            tHighMinNs = 260;
+            speed = 2;
+        }
+
+        spkLenReg.ALL_BITS = _readReg(BT_IC_FS_SPKLEN_OFFSET);
+        spkLen = spkLenReg.IC_FS_SPKLENRX_TL;
+        if (spkLen == 0)
+        {
+            spkLen = 1;
+        }
+        highOverhead = spkLen + 7;
+
+        // Round the period up so the achieved rate never exceeds the requested rate.
+        totalCycles = (BT_I2C_INPUT_CLOCK_HZ + clockHz - 1) / clockHz;
+        if (totalCycles <= (highOverhead + 1))
+        {
+            hr = DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED;
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Cycles that are set by the HCNT and LCNT registers.
+        countCycles = totalCycles - highOverhead - 1;
+
+        // Smallest counts that satisfy the specification and the controller minimums.
+        lcntMin = (ULONG)((((ULONGLONG)tLowMinNs * BT_I2C_INPUT_CLOCK_HZ) + 999999999) / 1000000000);
+        lcntMin = (lcntMin > 1) ? (lcntMin - 1) : 0;
+        if (lcntMin < 8)
+        {
+            lcntMin = 8;
+        }
+        hcntMin = (ULONG)((((ULONGLONG)tHighMinNs * BT_I2C_INPUT_CLOCK_HZ) + 999999999) / 1000000000);
+        hcntMin = (hcntMin > highOverhead) ? (hcntMin - highOverhead) : 0;
+        if (hcntMin < 6)
+        {
+            hcntMin = 6;
+        }
+
+        // Split the period in proportion to the minimum low and high times.
+        lcnt = (ULONG)(((ULONGLONG)countCycles * tLowMinNs) / (tLowMinNs + tHighMinNs));
+        if (lcnt < lcntMin)
+        {
+            lcnt = lcntMin;
+        }
+
+        if ((lcnt >= countCycles) || ((countCycles - lcnt) < hcntMin))
+        {
+            hr = DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED;
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hcnt = countCycles - lcnt;
+        if ((hcnt > 0xFFFF) || (lcnt > 0xFFFF))
+        {
+            hr = DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED;
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        m_actualClockHz = BT_I2C_INPUT_CLOCK_HZ / (hcnt + highOverhead + lcnt + 1);
+    }
+
+    return hr;
+}
+
 // Method to map the I2C controller into this process' virtual address space.
 HRESULT BtI2cControllerClass::_mapController()
 {
@@ -141,6 +261,13 @@ HRESULT BtI2cControllerClass::_mapController()
     BoardPinsClass::BOARD_TYPE board;
     PWCHAR deviceName = nullptr;
 
+
+    // There is nothing to map if the controller is being run against a register model.
+    if (m_registerAccess != nullptr)
+    {
+        return S_OK;
+    }
+
     hr = g_pins.getBoardType(board);
  
     if (SUCCEEDED(hr))
@@ -171,6 +298,16 @@ HRESULT BtI2cControllerClass::_mapController()
     return hr;
 }
 
+/// Method to perform a set of contiguous transfers.
+/**
+Commands are pushed to the TX FIFO in bursts: the FIFO levels are read once, then
+as many commands are written as there is known to be room for, without checking
+the status register between bytes.  Read commands are also limited so the bytes
+they return can not overflow the RX FIFO before they are drained.
+\param[in,out] pXfr The first transfer to perform.  On return, the transfer that
+follows the last one performed.
+\return HRESULT success or error code.
+*/
 HRESULT BtI2cControllerClass::_performContiguousTransfers(I2cTransferClass* & pXfr)
 {
     ULONGLONG startWaitTicks = 0;
@@ -183,8 +320,12 @@ HRESULT BtI2cControllerClass::_performContiguousTransfers(I2cTransferClass* & pX
     ULONG cmdDat;
     LONG cmdsOutstanding = 0;
     LONG readsOutstanding = 0;
+    LONG txSlots = 0;
+    LONG readsInFlight = 0;
+    LONG bytesRead = 0;
+    _IC_TXFLR txLevelReg;
+    LONGLONG spinStart = 0;
     UCHAR outByte;
-    UCHAR inByte;
 
 
     if (pXfr == nullptr)
@@ -224,60 +365,58 @@ HRESULT BtI2cControllerClass::_performContiguousTransfers(I2cTransferClass* & pX
         // For each byte in the transfer:
         while (SUCCEEDED(hr) && (cmdXfr->getNextCmd(outByte)))
         {
-            // Wait for at least one empty space in the TX FIFO.
-            while (txFifoFull());
-
-            // Issue the command.
-            if (cmdXfr->transferIsRead())
-            {
-                cmdDat = 0x100;             // Build read command (data is ignored)
-            }
-            else
+            // If the TX FIFO space we know about has been used up, or another read
+            // command could overflow the RX FIFO, drain the RX FIFO and find out
+            // how much room there is now.
+            if ((txSlots == 0) || (cmdXfr->transferIsRead() && (readsInFlight >= m_rxFifoDepth)))
             {
-                cmdDat = outByte;           // Build write command with data byte
-            }
+                m_trace->startTiming(spinStart);
+                while (SUCCEEDED(hr) &&
+                    ((txSlots == 0) || (cmdXfr->transferIsRead() && (readsInFlight >= m_rxFifoDepth))))
+                {
+                    bytesRead = _drainRxFifo(readXfr, readPtr);
+                    readsOutstanding -= bytesRead;
+                    readsInFlight -= bytesRead;
 
-            // If restart has been requested, signal a pre-RESTART.
-            if (restart)
-            {
-                cmdDat = cmdDat | (1 << 10);
-                restart = FALSE;            // Only want to RESTART on first command of transfer
-            }
+                    txLevelReg.ALL_BITS = _readReg(BT_IC_TXFLR_OFFSET);
+                    txSlots = m_txFifoDepth - (LONG)txLevelReg.TXFLR;
 
-            // If this is the last command before the end of the transaction or
-            // before a callback, signal a STOP.
-            if (cmdsOutstanding == 1)
-            {
-                cmdDat = cmdDat | (1 << 9);
+                    hr = _handleErrors();
+                }
+                m_trace->recordSpin(spinStart);
             }
 
-            // Issue the command.
-            m_registers->IC_DATA_CMD.ALL_BITS = cmdDat;
-            cmdsOutstanding--;
-
-            hr = _handleErrors();
-
-            // Pull any available bytes out of the receive FIFO.
-            while (SUCCEEDED(hr) && rxFifoNotEmtpy())
+            if (SUCCEEDED(hr))
             {
-                // Read a byte from the I2C Controller.
-                inByte = readByte();
-                readsOutstanding--;
+                // Build the command.
+                if (cmdXfr->transferIsRead())
+                {
+                    cmdDat = 0x100;             // Build read command (data is ignored)
+                    readsInFlight++;
+                }
+                else
+                {
+                    cmdDat = outByte;           // Build write command with data byte
+                }
 
-                // Store the byte if we have a place for it.
-                if (readPtr != nullptr)
+                // If restart has been requested, signal a pre-RESTART.
+                if (restart)
                 {
-                    *readPtr = inByte;
-
-                    // Figure out where the next byte should go.
-                    readPtr = readXfr->getNextReadLocation();
-                    while ((readPtr == nullptr) && (readXfr->getNextTransfer() != nullptr))
-                    {
-                        readXfr = readXfr->getNextTransfer();
-                        readXfr->resetRead();
-                        readPtr = readXfr->getNextReadLocation();
-                    }
+                    cmdDat = cmdDat | (1 << 10);
+                    restart = FALSE;            // Only want to RESTART on first command of transfer
                 }
+
+                // If this is the last command before the end of the transaction or
+                // before a callback, signal a STOP.
+                if (cmdsOutstanding == 1)
+                {
+                    cmdDat = cmdDat | (1 << 9);
+                }
+
+                // Issue the command.
+                _writeReg(BT_IC_DATA_CMD_OFFSET, cmdDat);
+                cmdsOutstanding--;
+                txSlots--;
             }
         }
 
@@ -290,30 +429,11 @@ HRESULT BtI2cControllerClass::_performContiguousTransfers(I2cTransferClass* & pX
     // Complete any outstanding reads and wait for the TX FIFO to empty.
     startWaitTicks = GetTickCount64();
     currentTicks = startWaitTicks;
+    m_trace->startTiming(spinStart);
     while (SUCCEEDED(hr) && ((readsOutstanding > 0) || !txFifoEmpty()) && !errorOccurred())
     {
         // Pull any available bytes out of the receive FIFO.
-        while (rxFifoNotEmtpy())
-        {
-            // Read a byte from the I2C Controller.
-            inByte = readByte();
-            readsOutstanding--;
-
-            // Store the byte if we have a place for it.
-            if (readPtr != nullptr)
-            {
-                *readPtr = inByte;
-
-                // Figure out where the next byte should go.
-                readPtr = readXfr->getNextReadLocation();
-                while ((readPtr == nullptr) && (readXfr->getNextTransfer() != nullptr))
-                {
-                    readXfr = readXfr->getNextTransfer();
-                    readXfr->resetRead();
-                    readPtr = readXfr->getNextReadLocation();
-                }
-            }
-        }
+        readsOutstanding -= _drainRxFifo(readXfr, readPtr);
 
         // Wait up to to 100 milliseconds for transfers to happen.
         if (readsOutstanding > 0)
@@ -325,6 +445,7 @@ HRESULT BtI2cControllerClass::_performContiguousTransfers(I2cTransferClass* & pX
             }
         }
     }
+    m_trace->recordSpin(spinStart);
 
     // Determine if an error occured on this transaction.
     if (SUCCEEDED(hr))
@@ -361,3 +482,63 @@ HRESULT BtI2cControllerClass::_performContiguousTransfers(I2cTransferClass* & pX
     return hr;
 }
 
+/**
+Read the RX FIFO level once, then move that many bytes from the FIFO to the
+read transfers.  Bytes that arrive when there is no read buffer left are discarded.
+\param[in,out] readXfr The transfer currently being read into.
+\param[in,out] readPtr The location the next byte read is stored at.
+\return The number of bytes taken from the RX FIFO.
+*/
+LONG BtI2cControllerClass::_drainRxFifo(I2cTransferClass* & readXfr, PUCHAR & readPtr)
+{
+    _IC_RXFLR rxLevelReg;
+    LONG rxLevel = 0;
+    UCHAR inByte;
+
+    rxLevelReg.ALL_BITS = _readReg(BT_IC_RXFLR_OFFSET);
+    rxLevel = (LONG)rxLevelReg.RXFLR;
+
+    for (LONG i = 0; i < rxLevel; i++)
+    {
+        // Read a byte from the I2C Controller.
+        inByte = readByte();
+
+        // Store the byte if we have a place for it.
+        if (readPtr != nullptr)
+        {
+            *readPtr = inByte;
+
+            // Figure out where the next byte should go.
+            readPtr = readXfr->getNextReadLocation();
+            while ((readPtr == nullptr) && (readXfr->getNextTransfer() != nullptr))
+            {
+                readXfr = readXfr->getNextTransfer();
+                readXfr->resetRead();
+                readPtr = readXfr->getNextReadLocation();
+            }
+        }
+    }
+
+    return rxLevel;
+}
+
+// Method to read the TX and RX FIFO depths the controller was built with.
+void BtI2cControllerClass::_readFifoDepths()
+{
+    _IC_COMP_PARAM_1 paramReg;
+
+    paramReg.ALL_BITS = _readReg(BT_IC_COMP_PARAM_1_OFFSET);
+
+    // If the controller reports its parameters, use the FIFO sizes it reports.
+    if ((paramReg.ALL_BITS != 0) && (paramReg.ADD_ENCODED_PARAMS == 1))
+    {
+        m_txFifoDepth = paramReg.TX_BUFFER_DEPTH + 1;
+        m_rxFifoDepth = paramReg.RX_BUFFER_DEPTH + 1;
+    }
+    else
+    {
+        m_txFifoDepth = BT_I2C_DEFAULT_FIFO_DEPTH;
+        m_rxFifoDepth = BT_I2C_DEFAULT_FIFO_DEPTH;
+    }
+}
+
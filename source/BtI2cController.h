@@ -11,6 +11,45 @@
 #include "I2cController.h"
 #include "BoardPins.h"
 
+// Byte offsets of the BayTrail (DesignWare) I2C Controller registers used here.
+#define BT_IC_CON_OFFSET            0x00
+#define BT_IC_TAR_OFFSET            0x04
+#define BT_IC_DATA_CMD_OFFSET       0x10
+#define BT_IC_SS_SCL_HCNT_OFFSET    0x14
+#define BT_IC_SS_SCL_LCNT_OFFSET    0x18
+#define BT_IC_FS_SCL_HCNT_OFFSET    0x1C
+#define BT_IC_FS_SCL_LCNT_OFFSET    0x20
+#define BT_IC_INTR_MASK_OFFSET      0x30
+#define BT_IC_RAW_INTR_STAT_OFFSET  0x34
+#define BT_IC_CLR_INTR_OFFSET       0x40
+#define BT_IC_CLR_TX_ABRT_OFFSET    0x54
+#define BT_IC_ENABLE_OFFSET         0x6C
+#define BT_IC_STATUS_OFFSET         0x70
+#define BT_IC_TXFLR_OFFSET          0x74
+#define BT_IC_RXFLR_OFFSET          0x78
+#define BT_IC_TX_ABRT_SOURCE_OFFSET 0x80
+#define BT_IC_ENABLE_STATUS_OFFSET  0x9C
+#define BT_IC_FS_SPKLEN_OFFSET      0xA0
+#define BT_IC_COMP_PARAM_1_OFFSET   0xF4
+
+//
+// Interface used to substitute a software model for the BayTrail I2C Controller
+// registers, so the controller code can be run and measured without hardware.
+//
+class BtI2cRegisterAccessClass
+{
+public:
+    virtual ~BtI2cRegisterAccessClass()
+    {
+    }
+
+    /// Method to read the 32-bit register at a byte offset from the controller base.
+    virtual ULONG readRegister(ULONG offset) = 0;
+
+    /// Method to write the 32-bit register at a byte offset from the controller base.
+    virtual void writeRegister(ULONG offset, ULONG value) = 0;
+};
+
 
 //
 // Class that is used to interact with the BayTrail I2C Controller hardware.
@@ -20,7 +59,11 @@ class BtI2cControllerClass : public I2cControllerClass
 public:
     BtI2cControllerClass() :
         m_registers(nullptr),
-        m_controllerInitialized(FALSE)
+        m_registerAccess(nullptr),
+        m_controllerInitialized(FALSE),
+        m_configuredClockHz(0),
+        m_txFifoDepth(BT_I2C_DEFAULT_FIFO_DEPTH),
+        m_rxFifoDepth(BT_I2C_DEFAULT_FIFO_DEPTH)
     {
     }
 
@@ -48,7 +91,7 @@ public:
     LIGHTNING_DLL_API HRESULT configurePins(ULONG sdaPin, ULONG sclPin) override;
 
     // Method to initialize the I2C Controller at the start of a transaction.
-    LIGHTNING_DLL_API HRESULT _initializeForTransaction(ULONG slaveAddress, BOOL useHighSpeed) override;
+    LIGHTNING_DLL_API HRESULT _initializeForTransaction(ULONG slaveAddress, ULONG clockHz) override;
 
     // This method records that the controller has been initialized.
     void setInitialized()
@@ -62,6 +105,24 @@ public:
         return m_controllerInitialized;
     }
 
+    /// Method to run this controller against a software register model.
+    /**
+    When a register model is set, all register reads and writes go to the model
+    instead of the controller hardware, and the hardware is not mapped.
+    \param[in] registerAccess The register model, or nullptr to use the hardware.
+    */
+    void setRegisterAccess(BtI2cRegisterAccessClass* registerAccess)
+    {
+        m_registerAccess = registerAccess;
+        m_controllerInitialized = FALSE;
+    }
+
+    /// Determine whether this controller is running against a software register model.
+    BOOL hasRegisterModel() const override
+    {
+        return (m_registerAccess != nullptr);
+    }
+
     //
     // I2C Controller accessor methods.  These methods assume the I2C Controller
     // has already been mapped using mapIfNeeded().
@@ -69,34 +130,46 @@ public:
 
     BOOL txFifoFull() const override
     {
-        return (m_registers->IC_STATUS.TFNF == 0);
+        _IC_STATUS statusReg;
+        statusReg.ALL_BITS = _readReg(BT_IC_STATUS_OFFSET);
+        return (statusReg.TFNF == 0);
     }
 
     BOOL txFifoEmpty() const override
     {
-        return (m_registers->IC_STATUS.TFE == 1);
+        _IC_STATUS statusReg;
+        statusReg.ALL_BITS = _readReg(BT_IC_STATUS_OFFSET);
+        return (statusReg.TFE == 1);
     }
 
     BOOL rxFifoNotEmtpy() const override
     {
-        return (m_registers->IC_STATUS.RFNE == 1);
+        _IC_STATUS statusReg;
+        statusReg.ALL_BITS = _readReg(BT_IC_STATUS_OFFSET);
+        return (statusReg.RFNE == 1);
     }
 
     BOOL rxFifoEmpty() const override
     {
-        return (m_registers->IC_STATUS.RFNE == 0);
+        _IC_STATUS statusReg;
+        statusReg.ALL_BITS = _readReg(BT_IC_STATUS_OFFSET);
+        return (statusReg.RFNE == 0);
     }
 
     LIGHTNING_DLL_API HRESULT _performContiguousTransfers(I2cTransferClass* & pXfr) override;
 
     UCHAR readByte() override
     {
-        return (m_registers->IC_DATA_CMD.DAT);
+        _IC_DATA_CMD dataReg;
+        dataReg.ALL_BITS = _readReg(BT_IC_DATA_CMD_OFFSET);
+        return (UCHAR)dataReg.DAT;
     }
 
     BOOL isActive() const override
     {
-        return (m_registers->IC_STATUS.MST_ACTIVITY == 1);
+        _IC_STATUS statusReg;
+        statusReg.ALL_BITS = _readReg(BT_IC_STATUS_OFFSET);
+        return (statusReg.MST_ACTIVITY == 1);
     }
 
     /// Determine whether a TX Error has occurred or not.
@@ -107,7 +180,9 @@ public:
     */
     BOOL errorOccurred() override
     {
-        return (m_registers->IC_RAW_INTR_STAT.TX_ABRT == 1);
+        _IC_RAW_INTR_STAT rawIntrReg;
+        rawIntrReg.ALL_BITS = _readReg(BT_IC_RAW_INTR_STAT_OFFSET);
+        return (rawIntrReg.TX_ABRT == 1);
     }
 
     /// Determine if an I2C address was sent but not acknowledged by any slave.
@@ -119,7 +194,9 @@ public:
     */
     BOOL addressWasNacked() override
     {
-        return (m_registers->IC_TX_ABRT_SOURCE.ABRT_7B_ADDR_NOACK == 1);
+        _IC_TX_ABRT_SOURCE abrtSourceReg;
+        abrtSourceReg.ALL_BITS = _readReg(BT_IC_TX_ABRT_SOURCE_OFFSET);
+        return (abrtSourceReg.ABRT_7B_ADDR_NOACK == 1);
     }
 
     /// Determine if I2C data was sent but not acknowledged by a slave.
@@ -131,7 +208,9 @@ public:
     */
     BOOL dataWasNacked() override
     {
-        return (m_registers->IC_TX_ABRT_SOURCE.ABRT_TXDATA_NOACK == 1);
+        _IC_TX_ABRT_SOURCE abrtSourceReg;
+        abrtSourceReg.ALL_BITS = _readReg(BT_IC_TX_ABRT_SOURCE_OFFSET);
+        return (abrtSourceReg.ABRT_TXDATA_NOACK == 1);
     }
 
     /// Handle any errors that have occurred during an I2C transaction.
@@ -179,7 +258,7 @@ public:
     */
     void clearErrors() override
     {
-        ULONG dummy = m_registers->IC_CLR_TX_ABRT.ALL_BITS;
+        ULONG dummy = _readReg(BT_IC_CLR_TX_ABRT_OFFSET);
     }
 
 private:
@@ -447,8 +526,8 @@ private:
     // I2C Transmit FIFO Level Register.
     typedef union {
         struct {
-            ULONG TXFLR : 5;                // Count of valid data entries in TX FIFO
-            ULONG _rsv : 27;                // Reserved
+            ULONG TXFLR : 8;                // Count of valid data entries in TX FIFO
+            ULONG _rsv : 24;                // Reserved
         };
         ULONG ALL_BITS;
     } _IC_TXFLR;
@@ -456,8 +535,8 @@ private:
     // I2C Receive FIFO Level Register.
     typedef union {
         struct {
-            ULONG RXFLR : 5;                // Count of valid data entries in RX FIFO
-            ULONG _rsv : 27;                // Reserved
+            ULONG RXFLR : 8;                // Count of valid data entries in RX FIFO
+            ULONG _rsv : 24;                // Reserved
         };
         ULONG ALL_BITS;
     } _IC_RXFLR;
@@ -508,6 +587,22 @@ private:
         ULONG ALL_BITS;
     } _IC_FS_SPKLEN;
 
+    // Component Parameter Register 1.
+    typedef union {
+        struct {
+            ULONG APB_DATA_WIDTH : 2;       // 0: 8 bits, 1: 16 bits, 2: 32 bits
+            ULONG MAX_SPEED_MODE : 2;       // 1: standard, 2: fast, 3: high
+            ULONG HC_COUNT_VALUES : 1;      // 1: SCL count registers are read-only
+            ULONG INTR_IO : 1;              // 0: individual interrupts, 1: combined interrupt
+            ULONG HAS_DMA : 1;              // 1: DMA handshaking signals are present
+            ULONG ADD_ENCODED_PARAMS : 1;   // 1: this register contains valid parameters
+            ULONG RX_BUFFER_DEPTH : 8;      // Depth of the RX FIFO minus one
+            ULONG TX_BUFFER_DEPTH : 8;      // Depth of the TX FIFO minus one
+            ULONG _rsv : 8;                 // Reserved
+        };
+        ULONG ALL_BITS;
+    } _IC_COMP_PARAM_1;
+
     #pragma warning( pop )
 
     // Layout of the BayTrail I2C Controller registers in memory.
@@ -546,6 +641,8 @@ private:
         ULONG                       _reserved5[6];      // 0x84 - 0x9B
         volatile _IC_ENABLE_STATUS  IC_ENABLE_STATUS;   // 0x9C - Enable Status
         volatile _IC_FS_SPKLEN      IC_FS_SPKLEN;       // 0xA0 - SS and FS Spike Suppression Limit
+        ULONG                       _reserved6[20];     // 0xA4 - 0xF3
+        volatile _IC_COMP_PARAM_1   IC_COMP_PARAM_1;    // 0xF4 - Component Parameter Register 1
     } I2C_CONTROLLER, *PI2C_CONTROLLER;
 
     //
@@ -556,11 +653,61 @@ private:
     // they are mapped into this process' address space.
     PI2C_CONTROLLER m_registers;
 
+    // Software register model used in place of the hardware, if any.
+    BtI2cRegisterAccessClass* m_registerAccess;
+
+    // Read a controller register.
+    ULONG _readReg(ULONG offset) const
+    {
+        if (m_registerAccess != nullptr)
+        {
+            return m_registerAccess->readRegister(offset);
+        }
+        return *((volatile ULONG*)(((PUCHAR)m_registers) + offset));
+    }
+
+    // Write a controller register.
+    void _writeReg(ULONG offset, ULONG value)
+    {
+        if (m_registerAccess != nullptr)
+        {
+            m_registerAccess->writeRegister(offset, value);
+        }
+        else
+        {
+            *((volatile ULONG*)(((PUCHAR)m_registers) + offset)) = value;
+        }
+    }
+
     // Method to map the I2C controller into this process' virtual address space.
     LIGHTNING_DLL_API HRESULT _mapController() override;
 
+    // Method to calculate the SCL high and low counts for a desired clock rate.
+    HRESULT _calculateSclCounts(ULONG clockHz, ULONG & hcnt, ULONG & lcnt, ULONG & speed);
+
+    // Method to read the TX and RX FIFO depths the controller was built with.
+    void _readFifoDepths();
+
+    // Method to move all bytes currently in the RX FIFO to the read transfers.
+    LONG _drainRxFifo(I2cTransferClass* & readXfr, PUCHAR & readPtr);
+
     // TRUE if the controller has been initialized.
     BOOL m_controllerInitialized;
+
+    // The clock rate (in Hz) requested when the controller was last initialized.
+    ULONG m_configuredClockHz;
+
+    // Frequency of the clock that drives the I2C controller (ic_clk).
+    const ULONG BT_I2C_INPUT_CLOCK_HZ = 100000000;
+
+    // FIFO depth to assume if the controller does not report its parameters.
+    static const LONG BT_I2C_DEFAULT_FIFO_DEPTH = 16;
+
+    // Number of entries in the TX FIFO.
+    LONG m_txFifoDepth;
+
+    // Number of entries in the RX FIFO.
+    LONG m_rxFifoDepth;
 };
 
 #endif // _BT_I2C_CONTROLLER_H_
\ No newline at end of file
@@ -0,0 +1,576 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#ifndef _BT_I2C_MODEL_H_
+#define _BT_I2C_MODEL_H_
+
+#include <Windows.h>
+#include <deque>
+#include <map>
+
+#include "BtI2cController.h"
+#include "I2cModelSlave.h"
+
+//
+// Cycle-approximate software model of the BayTrail (Synopsys DesignWare) I2C
+// Controller in master mode.
+//
+// The model implements the registers the controller code uses, the command (TX)
+// and RX FIFOs with configurable depths reported through IC_COMP_PARAM_1, the
+// STOP and RESTART command bits, restarts on a change of direction, and transmit
+// aborts on an address or data NACK.  Time is simulated: each register access
+// advances the model clock by a fixed cost, and the bus moves one command for
+// every nine SCL periods (plus any clock stretching) that have elapsed, with the
+// SCL period set by the speed mode and the SCL high and low count registers.
+// Like the hardware, the master holds SCL low when the TX FIFO runs dry before a
+// command with the STOP bit has been issued.  Unlike the BCM controller it does
+// not stall when the RX FIFO is full: the byte is lost and RX_OVER is set, so the
+// model counts RX overflows to show whether the software kept up.
+//
+class BtI2cModelClass : public BtI2cRegisterAccessClass
+{
+public:
+    BtI2cModelClass(ULONG txFifoDepth = 64, ULONG rxFifoDepth = 64) :
+        m_accessNs(100),
+        m_nowNs(0),
+        m_busCreditNs(0),
+        m_registerAccesses(0),
+        m_busBytes(0),
+        m_rxOverflows(0),
+        m_maxRxLevel(0)
+    {
+        m_txFifoDepth = txFifoDepth;
+        m_rxFifoDepth = rxFifoDepth;
+        m_reportParams = TRUE;
+        _reset();
+    }
+
+    virtual ~BtI2cModelClass()
+    {
+    }
+
+    /// Attach a simulated slave to the bus at a 7-bit address.
+    void attachSlave(ULONG address, I2cModelSlaveClass* slave)
+    {
+        m_slaves[address & 0x7F] = slave;
+    }
+
+    /// Set whether IC_COMP_PARAM_1 reports the FIFO depths, or reads as zero.
+    void setReportParams(BOOL reportParams)
+    {
+        m_reportParams = reportParams;
+    }
+
+    /// Set the simulated time cost of one register access, in nanoseconds.
+    void setAccessNs(ULONG accessNs)
+    {
+        m_accessNs = accessNs;
+    }
+
+    /// Get the simulated time that has elapsed, in nanoseconds.
+    ULONGLONG getSimulatedNs() const
+    {
+        return m_nowNs;
+    }
+
+    /// Get the number of register reads and writes performed.
+    ULONGLONG getRegisterAccesses() const
+    {
+        return m_registerAccesses;
+    }
+
+    /// Get the number of address and data bytes moved on the bus.
+    ULONGLONG getBusBytes() const
+    {
+        return m_busBytes;
+    }
+
+    /// Get the number of bytes lost because the RX FIFO was full.
+    ULONGLONG getRxOverflows() const
+    {
+        return m_rxOverflows;
+    }
+
+    /// Get the highest number of bytes seen waiting in the RX FIFO.
+    ULONG getMaxRxLevel() const
+    {
+        return m_maxRxLevel;
+    }
+
+    /// Zero the time and access counters.
+    void resetCounters()
+    {
+        m_nowNs = 0;
+        m_registerAccesses = 0;
+        m_busBytes = 0;
+        m_rxOverflows = 0;
+        m_maxRxLevel = 0;
+    }
+
+    ULONG readRegister(ULONG offset) override
+    {
+        ULONG value = 0;
+
+        _access();
+
+        switch (offset)
+        {
+        case BT_IC_CON_OFFSET:
+            value = m_con;
+            break;
+        case BT_IC_TAR_OFFSET:
+            value = m_tar;
+            break;
+        case BT_IC_DATA_CMD_OFFSET:
+            if (!m_rxFifo.empty())
+            {
+                value = m_rxFifo.front();
+                m_rxFifo.pop_front();
+            }
+            else
+            {
+                m_rawIntr |= INTR_RX_UNDER;
+            }
+            break;
+        case BT_IC_SS_SCL_HCNT_OFFSET:
+            value = m_ssHcnt;
+            break;
+        case BT_IC_SS_SCL_LCNT_OFFSET:
+            value = m_ssLcnt;
+            break;
+        case BT_IC_FS_SCL_HCNT_OFFSET:
+            value = m_fsHcnt;
+            break;
+        case BT_IC_FS_SCL_LCNT_OFFSET:
+            value = m_fsLcnt;
+            break;
+        case BT_IC_INTR_MASK_OFFSET:
+            value = m_intrMask;
+            break;
+        case BT_IC_RAW_INTR_STAT_OFFSET:
+            value = m_rawIntr;
+            break;
+        case BT_IC_CLR_INTR_OFFSET:
+            // Reading this register clears all software clearable interrupts.
+            m_rawIntr &= ~(INTR_RX_UNDER | INTR_RX_OVER | INTR_TX_OVER | INTR_TX_ABRT |
+                INTR_ACTIVITY | INTR_STOP_DET | INTR_START_DET);
+            m_abrtSource = 0;
+            break;
+        case BT_IC_CLR_TX_ABRT_OFFSET:
+            m_rawIntr &= ~INTR_TX_ABRT;
+            m_abrtSource = 0;
+            break;
+        case BT_IC_ENABLE_OFFSET:
+            value = m_enable ? 1 : 0;
+            break;
+        case BT_IC_STATUS_OFFSET:
+            value = _status();
+            break;
+        case BT_IC_TXFLR_OFFSET:
+            value = (ULONG)m_txFifo.size();
+            break;
+        case BT_IC_RXFLR_OFFSET:
+            value = (ULONG)m_rxFifo.size();
+            break;
+        case BT_IC_TX_ABRT_SOURCE_OFFSET:
+            value = m_abrtSource;
+            break;
+        case BT_IC_ENABLE_STATUS_OFFSET:
+            value = m_enable ? 1 : 0;
+            break;
+        case BT_IC_FS_SPKLEN_OFFSET:
+            value = m_spkLen;
+            break;
+        case BT_IC_COMP_PARAM_1_OFFSET:
+            if (m_reportParams)
+            {
+                value = PARAM_ADD_ENCODED_PARAMS |
+                    (((ULONG)m_rxFifoDepth - 1) << 8) |     // RX_BUFFER_DEPTH
+                    (((ULONG)m_txFifoDepth - 1) << 16);     // TX_BUFFER_DEPTH
+            }
+            break;
+        }
+
+        return value;
+    }
+
+    void writeRegister(ULONG offset, ULONG value) override
+    {
+        _access();
+
+        switch (offset)
+        {
+        case BT_IC_CON_OFFSET:
+            m_con = value & 0x7F;
+            break;
+        case BT_IC_TAR_OFFSET:
+            m_tar = value & 0x1FFF;
+            break;
+        case BT_IC_DATA_CMD_OFFSET:
+            // Commands are dropped while disabled or while a transmit abort is pending.
+            if (!m_enable || (m_rawIntr & INTR_TX_ABRT))
+            {
+                break;
+            }
+            if (m_txFifo.size() >= m_txFifoDepth)
+            {
+                m_rawIntr |= INTR_TX_OVER;
+                break;
+            }
+            m_txFifo.push_back(value & 0x7FF);
+            break;
+        case BT_IC_SS_SCL_HCNT_OFFSET:
+            m_ssHcnt = value & 0xFFFF;
+            break;
+        case BT_IC_SS_SCL_LCNT_OFFSET:
+            m_ssLcnt = value & 0xFFFF;
+            break;
+        case BT_IC_FS_SCL_HCNT_OFFSET:
+            m_fsHcnt = value & 0xFFFF;
+            break;
+        case BT_IC_FS_SCL_LCNT_OFFSET:
+            m_fsLcnt = value & 0xFFFF;
+            break;
+        case BT_IC_INTR_MASK_OFFSET:
+            m_intrMask = value & 0x7FF;
+            break;
+        case BT_IC_ENABLE_OFFSET:
+            _writeEnable((value & 1) != 0);
+            break;
+        case BT_IC_FS_SPKLEN_OFFSET:
+            m_spkLen = value & 0xFF;
+            break;
+        }
+    }
+
+private:
+
+    // Data command register bits.
+    static const ULONG CMD_READ = 0x100;
+    static const ULONG CMD_STOP = 0x200;
+    static const ULONG CMD_RESTART = 0x400;
+
+    // Raw interrupt status bits.
+    static const ULONG INTR_RX_UNDER = 0x001;
+    static const ULONG INTR_RX_OVER = 0x002;
+    static const ULONG INTR_TX_OVER = 0x008;
+    static const ULONG INTR_TX_ABRT = 0x040;
+    static const ULONG INTR_ACTIVITY = 0x100;
+    static const ULONG INTR_STOP_DET = 0x200;
+    static const ULONG INTR_START_DET = 0x400;
+
+    // Status register bits.
+    static const ULONG STATUS_ACTIVITY = 0x01;
+    static const ULONG STATUS_TFNF = 0x02;
+    static const ULONG STATUS_TFE = 0x04;
+    static const ULONG STATUS_RFNE = 0x08;
+    static const ULONG STATUS_RFF = 0x10;
+    static const ULONG STATUS_MST_ACTIVITY = 0x20;
+
+    // Transmit abort source bits.
+    static const ULONG ABRT_7B_ADDR_NOACK = 0x01;
+    static const ULONG ABRT_TXDATA_NOACK = 0x08;
+
+    // Component parameter bit that says the register holds valid parameters.
+    static const ULONG PARAM_ADD_ENCODED_PARAMS = 0x80;
+
+    // Controller input clock (ic_clk) period in nanoseconds.
+    static const ULONG IC_CLK_NS = 10;
+
+    // Bus phases.
+    enum BUS_PHASE {
+        IDLE,               // No transfer active
+        ADDRESS,            // START (or restart) and slave address
+        DATA,               // Executing commands from the TX FIFO
+        HOLD                // Waiting for the software to queue the next command
+    };
+
+    /// Put the registers in their reset state.
+    void _reset()
+    {
+        m_con = 0x65;
+        m_tar = 0x55;
+        m_ssHcnt = 0x190;
+        m_ssLcnt = 0x1D6;
+        m_fsHcnt = 0x3C;
+        m_fsLcnt = 0x82;
+        m_intrMask = 0x8FF;
+        m_rawIntr = 0;
+        m_abrtSource = 0;
+        m_enable = FALSE;
+        m_spkLen = 0x05;
+        m_phase = IDLE;
+        m_isRead = FALSE;
+        m_slave = nullptr;
+        m_txFifo.clear();
+        m_rxFifo.clear();
+    }
+
+    /// Account for one register access and let the bus catch up.
+    void _access()
+    {
+        m_registerAccesses++;
+        m_nowNs += m_accessNs;
+        _advance(m_accessNs);
+    }
+
+    /// Get the length of one SCL period in nanoseconds.
+    ULONGLONG _sclPeriodNs() const
+    {
+        ULONG speed = (m_con >> 1) & 0x3;
+        ULONG hcnt = (speed == 1) ? m_ssHcnt : m_fsHcnt;
+        ULONG lcnt = (speed == 1) ? m_ssLcnt : m_fsLcnt;
+
+        // The high period is stretched by the spike suppression length plus seven
+        // ic_clk cycles, and the low period by one cycle.
+        return (ULONGLONG)(hcnt + m_spkLen + 7 + lcnt + 1) * IC_CLK_NS;
+    }
+
+    /// Compose the status register.
+    ULONG _status() const
+    {
+        ULONG status = 0;
+
+        if (m_phase != IDLE)
+        {
+            status |= STATUS_ACTIVITY | STATUS_MST_ACTIVITY;
+        }
+        if (m_txFifo.size() < m_txFifoDepth)
+        {
+            status |= STATUS_TFNF;
+        }
+        if (m_txFifo.empty())
+        {
+            status |= STATUS_TFE;
+        }
+        if (!m_rxFifo.empty())
+        {
+            status |= STATUS_RFNE;
+        }
+        if (m_rxFifo.size() >= m_rxFifoDepth)
+        {
+            status |= STATUS_RFF;
+        }
+        return status;
+    }
+
+    /// Handle a write to the enable register.
+    void _writeEnable(BOOL enable)
+    {
+        if (!enable)
+        {
+            // Disabling the controller flushes the FIFOs and abandons any transfer.
+            if (m_phase != IDLE)
+            {
+                _stop();
+            }
+            m_txFifo.clear();
+            m_rxFifo.clear();
+        }
+        m_enable = enable;
+    }
+
+    /// Begin a new segment with a START or restart and the slave address.
+    void _startSegment(BOOL isRead)
+    {
+        std::map<ULONG, I2cModelSlaveClass*>::iterator slave = m_slaves.find(m_tar & 0x7F);
+
+        m_slave = (slave == m_slaves.end()) ? nullptr : slave->second;
+        m_isRead = isRead;
+        m_phase = ADDRESS;
+        m_rawIntr |= INTR_START_DET | INTR_ACTIVITY;
+    }
+
+    /// End the transfer with a STOP.
+    void _stop()
+    {
+        if (m_slave != nullptr)
+        {
+            m_slave->stop();
+        }
+        m_phase = IDLE;
+        m_rawIntr |= INTR_STOP_DET;
+        m_busCreditNs = 0;
+    }
+
+    /// Abort the transfer after a NACK: flush the TX FIFO and send a STOP.
+    void _abort(ULONG source)
+    {
+        m_abrtSource |= source;
+        m_rawIntr |= INTR_TX_ABRT;
+        m_txFifo.clear();
+        _stop();
+    }
+
+    /// Move the bus forward by an amount of simulated time.
+    void _advance(ULONGLONG ns)
+    {
+        ULONGLONG period = _sclPeriodNs();
+        ULONGLONG cost = 0;
+        ULONG stretch = 0;
+        ULONG cmd = 0;
+        BOOL cmdIsRead = FALSE;
+        BOOL stalled = FALSE;
+
+        if (!m_enable || ((m_phase == IDLE) && m_txFifo.empty()))
+        {
+            return;
+        }
+
+        m_busCreditNs += ns;
+
+        while (!stalled)
+        {
+            // Clock stretching by the slave delays each address and data byte.
+            stretch = (m_slave == nullptr) ? 0 : m_slave->stretchClocks();
+
+            switch (m_phase)
+            {
+            case IDLE:
+            case HOLD:
+                if (m_txFifo.empty())
+                {
+                    // With no command to execute, an active master holds SCL low.
+                    if (m_phase == HOLD)
+                    {
+                        m_busCreditNs = 0;
+                    }
+                    stalled = TRUE;
+                    break;
+                }
+
+                cmd = m_txFifo.front();
+                cmdIsRead = ((cmd & CMD_READ) != 0);
+
+                // A START begins each transfer, and a restart is sent when the
+                // direction changes or the command asks for one.
+                if ((m_phase == IDLE) || (cmdIsRead != m_isRead) || (cmd & CMD_RESTART))
+                {
+                    _startSegment(cmdIsRead);
+                }
+                else
+                {
+                    m_phase = DATA;
+                }
+                break;
+
+            case ADDRESS:
+                cost = (10 + stretch) * period;
+                if (m_busCreditNs < cost)
+                {
+                    stalled = TRUE;
+                    break;
+                }
+                m_busCreditNs -= cost;
+                m_busBytes++;
+
+                if ((m_slave == nullptr) || !m_slave->start(m_isRead))
+                {
+                    _abort(ABRT_7B_ADDR_NOACK);
+                }
+                else
+                {
+                    m_phase = DATA;
+                }
+                break;
+
+            case DATA:
+                cost = (9 + stretch) * period;
+                if (m_busCreditNs < cost)
+                {
+                    stalled = TRUE;
+                    break;
+                }
+                m_busCreditNs -= cost;
+                m_busBytes++;
+
+                cmd = m_txFifo.front();
+                m_txFifo.pop_front();
+
+                if (m_isRead)
+                {
+                    if (m_rxFifo.size() < m_rxFifoDepth)
+                    {
+                        m_rxFifo.push_back(m_slave->readByte());
+                        if (m_rxFifo.size() > m_maxRxLevel)
+                        {
+                            m_maxRxLevel = (ULONG)m_rxFifo.size();
+                        }
+                    }
+                    else
+                    {
+                        m_slave->readByte();
+                        m_rawIntr |= INTR_RX_OVER;
+                        m_rxOverflows++;
+                    }
+                }
+                else if (!m_slave->writeByte((UCHAR)(cmd & 0xFF)))
+                {
+                    _abort(ABRT_TXDATA_NOACK);
+                    break;
+                }
+
+                if (cmd & CMD_STOP)
+                {
+                    cost = period;
+                    m_busCreditNs = (m_busCreditNs > cost) ? (m_busCreditNs - cost) : 0;
+                    _stop();
+                }
+                else
+                {
+                    m_phase = HOLD;
+                }
+                break;
+
+            default:
+                stalled = TRUE;
+                break;
+            }
+        }
+    }
+
+    //
+    // Register state.
+    //
+
+    ULONG m_con;                // Control register
+    ULONG m_tar;                // Target address register
+    ULONG m_ssHcnt;             // Standard speed SCL high count
+    ULONG m_ssLcnt;             // Standard speed SCL low count
+    ULONG m_fsHcnt;             // Fast speed SCL high count
+    ULONG m_fsLcnt;             // Fast speed SCL low count
+    ULONG m_intrMask;           // Interrupt mask
+    ULONG m_rawIntr;            // Raw interrupt status
+    ULONG m_abrtSource;         // Transmit abort source
+    BOOL m_enable;              // Controller enabled
+    ULONG m_spkLen;             // Spike suppression limit
+    std::deque<ULONG> m_txFifo; // TX (command) FIFO
+    std::deque<UCHAR> m_rxFifo; // RX FIFO
+
+    //
+    // Bus state.
+    //
+
+    size_t m_txFifoDepth;                   // Depth of the TX FIFO
+    size_t m_rxFifoDepth;                   // Depth of the RX FIFO
+    BOOL m_reportParams;                    // TRUE if IC_COMP_PARAM_1 is implemented
+    BUS_PHASE m_phase;                      // Current bus phase
+    BOOL m_isRead;                          // Direction of the current segment
+    I2cModelSlaveClass* m_slave;            // Slave addressed by the current segment
+    std::map<ULONG, I2cModelSlaveClass*> m_slaves;  // Attached slaves by address
+
+    //
+    // Simulated time and counters.
+    //
+
+    ULONG m_accessNs;                       // Simulated cost of a register access
+    ULONGLONG m_nowNs;                      // Simulated time
+    ULONGLONG m_busCreditNs;                // Time the bus has not used yet
+    ULONGLONG m_registerAccesses;           // Register reads and writes
+    ULONGLONG m_busBytes;                   // Address and data bytes on the bus
+    ULONGLONG m_rxOverflows;                // Bytes lost to a full RX FIFO
+    ULONG m_maxRxLevel;                     // Highest RX FIFO level seen
+};
+
+#endif  // _BT_I2C_MODEL_H_
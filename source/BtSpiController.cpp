@@ -84,6 +84,7 @@ BtSpiControllerClass::BtSpiControllerClass()
 {
     m_hController = INVALID_HANDLE_VALUE;
     m_registers = nullptr;
+    m_registerAccess = nullptr;
 
     // Load values for the SPI clock generators.
     spiSpeed15mhz = { 3, 4, 4 };    // Fastest supported SPI clock on BayTrail is 15mhz
@@ -133,14 +134,14 @@ HRESULT BtSpiControllerClass::begin(ULONG busNumber, ULONG mode, ULONG clockKhz,
             hr = DMAP_E_SPI_BUS_REQUESTED_DOES_NOT_EXIST;
         }
 
-        if (SUCCEEDED(hr))
+        // There is nothing to map if the controller is being run against a register model.
+        if (SUCCEEDED(hr) && (m_registerAccess == nullptr))
         {
             // Open the Dmap device for the SPI controller.
             hr = GetControllerBaseAddress(deviceName, m_hController, baseAddress);
             if (SUCCEEDED(hr))
             {
                 m_registers = (PSPI_CONTROLLER)baseAddress;
-                m_registersUpper = (PSPI_CONTROLLER_UPPER)(((PBYTE)baseAddress) + SPI_CONTROLLER_UPPER_OFFSET);
             }
         }
 
@@ -148,15 +149,15 @@ HRESULT BtSpiControllerClass::begin(ULONG busNumber, ULONG mode, ULONG clockKhz,
         {
             // We now "own" the SPI controller, intialize it.
             sscr0.ALL_BITS = 0;
-            m_registers->SSCR0.ALL_BITS = sscr0.ALL_BITS;  // Disable controller
+            _writeReg(BT_SPI_SSCR0_OFFSET, sscr0.ALL_BITS);  // Disable controller
 
             sscr0.DSS = (dataBits - 1) & 0x0F;             // Data width ls4bits
             sscr0.EDSS = ((dataBits - 1) >> 4) & 0x01;     // Data width msbit
             sscr0.RIM = 1;                                 // Mask RX FIFO Over Run interrupts
             sscr0.TIM = 1;                                 // Mask TX FIFO Under Run interrupts
-            m_registers->SSCR0.ALL_BITS = sscr0.ALL_BITS;
+            _writeReg(BT_SPI_SSCR0_OFFSET, sscr0.ALL_BITS);
 
-            m_registers->SSCR1.ALL_BITS = 0;              // Master mode, interrupts disabled
+            _writeReg(BT_SPI_SSCR1_OFFSET, 0);            // Master mode, interrupts disabled
 
             sssr.ALL_BITS = 0;
             sssr.ROR = 1;                                  // Clear any Receive Overrun int
@@ -165,7 +166,7 @@ HRESULT BtSpiControllerClass::begin(ULONG busNumber, ULONG mode, ULONG clockKhz,
             sssr.EOC = 1;                                  // Clear any End of Chain int
             sssr.TUR = 1;                                  // Clear any Transmit FIFO Under Run int
             sssr.BCE = 1;                                  // Clear any Bit Count Error
-            m_registers->SSSR.ALL_BITS = sssr.ALL_BITS;
+            _writeReg(BT_SPI_SSSR_OFFSET, sssr.ALL_BITS);
 
             hr = setMode(mode);
             
@@ -186,12 +187,15 @@ Unmap and close the SPI controller associated with this object.
 */
 void BtSpiControllerClass::end()
 {
-    if (m_registers != nullptr)
+    _SSCR0 sscr0;
+
+    if (_registersAvailable())
     {
         // Disable the SPI controller.
-        m_registers->SSCR0.SSE = 0;
+        sscr0.ALL_BITS = _readReg(BT_SPI_SSCR0_OFFSET);
+        sscr0.SSE = 0;
+        _writeReg(BT_SPI_SSCR0_OFFSET, sscr0.ALL_BITS);
         m_registers = nullptr;
-        m_registersUpper = nullptr;
     }
 
     if (m_hController != INVALID_HANDLE_VALUE)
@@ -217,7 +221,7 @@ HRESULT BtSpiControllerClass::setMode(ULONG mode)
 
 
     // If we don't have the controller registers mapped, fail.
-    if (m_registers == nullptr)
+    if (!_registersAvailable())
     {
         hr = DMAP_E_DMAP_INTERNAL_ERROR;
     }
@@ -251,10 +255,10 @@ HRESULT BtSpiControllerClass::setMode(ULONG mode)
     // Set the SPI phase and polarity values in the SPI controller registers.
     if (SUCCEEDED(hr))
     {
-        sscr1.ALL_BITS = m_registers->SSCR1.ALL_BITS;
+        sscr1.ALL_BITS = _readReg(BT_SPI_SSCR1_OFFSET);
         sscr1.SPO = polarity;
         sscr1.SPH = phase;
-        m_registers->SSCR1.ALL_BITS = sscr1.ALL_BITS;
+        _writeReg(BT_SPI_SSCR1_OFFSET, sscr1.ALL_BITS);
     }
 
     return hr;
@@ -275,7 +279,7 @@ HRESULT BtSpiControllerClass::setClock(ULONG clockKhz)
 
 
     // If we don't have the controller registers mapped, fail.
-    if (m_registers == nullptr)
+    if (!_registersAvailable())
     {
         hr = DMAP_E_DMAP_INTERNAL_ERROR;
     }
@@ -352,16 +356,20 @@ HRESULT BtSpiControllerClass::setClock(ULONG clockKhz)
     if (SUCCEEDED(hr))
     {
         // Set the clock rate.
-        sscr0.ALL_BITS = m_registers->SSCR0.ALL_BITS;
+        sscr0.ALL_BITS = _readReg(BT_SPI_SSCR0_OFFSET);
         sscr0.SCR = pSpeed->SCR;
-        m_registers->SSCR0.ALL_BITS = sscr0.ALL_BITS;
+        _writeReg(BT_SPI_SSCR0_OFFSET, sscr0.ALL_BITS);
 
-        prvClockParams.ALL_BITS = m_registersUpper->PRV_CLOCK_PARAMS.ALL_BITS;
+        prvClockParams.ALL_BITS = _readReg(BT_SPI_PRV_CLOCK_PARAMS_OFFSET);
         prvClockParams.M_VAL = pSpeed->M_VALUE;
         prvClockParams.N_VAL = pSpeed->N_VALUE;
         prvClockParams.CLK_UPDATE = 1;
         prvClockParams.CLK_EN = 1;
-        m_registersUpper->PRV_CLOCK_PARAMS.ALL_BITS = prvClockParams.ALL_BITS;
+        _writeReg(BT_SPI_PRV_CLOCK_PARAMS_OFFSET, prvClockParams.ALL_BITS);
+        m_clockKhz = clockKhz;
+
+        // SPI clock is 100 mhz * (M / N) / (SCR + 1).
+        m_actualClockHz = (ULONG)((100000000ULL * pSpeed->M_VALUE) / pSpeed->N_VALUE / (pSpeed->SCR + 1));
     }
     
     return hr;
@@ -369,7 +377,9 @@ HRESULT BtSpiControllerClass::setClock(ULONG clockKhz)
 
 
 /**
-This method transfers a buffer of data on the bus.
+This method transfers a buffer of data on the bus.  The TX FIFO is kept filled while the
+RX FIFO is drained, so the bus does not sit idle between bytes.  No more than a FIFO's
+worth of bytes are sent ahead of those received, so the RX FIFO can never overrun.
 \param[in] dataOut The data to send on the SPI bus. If the parameter is NULL, 0's will be sent
 \param[in] datIn The data received on the SPI bus. If this parameter is NULL, data in will be ignored
 \param[in] bufferBytes the size of each of the buffers
@@ -377,21 +387,75 @@ This method transfers a buffer of data on the bus.
 */
 HRESULT BtSpiControllerClass::transferBuffer(PBYTE dataOut, PBYTE dataIn, size_t bufferBytes)
 {
-    ULONG tempDataIn = 0;
-    HRESULT hr;
-    for (size_t i = 0; i < bufferBytes; i++)
+    HRESULT hr = S_OK;
+    size_t bytesWritten = 0;
+    size_t bytesRead = 0;
+    size_t bytesReadBefore;
+    ULONG rxData;
+    BYTE txData;
+    BOOL lsbFirst = _isLsbFirst();
+    _SSCR0 sscr0;
+    LONGLONG startTicks;
+    LONGLONG spinStart = 0;
+
+
+    if (!_registersAvailable())
     {
-        hr = _transfer(dataOut ? dataOut[i] : 0, tempDataIn, 8);
+        hr = DMAP_E_DMAP_INTERNAL_ERROR;
+    }
 
-        if (FAILED(hr))
-        {
-            break;
-        }
+    if (SUCCEEDED(hr))
+    {
+        m_counters.startTiming(startTicks);
+
+        // Make sure the SPI bus is enabled.
+        sscr0.ALL_BITS = _readReg(BT_SPI_SSCR0_OFFSET);
+        sscr0.SSE = 1;
+        _writeReg(BT_SPI_SSCR0_OFFSET, sscr0.ALL_BITS);
 
-        if (dataIn)
+        while (bytesRead < bufferBytes)
         {
-            dataIn[i] = (BYTE)tempDataIn;
+            // Top up the TX FIFO.  Since the bytes in flight never exceed the FIFO depth,
+            // there is room for them without checking the FIFO status.
+            while ((bytesWritten < bufferBytes) && ((bytesWritten - bytesRead) < SSP_FIFO_DEPTH))
+            {
+                txData = dataOut ? dataOut[bytesWritten] : 0;
+                if (lsbFirst)
+                {
+                    txData = _reverseBits(txData);
+                }
+                _writeReg(BT_SPI_SSDR_OFFSET, txData);
+                bytesWritten++;
+            }
+
+            // Read all the data that has been received so far.
+            bytesReadBefore = bytesRead;
+            while ((bytesRead < bytesWritten) && (_readStatus().RNE != 0))
+            {
+                rxData = _readReg(BT_SPI_SSDR_OFFSET);
+                if (dataIn)
+                {
+                    dataIn[bytesRead] = lsbFirst ? _reverseBits((BYTE)rxData) : (BYTE)(rxData & 0x000000FF);
+                }
+                bytesRead++;
+            }
+
+            // Time the passes that find no received data, waiting for the bus.
+            if (bytesRead == bytesReadBefore)
+            {
+                if (spinStart == 0)
+                {
+                    m_counters.startTiming(spinStart);
+                }
+            }
+            else if (spinStart != 0)
+            {
+                m_counters.recordSpin(spinStart);
+                spinStart = 0;
+            }
         }
+
+        m_counters.recordTransfer(startTicks, bufferBytes, m_actualClockHz, hr);
     }
 
     return hr;
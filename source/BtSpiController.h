@@ -10,6 +10,33 @@
 #include "DmapSupport.h"
 #include "BoardPins.h"
 
+//
+// BayTrail SPI Controller register offsets from the controller base address.
+//
+#define BT_SPI_SSCR0_OFFSET             0x00
+#define BT_SPI_SSCR1_OFFSET             0x04
+#define BT_SPI_SSSR_OFFSET              0x08
+#define BT_SPI_SSDR_OFFSET              0x10
+#define BT_SPI_PRV_CLOCK_PARAMS_OFFSET  0x400
+
+//
+// Interface used to substitute a software model for the BayTrail SPI Controller
+// registers, so the controller code can be run and measured without hardware.
+//
+class BtSpiRegisterAccessClass
+{
+public:
+    virtual ~BtSpiRegisterAccessClass()
+    {
+    }
+
+    /// Method to read the 32-bit register at a byte offset from the controller base.
+    virtual ULONG readRegister(ULONG offset) = 0;
+
+    /// Method to write the 32-bit register at a byte offset from the controller base.
+    virtual void writeRegister(ULONG offset, ULONG value) = 0;
+};
+
 
 /// BayTrail SPI Controller Class for use with MinnowBoard Max.
 class BtSpiControllerClass : public SpiControllerClass
@@ -77,6 +104,18 @@ public:
     */
     LIGHTNING_DLL_API HRESULT transferBuffer(PBYTE dataOut, PBYTE dataIn, size_t bufferBytes) override;
 
+    /// Method to run this controller against a software register model.
+    /**
+    When a register model is set, all register reads and writes go to the model
+    instead of the controller hardware, and the hardware is not mapped.  This must
+    be called before begin().
+    \param[in] registerAccess The register model, or nullptr to use the hardware.
+    */
+    void setRegisterAccess(BtSpiRegisterAccessClass* registerAccess)
+    {
+        m_registerAccess = registerAccess;
+    }
+
 private:
 
 #pragma warning(push)
@@ -361,8 +400,8 @@ private:
 
 #pragma warning( pop )
 
-    /// Offset from SPI Controller register base to the upper registers.
-    const ULONG SPI_CONTROLLER_UPPER_OFFSET = 0x400;
+    /// Number of words the SSP TX and RX FIFOs can each hold (they are at least this deep).
+    const ULONG SSP_FIFO_DEPTH = 16;
 
     /// Layout of the BayTrail SPI Controller upper address registers in memory.
     typedef struct _SPI_CONTROLLER_UPPER {
@@ -405,14 +444,51 @@ private:
     /// Pointer to SPI controller registers mapped into this process' address space.
     PSPI_CONTROLLER m_registers;
 
-    /// Pointer to upper SPI controller registers mapped into this process' address space.
-    PSPI_CONTROLLER_UPPER m_registersUpper;
+    /// Software register model used in place of the hardware, if any.
+    BtSpiRegisterAccessClass* m_registerAccess;
 
     /// The minimum width of a transfer on this controller.
     const UINT m_minTransferBits = 4;
 
     /// The maximum width of a transfer on this controller.
     const UINT m_maxTransferBits = 32;
+
+    /// Determine whether the controller registers can be accessed.
+    BOOL _registersAvailable() const
+    {
+        return (m_registers != nullptr) || (m_registerAccess != nullptr);
+    }
+
+    /// Read a controller register.
+    ULONG _readReg(ULONG offset) const
+    {
+        if (m_registerAccess != nullptr)
+        {
+            return m_registerAccess->readRegister(offset);
+        }
+        return *((volatile ULONG*)(((PUCHAR)m_registers) + offset));
+    }
+
+    /// Write a controller register.
+    void _writeReg(ULONG offset, ULONG value)
+    {
+        if (m_registerAccess != nullptr)
+        {
+            m_registerAccess->writeRegister(offset, value);
+        }
+        else
+        {
+            *((volatile ULONG*)(((PUCHAR)m_registers) + offset)) = value;
+        }
+    }
+
+    /// Read the SSP Status Register.
+    _SSSR _readStatus() const
+    {
+        _SSSR sssr;
+        sssr.ALL_BITS = _readReg(BT_SPI_SSSR_OFFSET);
+        return sssr;
+    }
 };
 
 
@@ -431,36 +507,52 @@ inline HRESULT BtSpiControllerClass::_transfer(ULONG dataOut, ULONG & dataIn, UL
     ULONG txData;
     ULONG rxData;
     _SSCR0 sscr0;
+    LONGLONG startTicks;
+    LONGLONG spinStart;
 
 
-    if (m_registers == nullptr)
+    if (!_registersAvailable())
     {
         hr = DMAP_E_DMAP_INTERNAL_ERROR;
     }
 
     if (SUCCEEDED(hr))
     {
+        m_counters.startTiming(startTicks);
+
         txData = dataOut;
         txData = txData & (0xFFFFFFFF >> (32 - bits));
 
         // Make sure the SPI bus is enabled.
-        sscr0.ALL_BITS = m_registers->SSCR0.ALL_BITS;
+        sscr0.ALL_BITS = _readReg(BT_SPI_SSCR0_OFFSET);
         sscr0.SSE = 1;
-        m_registers->SSCR0.ALL_BITS = sscr0.ALL_BITS;
+        _writeReg(BT_SPI_SSCR0_OFFSET, sscr0.ALL_BITS);
 
         // Wait for an empty space in the FIFO.
-        while (m_registers->SSSR.TNF == 0);
+        if (_readStatus().TNF == 0)
+        {
+            m_counters.startTiming(spinStart);
+            while (_readStatus().TNF == 0);
+            m_counters.recordSpin(spinStart);
+        }
 
         // Send the data.
-        m_registers->SSDR.ALL_BITS = txData;
+        _writeReg(BT_SPI_SSDR_OFFSET, txData);
 
         // Wait for data to be received.
-        while (m_registers->SSSR.RNE == 0);
+        if (_readStatus().RNE == 0)
+        {
+            m_counters.startTiming(spinStart);
+            while (_readStatus().RNE == 0);
+            m_counters.recordSpin(spinStart);
+        }
 
         // Get the received data.
-        rxData = m_registers->SSDR.ALL_BITS;
+        rxData = _readReg(BT_SPI_SSDR_OFFSET);
 
         dataIn = rxData & (0xFFFFFFFF >> (32 - bits));
+
+        m_counters.recordTransfer(startTicks, (bits + 7) / 8, m_actualClockHz, hr);
     }
 
     return hr;
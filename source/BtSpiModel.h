@@ -0,0 +1,401 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#ifndef _BT_SPI_MODEL_H_
+#define _BT_SPI_MODEL_H_
+
+#include <Windows.h>
+#include <deque>
+#include <vector>
+
+#include "BtSpiController.h"
+#include "SpiModelSlave.h"
+
+//
+// Cycle-approximate software model of the BayTrail SSP (SPI) Controller in master mode.
+//
+// The model implements the SSCR0, SSCR1, SSSR and SSDR registers and the private
+// clock parameters register, with TX and RX FIFOs of a configurable depth (16
+// words by default, the depth the controller code relies on).  SSSR reports TNF,
+// RNE, BSY, the FIFO levels and a sticky ROR bit that is cleared by writing 1.
+//
+// Time is simulated: each register access advances the model clock by a fixed
+// cost, and while SSE is set the bus moves one word from the TX FIFO for every
+// word-width of SCLK periods that have elapsed.  The SCLK rate is 100 mhz * (M / N)
+// / (SCR + 1).  Words wider than 8 bits are shifted most significant byte first.
+// A word written while the TX FIFO is full is dropped, and a word received while
+// the RX FIFO is full is lost and sets ROR, so the model counts both to show
+// whether the software kept the number of words in flight within the FIFO depth.
+// If no slave is attached, MISO is looped back from MOSI.
+//
+class BtSpiModelClass : public BtSpiRegisterAccessClass
+{
+public:
+    BtSpiModelClass(ULONG fifoDepth = 16) :
+        m_slave(nullptr),
+        m_accessNs(100),
+        m_nowNs(0),
+        m_busCreditNs(0),
+        m_registerAccesses(0),
+        m_busWords(0),
+        m_txOverflows(0),
+        m_rxOverruns(0),
+        m_maxTxLevel(0)
+    {
+        m_fifoDepth = fifoDepth;
+        _reset();
+    }
+
+    virtual ~BtSpiModelClass()
+    {
+    }
+
+    /// Attach a simulated slave to the bus, or nullptr to loop MOSI back to MISO.
+    void attachSlave(SpiModelSlaveClass* slave)
+    {
+        m_slave = slave;
+    }
+
+    /// Set the simulated time cost of one register access, in nanoseconds.
+    void setAccessNs(ULONG accessNs)
+    {
+        m_accessNs = accessNs;
+    }
+
+    /// Get the simulated time that has elapsed, in nanoseconds.
+    ULONGLONG getSimulatedNs() const
+    {
+        return m_nowNs;
+    }
+
+    /// Get the number of register reads and writes performed.
+    ULONGLONG getRegisterAccesses() const
+    {
+        return m_registerAccesses;
+    }
+
+    /// Get the number of words shifted on the bus.
+    ULONGLONG getBusWords() const
+    {
+        return m_busWords;
+    }
+
+    /// Get the number of words dropped because the TX FIFO was full.
+    ULONGLONG getTxOverflows() const
+    {
+        return m_txOverflows;
+    }
+
+    /// Get the number of words lost because the RX FIFO was full.
+    ULONGLONG getRxOverruns() const
+    {
+        return m_rxOverruns;
+    }
+
+    /// Get the highest number of words seen waiting in the TX FIFO.
+    ULONG getMaxTxLevel() const
+    {
+        return m_maxTxLevel;
+    }
+
+    /// Get the bytes the master has sent on MOSI since the counters were reset.
+    const std::vector<UCHAR> & getMosiBytes() const
+    {
+        return m_mosiBytes;
+    }
+
+    /// Zero the time and access counters and forget the MOSI bytes.
+    void resetCounters()
+    {
+        m_nowNs = 0;
+        m_registerAccesses = 0;
+        m_busWords = 0;
+        m_txOverflows = 0;
+        m_rxOverruns = 0;
+        m_maxTxLevel = 0;
+        m_mosiBytes.clear();
+    }
+
+    ULONG readRegister(ULONG offset) override
+    {
+        ULONG value = 0;
+
+        _access();
+
+        switch (offset)
+        {
+        case BT_SPI_SSCR0_OFFSET:
+            value = m_sscr0;
+            break;
+        case BT_SPI_SSCR1_OFFSET:
+            value = m_sscr1;
+            break;
+        case BT_SPI_SSSR_OFFSET:
+            value = _status();
+            break;
+        case BT_SPI_SSDR_OFFSET:
+            if (!m_rxFifo.empty())
+            {
+                value = m_rxFifo.front();
+                m_rxFifo.pop_front();
+            }
+            break;
+        case BT_SPI_PRV_CLOCK_PARAMS_OFFSET:
+            value = m_clockParams;
+            break;
+        }
+
+        return value;
+    }
+
+    void writeRegister(ULONG offset, ULONG value) override
+    {
+        _access();
+
+        switch (offset)
+        {
+        case BT_SPI_SSCR0_OFFSET:
+            m_sscr0 = value;
+            if (!_enabled())
+            {
+                // Disabling the port empties the FIFOs.
+                m_txFifo.clear();
+                m_rxFifo.clear();
+                m_busCreditNs = 0;
+            }
+            break;
+        case BT_SPI_SSCR1_OFFSET:
+            m_sscr1 = value;
+            break;
+        case BT_SPI_SSSR_OFFSET:
+            // Writing 1 clears the receiver overrun bit.
+            if (value & SSSR_ROR)
+            {
+                m_ror = FALSE;
+            }
+            break;
+        case BT_SPI_SSDR_OFFSET:
+            if (m_txFifo.size() < m_fifoDepth)
+            {
+                m_txFifo.push_back(value & _wordMask());
+                if (m_txFifo.size() > m_maxTxLevel)
+                {
+                    m_maxTxLevel = (ULONG)m_txFifo.size();
+                }
+            }
+            else
+            {
+                m_txOverflows++;
+            }
+            break;
+        case BT_SPI_PRV_CLOCK_PARAMS_OFFSET:
+            // The update bit is self-clearing.
+            m_clockParams = value & ~PRV_CLOCK_UPDATE;
+            break;
+        }
+    }
+
+private:
+
+    // SSCR0 fields.
+    static const ULONG SSCR0_DSS_MASK = 0x0000000F;
+    static const ULONG SSCR0_SSE = 0x00000080;
+    static const ULONG SSCR0_SCR_SHIFT = 8;
+    static const ULONG SSCR0_SCR_MASK = 0x000FFF00;
+    static const ULONG SSCR0_EDSS = 0x00100000;
+
+    // SSSR bits.
+    static const ULONG SSSR_TNF = 0x00000004;
+    static const ULONG SSSR_RNE = 0x00000008;
+    static const ULONG SSSR_BSY = 0x00000010;
+    static const ULONG SSSR_ROR = 0x00000080;
+    static const ULONG SSSR_TFL_SHIFT = 8;
+    static const ULONG SSSR_RFL_SHIFT = 12;
+
+    // Private clock parameters fields.
+    static const ULONG PRV_CLOCK_M_SHIFT = 1;
+    static const ULONG PRV_CLOCK_N_SHIFT = 16;
+    static const ULONG PRV_CLOCK_VALUE_MASK = 0x7FFF;
+    static const ULONG PRV_CLOCK_UPDATE = 0x80000000;
+
+    /// Put the registers in their reset state.
+    void _reset()
+    {
+        m_sscr0 = 0;
+        m_sscr1 = 0;
+        m_clockParams = 0;
+        m_ror = FALSE;
+        m_txFifo.clear();
+        m_rxFifo.clear();
+    }
+
+    /// Account for one register access and let the bus catch up.
+    void _access()
+    {
+        m_registerAccesses++;
+        m_nowNs += m_accessNs;
+        _advance(m_accessNs);
+    }
+
+    /// Determine whether the port is enabled.
+    BOOL _enabled() const
+    {
+        return (m_sscr0 & SSCR0_SSE) != 0;
+    }
+
+    /// Get the number of bits in a word.
+    ULONG _wordBits() const
+    {
+        return (((m_sscr0 & SSCR0_EDSS) ? 16 : 0) + (m_sscr0 & SSCR0_DSS_MASK) + 1);
+    }
+
+    /// Get the mask for the bits of a word.
+    ULONG _wordMask() const
+    {
+        return 0xFFFFFFFF >> (32 - _wordBits());
+    }
+
+    /// Get the length of one SCLK period in nanoseconds.
+    ULONGLONG _sclkPeriodNs() const
+    {
+        ULONGLONG m = (m_clockParams >> PRV_CLOCK_M_SHIFT) & PRV_CLOCK_VALUE_MASK;
+        ULONGLONG n = (m_clockParams >> PRV_CLOCK_N_SHIFT) & PRV_CLOCK_VALUE_MASK;
+        ULONGLONG scr = (m_sscr0 & SSCR0_SCR_MASK) >> SSCR0_SCR_SHIFT;
+
+        // The clock parameters have not been set, run at the fastest rate.
+        if ((m == 0) || (n == 0))
+        {
+            m = 1;
+            n = 1;
+        }
+
+        // The SSP clock is 100 mhz (10 ns) divided by N / M, then by SCR + 1.
+        return ((10 * n * (scr + 1)) + m - 1) / m;
+    }
+
+    /// Compose the status register.
+    ULONG _status() const
+    {
+        ULONG status = 0;
+
+        if (m_txFifo.size() < m_fifoDepth)
+        {
+            status |= SSSR_TNF;
+        }
+        if (!m_rxFifo.empty())
+        {
+            status |= SSSR_RNE;
+        }
+        if (_enabled() && !m_txFifo.empty())
+        {
+            status |= SSSR_BSY;
+        }
+        if (m_ror)
+        {
+            status |= SSSR_ROR;
+        }
+
+        // The level fields are four bits: TFL reads 0 when the FIFO is empty or full,
+        // and RFL holds the level minus one, reading 0xF when empty or full.
+        status |= ((ULONG)m_txFifo.size() & 0x0F) << SSSR_TFL_SHIFT;
+        status |= ((ULONG)(m_rxFifo.size() - 1) & 0x0F) << SSSR_RFL_SHIFT;
+
+        return status;
+    }
+
+    /// Shift one word on the bus and return the word received.
+    ULONG _shiftWord(ULONG mosiWord)
+    {
+        ULONG misoWord = 0;
+        ULONG bytes = (_wordBits() + 7) / 8;
+        UCHAR mosi;
+
+        for (ULONG i = bytes; i > 0; i--)
+        {
+            mosi = (UCHAR)(mosiWord >> ((i - 1) * 8));
+            m_mosiBytes.push_back(mosi);
+            misoWord = (misoWord << 8) | ((m_slave == nullptr) ? mosi : m_slave->transferByte(mosi));
+        }
+
+        return misoWord & _wordMask();
+    }
+
+    /// Move words on the bus for the time that has elapsed.
+    void _advance(ULONGLONG ns)
+    {
+        ULONGLONG cost = _wordBits() * _sclkPeriodNs();
+        ULONG misoWord;
+
+        if (!_enabled())
+        {
+            return;
+        }
+
+        m_busCreditNs += ns;
+
+        for (;;)
+        {
+            // The bus is idle while there is nothing to send.
+            if (m_txFifo.empty())
+            {
+                m_busCreditNs = 0;
+                break;
+            }
+
+            if (m_busCreditNs < cost)
+            {
+                break;
+            }
+            m_busCreditNs -= cost;
+
+            misoWord = _shiftWord(m_txFifo.front());
+            m_txFifo.pop_front();
+            m_busWords++;
+
+            if (m_rxFifo.size() < m_fifoDepth)
+            {
+                m_rxFifo.push_back(misoWord);
+            }
+            else
+            {
+                m_ror = TRUE;
+                m_rxOverruns++;
+            }
+        }
+    }
+
+    //
+    // Controller state.
+    //
+
+    ULONG m_fifoDepth;              // Depth of the TX and RX FIFOs in words
+    ULONG m_sscr0;                  // SSP Control Register 0
+    ULONG m_sscr1;                  // SSP Control Register 1
+    ULONG m_clockParams;            // Private clock parameters (M and N)
+    BOOL m_ror;                     // Receiver overrun
+    std::deque<ULONG> m_txFifo;     // TX FIFO
+    std::deque<ULONG> m_rxFifo;     // RX FIFO
+
+    //
+    // Bus state.
+    //
+
+    SpiModelSlaveClass* m_slave;            // Attached slave, or nullptr for loopback
+    std::vector<UCHAR> m_mosiBytes;         // Bytes sent on MOSI
+
+    //
+    // Simulated time and counters.
+    //
+
+    ULONG m_accessNs;                       // Simulated cost of a register access
+    ULONGLONG m_nowNs;                      // Simulated time
+    ULONGLONG m_busCreditNs;                // Time the bus has not used yet
+    ULONGLONG m_registerAccesses;           // Register reads and writes
+    ULONGLONG m_busWords;                   // Words shifted on the bus
+    ULONGLONG m_txOverflows;                // Words written to a full TX FIFO
+    ULONGLONG m_rxOverruns;                 // Words lost to a full RX FIFO
+    ULONG m_maxTxLevel;                     // Highest TX FIFO level seen
+};
+
+#endif  // _BT_SPI_MODEL_H_
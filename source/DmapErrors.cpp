@@ -31,8 +31,10 @@ std::map<HRESULT, LPCWSTR> DmapErrors = {
     { DMAP_E_I2C_OPERATION_INCOMPLETE           , L"One or more transfers remained undone at the end of the I2C operation." },
     { DMAP_E_I2C_INVALID_BUS_NUMBER_SPECIFIED   , L"The I2C bus specified does not exist." },
     { DMAP_E_I2C_TRANSFER_LENGTH_OVER_MAX       , L"The specified I2C transfer length is longer than the controller supports." },
+    { DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED       , L"The specified I2C clock rate is not supported by the controller." },
     { DMAP_E_ADC_DATA_FROM_WRONG_CHANNEL        , L"ADC data for a different channel than requested was received." },
     { DMAP_E_ADC_DOES_NOT_HAVE_REQUESTED_CHANNEL, L"The ADC does not have the channel that has been requested." },
+    { DMAP_E_ADC_READY_SAMPLING_ACTIVE          , L"The ADC is busy sampling on its conversion ready signal." },
     { DMAP_E_SPI_DATA_WIDTH_MISMATCH            , L"The width of data sent does not match the data width set on the SPI controller." },
     { DMAP_E_SPI_BUS_REQUESTED_DOES_NOT_EXIST   , L"The specified BUS number does not exist on this board." },
     { DMAP_E_SPI_MODE_SPECIFIED_IS_INVALID      , L"The SPI mode specified is not a legal SPI mode value (0-3)." },
@@ -40,6 +42,9 @@ std::map<HRESULT, LPCWSTR> DmapErrors = {
     { DMAP_E_SPI_BUFFER_TRANSFER_NOT_IMPLEMENTED, L"This SPI implementation does not support buffer transfers." },
     { DMAP_E_SPI_DATA_WIDTH_SPECIFIED_IS_INVALID, L"The specified number of bits per transfer is not supported by the SPI controller." },
     { DMAP_E_SPI_CONTROLLER_NOT_SUPPORTED       , L"The specified SPI controller is not supported." },
+    { DMAP_E_SPI_CHIP_SELECT_NOT_SUPPORTED      , L"The SPI controller can't drive the requested chip select line itself." },
+    { DMAP_E_SPI_STREAM_NOT_RUNNING             , L"The SPI stream is not running, or no stream buffer has been acquired." },
+    { DMAP_E_SPI_STREAM_BUFFER_NOT_AVAILABLE    , L"No SPI stream buffer became free before the timeout expired." },
     { DMAP_E_GPIO_PIN_IS_SET_TO_PWM             , L"A GPIO operation was performed on a pin configured as a PWM output." }
 };
 
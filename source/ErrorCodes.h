@@ -125,6 +125,10 @@ LIGHTNING_DLL_API extern std::map<HRESULT, LPCWSTR> DmapErrors;
 /// The specified I2C transfer length is longer than the controller supports.
 #define DMAP_E_I2C_TRANSFER_LENGTH_OVER_MAX MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x9229)
 
+/// HexValue: 0x8004922A
+/// The specified I2C clock rate is not supported by the controller.
+#define DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x922A)
+
 //
 // ADC related error codes.
 //
@@ -141,6 +145,10 @@ attempting to use the ADC at the same time.
 /// The ADC does not have the channel that has been requested.
 #define DMAP_E_ADC_DOES_NOT_HAVE_REQUESTED_CHANNEL MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x9231)
 
+/// HexValue: 0x80049232
+/// The ADC is busy sampling on its conversion ready signal.
+#define DMAP_E_ADC_READY_SAMPLING_ACTIVE MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x9232)
+
 //
 // SPI related error codes.
 //
@@ -178,6 +186,18 @@ set the desired width, then call SPI.begin() to start the contrller again.
 /// The specified SPI controller is not supported.
 #define DMAP_E_SPI_CONTROLLER_NOT_SUPPORTED MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x9246)
 
+/// HexValue: 0x80049247
+/// The SPI controller can't drive the requested chip select line itself.
+#define DMAP_E_SPI_CHIP_SELECT_NOT_SUPPORTED MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x9247)
+
+/// HexValue: 0x80049248
+/// The SPI stream is not running, or no stream buffer has been acquired.
+#define DMAP_E_SPI_STREAM_NOT_RUNNING MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x9248)
+
+/// HexValue: 0x80049249
+/// No SPI stream buffer became free before the timeout expired.
+#define DMAP_E_SPI_STREAM_BUFFER_NOT_AVAILABLE MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x9249)
+
 //
 // PWM related error codes.
 //
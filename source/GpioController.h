@@ -16,6 +16,20 @@
 #include "concrt.h"
 #include "GpioInterrupt.h"
 
+/// Registers and values used to drive a GPIO output pin without the board pin lookup.
+/**
+Filled in by BoardPinsClass::getFastPin(), for drivers that toggle a pin (such as a
+chip select) at a high rate.  The values written are computed when the structure is
+filled in, so driving the pin is a single register write.
+*/
+typedef struct _FAST_GPIO_PIN
+{
+    volatile ULONG* setRegister;        ///< Register written to drive the pin HIGH
+    volatile ULONG* clearRegister;      ///< Register written to drive the pin LOW
+    ULONG setValue;                     ///< Value written to setRegister
+    ULONG clearValue;                   ///< Value written to clearRegister
+} FAST_GPIO_PIN, *PFAST_GPIO_PIN;
+
 
 #if defined(_M_IX86) || defined(_M_X64)
 /// Class used to interact with the BayTrail Fabric GPIO hardware.
@@ -80,6 +94,12 @@ public:
     /// Method to set the state of an S5 GPIO port bit.
     inline HRESULT setS5PinState(ULONG gpioNo, ULONG state);
 
+    /// Method to get the register and values used to drive an S0 GPIO port bit directly.
+    inline HRESULT getS0FastPin(ULONG gpioNo, FAST_GPIO_PIN & fastPin);
+
+    /// Method to get the register and values used to drive an S5 GPIO port bit directly.
+    inline HRESULT getS5FastPin(ULONG gpioNo, FAST_GPIO_PIN & fastPin);
+
     /// Method to read the state of an S0 GPIO bit.
     inline HRESULT getS0PinState(ULONG gpioNo, ULONG & state);
 
@@ -297,6 +317,9 @@ public:
     /// Method to set the state of a GPIO port bit.
     inline HRESULT setPinState(ULONG gpioNo, ULONG state);
 
+    /// Method to get the registers and values used to drive a GPIO port bit directly.
+    inline HRESULT getFastPin(ULONG gpioNo, FAST_GPIO_PIN & fastPin);
+
     /// Method to read the state of a GPIO bit.
     inline HRESULT getPinState(ULONG gpioNo, ULONG & state);
 
@@ -477,6 +500,66 @@ inline HRESULT BtFabricGpioControllerClass::setS5PinState(ULONG gpioNo, ULONG st
 }
 #endif // defined(_M_IX86) || defined(_M_X64)
 
+#if defined(_M_IX86) || defined(_M_X64)
+/**
+The pad value register holds the output enable and other pad settings as well as
+the pin state, so the values written are based on the register contents now.  The
+pad settings must not be changed while the fast pin information is in use.
+This method assumes the caller has checked the input parameters.
+\param[in] gpioNo The S0 GPIO number of the pad. Range: 0-127.
+\param[out] fastPin The register and values used to drive the pad.
+\return HRESULT error or success code.
+*/
+inline HRESULT BtFabricGpioControllerClass::getS0FastPin(ULONG gpioNo, FAST_GPIO_PIN & fastPin)
+{
+    HRESULT hr = mapS0IfNeeded();
+
+    if (SUCCEEDED(hr))
+    {
+        _PAD_VAL padVal;
+        padVal.ALL_BITS = m_s0Controller[gpioNo].PAD_VAL.ALL_BITS;
+        fastPin.setRegister = &m_s0Controller[gpioNo].PAD_VAL.ALL_BITS;
+        fastPin.clearRegister = fastPin.setRegister;
+        padVal.PAD_VAL = 1;
+        fastPin.setValue = padVal.ALL_BITS;
+        padVal.PAD_VAL = 0;
+        fastPin.clearValue = padVal.ALL_BITS;
+    }
+
+    return hr;
+}
+#endif // defined(_M_IX86) || defined(_M_X64)
+
+#if defined(_M_IX86) || defined(_M_X64)
+/**
+The pad value register holds the output enable and other pad settings as well as
+the pin state, so the values written are based on the register contents now.  The
+pad settings must not be changed while the fast pin information is in use.
+This method assumes the caller has checked the input parameters.
+\param[in] gpioNo The S5 GPIO number of the pad. Range: 0-59.
+\param[out] fastPin The register and values used to drive the pad.
+\return HRESULT error or success code.
+*/
+inline HRESULT BtFabricGpioControllerClass::getS5FastPin(ULONG gpioNo, FAST_GPIO_PIN & fastPin)
+{
+    HRESULT hr = mapS5IfNeeded();
+
+    if (SUCCEEDED(hr))
+    {
+        _PAD_VAL padVal;
+        padVal.ALL_BITS = m_s5Controller[gpioNo].PAD_VAL.ALL_BITS;
+        fastPin.setRegister = &m_s5Controller[gpioNo].PAD_VAL.ALL_BITS;
+        fastPin.clearRegister = fastPin.setRegister;
+        padVal.PAD_VAL = 1;
+        fastPin.setValue = padVal.ALL_BITS;
+        padVal.PAD_VAL = 0;
+        fastPin.clearValue = padVal.ALL_BITS;
+    }
+
+    return hr;
+}
+#endif // defined(_M_IX86) || defined(_M_X64)
+
 #if defined(_M_IX86) || defined(_M_X64)
 /**
 This method assumes the caller has checked the input parameters.
@@ -767,6 +850,38 @@ inline HRESULT BcmGpioControllerClass::setPinState(ULONG gpioNo, ULONG state)
 }
 #endif // defined(_M_ARM)
 
+#if defined(_M_ARM)
+/**
+This method assumes the caller has checked the input parameters.
+\param[in] gpioNo The GPIO number of the pad. Range: 0-53.
+\param[out] fastPin The registers and values used to drive the pad.
+\return HRESULT error or success code.
+*/
+inline HRESULT BcmGpioControllerClass::getFastPin(ULONG gpioNo, FAST_GPIO_PIN & fastPin)
+{
+    HRESULT hr = mapIfNeeded();
+
+    if (SUCCEEDED(hr))
+    {
+        if (gpioNo < 32)
+        {
+            fastPin.setRegister = &m_registers->GPSET0;
+            fastPin.clearRegister = &m_registers->GPCLR0;
+            fastPin.setValue = 1 << gpioNo;
+        }
+        else
+        {
+            fastPin.setRegister = &m_registers->GPSET1;
+            fastPin.clearRegister = &m_registers->GPCLR1;
+            fastPin.setValue = 1 << (gpioNo - 32);
+        }
+        fastPin.clearValue = fastPin.setValue;
+    }
+
+    return hr;
+}
+#endif // defined(_M_ARM)
+
 #if defined(_M_ARM)
 /**
 This method assumes the caller has checked the input parameters.
@@ -57,7 +57,11 @@ HRESULT I2cClass::begin()
         }
     }
 
-    hr = m_controller->begin(m_busNumber);
+    if (m_controller != nullptr)
+    {
+        m_controller->setTrace(&m_trace);
+        hr = m_controller->begin(m_busNumber);
+    }
 
     if (SUCCEEDED(hr))
     {
@@ -77,7 +81,7 @@ void I2cClass::end()
     if (m_refCount > 0)
     {
         m_refCount--;
-        if (m_refCount == 0)
+        if ((m_refCount == 0) && m_ownsController)
         {
             delete m_controller;
             m_controller = nullptr;
@@ -86,3 +90,99 @@ void I2cClass::end()
 
     LeaveCriticalSection(&m_lock);
 }
+
+/// Method to run this bus on a controller object supplied by the caller.
+/**
+This is used to run I2C device code against a controller attached to a software
+register model.  The bus must not be open.  The caller keeps ownership of the
+controller, which stays in use until this method is called again.
+\param[in] controller The controller to use, or nullptr to go back to creating the
+controller for the board in begin().
+\return HRESULT success or error code.
+*/
+HRESULT I2cClass::useController(I2cControllerClass* controller)
+{
+    HRESULT hr = S_OK;
+
+    EnterCriticalSection(&m_lock);
+
+    if (m_refCount > 0)
+    {
+        hr = HRESULT_FROM_WIN32(ERROR_INVALID_STATE);
+    }
+    else
+    {
+        if (m_ownsController)
+        {
+            delete m_controller;
+        }
+        else if (m_controller != nullptr)
+        {
+            m_controller->setTrace(nullptr);
+        }
+        m_controller = controller;
+        m_ownsController = (controller == nullptr);
+        if (m_controller != nullptr)
+        {
+            m_controller->setTrace(&m_trace);
+        }
+    }
+
+    LeaveCriticalSection(&m_lock);
+
+    return hr;
+}
+
+/// Method to turn transaction tracing on or off for this bus.
+/**
+Tracing can be turned on before the bus is opened.  Traces and counters are kept
+by this object, so they build up across opening and closing the bus until they
+are reset.
+\param[in] enable TRUE to start recording transactions, FALSE to stop.
+\return HRESULT success or error code.
+*/
+HRESULT I2cClass::enableTracing(BOOL enable)
+{
+    m_trace.enable(enable);
+    return S_OK;
+}
+
+/// Method to get the aggregate transaction counters for this bus.
+HRESULT I2cClass::getCounters(I2C_BUS_COUNTERS & counters)
+{
+    m_trace.getCounters(counters);
+    return S_OK;
+}
+
+/// Method to get the most recent transaction traces for this bus.
+/**
+\param[out] entries Buffer to receive the traces, oldest first.
+\param[in] maxEntries The number of traces the buffer can hold.
+\param[out] entryCount The number of traces copied to the buffer.
+\return HRESULT success or error code.
+*/
+HRESULT I2cClass::getTraces(PI2C_TRANSACTION_TRACE entries, ULONG maxEntries, ULONG & entryCount)
+{
+    HRESULT hr = S_OK;
+
+    entryCount = 0;
+
+    if ((entries == nullptr) && (maxEntries > 0))
+    {
+        hr = E_POINTER;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        entryCount = m_trace.getTraces(entries, maxEntries);
+    }
+
+    return hr;
+}
+
+/// Method to discard the transaction traces and zero the counters for this bus.
+HRESULT I2cClass::resetCounters()
+{
+    m_trace.reset();
+    return S_OK;
+}
@@ -19,6 +19,7 @@ public:
         m_sclPin(0xFFFFFFFF),
         m_busNumber(busNumber),
         m_controller(nullptr),
+        m_ownsController(TRUE),
         m_refCount(0)
     {
         InitializeCriticalSection(&m_lock);
@@ -45,6 +46,21 @@ public:
         return m_controller;
     }
 
+    /// Method to run this bus on a controller object supplied by the caller.
+    LIGHTNING_DLL_API HRESULT useController(I2cControllerClass* controller);
+
+    /// Method to turn transaction tracing on or off for this bus.
+    LIGHTNING_DLL_API HRESULT enableTracing(BOOL enable);
+
+    /// Method to get the aggregate transaction counters for this bus.
+    LIGHTNING_DLL_API HRESULT getCounters(I2C_BUS_COUNTERS & counters);
+
+    /// Method to get the most recent transaction traces for this bus.
+    LIGHTNING_DLL_API HRESULT getTraces(PI2C_TRANSACTION_TRACE entries, ULONG maxEntries, ULONG & entryCount);
+
+    /// Method to discard the transaction traces and zero the counters for this bus.
+    LIGHTNING_DLL_API HRESULT resetCounters();
+
 protected:
 
     /// I2C Serial Data pin number.
@@ -65,9 +81,15 @@ private:
     /// The object we use to talk to the I2C Controller.
     I2cControllerClass* m_controller;
 
+    /// TRUE if this object created the controller and deletes it when the bus is closed.
+    BOOL m_ownsController;
+
     /// Count of how many times this object is currently open by this process.
     LONG m_refCount;
 
+    /// Transaction traces and counters for this bus, kept while the controller comes and goes.
+    I2cTraceClass m_trace;
+
     /// Lock used to serialize opening and closing the controller.
     RTL_CRITICAL_SECTION m_lock;
 };
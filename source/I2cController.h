@@ -9,6 +9,7 @@
 
 #include "I2cTransfer.h"
 #include "I2cTransaction.h"
+#include "I2cTrace.h"
 #include "DmapSupport.h"
 
 #define EXTERNAL_I2C_BUS 0
@@ -28,7 +29,9 @@ public:
         m_sclPin(INVALID_PIN_NUMBER),
         m_busNumber(EXTERNAL_I2C_BUS),
         m_error(I2cTransactionClass::ERROR_CODE::SUCCESS),
-        m_maxWaitTicks(0)
+        m_maxWaitTicks(0),
+        m_actualClockHz(0),
+        m_trace(&m_ownTrace)
     {
     }
 
@@ -55,8 +58,51 @@ public:
     // This method maps the I2C controller if needed.
     LIGHTNING_DLL_API HRESULT mapIfNeeded();
 
-    // Method to initialize the I2C Controller at the start of a transaction.
-    virtual HRESULT _initializeForTransaction(ULONG slaveAddress, BOOL useHighSpeed) = 0;
+    /// Method to initialize the I2C Controller at the start of a transaction.
+    /**
+    \param[in] slaveAddress The 7-bit address of the slave for the transaction.
+    \param[in] clockHz The desired I2C bus clock rate in Hz.  The controller uses the
+    fastest rate it can generate that does not exceed this value.
+    \return HRESULT success or error code.
+    */
+    virtual HRESULT _initializeForTransaction(ULONG slaveAddress, ULONG clockHz) = 0;
+
+    /// Get the I2C bus clock rate (in Hz) set by the most recent transaction.
+    /**
+    \return The achieved clock rate, or zero if no transaction has been performed.
+    */
+    ULONG getActualClockRate() const
+    {
+        return m_actualClockHz;
+    }
+
+    /// Get the object that collects transaction traces and counters for this bus.
+    I2cTraceClass* getTrace()
+    {
+        return m_trace;
+    }
+
+    /// Set the object that collects transaction traces and counters for this bus.
+    /**
+    The bus object passes in its own trace object, so the traces and counters outlive
+    this controller object.
+    \param[in] trace The trace object to use, or nullptr to use this controller's own.
+    */
+    void setTrace(I2cTraceClass* trace)
+    {
+        m_trace = (trace != nullptr) ? trace : &m_ownTrace;
+    }
+
+    /// Determine whether this controller is running against a software register model.
+    /**
+    A modelled controller has no hardware to share with other processes, so
+    transactions on it do not take the I2C bus lock.
+    \return TRUE if register accesses go to a model, FALSE if they go to the hardware.
+    */
+    virtual BOOL hasRegisterModel() const
+    {
+        return FALSE;
+    }
 
     //
     // I2C Controller accessor methods.  These methods assume the I2C Controller
@@ -80,6 +126,12 @@ public:
         return m_error;
     }
 
+    // Forget any transfer error left over from a previous transaction.
+    void clearTransfersError()
+    {
+        m_error = I2cTransactionClass::ERROR_CODE::SUCCESS;
+    }
+
     virtual inline UCHAR readByte() = 0;
 
     virtual inline BOOL isActive() const = 0;
@@ -151,6 +203,15 @@ protected:
     // Maximum number of wait ticks we have waited for outstanding reads to complete.
     ULONGLONG m_maxWaitTicks;
 
+    /// The I2C bus clock rate (in Hz) the controller is currently set to generate.
+    ULONG m_actualClockHz;
+
+    /// Transaction traces and counters for this bus.
+    I2cTraceClass* m_trace;
+
+    /// Trace object used when the bus object has not supplied one.
+    I2cTraceClass m_ownTrace;
+
     /// Method to map the I2C controller into this process' virtual address space.
     virtual HRESULT _mapController() = 0;
 
@@ -0,0 +1,168 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#ifndef _I2C_MODEL_SLAVE_H_
+#define _I2C_MODEL_SLAVE_H_
+
+#include <Windows.h>
+#include <vector>
+
+//
+// Interface for a simulated I2C slave device attached to a simulated I2C bus.
+//
+class I2cModelSlaveClass
+{
+public:
+    virtual ~I2cModelSlaveClass()
+    {
+    }
+
+    /// Called when the slave is addressed after a START or restart.
+    /**
+    \param[in] isRead TRUE if the master is starting a read, FALSE for a write.
+    \return TRUE to acknowledge the address, FALSE to NACK it.
+    */
+    virtual BOOL start(BOOL isRead) = 0;
+
+    /// Called for each byte the master writes to the slave.
+    /**
+    \return TRUE to acknowledge the byte, FALSE to NACK it.
+    */
+    virtual BOOL writeByte(UCHAR data) = 0;
+
+    /// Called for each byte the master reads from the slave.
+    virtual UCHAR readByte() = 0;
+
+    /// Called when the master ends the transaction with a STOP.
+    virtual void stop()
+    {
+    }
+
+    /// Number of SCL periods the slave stretches the clock before the next byte.
+    virtual ULONG stretchClocks()
+    {
+        return 0;
+    }
+};
+
+//
+// A simulated slave with a bank of byte registers.  The first byte of each write
+// sets the register pointer, which auto-increments as data is written or read.
+// This matches most sensors and small EEPROMs.
+//
+class I2cModelRegisterSlaveClass : public I2cModelSlaveClass
+{
+public:
+    I2cModelRegisterSlaveClass(ULONG registerCount) :
+        m_registers(registerCount, 0),
+        m_pointer(0),
+        m_firstWrite(FALSE),
+        m_nackAddress(FALSE),
+        m_nackAfterBytes(0),
+        m_bytesWritten(0),
+        m_stretchClocks(0)
+    {
+    }
+
+    virtual ~I2cModelRegisterSlaveClass()
+    {
+    }
+
+    /// Make the slave NACK its address, as if it were absent or busy.
+    void setNackAddress(BOOL nack)
+    {
+        m_nackAddress = nack;
+    }
+
+    /// Make the slave NACK the Nth data byte written in a transaction (0 for never).
+    void setNackAfterBytes(ULONG byteCount)
+    {
+        m_nackAfterBytes = byteCount;
+    }
+
+    /// Make the slave stretch the clock for a number of SCL periods before each byte.
+    void setStretchClocks(ULONG clocks)
+    {
+        m_stretchClocks = clocks;
+    }
+
+    /// Get the register bank so it can be preset or checked.
+    std::vector<UCHAR> & registers()
+    {
+        return m_registers;
+    }
+
+    BOOL start(BOOL isRead) override
+    {
+        if (!isRead)
+        {
+            m_firstWrite = TRUE;
+            m_bytesWritten = 0;
+        }
+        return !m_nackAddress;
+    }
+
+    BOOL writeByte(UCHAR data) override
+    {
+        m_bytesWritten++;
+        if ((m_nackAfterBytes != 0) && (m_bytesWritten >= m_nackAfterBytes))
+        {
+            return FALSE;
+        }
+
+        if (m_firstWrite)
+        {
+            m_pointer = data;
+            m_firstWrite = FALSE;
+        }
+        else if (!m_registers.empty())
+        {
+            m_registers[m_pointer % m_registers.size()] = data;
+            m_pointer++;
+        }
+        return TRUE;
+    }
+
+    UCHAR readByte() override
+    {
+        UCHAR data = 0xFF;
+
+        if (!m_registers.empty())
+        {
+            data = m_registers[m_pointer % m_registers.size()];
+            m_pointer++;
+        }
+        return data;
+    }
+
+    ULONG stretchClocks() override
+    {
+        return m_stretchClocks;
+    }
+
+private:
+
+    /// The register bank.
+    std::vector<UCHAR> m_registers;
+
+    /// Index of the register the next byte is written to or read from.
+    ULONG m_pointer;
+
+    /// TRUE if the next byte written sets the register pointer.
+    BOOL m_firstWrite;
+
+    /// TRUE to NACK the slave address.
+    BOOL m_nackAddress;
+
+    /// Data byte of a write transaction to NACK, or 0 to ACK all data.
+    ULONG m_nackAfterBytes;
+
+    /// Data bytes written since the last START.
+    ULONG m_bytesWritten;
+
+    /// SCL periods to stretch the clock before each byte.
+    ULONG m_stretchClocks;
+};
+
+#endif  // _I2C_MODEL_SLAVE_H_
@@ -0,0 +1,254 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#ifndef _I2C_TRACE_H_
+#define _I2C_TRACE_H_
+
+#include <Windows.h>
+
+#include "I2cTransaction.h"
+
+// Number of transactions kept in the trace ring of each I2C bus.
+#define I2C_TRACE_RING_ENTRIES 64
+
+// Lock waits longer than this (in microseconds) are counted as contended.
+#define I2C_LOCK_CONTENDED_US 50
+
+/// Record of one I2C transaction, kept when tracing is enabled on a bus.
+typedef struct _I2C_TRANSACTION_TRACE {
+    ULONG slaveAddress;                     ///< 7-bit address of the slave
+    ULONG bytesWritten;                     ///< Bytes queued to be written to the slave
+    ULONG bytesRead;                        ///< Bytes queued to be read from the slave
+    ULONG lockWaitUs;                       ///< Time spent waiting for the bus lock
+    ULONG busUs;                            ///< Time the bus was held by the transaction
+    ULONG spinUs;                           ///< Time spent polling the controller for FIFO space, data or completion
+    I2cTransactionClass::ERROR_CODE error;  ///< NACK or other bus error
+    HRESULT hr;                             ///< Result returned by execute()
+} I2C_TRANSACTION_TRACE, *PI2C_TRANSACTION_TRACE;
+
+/// Aggregate counters for one I2C bus, kept when tracing is enabled on the bus.
+typedef struct _I2C_BUS_COUNTERS {
+    ULONGLONG transactions;                 ///< Transactions executed
+    ULONGLONG failedTransactions;           ///< Transactions that returned an error
+    ULONGLONG addressNacks;                 ///< Transactions ended by an address NACK
+    ULONGLONG dataNacks;                    ///< Transactions ended by a data NACK
+    ULONGLONG bytesWritten;                 ///< Total bytes written
+    ULONGLONG bytesRead;                    ///< Total bytes read
+    ULONGLONG contendedLocks;               ///< Lock waits over I2C_LOCK_CONTENDED_US
+    ULONGLONG totalLockWaitUs;              ///< Total time spent waiting for the bus lock
+    ULONG maxLockWaitUs;                    ///< Longest wait for the bus lock
+    ULONGLONG totalBusUs;                   ///< Total time the bus was held
+    ULONG maxBusUs;                         ///< Longest time the bus was held
+    ULONGLONG totalSpinUs;                  ///< Total time spent polling the controller
+} I2C_BUS_COUNTERS, *PI2C_BUS_COUNTERS;
+
+/// Class used to collect per-transaction traces and counters for an I2C bus.
+/**
+Nothing is recorded unless tracing has been enabled.  The most recent
+I2C_TRACE_RING_ENTRIES transactions are kept, the aggregate counters cover
+every transaction since tracing was enabled or the counters were reset.
+*/
+class I2cTraceClass
+{
+public:
+    I2cTraceClass() :
+        m_enabled(FALSE),
+        m_nextEntry(0),
+        m_entryCount(0),
+        m_spinTicks(0)
+    {
+        InitializeCriticalSection(&m_lock);
+        QueryPerformanceFrequency(&m_frequency);
+        ZeroMemory(&m_counters, sizeof(m_counters));
+        ZeroMemory(m_ring, sizeof(m_ring));
+    }
+
+    virtual ~I2cTraceClass()
+    {
+        DeleteCriticalSection(&m_lock);
+    }
+
+    /// Method to turn tracing on or off.
+    void enable(BOOL enable)
+    {
+        m_enabled = enable;
+    }
+
+    /// Method to determine whether tracing is on.
+    BOOL isEnabled() const
+    {
+        return m_enabled;
+    }
+
+    /// Method to convert a count of high resolution timer ticks to microseconds.
+    ULONG ticksToMicroseconds(LONGLONG ticks) const
+    {
+        if ((ticks <= 0) || (m_frequency.QuadPart == 0))
+        {
+            return 0;
+        }
+        return (ULONG)((ticks * 1000000LL) / m_frequency.QuadPart);
+    }
+
+    /// Method to get a timestamp for timing a controller poll loop, if tracing is on.
+    /**
+    \param[out] ticks The high resolution timer count, or 0 if tracing is off.
+    */
+    inline void startTiming(LONGLONG & ticks) const
+    {
+        LARGE_INTEGER now;
+
+        ticks = 0;
+        if (m_enabled)
+        {
+            QueryPerformanceCounter(&now);
+            ticks = now.QuadPart;
+        }
+    }
+
+    /// Method to add the time spent in a controller poll loop to the current transaction.
+    /**
+    Only the thread that holds the bus lock records spin time, so no lock is taken here.
+    \param[in] startTicks The timestamp taken with startTiming() when the poll loop began.
+    */
+    inline void recordSpin(LONGLONG startTicks)
+    {
+        LARGE_INTEGER now;
+
+        // Tracing was turned on during the poll loop, so it has no start time.
+        if (startTicks != 0)
+        {
+            QueryPerformanceCounter(&now);
+            m_spinTicks += now.QuadPart - startTicks;
+        }
+    }
+
+    /// Method to get the spin time recorded since the last call, and start again from zero.
+    LONGLONG takeSpinTicks()
+    {
+        LONGLONG ticks = m_spinTicks;
+        m_spinTicks = 0;
+        return ticks;
+    }
+
+    /// Method to record a completed transaction.
+    void record(const I2C_TRANSACTION_TRACE & entry)
+    {
+        EnterCriticalSection(&m_lock);
+
+        m_ring[m_nextEntry] = entry;
+        m_nextEntry = (m_nextEntry + 1) % I2C_TRACE_RING_ENTRIES;
+        if (m_entryCount < I2C_TRACE_RING_ENTRIES)
+        {
+            m_entryCount++;
+        }
+
+        m_counters.transactions++;
+        if (FAILED(entry.hr))
+        {
+            m_counters.failedTransactions++;
+        }
+        if (entry.error == I2cTransactionClass::ERROR_CODE::ADR_NACK)
+        {
+            m_counters.addressNacks++;
+        }
+        else if (entry.error == I2cTransactionClass::ERROR_CODE::DATA_NACK)
+        {
+            m_counters.dataNacks++;
+        }
+        m_counters.bytesWritten += entry.bytesWritten;
+        m_counters.bytesRead += entry.bytesRead;
+        if (entry.lockWaitUs > I2C_LOCK_CONTENDED_US)
+        {
+            m_counters.contendedLocks++;
+        }
+        m_counters.totalLockWaitUs += entry.lockWaitUs;
+        if (entry.lockWaitUs > m_counters.maxLockWaitUs)
+        {
+            m_counters.maxLockWaitUs = entry.lockWaitUs;
+        }
+        m_counters.totalBusUs += entry.busUs;
+        if (entry.busUs > m_counters.maxBusUs)
+        {
+            m_counters.maxBusUs = entry.busUs;
+        }
+        m_counters.totalSpinUs += entry.spinUs;
+
+        LeaveCriticalSection(&m_lock);
+    }
+
+    /// Method to get a copy of the aggregate counters.
+    void getCounters(I2C_BUS_COUNTERS & counters)
+    {
+        EnterCriticalSection(&m_lock);
+        counters = m_counters;
+        LeaveCriticalSection(&m_lock);
+    }
+
+    /// Method to get a copy of the most recent transaction traces.
+    /**
+    \param[out] entries Buffer to receive the traces, oldest first.
+    \param[in] maxEntries The number of traces the buffer can hold.
+    \return The number of traces copied to the buffer.
+    */
+    ULONG getTraces(PI2C_TRANSACTION_TRACE entries, ULONG maxEntries)
+    {
+        ULONG count = 0;
+        ULONG index = 0;
+
+        EnterCriticalSection(&m_lock);
+
+        count = (maxEntries < m_entryCount) ? maxEntries : m_entryCount;
+
+        // Start with the oldest of the entries that will fit.
+        index = (m_nextEntry + I2C_TRACE_RING_ENTRIES - count) % I2C_TRACE_RING_ENTRIES;
+        for (ULONG i = 0; i < count; i++)
+        {
+            entries[i] = m_ring[index];
+            index = (index + 1) % I2C_TRACE_RING_ENTRIES;
+        }
+
+        LeaveCriticalSection(&m_lock);
+
+        return count;
+    }
+
+    /// Method to discard all traces and zero the counters.
+    void reset()
+    {
+        EnterCriticalSection(&m_lock);
+        m_nextEntry = 0;
+        m_entryCount = 0;
+        ZeroMemory(&m_counters, sizeof(m_counters));
+        LeaveCriticalSection(&m_lock);
+    }
+
+private:
+
+    /// TRUE if transactions are being recorded.
+    volatile BOOL m_enabled;
+
+    /// The high resolution timer frequency on this system.
+    LARGE_INTEGER m_frequency;
+
+    /// Ring of the most recent transaction traces.
+    I2C_TRANSACTION_TRACE m_ring[I2C_TRACE_RING_ENTRIES];
+
+    /// Index of the ring entry the next trace is written to.
+    ULONG m_nextEntry;
+
+    /// Number of valid entries in the ring.
+    ULONG m_entryCount;
+
+    /// Aggregate counters.
+    I2C_BUS_COUNTERS m_counters;
+
+    /// Lock used to serialize recording and reading the traces.
+    RTL_CRITICAL_SECTION m_lock;
+
+    /// Timer ticks spent in controller poll loops during the current transaction.
+    LONGLONG m_spinTicks;
+};
+
+#endif  // _I2C_TRACE_H_
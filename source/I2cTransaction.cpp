@@ -51,6 +51,24 @@ HRESULT I2cTransactionClass::setAddress(ULONG slaveAdr)
     return hr;
 }
 
+// Sets the I2C bus clock rate for this transaction.
+HRESULT I2cTransactionClass::setClockRate(ULONG clockHz)
+{
+    HRESULT hr = S_OK;
+
+    if ((clockHz == 0) || (clockHz > I2C_FAST_MODE_PLUS_HZ))
+    {
+        hr = DMAP_E_I2C_CLOCK_RATE_NOT_SUPPORTED;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        m_clockHz = clockHz;
+    }
+
+    return hr;
+}
+
 // Add a write transfer to the transaction.
 HRESULT I2cTransactionClass::queueWrite(PUCHAR buffer, ULONG bufferBytes, BOOL preRestart)
 {
@@ -188,6 +206,11 @@ HRESULT I2cTransactionClass::execute(I2cControllerClass* controller)
     I2cTransferClass* pReadXfr = nullptr;
     DWORD lockResult = 0;
     BOOL haveLock = FALSE;
+    I2cTraceClass* trace = nullptr;
+    LARGE_INTEGER lockStart = { 0 };
+    LARGE_INTEGER busStart = { 0 };
+    LARGE_INTEGER spinStart = { 0 };
+    LARGE_INTEGER busEnd = { 0 };
     
     // Get the I2C Controller mapped if it is not mapped yet.
     m_controller = controller;
@@ -196,40 +219,120 @@ HRESULT I2cTransactionClass::execute(I2cControllerClass* controller)
     if (SUCCEEDED(hr))
     {
         m_hI2cLock = m_controller->getControllerHandle();
+
+        // Only take timestamps if this bus is being traced.
+        if (m_controller->getTrace()->isEnabled())
+        {
+            trace = m_controller->getTrace();
+            QueryPerformanceCounter(&lockStart);
+        }
     }
 
     if (SUCCEEDED(hr))
     {
-        // Lock the I2C bus for access exclusively by this transaction.
-        hr = _acquireI2cLock();
+        // Lock the I2C bus for access exclusively by this transaction.  A controller
+        // running against a register model has no bus to share and no lock handle.
+        if (!m_controller->hasRegisterModel())
+        {
+            hr = _acquireI2cLock();
+        }
+
+        if (trace != nullptr)
+        {
+            QueryPerformanceCounter(&busStart);
+            spinStart = busStart;
+            busEnd = busStart;
+        }
     }
 
     // If we have the I2C bus locked:
     if (SUCCEEDED(hr))
     {
+        // Discard any spin time left over from a transaction that stopped being traced.
+        if (trace != nullptr)
+        {
+            trace->takeSpinTicks();
+        }
+
         // Initialize the controller.
-        hr = m_controller->_initializeForTransaction(m_slaveAddress, m_useHighSpeed);
+        hr = m_controller->_initializeForTransaction(m_slaveAddress, m_clockHz);
 
         if (SUCCEEDED(hr))
         {
+            // Record the bus clock rate the controller was able to generate.
+            m_actualClockHz = m_controller->getActualClockRate();
+
             // Process each transfer on the queue.
             hr = _processTransfers();
         }
 
+        if (trace != nullptr)
+        {
+            QueryPerformanceCounter(&spinStart);
+        }
+
         if (SUCCEEDED(hr))
         {
             // Shut down the controller.
             hr = _shutDownI2cAfterTransaction();
         }
 
+        if (trace != nullptr)
+        {
+            QueryPerformanceCounter(&busEnd);
+        }
+
         // Release the I2C lock, ignoring any error returned because it is likely
         // we already have an error that we don't want to cover up.
-        _releaseI2cLock();
+        if (!m_controller->hasRegisterModel())
+        {
+            _releaseI2cLock();
+        }
+    }
+
+    // Add this transaction to the trace for the bus if it is being traced.  The spin
+    // time is the time the controller spent in its poll loops, plus the final wait for
+    // the controller to go idle.
+    if (trace != nullptr)
+    {
+        _recordTrace(trace, hr,
+            busStart.QuadPart - lockStart.QuadPart,
+            busEnd.QuadPart - busStart.QuadPart,
+            trace->takeSpinTicks() + (busEnd.QuadPart - spinStart.QuadPart));
     }
 
     return hr;
 }
 
+// Method to add the results of this transaction to a bus trace.
+void I2cTransactionClass::_recordTrace(I2cTraceClass* trace, HRESULT hr, LONGLONG lockWaitTicks, LONGLONG busTicks, LONGLONG spinTicks)
+{
+    I2C_TRANSACTION_TRACE entry;
+    I2cTransferClass* pXfr = nullptr;
+
+    entry.slaveAddress = m_slaveAddress;
+    entry.bytesWritten = 0;
+    entry.bytesRead = 0;
+    for (pXfr = m_pFirstXfr; pXfr != nullptr; pXfr = pXfr->getNextTransfer())
+    {
+        if (pXfr->transferIsRead())
+        {
+            entry.bytesRead += pXfr->getBufferSize();
+        }
+        else if (!pXfr->hasCallback())
+        {
+            entry.bytesWritten += pXfr->getBufferSize();
+        }
+    }
+    entry.lockWaitUs = trace->ticksToMicroseconds(lockWaitTicks);
+    entry.busUs = trace->ticksToMicroseconds(busTicks);
+    entry.spinUs = trace->ticksToMicroseconds(spinTicks);
+    entry.error = m_error;
+    entry.hr = hr;
+
+    trace->record(entry);
+}
+
 // Method to queue a transfer as part of this transaction.
 void I2cTransactionClass::_queueTransfer(I2cTransferClass* pXfr)
 {
@@ -260,6 +363,7 @@ HRESULT I2cTransactionClass::_processTransfers()
     m_maxWaitTicks = 0;
     m_abort = FALSE;
     m_error = SUCCESS;
+    m_controller->clearTransfersError();
 
     // For each sequence of transfers in the queue, or until transaction is aborted:
     pXfr = m_pFirstXfr;
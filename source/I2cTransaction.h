@@ -10,6 +10,12 @@
 #include "I2cTransfer.h"
 
 class I2cControllerClass;
+class I2cTraceClass;
+
+// I2C bus clock rates defined by the I2C specification (in Hz).
+#define I2C_STANDARD_MODE_HZ 100000
+#define I2C_FAST_MODE_HZ 400000
+#define I2C_FAST_MODE_PLUS_HZ 1000000
 
 //
 // Here, "transaction" is used to mean a set of I2C transfers that occurs 
@@ -29,7 +35,8 @@ public:
         m_abort(FALSE),
         m_error(SUCCESS),
         m_isIncomplete(FALSE),
-        m_useHighSpeed(FALSE)
+        m_clockHz(I2C_STANDARD_MODE_HZ),
+        m_actualClockHz(0)
     {
     }
 
@@ -131,7 +138,31 @@ public:
     /// Method to signal high speed can be used for this transaction.
     void useHighSpeed()
     {
-        m_useHighSpeed = TRUE;
+        m_clockHz = I2C_FAST_MODE_HZ;
+    }
+
+    /// Method to set the I2C bus clock rate to use for this transaction.
+    /**
+    The controller runs the bus at the fastest rate it can generate that does not
+    exceed the requested rate.  Rates up to Fast-mode Plus (1 MHz) are accepted.
+    \param[in] clockHz The desired I2C bus clock rate in Hz.
+    \return HRESULT success or error code.
+    */
+    LIGHTNING_DLL_API HRESULT setClockRate(ULONG clockHz);
+
+    /// Get the I2C bus clock rate requested for this transaction.
+    ULONG getClockRate() const
+    {
+        return m_clockHz;
+    }
+
+    /// Get the I2C bus clock rate actually used the last time this transaction executed.
+    /**
+    \return The achieved clock rate in Hz, or zero if the transaction has not executed.
+    */
+    ULONG getActualClockRate() const
+    {
+        return m_actualClockHz;
     }
 
 private:
@@ -168,8 +199,11 @@ private:
     /// TRUE if one or more incompleted transfers exist on this transaction.
     BOOL m_isIncomplete;
 
-    /// TRUE to allow use of high speed for this transaction.
-    BOOL m_useHighSpeed;
+    /// The requested I2C bus clock rate (in Hz) for this transaction.
+    ULONG m_clockHz;
+
+    /// The I2C bus clock rate (in Hz) the controller achieved for this transaction.
+    ULONG m_actualClockHz;
 
     //
     // I2cTransactionClass private member functions.
@@ -189,6 +223,9 @@ private:
 
     /// Method to release this transaction's lock on the I2C Controller.
     HRESULT _releaseI2cLock();
+
+    /// Method to add the results of this transaction to a bus trace.
+    void _recordTrace(I2cTraceClass* trace, HRESULT hr, LONGLONG lockWaitTicks, LONGLONG busTicks, LONGLONG spinTicks);
 };
 
 #endif // _I2C_TRANSACTION_H_
\ No newline at end of file
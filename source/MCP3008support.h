@@ -15,20 +15,56 @@
 
 #define MCP3008_SPI_MODE SPI_MODE0
 #define MCP3008_MAX_SPI_KHZ 1350
-#define MCP3008_SPI_TRANSFER_BITS 24
+#define MCP3008_SPI_TRANSFER_BITS 8
+
+/// The number of bytes transferred for each MCP3008 conversion.
+#define MCP3008_FRAME_BYTES 3
+
+/// The number of conversions whose frames are built at a time by readBlock().
+#define MCP3008_BLOCK_CONVERSIONS 32
 
 class MCP3008Device
 {
 public:
     /// Constructor.
     MCP3008Device() :
-        m_csPin(0)
+        m_csPin(0),
+        m_hardwareCs(FALSE),
+        m_fastCs(FALSE),
+        m_spi(nullptr),
+        m_ownsController(TRUE)
     {
+        ZeroMemory(&m_csFastPin, sizeof(m_csFastPin));
     }
 
     /// Destructor.
     virtual ~MCP3008Device()
     {
+        if (m_ownsController && (m_spi != nullptr))
+        {
+            delete m_spi;
+            m_spi = nullptr;
+        }
+    }
+
+    /// Run the ADC on an SPI controller object supplied by the caller.
+    /**
+    The caller keeps ownership of the controller, and must have initialized it with its
+    own begin() method and had it drive the ADC chip select line with
+    setHardwareChipSelect().  This lets the ADC code run against a software register
+    model.  It must not be called while the ADC is in use.
+    \param[in] controller The controller to use, or nullptr to have begin() create one.
+    */
+    inline void useController(SpiControllerClass* controller)
+    {
+        if (m_ownsController && (m_spi != nullptr))
+        {
+            delete m_spi;
+        }
+        m_spi = controller;
+        m_ownsController = (controller == nullptr);
+        m_hardwareCs = (controller != nullptr);
+        m_fastCs = FALSE;
     }
 
     /// Prepare to use this ADC.
@@ -40,6 +76,16 @@ public:
         HRESULT hr;
         BoardPinsClass::BOARD_TYPE board;
 
+        // A controller supplied by the caller has already been set up.
+        if (!m_ownsController)
+        {
+            m_spi->setMsbFirstBitOrder();
+            return S_OK;
+        }
+
+        m_hardwareCs = FALSE;
+        m_fastCs = FALSE;
+
         hr = g_pins.getBoardType(board);
 
         if (FAILED(hr))
@@ -67,7 +113,14 @@ public:
                 hr = DMAP_E_BOARD_TYPE_NOT_RECOGNIZED;
             }
 
-            if (SUCCEEDED(hr))
+            // Let the SPI controller drive CS if the CS pin is its CS0 line, which it
+            // is on the Raspberry Pi 2.
+            if (SUCCEEDED(hr) && (board == BoardPinsClass::BOARD_TYPE::PI2_BARE) && (m_csPin == PI2_PIN_SPI0_CS0))
+            {
+                m_hardwareCs = SUCCEEDED(m_spi->setHardwareChipSelect(0, m_csPin, FALSE));
+            }
+
+            if (SUCCEEDED(hr) && !m_hardwareCs)
             {
                 hr = g_pins.setPinMode(m_csPin, DIRECTION_OUT, FALSE);
 
@@ -80,6 +133,14 @@ public:
                 {
                     hr = g_pins.verifyPinFunction(m_csPin, FUNC_DIO, BoardPinsClass::LOCK_FUNCTION);
                 }
+
+                // Cache the register and mask used to drive CS, so each conversion
+                // doesn't go through the board pin lookup.  If that can't be done, CS
+                // is driven with setPinState() instead.
+                if (SUCCEEDED(hr))
+                {
+                    m_fastCs = SUCCEEDED(g_pins.getFastPin(m_csPin, m_csFastPin));
+                }
             }
         }
 
@@ -101,6 +162,12 @@ public:
     /// Release the ADC.
     inline void end()
     {
+        // A controller supplied by the caller is released by the caller.
+        if (!m_ownsController || (m_spi == nullptr))
+        {
+            return;
+        }
+
         // Release the ADC SPI bus.
         m_spi->end();
 
@@ -108,7 +175,13 @@ public:
         m_spi->revertPinsToGpio();
 
         // Unlock the CS line so it can be used for non-GPIO function.
-        g_pins.verifyPinFunction(m_csPin, FUNC_DIO, BoardPinsClass::UNLOCK_FUNCTION);
+        if (!m_hardwareCs)
+        {
+            g_pins.verifyPinFunction(m_csPin, FUNC_DIO, BoardPinsClass::UNLOCK_FUNCTION);
+        }
+
+        delete m_spi;
+        m_spi = nullptr;
     }
 
     /// Take a reading with the ADC used on the Gen2 board.
@@ -121,63 +194,161 @@ public:
     inline HRESULT readValue(ULONG channel, ULONG & value, ULONG & bits)
     {
         HRESULT hr = S_OK;
-        
-        // Make sure the channel number is in range.
-        if (channel >= ADC_CHANNELS)
+
+        hr = readBlock(&channel, 1, &value);
+
+        if (SUCCEEDED(hr))
         {
-            hr = DMAP_E_ADC_DOES_NOT_HAVE_REQUESTED_CHANNEL;
+            bits = ADC_BITS;
         }
+        
+        return hr;
+    }
 
-        ULONG dataIn = 0;
-        BYTE command = (BYTE)(channel & 0x03);  // Using only 3 bits of the passed in ULONG for channel ID
+    /// Take a number of readings with the ADC.
+    /**
+    The command frames for up to MCP3008_BLOCK_CONVERSIONS conversions are built at a
+    time and sent with buffer transfers.  The ADC needs CS raised between conversions,
+    so each frame is sent with its own transfer.  The SPI controller drives CS if it
+    can, otherwise CS is toggled by writing the GPIO registers directly where possible.
+    \param[in] channels The channel to read for each conversion.  A channel can appear
+    more than once, to take several readings of it.
+    \param[in] count The number of conversions to perform.
+    \param[out] values The value read for each conversion.  The readings are 
+    ADC_BITS (10) bits in size.
+    \return HRESULT success or error code.
+    */
+    inline HRESULT readBlock(const ULONG* channels, ULONG count, ULONG* values)
+    {
+        HRESULT hr = S_OK;
 
-        command |= 0x08;     // Single-Ended read - comparing the sample voltage to AGND
-        command <<= 4;      // Channel number and Single-Ended bit are in the upper 4 bits of the command byte
+        BYTE dataOut[MCP3008_BLOCK_CONVERSIONS * MCP3008_FRAME_BYTES];
+        BYTE dataIn[MCP3008_BLOCK_CONVERSIONS * MCP3008_FRAME_BYTES];
+        ULONG done = 0;
+        ULONG blockCount;
+        ULONG i;
+        PBYTE frameIn;
 
-        BYTE dataOut[4] = 
-        { 
-            0x00,       // Upper byte is not used (24 bit transfer)
-            0x01,       // Start Bit
-            command,    // 4 Command bits in top of byte
-            0x00        // MCP3008 ignores these bits.
-        };
+        if ((count > 0) && ((channels == nullptr) || (values == nullptr)))
+        {
+            hr = E_INVALIDARG;
+        }
 
-        if (SUCCEEDED(hr))
+        if (SUCCEEDED(hr) && (m_spi == nullptr))
         {
-            // Perform a conversion and get the result.
-            g_pins.setPinState(m_csPin, LOW);
+            hr = DMAP_E_DMAP_INTERNAL_ERROR;
+        }
 
-            hr = m_spi->transfer24(*reinterpret_cast<ULONG*>(&dataOut[0]), dataIn);
-                
-            g_pins.setPinState(m_csPin, HIGH);
+        // Make sure the channel numbers are in range.
+        for (i = 0; SUCCEEDED(hr) && (i < count); i++)
+        {
+            if (channels[i] >= ADC_CHANNELS)
+            {
+                hr = DMAP_E_ADC_DOES_NOT_HAVE_REQUESTED_CHANNEL;
+            }
         }
 
-        if (SUCCEEDED(hr))
+        while (SUCCEEDED(hr) && (done < count))
         {
-            // Extract the reading from the data sent back from the ADC.
-            value = dataIn & ((1 << ADC_BITS) - 1);
-            bits = ADC_BITS;
+            blockCount = count - done;
+            if (blockCount > MCP3008_BLOCK_CONVERSIONS)
+            {
+                blockCount = MCP3008_BLOCK_CONVERSIONS;
+            }
+
+            // Build the command frames, in the order they are sent on the bus:
+            //   0000 0001   Start bit
+            //   SDDD xxxx   Single-ended bit, 3-bit channel number
+            //   xxxx xxxx   Clocks for the rest of the result
+            for (i = 0; i < blockCount; i++)
+            {
+                dataOut[(i * MCP3008_FRAME_BYTES) + 0] = 0x01;
+                dataOut[(i * MCP3008_FRAME_BYTES) + 1] = (BYTE)((0x08 | (channels[done + i] & 0x07)) << 4);
+                dataOut[(i * MCP3008_FRAME_BYTES) + 2] = 0x00;
+            }
+
+            // Perform the conversions.
+            for (i = 0; SUCCEEDED(hr) && (i < blockCount); i++)
+            {
+                hr = _setChipSelect(LOW);
+
+                if (SUCCEEDED(hr))
+                {
+                    hr = m_spi->transferBuffer(&dataOut[i * MCP3008_FRAME_BYTES], &dataIn[i * MCP3008_FRAME_BYTES], MCP3008_FRAME_BYTES);
+
+                    HRESULT hr2 = _setChipSelect(HIGH);
+                    if (SUCCEEDED(hr))
+                    {
+                        hr = hr2;
+                    }
+                }
+            }
+
+            // Extract the readings from the data sent back from the ADC:
+            //   xxxx xxxx
+            //   xxxx x0DD   Null bit, result bits 9-8
+            //   DDDD DDDD   Result bits 7-0
+            for (i = 0; SUCCEEDED(hr) && (i < blockCount); i++)
+            {
+                frameIn = &dataIn[i * MCP3008_FRAME_BYTES];
+                values[done + i] = ((frameIn[1] << 8) | frameIn[2]) & ((1 << ADC_BITS) - 1);
+            }
+
+            done = done + blockCount;
         }
         
         return hr;
     }
 
 private:
+    /// Drive the CS pin, if the SPI controller is not driving it.
+    /**
+    \param[in] state The state to drive the pin to, LOW to select the ADC.
+    \return HRESULT success or error code.
+    */
+    inline HRESULT _setChipSelect(ULONG state)
+    {
+        HRESULT hr = S_OK;
+
+        if (!m_hardwareCs)
+        {
+            if (m_fastCs)
+            {
+                BoardPinsClass::setFastPinState(m_csFastPin, state);
+            }
+            else
+            {
+                hr = g_pins.setPinState(m_csPin, state);
+            }
+        }
+
+        return hr;
+    }
+
     /// The number of channels on the ADC.
     const ULONG ADC_CHANNELS = 8;
 
     /// The number of bits in an ADC conversion.
     const ULONG ADC_BITS = 10;
 
-    /// The shift amount to put the channel number into a 24-bit value.
-    const ULONG CHAN_SHIFT = 12;
-
     /// The pin number of the CS pin.
     ULONG m_csPin;
 
+    /// The register information used to drive the CS pin.
+    FAST_GPIO_PIN m_csFastPin;
+
+    /// TRUE if the SPI controller drives the CS pin.
+    BOOL m_hardwareCs;
+
+    /// TRUE if m_csFastPin can be used to drive the CS pin.
+    BOOL m_fastCs;
+
     /// The SPI Controller object used to talk to the ADC.
     SpiControllerClass* m_spi;
 
+    /// TRUE if this object created the SPI Controller object and deletes it.
+    BOOL m_ownsController;
+
 };
 
 #endif  // _MCP3008_SUPPORT_H_
\ No newline at end of file
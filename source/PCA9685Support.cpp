@@ -10,12 +10,13 @@
 #include "ErrorCodes.h"
 #include "ArduinoCommon.h"
 
-// Start with "chip not initialized" status.
-BOOL PCA9685Device::m_chipIsInitialized = FALSE;
+// Start with no PWM chips known.
+std::map<ULONG, std::unique_ptr<PCA9685Device> > PCA9685Device::m_devices;
+SRWLOCK PCA9685Device::m_devicesLock = SRWLOCK_INIT;
 
 // PWM prescale value for default pulse rate of 1000 pulses per second.
 // Prescale = round(25000000/(4096 * pulse_rate)) - 1
-UCHAR PCA9685Device::m_freqPreScale = 5;
+const UCHAR PCA9685Device::DEFAULT_PRE_SCALE = 5;
 
 const ULONG PCA9685Device::PWM_BITS         =   12;     // This PWM chip has 12 bits of resolution
 
@@ -40,8 +41,7 @@ This method takes the actions needed to set a port bit of the PWM chip to the de
 HRESULT PCA9685Device::SetBitState(ULONG i2cAdr, ULONG portBit, ULONG state)
 {
     HRESULT hr = S_OK;
-    I2cTransactionClass transaction;
-    UCHAR bitRegsAdr = 0;                       // Address of start of registers for bit in question
+    PCA9685Device* device = nullptr;
     UCHAR lowBitData[REGS_PER_LED] = { 0x00, 0x00, 0x00, 0x10 };    // Registers data to set bit low
     UCHAR highBitData[REGS_PER_LED] = { 0x00, 0x10, 0x00, 0x00 };   // Registers data to set bit high
 
@@ -57,46 +57,31 @@ HRESULT PCA9685Device::SetBitState(ULONG i2cAdr, ULONG portBit, ULONG state)
 
     if (SUCCEEDED(hr))
     {
-        // Make sure the PWM chip is initialized.
-        hr = _InitializeChip(i2cAdr);
+        // Get the object for the PWM chip at this address.
+        hr = _GetDevice(i2cAdr, device);
     }
 
     if (SUCCEEDED(hr))
     {
-        // Set the I2C address of the PWM chip.
-        hr = transaction.setAddress(i2cAdr);
-    }
+        EnterCriticalSection(&device->m_lock);
 
-    if (SUCCEEDED(hr))
-    {
-        // Indicate this chip supports high speed I2C transfers.
-        transaction.useHighSpeed();
-
-        // Calculate the address of the first register for the port in question.
-        bitRegsAdr = (UCHAR)(LEDS_BASE_ADR + (portBit * REGS_PER_LED));
-
-        // Queue sending the base address of the port registers to the chip.
-        hr = transaction.queueWrite(&bitRegsAdr, 1);
-    }
+        // Make sure the PWM chip is initialized.
+        hr = device->_InitializeChip();
 
-    if (SUCCEEDED(hr))
-    {
-        // Queue sending the registers contents to set the specified bit state.
-        if (state == LOW)
-        {
-            hr = transaction.queueWrite(lowBitData, REGS_PER_LED);
-        }
-        else
+        if (SUCCEEDED(hr))
         {
-            hr = transaction.queueWrite(highBitData, REGS_PER_LED);
+            // Send the registers contents to set the specified bit state (if they changed).
+            if (state == LOW)
+            {
+                hr = device->_WriteLedRegs(portBit, 1, lowBitData);
+            }
+            else
+            {
+                hr = device->_WriteLedRegs(portBit, 1, highBitData);
+            }
         }
-        
-    }
 
-    if (SUCCEEDED(hr))
-    {
-        // Actually perform the I2C transfers specified above.
-        hr = transaction.execute(g_i2c.getController());
+        LeaveCriticalSection(&device->m_lock);
     }
     
     return hr;
@@ -113,6 +98,7 @@ HRESULT PCA9685Device::GetBitState(ULONG i2cAdr, ULONG portBit, ULONG & state)
 {
     HRESULT hr = S_OK;
     I2cTransactionClass transaction;
+    PCA9685Device* device = nullptr;
     UCHAR bitRegsAdr = 0;                       // Address of start of registers for bit in question
     UCHAR bitData[REGS_PER_LED] = { 0 };        // Buffer for bit register contents
 
@@ -124,8 +110,18 @@ HRESULT PCA9685Device::GetBitState(ULONG i2cAdr, ULONG portBit, ULONG & state)
 
     if (SUCCEEDED(hr))
     {
+        // Get the object for the PWM chip at this address.
+        hr = _GetDevice(i2cAdr, device);
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        EnterCriticalSection(&device->m_lock);
+
         // Make sure the PWM chip is initialized.
-        hr = _InitializeChip(i2cAdr);
+        hr = device->_InitializeChip();
+
+        LeaveCriticalSection(&device->m_lock);
     }
 
     if (SUCCEEDED(hr))
@@ -189,9 +185,7 @@ Set the width of the positive pulses on one of the PWM channels.
 HRESULT PCA9685Device::SetPwmDutyCycle(ULONG i2cAdr, ULONG channel, ULONG dutyCycle)
 {
     HRESULT hr = S_OK;
-    I2cTransactionClass transaction;
-    ULONGLONG tmpPulsetime = 0;
-    UCHAR bitRegsAdr = 0;                       // Address of start of registers for bit in question
+    PCA9685Device* device = nullptr;
     UCHAR pulseData[REGS_PER_LED] = { 0x00, 0x00, 0x00, 0x00 };    // Registers data to set pulse time
 
 
@@ -202,46 +196,99 @@ HRESULT PCA9685Device::SetPwmDutyCycle(ULONG i2cAdr, ULONG channel, ULONG dutyCy
 
     if (SUCCEEDED(hr))
     {
-        // Make sure the PWM chip is initialized.
-        hr = _InitializeChip(i2cAdr);
+        // Get the object for the PWM chip at this address.
+        hr = _GetDevice(i2cAdr, device);
     }
 
     if (SUCCEEDED(hr))
     {
-        // Set the I2C address of the PWM chip.
-        hr = transaction.setAddress(i2cAdr);
+        // Get the pulse high time in PWM chip terms.
+        _DutyCycleToLedRegs(dutyCycle, pulseData);
+
+        EnterCriticalSection(&device->m_lock);
+
+        // Make sure the PWM chip is initialized.
+        hr = device->_InitializeChip();
+
+        if (SUCCEEDED(hr))
+        {
+            // Send the registers contents for the desired pulse width (if they changed).
+            hr = device->_WriteLedRegs(channel, 1, pulseData);
+        }
+
+        LeaveCriticalSection(&device->m_lock);
     }
+    
+    return hr;
+}
 
-    if (SUCCEEDED(hr))
-    {
-        // Indicate this chip supports high speed I2C transfers.
-        transaction.useHighSpeed();
+/**
+Set the width of the positive pulses on a range of PWM channels.  The registers of all 
+the channels whose pulse width changes are written in one auto-incremented I2C write.
+Since the chip is set to update its outputs on the I2C STOP, all the new pulse widths
+take effect together.
+\param[in] i2cAdr The I2C address of the PWM chip.
+\param[in] firstChannel The first channel on the PWM chip for which to set the pulse width.
+\param[in] count The number of channels for which to set the pulse width.
+\param[in] dutyCycles Array of count duty-cycles (0-0xFFFFFFFF for 0-100%), one per channel.
+\param[in] channelMask Bit set for each channel in the range to set (bit 0 for firstChannel).
+Channels with a clear bit keep their current pulse widths.
+\return HRESULT success or error code.
+*/
+HRESULT PCA9685Device::SetDutyCycles(ULONG i2cAdr, ULONG firstChannel, ULONG count, const ULONG* dutyCycles, ULONG channelMask)
+{
+    HRESULT hr = S_OK;
+    PCA9685Device* device = nullptr;
+    UCHAR pulseData[PCA9685_LED_REGS_BYTES] = { 0 };    // Registers data to set pulse times
 
-        // Calculate the address of the first register for the port in question.
-        bitRegsAdr = (UCHAR)(LEDS_BASE_ADR + (channel * REGS_PER_LED));
 
-        // Queue sending the base address of the port registers to the chip.
-        hr = transaction.queueWrite(&bitRegsAdr, 1);
+    if ((firstChannel >= LED_COUNT) || (count == 0) || (count > (LED_COUNT - firstChannel)))
+    {
+        hr = DMAP_E_INVALID_PORT_BIT_FOR_DEVICE;
     }
 
-    if (SUCCEEDED(hr))
+    if (SUCCEEDED(hr) && (dutyCycles == nullptr))
     {
-        // Get the pulse high time in PWM chip terms.
-        tmpPulsetime = ((((ULONGLONG)dutyCycle) * (1LL << PWM_BITS)) + 0x80000000LL) / 0x100000000LL;
-        tmpPulsetime = tmpPulsetime & ((1LL << PWM_BITS) - 1LL);
-        pulseData[2] = (UCHAR)(tmpPulsetime & 0xFF);
-        pulseData[3] = (UCHAR)((tmpPulsetime >> 8) & 0xFF);
+        hr = E_INVALIDARG;
+    }
 
-        // Queue sending the registers contents for the desired pulse width.
-        hr = transaction.queueWrite(pulseData, REGS_PER_LED);
+    if (SUCCEEDED(hr))
+    {
+        // Get the object for the PWM chip at this address.
+        hr = _GetDevice(i2cAdr, device);
     }
 
     if (SUCCEEDED(hr))
     {
-        // Actually perform the I2C transfers specified above.
-        hr = transaction.execute(g_i2c.getController());
+        // Get the pulse high times in PWM chip terms.
+        for (ULONG i = 0; i < count; i++)
+        {
+            _DutyCycleToLedRegs(dutyCycles[i], &pulseData[i * REGS_PER_LED]);
+        }
+
+        EnterCriticalSection(&device->m_lock);
+
+        // Make sure the PWM chip is initialized.
+        hr = device->_InitializeChip();
+
+        if (SUCCEEDED(hr))
+        {
+            // Channels left out of the mask keep what the chip already has.
+            for (ULONG i = 0; i < count; i++)
+            {
+                if ((channelMask & (1UL << i)) == 0)
+                {
+                    memcpy(&pulseData[i * REGS_PER_LED], &device->m_ledRegs[(firstChannel + i) * REGS_PER_LED], REGS_PER_LED);
+                }
+            }
+
+            // Send the registers contents for the channels that changed.
+            hr = device->_WriteLedRegs(firstChannel, count, pulseData);
+        }
+
+        LeaveCriticalSection(&device->m_lock);
     }
-    
+
     return hr;
 }
 
@@ -255,7 +302,8 @@ HRESULT PCA9685Device::SetPwmFrequency(ULONG i2cAdr, ULONG frequency)
 {
     HRESULT hr = S_OK;
     I2cTransactionClass transaction;
-    ULONG preScale;
+    PCA9685Device* device = nullptr;
+    ULONG preScale = 0;
     UCHAR readBuf[1] = { 0 };                       // Buffer for reading data from chip
     UCHAR mode1RegAdr[1] = { MODE1_ADR };           // Buffer for MODE1 register address
     UCHAR preScaleAdr[1] = { PRE_SCALE_ADR };       // Buffer for PRE_SCALE register address
@@ -263,8 +311,18 @@ HRESULT PCA9685Device::SetPwmFrequency(ULONG i2cAdr, ULONG frequency)
     MODE1 mode1Run = { 0, 0, 0, 0, 0, 1, 0, 0 };    // No sleep, auto-increment, internal clock
 
 
-                                                    // Make sure the PWM chip is initialized.
-    hr = _InitializeChip(i2cAdr);
+    // Get the object for the PWM chip at this address.
+    hr = _GetDevice(i2cAdr, device);
+
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    EnterCriticalSection(&device->m_lock);
+
+    // Make sure the PWM chip is initialized.
+    hr = device->_InitializeChip();
 
     if (SUCCEEDED(hr))
     {
@@ -291,7 +349,7 @@ HRESULT PCA9685Device::SetPwmFrequency(ULONG i2cAdr, ULONG frequency)
     }
 
     // If we need to set a new prescale value.
-    if (SUCCEEDED(hr) && (m_freqPreScale != preScale))
+    if (SUCCEEDED(hr) && (device->m_freqPreScale != preScale))
     {
         // Queue a write to set the Sleep bit (so we can change the PWM frequency).
         hr = transaction.queueWrite(mode1RegAdr, sizeof(mode1RegAdr));
@@ -339,10 +397,12 @@ HRESULT PCA9685Device::SetPwmFrequency(ULONG i2cAdr, ULONG frequency)
         // Record the prescale value just set.
         if (SUCCEEDED(hr))
         {
-            m_freqPreScale = (UCHAR)preScale;
+            device->m_freqPreScale = (UCHAR)preScale;
         }
     }
 
+    LeaveCriticalSection(&device->m_lock);
+
     return hr;
 }
 
@@ -354,13 +414,22 @@ Get the actual pulse repetition rate for the PWM channels on the specified chip.
 ULONG PCA9685Device::GetActualPwmFrequency(ULONG i2cAdr)
 {
     HRESULT hr = S_OK;
+    PCA9685Device* device = nullptr;
+    ULONG preScale = DEFAULT_PRE_SCALE;
     ULONG frequency;
     ULONG divisor;
 
+    // Get the prescale value last set on the PWM chip at this address.
+    hr = _GetDevice(i2cAdr, device);
+    if (SUCCEEDED(hr))
+    {
+        preScale = device->m_freqPreScale;
+    }
+
     // From PCA9685 datasheet: prescale = round(25,000,000 / (4096 * pulse_rate)) - 1
     // so pulse_rate = round( 25,000,000 / ((prescale + 1) * 4096) )
 
-    divisor = (m_freqPreScale + 1) * 4096;
+    divisor = (preScale + 1) * 4096;
     frequency = (25000000 + (divisor / 2)) / divisor;
 
     return frequency;
@@ -371,10 +440,11 @@ This method takes any actions needed to initialize the PWM chip for use by other
 If the chip has already been initialized it does nothing, otherwise it sets the pulse rate
 prescale value, turns on the chip and sets the mode registers for how other methods access 
 the chip.
-\param[in] i2cAdr The I2C address of the PWM chip.
+Once the chip is initialized its LED output registers are read into the shadow copy.
 \return HRESULT success or error code.
+\note The caller must hold this chip's lock.
 */
-HRESULT PCA9685Device::_InitializeChip(ULONG i2cAdr)
+HRESULT PCA9685Device::_InitializeChip()
 {
     HRESULT hr = S_OK;
 
@@ -391,10 +461,10 @@ HRESULT PCA9685Device::_InitializeChip(ULONG i2cAdr)
         UCHAR mode2RegAdr[1] = { MODE2_ADR };       // Buffer for MODE2 register address
         UCHAR preScaleAdr[1] = { PRE_SCALE_ADR };   // Buffer for PRE_SCALE register address
         MODE1 mode1Reg = { 0, 0, 0, 0, 0, 1, 0, 0 }; // No sleep, auto-increment, internal clock
-        MODE2 mode2Reg = { 0, 1, 1, 0, 0 };         // Drive outputs both high & low, change on ACK, non-inverted
+        MODE2 mode2Reg = { 0, 1, 0, 0, 0 };         // Drive outputs both high & low, change on STOP, non-inverted
 
         // Set the I2C address of the PWM chip.
-        hr = transaction.setAddress(i2cAdr);
+        hr = transaction.setAddress(m_i2cAdr);
 
         if (SUCCEEDED(hr))
         {
@@ -411,6 +481,23 @@ HRESULT PCA9685Device::_InitializeChip(ULONG i2cAdr)
             hr = transaction.queueRead(readBuf, sizeof(readBuf));
         }
 
+        //
+        // Set MODE2 whether or not the chip was initialized, so a chip set up to change
+        // its outputs on ACK is switched to changing them on STOP.
+        //
+
+        if (SUCCEEDED(hr))
+        {
+            // Queue RESTART and sending the address of the MODE2 register to the PWM chip.
+            hr = transaction.queueWrite(mode2RegAdr, sizeof(mode2RegAdr), TRUE);
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            // Queue sending the contents of MODE2 register.
+            hr = transaction.queueWrite((PUCHAR)&mode2Reg, 1);
+        }
+
         //
         // If the SLEEP bit is clear, the chip has been initialize: abort the rest of the transaction.
         //
@@ -468,30 +555,36 @@ HRESULT PCA9685Device::_InitializeChip(ULONG i2cAdr)
             }
         }
 
+        //
+        // Perform the read, decision, and writes to initialize the chip (if needed).
+        //
+
         if (SUCCEEDED(hr))
         {
-            // Queue RESTART and sending the address of the MODE2 register to the PWM chip.
-            hr = transaction.queueWrite(mode2RegAdr, sizeof(mode2RegAdr), TRUE);
+            // Actually perform the I2C transfers specified above.
+            hr = transaction.execute(g_i2c.getController());
         }
 
-        if (SUCCEEDED(hr))
+        //
+        // If the chip was found initialized without register auto-increment, turn it on.
+        //
+
+        if (SUCCEEDED(hr) && (((PMODE1)readBuf)->AI == 0))
         {
-            // Queue sending the contents of MODE2 register.
-            hr = transaction.queueWrite((PUCHAR)&mode2Reg, 1);
+            hr = _EnableAutoIncrement(readBuf[0]);
         }
 
         //
-        // Perform the read, decision, and writes to initialize the chip (if needed).
+        // Whether we initialized the chip or found it initialized, get the current LED settings.
         //
 
         if (SUCCEEDED(hr))
         {
-            // Actually perform the I2C transfers specified above.
-            hr = transaction.execute(g_i2c.getController());
+            hr = _ReadLedRegs();
         }
 
         //
-        // Whether we initialized the chip or found it initialized, we now know it is initialized.
+        // We now know the chip is initialized.
         //
 
         if (SUCCEEDED(hr))
@@ -502,4 +595,216 @@ HRESULT PCA9685Device::_InitializeChip(ULONG i2cAdr)
     }
     
     return hr;
-}
\ No newline at end of file
+}
+
+/**
+Get the object that holds the state of the PWM chip at an I2C address.  The first
+time an address is used an object is created for it.
+\param[in] i2cAdr The I2C address of the PWM chip.
+\param[out] device Pointer to the object for the PWM chip.
+\return HRESULT success or error code.
+*/
+HRESULT PCA9685Device::_GetDevice(ULONG i2cAdr, PCA9685Device* & device)
+{
+    HRESULT hr = S_OK;
+
+    AcquireSRWLockExclusive(&m_devicesLock);
+
+    std::unique_ptr<PCA9685Device> & entry = m_devices[i2cAdr];
+    if (!entry)
+    {
+        entry.reset(new (std::nothrow) PCA9685Device(i2cAdr));
+    }
+    device = entry.get();
+
+    if (device == nullptr)
+    {
+        m_devices.erase(i2cAdr);
+        hr = E_OUTOFMEMORY;
+    }
+
+    ReleaseSRWLockExclusive(&m_devicesLock);
+
+    return hr;
+}
+
+/**
+Read all the LED output registers from the PWM chip into the shadow copy.
+\return HRESULT success or error code.
+*/
+HRESULT PCA9685Device::_ReadLedRegs()
+{
+    HRESULT hr = S_OK;
+    I2cTransactionClass transaction;
+    UCHAR ledsBaseAdr[1] = { LEDS_BASE_ADR };   // Buffer for address of first LED register
+
+    // Set the I2C address of the PWM chip.
+    hr = transaction.setAddress(m_i2cAdr);
+
+    if (SUCCEEDED(hr))
+    {
+        // Indicate this chip supports high speed I2C transfers.
+        transaction.useHighSpeed();
+
+        // Queue sending the address of the first LED register to the PWM chip.
+        hr = transaction.queueWrite(ledsBaseAdr, sizeof(ledsBaseAdr));
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Queue reading all the LED registers (the chip auto-increments the register address).
+        hr = transaction.queueRead(m_ledRegs, sizeof(m_ledRegs));
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Actually perform the I2C transfers specified above.
+        hr = transaction.execute(g_i2c.getController());
+    }
+
+    return hr;
+}
+
+/**
+Convert a duty-cycle to the contents of the LED output registers for a channel.
+\param[in] dutyCycle The desired duty-cycle of the positive pulses (0-0xFFFFFFFF for 0-100%).
+\param[out] regData The REGS_PER_LED bytes of register contents for the duty-cycle.
+*/
+void PCA9685Device::_DutyCycleToLedRegs(ULONG dutyCycle, PUCHAR regData)
+{
+    ULONGLONG tmpPulsetime = 0;
+
+    // Pulses start at count zero, and end at a count proportional to the duty-cycle.
+    tmpPulsetime = ((((ULONGLONG)dutyCycle) * (1LL << PWM_BITS)) + 0x80000000LL) / 0x100000000LL;
+    tmpPulsetime = tmpPulsetime & ((1LL << PWM_BITS) - 1LL);
+    regData[0] = 0x00;
+    regData[1] = 0x00;
+    regData[2] = (UCHAR)(tmpPulsetime & 0xFF);
+    regData[3] = (UCHAR)((tmpPulsetime >> 8) & 0xFF);
+}
+
+/**
+Set the LED output registers for a range of channels of the PWM chip.  The registers
+from the first to the last channel whose contents change are sent as one
+auto-incremented write, so the update is a single I2C transaction with a single STOP.
+Unchanged channels between them are sent again with the values they already hold.
+\param[in] firstChannel The first channel on the PWM chip for which to set the registers.
+\param[in] count The number of channels for which to set the registers.
+\param[in] regData The REGS_PER_LED bytes to write to each channel's registers.
+\return HRESULT success or error code.
+\note The caller must hold this chip's lock, and the chip must be initialized.
+*/
+HRESULT PCA9685Device::_WriteLedRegs(ULONG firstChannel, ULONG count, const UCHAR* regData)
+{
+    HRESULT hr = S_OK;
+    I2cTransactionClass transaction;
+    UCHAR newRegs[PCA9685_LED_REGS_BYTES];      // LED register contents after the update
+    UCHAR spanRegsAdr[1] = { 0 };               // Address of the first register of the span
+    ULONG spanStart = LED_COUNT;                // First channel that changes
+    ULONG spanEnd = 0;                          // One past the last channel that changes
+    ULONG channel = 0;
+
+
+    // Build the new register contents, and find the span of channels that change.
+    memcpy(newRegs, m_ledRegs, sizeof(newRegs));
+    memcpy(&newRegs[firstChannel * REGS_PER_LED], regData, count * REGS_PER_LED);
+    for (channel = firstChannel; channel < (firstChannel + count); channel++)
+    {
+        if (memcmp(&newRegs[channel * REGS_PER_LED], &m_ledRegs[channel * REGS_PER_LED], REGS_PER_LED) != 0)
+        {
+            if (spanStart == LED_COUNT)
+            {
+                spanStart = channel;
+            }
+            spanEnd = channel + 1;
+        }
+    }
+
+    // If the chip already has these register values, we are done.
+    if (spanStart == LED_COUNT)
+    {
+        return S_OK;
+    }
+
+    // Set the I2C address of the PWM chip.
+    hr = transaction.setAddress(m_i2cAdr);
+
+    if (SUCCEEDED(hr))
+    {
+        // Indicate this chip supports high speed I2C transfers.
+        transaction.useHighSpeed();
+
+        // Queue sending the address of the first register of the span.
+        spanRegsAdr[0] = (UCHAR)(LEDS_BASE_ADR + (spanStart * REGS_PER_LED));
+        hr = transaction.queueWrite(spanRegsAdr, sizeof(spanRegsAdr));
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Queue sending the contents of the registers in the span.
+        hr = transaction.queueWrite(&newRegs[spanStart * REGS_PER_LED], (spanEnd - spanStart) * REGS_PER_LED);
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Actually perform the I2C transfers specified above.
+        hr = transaction.execute(g_i2c.getController());
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Record what the chip now holds.
+        memcpy(m_ledRegs, newRegs, sizeof(m_ledRegs));
+    }
+    else
+    {
+        // The chip contents are no longer known, re-initialize it on next use.
+        m_chipIsInitialized = FALSE;
+    }
+
+    return hr;
+}
+
+/**
+Set the auto-increment bit in the MODE1 register, so multi-register reads and writes
+access consecutive registers.
+\param[in] mode1 The current contents of the MODE1 register.
+\return HRESULT success or error code.
+*/
+HRESULT PCA9685Device::_EnableAutoIncrement(UCHAR mode1)
+{
+    HRESULT hr = S_OK;
+    I2cTransactionClass transaction;
+    UCHAR mode1RegAdr[1] = { MODE1_ADR };       // Buffer for MODE1 register address
+    UCHAR mode1Reg = mode1;                     // New contents of the MODE1 register
+
+    // Set the auto-increment bit, without writing a 1 to RESTART (which would clear it).
+    ((PMODE1)&mode1Reg)->AI = 1;
+    ((PMODE1)&mode1Reg)->RESTART = 0;
+
+    // Set the I2C address of the PWM chip.
+    hr = transaction.setAddress(m_i2cAdr);
+
+    if (SUCCEEDED(hr))
+    {
+        // Indicate this chip supports high speed I2C transfers.
+        transaction.useHighSpeed();
+
+        // Queue sending the address of the MODE1 register to the PWM chip.
+        hr = transaction.queueWrite(mode1RegAdr, sizeof(mode1RegAdr));
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Queue sending the contents of MODE1 register.
+        hr = transaction.queueWrite(&mode1Reg, 1);
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Actually perform the I2C transfers specified above.
+        hr = transaction.execute(g_i2c.getController());
+    }
+
+    return hr;
+}
@@ -6,6 +6,11 @@
 #define _PCA9685_SUPPORT_H_
 
 #include <Windows.h>
+#include <map>
+#include <memory>
+
+// Number of bytes in the LED output registers of a PCA9685 (16 LEDs, 4 registers each).
+#define PCA9685_LED_REGS_BYTES 64
 
 class PCA9685Device
 {
@@ -20,6 +25,9 @@ public:
     /// Set the PWM pulse width.
     static HRESULT SetPwmDutyCycle(ULONG i2cAdr, ULONG bit, ULONG pulseWidth);
 
+    /// Set the PWM pulse widths of a range of channels in one I2C transaction.
+    LIGHTNING_DLL_API static HRESULT SetDutyCycles(ULONG i2cAdr, ULONG firstChannel, ULONG count, const ULONG* dutyCycles, ULONG channelMask = 0xFFFFFFFF);
+
     /// Set the PWM pulse repetition rate.
     static HRESULT SetPwmFrequency(ULONG i2cAdr, ULONG frequencyHz);
 
@@ -45,6 +53,7 @@ private:
     static const ULONG PRE_SCALE_ADR;   ///< Address of frequency prescale register
     static const ULONG TestMode_ADR;    ///< Address of TestMode register
     static const ULONG LED_COUNT;       ///< Number of LEDs supported by PWM chip
+    static const UCHAR DEFAULT_PRE_SCALE;   ///< Prescale value for the default pulse rate
 
     /// Struct with the layout of the PWM chip MODE1 register.
     typedef struct {
@@ -68,31 +77,64 @@ private:
     } MODE2, *PMODE2;
 
     /// Constructor.
-    PCA9685Device()
+    PCA9685Device(ULONG i2cAdr) :
+        m_i2cAdr(i2cAdr),
+        m_chipIsInitialized(FALSE),
+        m_freqPreScale(DEFAULT_PRE_SCALE)
     {
+        InitializeCriticalSection(&m_lock);
+        ZeroMemory(m_ledRegs, sizeof(m_ledRegs));
     }
 
     /// Copy constructor.
-    PCA9685Device(PCA9685Device&)
-    {
-    }
+    PCA9685Device(PCA9685Device&);
 
+public:
     /// Destructor.
     virtual ~PCA9685Device()
     {
+        DeleteCriticalSection(&m_lock);
     }
 
-    // If/when multiple PCA9685 chips are supported, the data unique to the chip
-    //    should be indexed by I2C address.
+private:
+    /// The I2C address of this PWM chip.
+    ULONG m_i2cAdr;
 
     /// Set to TRUE when the chip is known to have been initialized.
-    static BOOL m_chipIsInitialized;
+    BOOL m_chipIsInitialized;
+
+    /// The current PWM pulse rate pre-scale value for all channels of this chip.
+    UCHAR m_freqPreScale;
+
+    /// Shadow copy of the LED output registers, valid once the chip is initialized.
+    UCHAR m_ledRegs[PCA9685_LED_REGS_BYTES];
 
-    /// The current PWM pulse rate pre-scale value for all channels.
-    static UCHAR m_freqPreScale;
+    /// Lock used to serialize access to this chip and its shadow registers.
+    RTL_CRITICAL_SECTION m_lock;
+
+    /// The PWM chips in use, indexed by I2C address.
+    static std::map<ULONG, std::unique_ptr<PCA9685Device> > m_devices;
+
+    /// Lock used to serialize access to the map of PWM chips.
+    static SRWLOCK m_devicesLock;
+
+    /// Method to get the object for the PWM chip at an I2C address, creating it if needed.
+    static HRESULT _GetDevice(ULONG i2cAdr, PCA9685Device* & device);
 
     /// Method to take any necessary actions to initialize the PWM chip.
-    static HRESULT _InitializeChip(ULONG i2cAdr);
+    HRESULT _InitializeChip();
+
+    /// Method to read the LED output registers from the chip into the shadow copy.
+    HRESULT _ReadLedRegs();
+
+    /// Method to turn on register address auto-increment.
+    HRESULT _EnableAutoIncrement(UCHAR mode1);
+
+    /// Method to set the LED output registers for a range of channels, where they have changed.
+    HRESULT _WriteLedRegs(ULONG firstChannel, ULONG count, const UCHAR* regData);
+
+    /// Method to convert a duty-cycle to LED output register contents.
+    static void _DutyCycleToLedRegs(ULONG dutyCycle, PUCHAR regData);
 };
 
 #endif  // _PCA9685_SUPPORT_H_
\ No newline at end of file
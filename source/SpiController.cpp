@@ -24,6 +24,12 @@ HRESULT SpiControllerClass::revertPinsToGpio()
     tmpHr = g_pins.verifyPinFunction(m_misoPin, FUNC_DIO, BoardPinsClass::UNLOCK_FUNCTION);
     if (SUCCEEDED(hr)) { hr = tmpHr; }
 
+    if (hasHardwareChipSelect())
+    {
+        tmpHr = g_pins.verifyPinFunction(m_csPin, FUNC_DIO, BoardPinsClass::UNLOCK_FUNCTION);
+        if (SUCCEEDED(hr)) { hr = tmpHr; }
+    }
+
     return hr;
 }
 
@@ -182,12 +188,19 @@ HRESULT SpiControllerClass::transfer32(ULONG dataOut, ULONG & dataIn)
 HRESULT SpiControllerClass::transferN(ULONG dataOut, ULONG & dataIn, ULONG bits)
 {
     HRESULT hr = S_OK;
-    ULONG tmpData = dataOut;
     ULONG txData = dataOut;
     ULONG rxData = 0;
-    ULONG i;
 
-    if (bits > 32)
+    // Reverse the order of the low "bits" bits of a longword: reverse the bits in
+    // each byte, reverse the bytes, then drop the unused low bits.
+    auto reverseBits = [bits](ULONG data) -> ULONG
+    {
+        data = _reverseBitsInBytes(data);
+        data = (data >> 24) | ((data >> 8) & 0x0000FF00) | ((data << 8) & 0x00FF0000) | (data << 24);
+        return data >> (32 - bits);
+    };
+
+    if ((bits == 0) || (bits > 32))
     {
         hr = DMAP_E_SPI_DATA_WIDTH_SPECIFIED_IS_INVALID;
     }
@@ -197,28 +210,176 @@ HRESULT SpiControllerClass::transferN(ULONG dataOut, ULONG & dataIn, ULONG bits)
         // Flip the bit order if needed.
         if (m_flipBitOrder)
         {
-            for (i = 0; i < (bits - 1); i++)
-            {
-                txData = txData << 1;
-                tmpData = tmpData >> 1;
-                txData = txData | (tmpData & 0x01);
-            }
+            txData = reverseBits(txData);
         }
 
-        hr = _transfer(tmpData, rxData, bits);
+        hr = _transfer(txData, rxData, bits);
 
-        tmpData = rxData;
         // Flip the received data bit order if needed.
         if (m_flipBitOrder)
         {
-            for (i = 0; i < (bits - 1); i++)
+            rxData = reverseBits(rxData);
+        }
+        dataIn = rxData & (0xFFFFFFFF >> (32 - bits));
+    }
+
+    return hr;
+}
+
+/**
+The segments are sent one after another without returning to the caller.  Chip select
+is asserted before the first segment and released after each segment whose csHold
+flag is FALSE, and after the last segment.  A segment delay is done before the chip
+select line is released.  Any clock rate change made for a segment is undone before
+this method returns.
+\param[in] segments The segments of the message, in the order they are sent.
+\param[in] segmentCount The number of segments in the message.
+\return HRESULT success or error code.
+*/
+HRESULT SpiControllerClass::transferMessage(const SPI_MESSAGE_SEGMENT* segments, ULONG segmentCount)
+{
+    HRESULT hr = S_OK;
+    HRESULT tmpHr;
+    ULONG savedClockKhz = m_clockKhz;
+    BOOL clockChanged = FALSE;
+    BOOL frameActive = FALSE;
+    ULONG bits;
+    ULONG wordBytes;
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    LONGLONG delayEnd;
+    ULONG i;
+
+    if ((segments == nullptr) && (segmentCount > 0))
+    {
+        hr = E_INVALIDARG;
+    }
+
+    // Check all the segments before anything is sent.
+    for (i = 0; SUCCEEDED(hr) && (i < segmentCount); i++)
+    {
+        bits = (segments[i].bitsPerWord == 0) ? m_dataBits : segments[i].bitsPerWord;
+        wordBytes = (bits <= 8) ? 1 : ((bits <= 16) ? 2 : 4);
+
+        if ((bits == 0) || (bits > 32) || ((segments[i].bufferBytes % wordBytes) != 0))
+        {
+            hr = DMAP_E_SPI_DATA_WIDTH_SPECIFIED_IS_INVALID;
+        }
+    }
+
+    QueryPerformanceFrequency(&frequency);
+
+    for (i = 0; SUCCEEDED(hr) && (i < segmentCount); i++)
+    {
+        if ((segments[i].clockKhz != 0) && (segments[i].clockKhz != m_clockKhz))
+        {
+            hr = setClock(segments[i].clockKhz);
+            clockChanged = TRUE;
+        }
+
+        if (SUCCEEDED(hr) && !frameActive)
+        {
+            _startChipSelectFrame();
+            frameActive = TRUE;
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            hr = _transferSegment(segments[i]);
+        }
+
+        if (SUCCEEDED(hr) && (segments[i].delayUs > 0))
+        {
+            QueryPerformanceCounter(&now);
+            delayEnd = now.QuadPart + ((segments[i].delayUs * frequency.QuadPart) + 999999) / 1000000;
+            do
+            {
+                YieldProcessor();
+                QueryPerformanceCounter(&now);
+            } while (now.QuadPart < delayEnd);
+        }
+
+        if (frameActive && (FAILED(hr) || !segments[i].csHold || (i == (segmentCount - 1))))
+        {
+            _endChipSelectFrame();
+            frameActive = FALSE;
+        }
+    }
+
+    if (clockChanged && (savedClockKhz != 0))
+    {
+        tmpHr = setClock(savedClockKhz);
+        if (SUCCEEDED(hr)) { hr = tmpHr; }
+    }
+
+    return hr;
+}
+
+/**
+Byte-wide segments are sent with a single buffer transfer.  Wider or narrower words are
+sent one at a time, inside the chip select frame of the message.
+\param[in] segment The segment to transfer.
+\return HRESULT success or error code.
+*/
+HRESULT SpiControllerClass::_transferSegment(const SPI_MESSAGE_SEGMENT & segment)
+{
+    HRESULT hr = S_OK;
+    ULONG bits = (segment.bitsPerWord == 0) ? m_dataBits : segment.bitsPerWord;
+    ULONG wordBytes = (bits <= 8) ? 1 : ((bits <= 16) ? 2 : 4);
+    ULONG dataOut;
+    ULONG dataIn;
+    USHORT halfWord;
+    size_t i;
+
+    if (segment.bufferBytes == 0)
+    {
+        // Nothing to send, this segment is only a delay.
+    }
+    else if (bits == 8)
+    {
+        hr = transferBuffer(segment.dataOut, segment.dataIn, segment.bufferBytes);
+    }
+    else
+    {
+        for (i = 0; SUCCEEDED(hr) && (i < segment.bufferBytes); i += wordBytes)
+        {
+            dataOut = 0;
+            if (segment.dataOut != nullptr)
+            {
+                if (wordBytes == 1)
+                {
+                    dataOut = segment.dataOut[i];
+                }
+                else if (wordBytes == 2)
+                {
+                    memcpy(&halfWord, &segment.dataOut[i], sizeof(halfWord));
+                    dataOut = halfWord;
+                }
+                else
+                {
+                    memcpy(&dataOut, &segment.dataOut[i], sizeof(dataOut));
+                }
+            }
+
+            hr = transferN(dataOut, dataIn, bits);
+
+            if (SUCCEEDED(hr) && (segment.dataIn != nullptr))
             {
-                tmpData = tmpData << 1;
-                rxData = rxData >> 1;
-                tmpData = tmpData | (rxData & 0x01);
+                if (wordBytes == 1)
+                {
+                    segment.dataIn[i] = (BYTE)dataIn;
+                }
+                else if (wordBytes == 2)
+                {
+                    halfWord = (USHORT)dataIn;
+                    memcpy(&segment.dataIn[i], &halfWord, sizeof(halfWord));
+                }
+                else
+                {
+                    memcpy(&segment.dataIn[i], &dataIn, sizeof(dataIn));
+                }
             }
         }
-        dataIn = tmpData & (0xFFFFFFFF >> (32 - bits));
     }
 
     return hr;
@@ -8,6 +8,7 @@
 #include <Windows.h>
 #include "DmapSupport.h"
 #include "BoardPins.h"
+#include "SpiCounters.h"
 
 #define ADC_SPI_BUS 0
 #define EXTERNAL_SPI_BUS 1
@@ -17,6 +18,23 @@
 #define DEFAULT_SPI_MODE 0
 #define DEFAULT_SPI_BITS 8
 
+/// One segment of an SPI message.
+/**
+A segment is a buffer transfer with its own word size, clock rate and chip select
+handling.  Words wider than 8 bits are held in the buffers as 2-byte (9-16 bits) or
+4-byte (17-32 bits) values in native byte order.
+*/
+typedef struct _SPI_MESSAGE_SEGMENT
+{
+    PBYTE dataOut;          ///< Data to send, or nullptr to send zeros
+    PBYTE dataIn;           ///< Buffer for the data received, or nullptr to ignore it
+    size_t bufferBytes;     ///< Length of each buffer in bytes (may be 0 for a delay only)
+    ULONG bitsPerWord;      ///< Word size for this segment, or 0 for the controller data width
+    ULONG clockKhz;         ///< Clock rate for this segment, or 0 for the current rate
+    BOOL csHold;            ///< TRUE to keep chip select asserted into the next segment
+    ULONG delayUs;          ///< Microseconds to wait after this segment, before any chip select change
+} SPI_MESSAGE_SEGMENT, *PSPI_MESSAGE_SEGMENT;
+
 class SpiControllerClass
 {
 public:
@@ -26,7 +44,10 @@ public:
         m_dataBits(DEFAULT_SPI_BITS),
         m_sckPin(0xFFFFFFFF),
         m_mosiPin(0xFFFFFFFF),
-        m_misoPin(0xFFFFFFFF)
+        m_misoPin(0xFFFFFFFF),
+        m_csPin(0xFFFFFFFF),
+        m_clockKhz(0),
+        m_actualClockHz(0)
     {
     }
 
@@ -41,6 +62,29 @@ public:
     /// Revert the pins used by this SPI controller to GPIO use.
     LIGHTNING_DLL_API HRESULT revertPinsToGpio();
 
+    /// Have the controller drive a chip select line itself.
+    /**
+    When hardware chip select is in use, the controller asserts the chip select line
+    for the duration of each transfer method call (one transferBuffer() call, for
+    example), so the caller does not toggle a GPIO pin around each transfer.
+    \param[in] csLine The controller chip select line to drive.
+    \param[in] csPin The number of the board pin that carries the chip select line.
+    \param[in] activeHigh TRUE if the chip select line is asserted high, FALSE if low.
+    \return HRESULT success or error code.  Controllers that can't drive chip select
+    return DMAP_E_SPI_CHIP_SELECT_NOT_SUPPORTED, in which case the caller must drive a
+    GPIO pin itself.
+    */
+    virtual HRESULT setHardwareChipSelect(ULONG csLine, ULONG csPin, BOOL activeHigh)
+    {
+        return DMAP_E_SPI_CHIP_SELECT_NOT_SUPPORTED;
+    }
+
+    /// Determine whether the controller is driving a chip select line itself.
+    BOOL hasHardwareChipSelect() const
+    {
+        return (m_csPin != 0xFFFFFFFF);
+    }
+
     /// Initialize the specified SPI bus, using the default mode and clock for the controller.
     /**
     \param[in] busNumber The number of the SPI bus to open (0 - 2)
@@ -63,6 +107,17 @@ public:
     /// Set the SPI clock rate.
     virtual HRESULT setClock(ULONG clockKhz) = 0;
 
+    /// Get the SPI clock rate actually generated by the controller.
+    /**
+    The controller sets the fastest clock rate it can generate that is not higher than
+    the rate passed to setClock().
+    \return The clock rate in Hz, or 0 if the clock has not been set.
+    */
+    ULONG getActualClockHz() const
+    {
+        return m_actualClockHz;
+    }
+
     /// Set the SPI mode (clock polarity and phase).
     virtual HRESULT setMode(ULONG mode) = 0;
 
@@ -117,12 +172,29 @@ public:
     \param[in] bufferBytes The number of bytes to transfer.  Each bufffer 
     must be at least this long.
     \return HRESULT success or error code.
-    \note The data is sent and received MSbit first.  If LSbit first transfer, or 
-    any other special ordering of the bytes in the buffer, is needed, the data must
-    be organized appropriately in the buffer before it is handed to this method.
+    \note Each byte is sent and received in the bit order set with setMsbFirstBitOrder()
+    or setLsbFirstBitOrder().  Any other special ordering of the bytes in the buffer
+    must be done before the buffer is handed to this method.
     */
     virtual inline HRESULT transferBuffer(PBYTE dataOut, PBYTE dataIn, size_t bufferBytes) = 0;
 
+    /// Transfer a message made up of several segments, back-to-back, in one call.
+    /**
+    \param[in] segments The segments of the message, in the order they are sent.
+    \param[in] segmentCount The number of segments in the message.
+    \return HRESULT success or error code.
+    \note Chip select is only driven here if the controller drives it itself (see
+    setHardwareChipSelect()).  A caller driving chip select as a GPIO should split the
+    message after each segment that does not hold chip select.
+    */
+    LIGHTNING_DLL_API HRESULT transferMessage(const SPI_MESSAGE_SEGMENT* segments, ULONG segmentCount);
+
+    /// Get the object that collects performance counters for this controller.
+    SpiCountersClass* getCounters()
+    {
+        return &m_counters;
+    }
+
 protected:
     /// SPI Clock pin number.
     ULONG m_sckPin;
@@ -133,9 +205,60 @@ protected:
     /// SPI Master In Slave Out pin number.
     ULONG  m_misoPin;
 
+    /// SPI Chip Select pin number, if the controller drives chip select.
+    ULONG m_csPin;
+
     /// The number of bits in an SPI transfer.
     ULONG m_dataBits;
 
+    /// The clock rate last requested with setClock(), in khz.
+    ULONG m_clockKhz;
+
+    /// The clock rate generated for the last setClock() request, in Hz.
+    ULONG m_actualClockHz;
+
+    /// Performance counters for this controller.
+    SpiCountersClass m_counters;
+
+    /// Assert the hardware chip select line, if the controller drives one.
+    /**
+    Frames nest, so a transfer made while a message holds chip select asserted does
+    not release it.
+    */
+    virtual void _startChipSelectFrame()
+    {
+    }
+
+    /// Release the hardware chip select line at the end of the outermost frame.
+    virtual void _endChipSelectFrame()
+    {
+    }
+
+    /// Determine whether data is sent LSB first.
+    inline BOOL _isLsbFirst() const
+    {
+        return m_flipBitOrder;
+    }
+
+    /// Reverse the order of the bits in a byte.
+    static inline BYTE _reverseBits(BYTE data)
+    {
+        return m_byteFlips[data];
+    }
+
+    /// Reverse the order of the bits in each of the four bytes of a longword.
+    /**
+    The bits are swapped in pairs, then in groups of two and four, in all four bytes
+    at once, so a word from a buffer is converted without a lookup per byte.
+    */
+    static inline ULONG _reverseBitsInBytes(ULONG data)
+    {
+        data = ((data >> 1) & 0x55555555) | ((data & 0x55555555) << 1);
+        data = ((data >> 2) & 0x33333333) | ((data & 0x33333333) << 2);
+        data = ((data >> 4) & 0x0F0F0F0F) | ((data & 0x0F0F0F0F) << 4);
+        return data;
+    }
+
 private:
 
     /// If TRUE invert the data before/after transfer (Controller only supports MSB first).
@@ -152,6 +275,9 @@ private:
     \return HRESULT success or error code.
     */
     virtual inline HRESULT _transfer(ULONG dataOut, ULONG & dataIn, ULONG bits) = 0;
+
+    /// Transfer the data of one message segment.
+    HRESULT _transferSegment(const SPI_MESSAGE_SEGMENT & segment);
 };
 
 #endif  // _SPI_CONTROLLER_H_
\ No newline at end of file
@@ -0,0 +1,272 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#ifndef _SPI_COUNTERS_H_
+#define _SPI_COUNTERS_H_
+
+#include <Windows.h>
+#include <stdio.h>
+
+/// Aggregate counters for one SPI controller, kept when counting is enabled.
+typedef struct _SPI_BUS_COUNTERS {
+    ULONGLONG transfers;                    ///< Buffer and single word transfers performed
+    ULONGLONG failedTransfers;              ///< Transfers that returned an error
+    ULONGLONG bytesTransferred;             ///< Bytes shifted out (the same number are shifted in)
+    ULONGLONG totalTransferUs;              ///< Total time spent in transfers
+    ULONG maxTransferUs;                    ///< Longest transfer
+    ULONGLONG totalSpinUs;                  ///< Total time spent polling for FIFO space, data or completion
+    ULONGLONG chipSelectFrames;             ///< Times the controller asserted its hardware chip select line
+    ULONG clockHz;                          ///< SPI clock rate when the counters were read
+    ULONG effectiveBitsPerSecond;           ///< Bits transferred divided by the time spent in transfers
+} SPI_BUS_COUNTERS, *PSPI_BUS_COUNTERS;
+
+/// Class used to collect performance counters for an SPI controller.
+/**
+Nothing is recorded unless counting has been enabled, and when it is not the only
+cost to a transfer is checking the enable flag.  Transfers are timed with the high
+resolution timer.  Spin time is only timed when a status poll finds the controller
+not ready, so a transfer that never waits on the FIFOs takes no extra timestamps.
+
+If a dump interval is set, the counters are written to the debugger output by the
+first transfer recorded after each interval has passed, so nothing is written while
+the bus is idle.  Comparing effectiveBitsPerSecond with clockHz shows how much of the
+bus time is lost between bytes and transfers, and totalSpinUs shows how much of the
+transfer time was spent waiting on the bus rather than moving data.
+*/
+class SpiCountersClass
+{
+public:
+    SpiCountersClass() :
+        m_enabled(FALSE),
+        m_dumpIntervalTicks(0),
+        m_lastDumpTicks(0),
+        m_totalTransferTicks(0),
+        m_maxTransferTicks(0),
+        m_totalSpinTicks(0)
+    {
+        InitializeCriticalSection(&m_lock);
+        QueryPerformanceFrequency(&m_frequency);
+        ZeroMemory(&m_counters, sizeof(m_counters));
+    }
+
+    virtual ~SpiCountersClass()
+    {
+        DeleteCriticalSection(&m_lock);
+    }
+
+    /// Method to turn counting on or off.
+    void enable(BOOL enable)
+    {
+        m_enabled = enable;
+    }
+
+    /// Method to determine whether counting is on.
+    BOOL isEnabled() const
+    {
+        return m_enabled;
+    }
+
+    /// Method to set how often the counters are written to the debugger output.
+    /**
+    \param[in] intervalMs The time between dumps in milliseconds, or 0 to stop dumping.
+    */
+    void setDumpInterval(ULONG intervalMs)
+    {
+        LARGE_INTEGER now;
+
+        QueryPerformanceCounter(&now);
+
+        EnterCriticalSection(&m_lock);
+        m_dumpIntervalTicks = (intervalMs * m_frequency.QuadPart) / 1000;
+        m_lastDumpTicks = now.QuadPart;
+        LeaveCriticalSection(&m_lock);
+    }
+
+    /// Method to get a timestamp, if counting is on.
+    /**
+    \param[out] ticks The high resolution timer count, or 0 if counting is off.
+    */
+    inline void startTiming(LONGLONG & ticks) const
+    {
+        LARGE_INTEGER now;
+
+        ticks = 0;
+        if (m_enabled)
+        {
+            QueryPerformanceCounter(&now);
+            ticks = now.QuadPart;
+        }
+    }
+
+    /// Method to record a completed transfer.
+    /**
+    \param[in] startTicks The timestamp taken with startTiming() before the transfer.
+    \param[in] bytes The number of bytes transferred.
+    \param[in] clockHz The SPI clock rate the transfer was made at.
+    \param[in] hr The result of the transfer.
+    */
+    void recordTransfer(LONGLONG startTicks, size_t bytes, ULONG clockHz, HRESULT hr)
+    {
+        LARGE_INTEGER now;
+        LONGLONG ticks;
+        BOOL dumpDue = FALSE;
+
+        // Counting was turned on during the transfer, so it has no start time.
+        if (startTicks == 0)
+        {
+            return;
+        }
+
+        QueryPerformanceCounter(&now);
+        ticks = now.QuadPart - startTicks;
+
+        EnterCriticalSection(&m_lock);
+
+        m_counters.transfers++;
+        if (FAILED(hr))
+        {
+            m_counters.failedTransfers++;
+        }
+        m_counters.bytesTransferred += bytes;
+        m_counters.clockHz = clockHz;
+        m_totalTransferTicks += ticks;
+        if (ticks > m_maxTransferTicks)
+        {
+            m_maxTransferTicks = ticks;
+        }
+
+        if ((m_dumpIntervalTicks != 0) && ((now.QuadPart - m_lastDumpTicks) >= m_dumpIntervalTicks))
+        {
+            m_lastDumpTicks = now.QuadPart;
+            dumpDue = TRUE;
+        }
+
+        LeaveCriticalSection(&m_lock);
+
+        if (dumpDue)
+        {
+            dump();
+        }
+    }
+
+    /// Method to record time spent waiting on the controller.
+    /**
+    \param[in] startTicks The timestamp taken with startTiming() when the wait began.
+    */
+    void recordSpin(LONGLONG startTicks)
+    {
+        LARGE_INTEGER now;
+
+        if (startTicks == 0)
+        {
+            return;
+        }
+
+        QueryPerformanceCounter(&now);
+
+        EnterCriticalSection(&m_lock);
+        m_totalSpinTicks += now.QuadPart - startTicks;
+        LeaveCriticalSection(&m_lock);
+    }
+
+    /// Method to record that the hardware chip select line was asserted.
+    void recordChipSelectFrame()
+    {
+        if (m_enabled)
+        {
+            EnterCriticalSection(&m_lock);
+            m_counters.chipSelectFrames++;
+            LeaveCriticalSection(&m_lock);
+        }
+    }
+
+    /// Method to get a copy of the counters.
+    void getCounters(SPI_BUS_COUNTERS & counters)
+    {
+        EnterCriticalSection(&m_lock);
+
+        counters = m_counters;
+        counters.totalTransferUs = _ticksToMicroseconds(m_totalTransferTicks);
+        counters.maxTransferUs = (ULONG)_ticksToMicroseconds(m_maxTransferTicks);
+        counters.totalSpinUs = _ticksToMicroseconds(m_totalSpinTicks);
+
+        LeaveCriticalSection(&m_lock);
+
+        counters.effectiveBitsPerSecond = 0;
+        if (counters.totalTransferUs > 0)
+        {
+            counters.effectiveBitsPerSecond = (ULONG)((counters.bytesTransferred * 8 * 1000000) / counters.totalTransferUs);
+        }
+    }
+
+    /// Method to write the counters to the debugger output.
+    void dump()
+    {
+        SPI_BUS_COUNTERS counters;
+        char buffer[256];
+
+        getCounters(counters);
+
+        sprintf_s(buffer, sizeof(buffer),
+            "SPI: %llu transfers (%llu failed), %llu bytes, %llu us in transfers (max %lu us), "
+            "%llu us spinning, %llu CS frames, %lu bps effective at %lu Hz clock\n",
+            counters.transfers, counters.failedTransfers, counters.bytesTransferred,
+            counters.totalTransferUs, counters.maxTransferUs, counters.totalSpinUs,
+            counters.chipSelectFrames, counters.effectiveBitsPerSecond, counters.clockHz);
+
+        OutputDebugStringA(buffer);
+    }
+
+    /// Method to zero the counters.
+    void reset()
+    {
+        EnterCriticalSection(&m_lock);
+        ZeroMemory(&m_counters, sizeof(m_counters));
+        m_totalTransferTicks = 0;
+        m_maxTransferTicks = 0;
+        m_totalSpinTicks = 0;
+        LeaveCriticalSection(&m_lock);
+    }
+
+private:
+
+    /// TRUE if transfers are being counted.
+    volatile BOOL m_enabled;
+
+    /// The high resolution timer frequency on this system.
+    LARGE_INTEGER m_frequency;
+
+    /// Timer ticks between dumps of the counters, or 0 for no dumps.
+    LONGLONG m_dumpIntervalTicks;
+
+    /// Timer count when the counters were last dumped.
+    LONGLONG m_lastDumpTicks;
+
+    /// Total timer ticks spent in transfers.
+    LONGLONG m_totalTransferTicks;
+
+    /// Timer ticks taken by the longest transfer.
+    LONGLONG m_maxTransferTicks;
+
+    /// Total timer ticks spent polling the controller.
+    LONGLONG m_totalSpinTicks;
+
+    /// Aggregate counters (the times are kept in timer ticks above).
+    SPI_BUS_COUNTERS m_counters;
+
+    /// Lock used to serialize recording and reading the counters.
+    RTL_CRITICAL_SECTION m_lock;
+
+    /// Method to convert a count of high resolution timer ticks to microseconds.
+    ULONGLONG _ticksToMicroseconds(LONGLONG ticks) const
+    {
+        if ((ticks <= 0) || (m_frequency.QuadPart == 0))
+        {
+            return 0;
+        }
+        return (ULONGLONG)((ticks * 1000000LL) / m_frequency.QuadPart);
+    }
+};
+
+#endif  // _SPI_COUNTERS_H_
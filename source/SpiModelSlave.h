@@ -0,0 +1,33 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#ifndef _SPI_MODEL_SLAVE_H_
+#define _SPI_MODEL_SLAVE_H_
+
+#include <Windows.h>
+
+//
+// Interface for a simulated SPI slave device attached to a simulated SPI bus.
+//
+class SpiModelSlaveClass
+{
+public:
+    virtual ~SpiModelSlaveClass()
+    {
+    }
+
+    /// Called for each byte shifted on the bus.
+    /**
+    \param[in] mosi The byte the master sent.
+    \return The byte the slave sends back on MISO.
+    */
+    virtual UCHAR transferByte(UCHAR mosi) = 0;
+
+    /// Called when the controller asserts or releases chip select.
+    virtual void chipSelect(BOOL asserted)
+    {
+    }
+};
+
+#endif  // _SPI_MODEL_SLAVE_H_
@@ -0,0 +1,299 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "SpiStreamer.h"
+#include "ErrorCodes.h"
+
+#if !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)  // If building a UWP app
+using namespace Windows::Foundation;
+using namespace Windows::System::Threading;
+#endif  // !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+
+SpiStreamerClass::SpiStreamerClass() :
+    m_spi(nullptr),
+    m_bufferCount(0),
+    m_bufferBytes(0),
+    m_submitted(0),
+    m_sent(0),
+    m_acquired(FALSE),
+    m_running(FALSE),
+    m_stopRequested(FALSE),
+    m_underruns(0),
+    m_transferErrors(0)
+{
+    m_hBufferReady = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+    m_hBufferSent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+    m_hThreadDone = CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_ALL_ACCESS);
+}
+
+SpiStreamerClass::~SpiStreamerClass()
+{
+    stop();
+
+    if (m_hBufferReady != nullptr)
+    {
+        CloseHandle(m_hBufferReady);
+        m_hBufferReady = nullptr;
+    }
+
+    if (m_hBufferSent != nullptr)
+    {
+        CloseHandle(m_hBufferSent);
+        m_hBufferSent = nullptr;
+    }
+
+    if (m_hThreadDone != nullptr)
+    {
+        CloseHandle(m_hThreadDone);
+        m_hThreadDone = nullptr;
+    }
+}
+
+/**
+\param[in] spi The SPI controller to send the data on.
+\param[in] bufferCount The number of buffers to cycle through (2 - SPI_STREAM_MAX_BUFFERS).
+\param[in] bufferBytes The size of each buffer in bytes.
+\param[in] onComplete Optional function called each time a buffer has been sent.
+\return HRESULT success or error code.
+*/
+HRESULT SpiStreamerClass::start(SpiControllerClass* spi, ULONG bufferCount, size_t bufferBytes, SpiStreamCompleteFunction onComplete)
+{
+    HRESULT hr = S_OK;
+
+    if ((spi == nullptr) || (bufferCount < 2) || (bufferCount > SPI_STREAM_MAX_BUFFERS) || (bufferBytes == 0))
+    {
+        hr = E_INVALIDARG;
+    }
+
+    if (SUCCEEDED(hr) && ((m_hBufferReady == nullptr) || (m_hBufferSent == nullptr) || (m_hThreadDone == nullptr)))
+    {
+        hr = HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        stop();
+
+        m_storage.reset(new (std::nothrow) BYTE[bufferCount * bufferBytes]);
+        if (!m_storage)
+        {
+            hr = E_OUTOFMEMORY;
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        m_spi = spi;
+        m_bufferCount = bufferCount;
+        m_bufferBytes = bufferBytes;
+        m_onComplete = onComplete;
+        m_submitted = 0;
+        m_sent = 0;
+        m_acquired = FALSE;
+        m_underruns = 0;
+        m_transferErrors = 0;
+
+        m_stopRequested = FALSE;
+        m_running = TRUE;
+        ResetEvent(m_hBufferReady);
+        ResetEvent(m_hBufferSent);
+        ResetEvent(m_hThreadDone);
+
+#if !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)  // If building a UWP app
+        auto workItem = ref new WorkItemHandler([this](IAsyncAction^ workItem)
+        {
+            _streamLoop();
+        });
+
+        try
+        {
+            ThreadPool::RunAsync(workItem, WorkItemPriority::High, WorkItemOptions::TimeSliced);
+        }
+        catch (Platform::Exception^ e)
+        {
+            hr = e->HResult;
+            m_running = FALSE;
+        }
+#else
+        HANDLE hThread = CreateThread(nullptr, 0, [](LPVOID param) -> DWORD
+        {
+            ((SpiStreamerClass*)param)->_streamLoop();
+            return 0;
+        }, this, 0, nullptr);
+
+        if (hThread == nullptr)
+        {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+            m_running = FALSE;
+        }
+        else
+        {
+            SetThreadPriority(hThread, THREAD_PRIORITY_HIGHEST);
+            CloseHandle(hThread);
+        }
+#endif  // !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    }
+
+    return hr;
+}
+
+void SpiStreamerClass::stop()
+{
+    if (m_running)
+    {
+        m_stopRequested = TRUE;
+        SetEvent(m_hBufferReady);
+        WaitForSingleObjectEx(m_hThreadDone, INFINITE, FALSE);
+        m_running = FALSE;
+
+        // Release any application thread waiting for a buffer.
+        SetEvent(m_hBufferSent);
+    }
+}
+
+/**
+\param[out] buffer The buffer to fill.
+\param[in] timeoutMs How long to wait for a buffer to be freed, in milliseconds.
+\return HRESULT success or error code.
+*/
+HRESULT SpiStreamerClass::acquireBuffer(PBYTE & buffer, ULONG timeoutMs)
+{
+    HRESULT hr = S_OK;
+
+    buffer = nullptr;
+
+    if (!m_running)
+    {
+        hr = DMAP_E_SPI_STREAM_NOT_RUNNING;
+    }
+
+    // Wait for the stream thread to finish with the oldest buffer if all are in use.
+    while (SUCCEEDED(hr) && !m_acquired && ((m_submitted.load() - m_sent.load()) >= m_bufferCount))
+    {
+        if (WaitForSingleObjectEx(m_hBufferSent, timeoutMs, FALSE) == WAIT_TIMEOUT)
+        {
+            hr = DMAP_E_SPI_STREAM_BUFFER_NOT_AVAILABLE;
+        }
+        else if (!m_running)
+        {
+            hr = DMAP_E_SPI_STREAM_NOT_RUNNING;
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        buffer = _buffer(m_submitted.load());
+        m_acquired = TRUE;
+    }
+
+    return hr;
+}
+
+/**
+\param[in] bufferBytes The number of bytes to send from the buffer.
+\return HRESULT success or error code.
+*/
+HRESULT SpiStreamerClass::submitBuffer(size_t bufferBytes)
+{
+    HRESULT hr = S_OK;
+    ULONG submitted = m_submitted.load();
+
+    if (!m_running || !m_acquired)
+    {
+        hr = DMAP_E_SPI_STREAM_NOT_RUNNING;
+    }
+
+    if (SUCCEEDED(hr) && ((bufferBytes == 0) || (bufferBytes > m_bufferBytes)))
+    {
+        hr = E_INVALIDARG;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        m_submittedBytes[submitted % m_bufferCount] = bufferBytes;
+        m_acquired = FALSE;
+        m_submitted.store(submitted + 1);
+        SetEvent(m_hBufferReady);
+    }
+
+    return hr;
+}
+
+/**
+\param[in] timeoutMs How long to wait, in milliseconds.
+\return HRESULT success or error code.
+*/
+HRESULT SpiStreamerClass::waitForIdle(ULONG timeoutMs)
+{
+    HRESULT hr = S_OK;
+
+    while (SUCCEEDED(hr) && m_running && (m_sent.load() != m_submitted.load()))
+    {
+        if (WaitForSingleObjectEx(m_hBufferSent, timeoutMs, FALSE) == WAIT_TIMEOUT)
+        {
+            hr = DMAP_E_SPI_STREAM_BUFFER_NOT_AVAILABLE;
+        }
+    }
+
+    if (SUCCEEDED(hr) && (m_sent.load() != m_submitted.load()))
+    {
+        hr = DMAP_E_SPI_STREAM_NOT_RUNNING;
+    }
+
+    return hr;
+}
+
+// Send submitted buffers in order until asked to stop.
+void SpiStreamerClass::_streamLoop()
+{
+    HRESULT hr;
+    ULONG sent;
+    PBYTE buffer;
+    size_t bufferBytes;
+    BOOL starved = FALSE;
+
+    while (!m_stopRequested)
+    {
+        sent = m_sent.load();
+
+        // Wait for the application to submit a buffer.
+        if (m_submitted.load() == sent)
+        {
+            if (sent > 0)
+            {
+                starved = TRUE;
+            }
+            WaitForSingleObjectEx(m_hBufferReady, INFINITE, FALSE);
+            continue;
+        }
+
+        if (starved)
+        {
+            m_underruns++;
+            starved = FALSE;
+        }
+
+        buffer = _buffer(sent);
+        bufferBytes = m_submittedBytes[sent % m_bufferCount];
+
+        hr = m_spi->transferBuffer(buffer, nullptr, bufferBytes);
+        if (FAILED(hr))
+        {
+            m_transferErrors++;
+        }
+
+        if (m_onComplete)
+        {
+            m_onComplete(buffer, bufferBytes, hr);
+        }
+
+        // Hand the buffer back to the application.
+        m_sent.store(sent + 1);
+        SetEvent(m_hBufferSent);
+    }
+
+    SetEvent(m_hThreadDone);
+}
@@ -0,0 +1,185 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#ifndef _SPI_STREAMER_H_
+#define _SPI_STREAMER_H_
+
+#include <Windows.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <new>
+
+#include "Lightning.h"
+#include "SpiController.h"
+
+/// The largest number of buffers an SPI stream can cycle through.
+#define SPI_STREAM_MAX_BUFFERS 8
+
+/// Function called on the stream thread each time a buffer has been sent.
+/**
+\param[in] buffer The buffer that was sent.  It is handed back to the application
+for refilling when this function returns.
+\param[in] bufferBytes The number of bytes that were sent from the buffer.
+\param[in] hr The result of the transfer.
+*/
+typedef std::function<void(PBYTE buffer, size_t bufferBytes, HRESULT hr)> SpiStreamCompleteFunction;
+
+/// Class that sends buffers of data on an SPI bus from a dedicated thread.
+/**
+The stream owns a ring of equal sized buffers.  The application acquires the next free
+buffer, fills it and submits it, and the stream thread sends submitted buffers in order
+while the application fills the next one.  When all the buffers have been submitted,
+acquiring another waits for the stream thread to finish sending one.
+
+Each buffer is sent with one transferBuffer() call, so if the SPI controller drives
+chip select itself each buffer is one chip select frame.  The SPI controller must not
+be used by any other thread while the stream is running.  Buffers must be acquired and
+submitted by one application thread at a time.
+*/
+class SpiStreamerClass
+{
+public:
+    /// Constructor.
+    LIGHTNING_DLL_API SpiStreamerClass();
+
+    /// Destructor.
+    LIGHTNING_DLL_API virtual ~SpiStreamerClass();
+
+    /// Allocate the stream buffers and start the stream thread.
+    /**
+    \param[in] spi The SPI controller to send the data on.  It must already be set up
+    with begin().
+    \param[in] bufferCount The number of buffers to cycle through (2 - SPI_STREAM_MAX_BUFFERS).
+    \param[in] bufferBytes The size of each buffer in bytes.
+    \param[in] onComplete Optional function called each time a buffer has been sent.
+    \return HRESULT success or error code.
+    */
+    LIGHTNING_DLL_API HRESULT start(SpiControllerClass* spi, ULONG bufferCount, size_t bufferBytes, SpiStreamCompleteFunction onComplete = nullptr);
+
+    /// Stop the stream thread once it has sent the buffer in progress.
+    /**
+    Buffers that have been submitted but not yet sent are discarded.  Use waitForIdle()
+    first to have them sent.
+    */
+    LIGHTNING_DLL_API void stop();
+
+    /// Get the next free buffer for the application to fill.
+    /**
+    Calling this again before the buffer is submitted returns the same buffer.
+    \param[out] buffer The buffer to fill.
+    \param[in] timeoutMs How long to wait for a buffer to be freed, in milliseconds.
+    \return HRESULT success or error code.
+    */
+    LIGHTNING_DLL_API HRESULT acquireBuffer(PBYTE & buffer, ULONG timeoutMs = INFINITE);
+
+    /// Queue the buffer returned by acquireBuffer() to be sent.
+    /**
+    \param[in] bufferBytes The number of bytes to send from the buffer.
+    \return HRESULT success or error code.
+    */
+    LIGHTNING_DLL_API HRESULT submitBuffer(size_t bufferBytes);
+
+    /// Wait for all the submitted buffers to be sent.
+    /**
+    \param[in] timeoutMs How long to wait, in milliseconds.
+    \return HRESULT success or error code.
+    */
+    LIGHTNING_DLL_API HRESULT waitForIdle(ULONG timeoutMs = INFINITE);
+
+    /// Determine whether the stream thread is running.
+    inline BOOL isRunning() const
+    {
+        return m_running.load();
+    }
+
+    /// Get the size of each stream buffer in bytes.
+    inline size_t getBufferBytes() const
+    {
+        return m_bufferBytes;
+    }
+
+    /// Get the number of buffers sent since the stream was started.
+    inline ULONG getBuffersSent() const
+    {
+        return m_sent.load();
+    }
+
+    /// Get the number of times the stream thread ran out of buffers to send.
+    /**
+    This counts each time the bus went idle waiting for the application to submit the
+    next buffer, not counting the wait for the first buffer.
+    */
+    inline ULONG getUnderrunCount() const
+    {
+        return m_underruns.load();
+    }
+
+    /// Get the number of buffer transfers that failed.
+    inline ULONG getTransferErrorCount() const
+    {
+        return m_transferErrors.load();
+    }
+
+private:
+
+    /// The SPI controller the data is sent on.
+    SpiControllerClass* m_spi;
+
+    /// The storage for all the stream buffers.
+    std::unique_ptr<BYTE[]> m_storage;
+
+    /// The number of buffers in the ring.
+    ULONG m_bufferCount;
+
+    /// The size of each buffer in bytes.
+    size_t m_bufferBytes;
+
+    /// The number of bytes to send from each submitted buffer.
+    size_t m_submittedBytes[SPI_STREAM_MAX_BUFFERS];
+
+    /// The function called when a buffer has been sent.
+    SpiStreamCompleteFunction m_onComplete;
+
+    /// Count of buffers ever submitted.
+    std::atomic<ULONG> m_submitted;
+
+    /// Count of buffers ever sent.
+    std::atomic<ULONG> m_sent;
+
+    /// TRUE if the application holds a buffer it has not submitted yet.
+    BOOL m_acquired;
+
+    /// TRUE while the stream thread is running.
+    std::atomic<BOOL> m_running;
+
+    /// Set to ask the stream thread to exit.
+    std::atomic<BOOL> m_stopRequested;
+
+    /// Count of times the stream thread waited for a buffer after sending one.
+    std::atomic<ULONG> m_underruns;
+
+    /// Count of failed buffer transfers.
+    std::atomic<ULONG> m_transferErrors;
+
+    /// Event signaled when a buffer is submitted.
+    HANDLE m_hBufferReady;
+
+    /// Event signaled when a buffer has been sent.
+    HANDLE m_hBufferSent;
+
+    /// Event signaled when the stream thread exits.
+    HANDLE m_hThreadDone;
+
+    /// Get a buffer in the ring from a count of buffers submitted or sent.
+    inline PBYTE _buffer(ULONG count) const
+    {
+        return &m_storage[(count % m_bufferCount) * m_bufferBytes];
+    }
+
+    /// The body of the stream thread.
+    void _streamLoop();
+};
+
+#endif  // _SPI_STREAMER_H_
@@ -0,0 +1,204 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#include "pch.h"
+
+#include <cmath>
+
+#include "WS2812Support.h"
+#include "ErrorCodes.h"
+
+WS2812Device::WS2812Device() :
+    m_spi(nullptr),
+    m_pixelCount(0),
+    m_spiBitsPerLedBit(3),
+    m_spiBytesPerColor(3),
+    m_brightness(255),
+    m_gamma(1.0f)
+{
+    _buildEncodeTable();
+}
+
+/**
+\param[in] spi The SPI controller whose MOSI pin drives the strip.
+\param[in] pixelCount The number of LEDs in the strip.
+\param[in] spiBitsPerLedBit The number of SPI bits sent for each LED bit: 3 or 4.
+\return HRESULT success or error code.
+*/
+HRESULT WS2812Device::begin(SpiControllerClass* spi, ULONG pixelCount, ULONG spiBitsPerLedBit)
+{
+    HRESULT hr = S_OK;
+    ULONG clockHz = WS2812_BIT_RATE * spiBitsPerLedBit;
+    ULONG actualHz;
+    ULONG resetBytes;
+
+    if ((spi == nullptr) || (pixelCount == 0) || ((spiBitsPerLedBit != 3) && (spiBitsPerLedBit != 4)))
+    {
+        hr = E_INVALIDARG;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hr = spi->setMode(0);
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hr = spi->setClock(clockHz / 1000);
+    }
+
+    // The LEDs allow about 150 ns of error on each pulse, so make sure the rate the
+    // controller can actually generate is close enough.
+    if (SUCCEEDED(hr))
+    {
+        actualHz = spi->getActualClockHz();
+        if (actualHz == 0)
+        {
+            actualHz = clockHz;
+        }
+        if (((actualHz * 100ULL) < ((ULONGLONG)clockHz * (100 - WS2812_CLOCK_TOLERANCE_PERCENT))) ||
+            ((actualHz * 100ULL) > ((ULONGLONG)clockHz * (100 + WS2812_CLOCK_TOLERANCE_PERCENT))))
+        {
+            hr = DMAP_E_SPI_SPEED_SPECIFIED_IS_INVALID;
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        spi->setMsbFirstBitOrder();
+
+        m_spi = spi;
+        m_pixelCount = pixelCount;
+        m_spiBitsPerLedBit = spiBitsPerLedBit;
+        m_spiBytesPerColor = spiBitsPerLedBit;
+        _buildEncodeTable();
+
+        // Hold the data line low after each frame for the reset time.
+        resetBytes = (ULONG)((((ULONGLONG)actualHz * WS2812_RESET_US) + 7999999) / 8000000);
+
+        m_pixels.assign(pixelCount * 3, 0);
+        m_frame.assign((pixelCount * 3 * m_spiBytesPerColor) + resetBytes, 0);
+    }
+
+    return hr;
+}
+
+/**
+\param[in] red The red level (0 - 255).
+\param[in] green The green level (0 - 255).
+\param[in] blue The blue level (0 - 255).
+*/
+void WS2812Device::fill(BYTE red, BYTE green, BYTE blue)
+{
+    for (ULONG i = 0; i < m_pixelCount; i++)
+    {
+        setPixel(i, red, green, blue);
+    }
+}
+
+/**
+\param[in] brightness The brightness (0 - 255), applied to every color value.
+*/
+void WS2812Device::setBrightness(BYTE brightness)
+{
+    m_brightness = brightness;
+    _buildEncodeTable();
+}
+
+/**
+\param[in] gamma The gamma, greater than 0.
+\return HRESULT success or error code.
+*/
+HRESULT WS2812Device::setGamma(float gamma)
+{
+    if (!(gamma > 0.0f))
+    {
+        return E_INVALIDARG;
+    }
+
+    m_gamma = gamma;
+    _buildEncodeTable();
+    return S_OK;
+}
+
+/**
+The pixel colors are encoded into the SPI bit stream and the whole frame is sent with
+one buffer transfer.
+\return HRESULT success or error code.
+*/
+HRESULT WS2812Device::show()
+{
+    HRESULT hr = S_OK;
+    PBYTE out;
+    ULONG pattern;
+
+    if (m_spi == nullptr)
+    {
+        hr = DMAP_E_DMAP_INTERNAL_ERROR;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        out = m_frame.data();
+
+        if (m_spiBytesPerColor == 3)
+        {
+            for (size_t i = 0; i < m_pixels.size(); i++)
+            {
+                pattern = m_encode[m_pixels[i]];
+                out[0] = (BYTE)(pattern >> 24);
+                out[1] = (BYTE)(pattern >> 16);
+                out[2] = (BYTE)(pattern >> 8);
+                out += 3;
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < m_pixels.size(); i++)
+            {
+                pattern = m_encode[m_pixels[i]];
+                out[0] = (BYTE)(pattern >> 24);
+                out[1] = (BYTE)(pattern >> 16);
+                out[2] = (BYTE)(pattern >> 8);
+                out[3] = (BYTE)pattern;
+                out += 4;
+            }
+        }
+
+        hr = m_spi->transferBuffer(m_frame.data(), nullptr, m_frame.size());
+    }
+
+    return hr;
+}
+
+// Work out the LED level for each color value, and the SPI bit pattern that sends it.
+void WS2812Device::_buildEncodeTable()
+{
+    ULONG zeroBits = (m_spiBitsPerLedBit == 3) ? 0x4 : 0x8;     // 100 or 1000
+    ULONG oneBits = (m_spiBitsPerLedBit == 3) ? 0x6 : 0xE;      // 110 or 1110
+    ULONG level;
+    ULONG pattern;
+
+    for (ULONG value = 0; value < 256; value++)
+    {
+        if (m_gamma == 1.0f)
+        {
+            level = value;
+        }
+        else
+        {
+            level = (ULONG)((powf(value / 255.0f, m_gamma) * 255.0f) + 0.5f);
+        }
+        level = ((level * m_brightness) + 127) / 255;
+
+        pattern = 0;
+        for (int bit = 7; bit >= 0; bit--)
+        {
+            pattern = (pattern << m_spiBitsPerLedBit) | (((level >> bit) & 1) ? oneBits : zeroBits);
+        }
+
+        // Left justify the 24 or 32 bits of the pattern.
+        m_encode[value] = pattern << (32 - (8 * m_spiBitsPerLedBit));
+    }
+}
@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Open Technologies, Inc.  All rights reserved.  
+// Licensed under the BSD 2-Clause License.  
+// See License.txt in the project root for license information.
+
+#ifndef _WS2812_SUPPORT_H_
+#define _WS2812_SUPPORT_H_
+
+#include <Windows.h>
+#include <vector>
+
+#include "Lightning.h"
+#include "SpiController.h"
+
+/// Data rate of the WS2812 one-wire protocol, in bits per second.
+#define WS2812_BIT_RATE 800000
+
+/// Time the data line must be held low to latch a frame into the LEDs, in microseconds.
+/// (50 us for the original WS2812, up to 280 us for the WS2812B.)
+#define WS2812_RESET_US 300
+
+/// Largest allowed error in the SPI clock rate, in percent of the rate wanted.
+#define WS2812_CLOCK_TOLERANCE_PERCENT 10
+
+/// Class used to drive a strip of WS2812 (NeoPixel) addressable LEDs from the MOSI pin
+/// of an SPI controller.
+/**
+Each bit sent to the LEDs is a high pulse followed by a low time, with a short pulse
+for a 0 and a long pulse for a 1.  The SPI clock is set to 3 or 4 times the WS2812 bit
+rate, so each LED bit is sent as 3 or 4 SPI bits: 100 or 110 (3 bits), or 1000 or 1110
+(4 bits).
+
+A table maps each color value straight to its SPI bit pattern, with the gamma and
+brightness correction included, so encoding a frame is one lookup per color byte.  Each
+frame is sent with one transferBuffer() call, followed by the low time that latches it.
+The bit stream can't pause, so the SPI controller must not be used by anything else
+while a frame is being sent.
+*/
+class WS2812Device
+{
+public:
+    /// Constructor.
+    LIGHTNING_DLL_API WS2812Device();
+
+    /// Destructor.
+    virtual ~WS2812Device()
+    {
+    }
+
+    /// Prepare to drive a strip of LEDs.
+    /**
+    All the pixels start out off.  The SPI controller's clock rate, mode and bit order
+    are set for the LED bit stream.
+    \param[in] spi The SPI controller whose MOSI pin drives the strip.  It must already
+    be set up with begin().
+    \param[in] pixelCount The number of LEDs in the strip.
+    \param[in] spiBitsPerLedBit The number of SPI bits sent for each LED bit: 3 or 4.
+    \return HRESULT success or error code.
+    */
+    LIGHTNING_DLL_API HRESULT begin(SpiControllerClass* spi, ULONG pixelCount, ULONG spiBitsPerLedBit = 3);
+
+    /// Set the color of one pixel.  The change is sent to the strip by show().
+    /**
+    \param[in] index The position of the pixel in the strip, starting at 0.
+    \param[in] red The red level (0 - 255).
+    \param[in] green The green level (0 - 255).
+    \param[in] blue The blue level (0 - 255).
+    \return HRESULT success or error code.
+    */
+    inline HRESULT setPixel(ULONG index, BYTE red, BYTE green, BYTE blue)
+    {
+        if (index >= m_pixelCount)
+        {
+            return E_INVALIDARG;
+        }
+
+        // The LEDs take the colors in green, red, blue order.
+        m_pixels[(index * 3) + 0] = green;
+        m_pixels[(index * 3) + 1] = red;
+        m_pixels[(index * 3) + 2] = blue;
+        return S_OK;
+    }
+
+    /// Set all the pixels to one color.
+    LIGHTNING_DLL_API void fill(BYTE red, BYTE green, BYTE blue);
+
+    /// Set the overall brightness of the strip (0 - 255, 255 is full brightness).
+    LIGHTNING_DLL_API void setBrightness(BYTE brightness);
+
+    /// Set the gamma used to map color values to LED levels.
+    /**
+    \param[in] gamma 1.0 for a linear mapping, about 2.5 to make equal steps in color
+    value look like equal steps in brightness.
+    \return HRESULT success or error code.
+    */
+    LIGHTNING_DLL_API HRESULT setGamma(float gamma);
+
+    /// Send the pixel colors to the strip.
+    LIGHTNING_DLL_API HRESULT show();
+
+    /// Get the number of LEDs in the strip.
+    inline ULONG getPixelCount() const
+    {
+        return m_pixelCount;
+    }
+
+private:
+
+    /// The SPI controller driving the strip.
+    SpiControllerClass* m_spi;
+
+    /// The number of LEDs in the strip.
+    ULONG m_pixelCount;
+
+    /// The number of SPI bits sent for each LED bit.
+    ULONG m_spiBitsPerLedBit;
+
+    /// The number of SPI bytes sent for each color byte (the same as m_spiBitsPerLedBit).
+    ULONG m_spiBytesPerColor;
+
+    /// The overall brightness.
+    BYTE m_brightness;
+
+    /// The gamma used to map color values to LED levels.
+    float m_gamma;
+
+    /// The pixel colors, three bytes per pixel in the order they are sent (G, R, B).
+    std::vector<BYTE> m_pixels;
+
+    /// The SPI bit stream for a frame, followed by the zero bytes of the reset time.
+    std::vector<BYTE> m_frame;
+
+    /// The SPI bit pattern for each color value, left justified.
+    ULONG m_encode[256];
+
+    /// Build the encoding table from the gamma and brightness settings.
+    void _buildEncodeTable();
+};
+
+#endif  // _WS2812_SUPPORT_H_
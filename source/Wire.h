@@ -17,6 +17,8 @@
 #define TWI_FREQ 100000L
 #endif
 
+// Arduino's fixed buffer size.  TwoWire buffers are not limited to this size
+// unless setBufferCapacity() is used to impose a limit.
 #define BUFFER_LENGTH 32
 
 // Forward declaration(s):
@@ -37,7 +39,9 @@ public:
     };
 
     /// Constructor.
-    TwoWire()
+    TwoWire() :
+        m_bufferCapacity(0),
+        m_transmissionBytes(0)
     {
         _cleanTransaction();
     }
@@ -62,6 +66,7 @@ public:
         m_writeBuffs.clear();
         m_readBuffs.clear();
         m_writeBuff.clear();
+        m_writeBuff.reserve(m_bufferCapacity);
     }
 
     /// Method to end use of the I2C bus by the code using this library.
@@ -72,6 +77,51 @@ public:
         g_i2c.end();
     }
 
+    /// Method to set the I2C bus clock rate used for subsequent transfers.
+    /**
+    The bus runs at the fastest rate the controller can generate that does not
+    exceed the requested rate.  Rates up to 1 MHz (Fast-mode Plus) are supported.
+    \param[in] clockHz The desired I2C bus clock rate in Hz.
+    \return None.  Any error is thrown.
+    */
+    void setClock(uint32_t clockHz)
+    {
+        HRESULT hr;
+
+        hr = m_i2cTransaction.setClockRate(clockHz);
+
+        if (FAILED(hr))
+        {
+            ThrowError(hr, "Error setting I2C clock rate to %d Hz: %08x", clockHz, hr);
+        }
+    }
+
+    /// Method to set the capacity of the write buffer.
+    /**
+    With a non-zero capacity the write buffer is allocated once, up front, and
+    bytes written beyond the capacity are dropped (write() returns the count of
+    bytes actually accepted), as they are by Arduino's fixed BUFFER_LENGTH buffer.
+    Reads requested by requestFrom() are also limited to the capacity.  With a 
+    capacity of zero (the default) the buffers grow as needed.
+    \note The capacity does not limit writeBuffer() or requestFrom() into a caller
+    supplied buffer, since no TwoWire buffer is used by those methods.
+    \param[in] capacity The maximum number of bytes to buffer, or zero for no limit.
+    */
+    void setBufferCapacity(size_t capacity)
+    {
+        m_bufferCapacity = capacity;
+        m_writeBuff.reserve(capacity);
+    }
+
+    /// Method to get the capacity of the write buffer.
+    /**
+    \return The maximum number of bytes buffered, or zero if there is no limit.
+    */
+    size_t getBufferCapacity() const
+    {
+        return m_bufferCapacity;
+    }
+
     // slave mode not supported
     // void begin(uint8_t);
     // void begin(int);
@@ -94,6 +144,7 @@ public:
 
         // Empty the current write buffer.
         m_writeBuff.clear();
+        m_transmissionBytes = 0;
     }
 
     /// Complete a series of I2C writes.
@@ -124,23 +175,13 @@ public:
 
         ULONG retVal = SUCCESS;
 
-        // Create a buffer on the write buffer queue for the transfer.
-        m_writeBuffs.push_back(m_writeBuff);
-
-        // Empty the write buffer now that it's contents are queued.
-        m_writeBuff.clear();
+        // Queue a write of any bytes in the write buffer.
+        _queueWriteBuffer();
 
         // If we have data to write, perform the write. If there is no data to write, do nothing.
-        if (m_writeBuffs.back().size() > 0)
+        if (m_transmissionBytes > 0)
         {
-            // Queue a write from the buffer.
-            hr = m_i2cTransaction.queueWrite(m_writeBuffs.back().data(), (ULONG)m_writeBuffs.back().size());
-
-            if (FAILED(hr))
-            {
-                _cleanTransaction();
-                ThrowError(hr, "An error occurred queueing an I2C write of %d bytes.  Error: 0x%08X", m_writeBuffs.back().size(), hr);
-            }
+            m_transmissionBytes = 0;
 
             // Perform all queued transfers if a STOP was specified.
             if (sendStop)
@@ -179,6 +220,41 @@ public:
         return retVal;
     }
 
+    /// Queue a write of an array of bytes directly from the caller's buffer.
+    /**
+    Unlike write(), this method does not copy the data into the TwoWire write buffer.
+    The caller's buffer is transferred to the I2C slave as-is, so it must not be 
+    changed or freed until the transfer has been performed by endTransmission() (or,
+    if endTransmission(FALSE) is used, by the requestFrom() that ends the transaction).
+    Bytes previously written with write() are sent ahead of this buffer.  The bytes
+    are sent without a restart, as if they had all been written with write().
+    \param[in] data Pointer to the first byte to send over the I2C bus.
+    \param[in] cbData The length of the data in bytes.
+    \return The number of bytes queued (the value cbData in this case).  Any error is thrown.
+    */
+    size_t writeBuffer(const uint8_t *data, size_t cbData)
+    {
+        HRESULT hr;
+
+        if (cbData > 0)
+        {
+            // Keep the bytes written so far ahead of the caller's buffer.
+            _queueWriteBuffer();
+
+            hr = m_i2cTransaction.queueWrite(const_cast<PUCHAR>(data), (ULONG)cbData);
+
+            if (FAILED(hr))
+            {
+                _cleanTransaction();
+                ThrowError(hr, "An error occurred queueing an I2C write of %d bytes.  Error: 0x%08X", cbData, hr);
+            }
+
+            m_transmissionBytes += cbData;
+        }
+
+        return cbData;
+    }
+
     /// Method to perform a complete read from an I2C slave.
     /**
     This method queues a read transfer and causes it (and any other transfers
@@ -209,52 +285,63 @@ public:
     */
     ULONG requestFrom(ULONG address, ULONG quantity, BOOL sendStop)
     {
-        HRESULT hr;
-
         if (quantity == 0)
         {
             _cleanTransaction();
             ThrowError(E_INVALIDARG, "Zero byte I2C reads are not allowed.");
         }
 
+        // Limit the read to the buffer capacity, if there is one.
+        if ((m_bufferCapacity > 0) && (quantity > m_bufferCapacity))
+        {
+            quantity = (ULONG)m_bufferCapacity;
+        }
+
         // Set the address of the I2C slave we are working with.
         _setSlaveAddress(address);
 
         // Create a buffer on the read buffer queue for the transfer.
-        buff_t newBuf(quantity, 0);
-        m_readBuffs.push_back(newBuf);
+        m_readBuffs.emplace_back(quantity, 0);
 
-        // Queue a read into the buffer.
-        hr = m_i2cTransaction.queueRead(m_readBuffs.back().data(), quantity);
+        return _queueRead(address, m_readBuffs.back().data(), quantity, sendStop);
+    }
 
-        if (FAILED(hr))
+    /// Method to perform a complete read from an I2C slave into the caller's buffer.
+    /**
+    \param[in] address The address of the I2C slave to read from.
+    \param[out] buffer The buffer to receive the data.
+    \param[in] quantity The number of bytes to read.
+    \return The number of bytes read.  Any error is thrown.
+    */
+    ULONG requestFrom(ULONG address, uint8_t *buffer, ULONG quantity)
+    {
+        return this->requestFrom(address, buffer, quantity, TRUE);
+    }
+
+    /// Method to queue or perform a read from an I2C slave into the caller's buffer.
+    /**
+    The data is read directly into the caller's buffer, without being copied through
+    the TwoWire read buffers, so it is not returned by available() or read().  If 
+    sendStop is FALSE the buffer must remain valid until the transaction has been
+    performed.
+    \param[in] address The address of the I2C slave to read from.
+    \param[out] buffer The buffer to receive the data.
+    \param[in] quantity The number of bytes to read.
+    \param[in] sendStop TRUE - end the tranfer with an I2C stop, FALSE - don't end with STOP.
+    \return The number of bytes read (or queued to be read).  Any error is thrown.
+    */
+    ULONG requestFrom(ULONG address, uint8_t *buffer, ULONG quantity, BOOL sendStop)
+    {
+        if ((buffer == nullptr) || (quantity == 0))
         {
             _cleanTransaction();
-            ThrowError(hr, "An error occurred queueing an I2C read of %d bytes to address: 0x%02X.  Error: 0x%08X", quantity, address, hr);
+            ThrowError(E_INVALIDARG, "A read buffer of at least one byte is required for an I2C read.");
         }
 
-        // Perform all queued transfers if a STOP was specified.
-        if (sendStop)
-        {
-            hr = m_i2cTransaction.execute(g_i2c.getController());
-
-            if (FAILED(hr))
-            {
-                _cleanTransaction();
-                ThrowError(hr, "Error encountered performing queued I2C transfers to address: 0x%02X, Error: 0x%08X", address, hr);
-            }
-
-            // Clear out queued transfers now that we are done with them.
-            m_writeBuffs.clear();
-
-            // Clean out the transaction so it can be used again in the future.
-            m_i2cTransaction.reset();
-
-            // Get the current count of bytes available in the read buffer.
-            _calculateReadBytesInBuffer();
-        }
+        // Set the address of the I2C slave we are working with.
+        _setSlaveAddress(address);
 
-        return quantity;
+        return _queueRead(address, buffer, quantity, sendStop);
     }
 
     /// Set the address of the I2C slave we are talking to.
@@ -294,8 +381,7 @@ public:
     */
     virtual size_t write(const uint8_t data)
     {
-        this->m_writeBuff.push_back(data);
-        return 1;
+        return _appendToWriteBuffer(&data, 1);
     }
 
     void onReceive(void(*)(int))
@@ -312,31 +398,22 @@ public:
     /**
     \param[in] data Pointer to the first byte to send over the I2C bus.
     \param[in] cbData The length of the data in bytes.
-    \return The number of bytes "sent" (the value cbData in this case).
+    \return The number of bytes "sent" (cbData, unless the buffer capacity is reached).
     */
     size_t write(const uint8_t *data, size_t cbData)
     {
-        size_t length = this->m_writeBuff.size();
-        this->m_writeBuff.resize(this->m_writeBuff.size() + cbData);
-        auto it = this->m_writeBuff.begin();
-        advance(it, length);
-        std::copy_n(data, cbData, it);
-        return cbData;
+        return _appendToWriteBuffer(data, cbData);
     }
 
     /// Queue a null terminated string write on the I2C bus.
     /**
     \param[in] string Pointer to the start of the null terminated byte string.
-    \return The number of bytes "sent" (the number of characters in the string).
+    \return The number of bytes "sent" (the number of characters in the string, unless 
+    the buffer capacity is reached).
     */
     size_t write(PCHAR string)
     {
-        size_t length = this->m_writeBuff.size();
-        this->m_writeBuff.resize(this->m_writeBuff.size() + strlen(string));
-        auto it = this->m_writeBuff.begin();
-        advance(it, length);
-        std::copy_n(string, strlen(string), it);
-        return strlen(string);
+        return _appendToWriteBuffer((const uint8_t*)string, strlen(string));
     }
 
     /// Method to return the number of bytes of available to be read from the buffer.
@@ -426,6 +503,113 @@ private:
     /// Count of bytes available to be read.
     ULONG m_readBytesAvailable;
 
+    /// Maximum number of bytes buffered, zero if there is no limit.
+    size_t m_bufferCapacity;
+
+    /// Count of bytes queued to be written since beginTransmission().
+    size_t m_transmissionBytes;
+
+    /// Method to add bytes to the current write buffer.
+    /**
+    \param[in] data Pointer to the first byte to add.
+    \param[in] cbData The number of bytes to add.
+    \return The number of bytes added, which is less than cbData if the buffer
+    capacity has been reached.
+    */
+    size_t _appendToWriteBuffer(const uint8_t *data, size_t cbData)
+    {
+        if (m_bufferCapacity > 0)
+        {
+            size_t room = 0;
+            if (m_writeBuff.size() < m_bufferCapacity)
+            {
+                room = m_bufferCapacity - m_writeBuff.size();
+            }
+            if (cbData > room)
+            {
+                cbData = room;
+            }
+        }
+
+        m_writeBuff.insert(m_writeBuff.end(), data, data + cbData);
+        m_transmissionBytes += cbData;
+        return cbData;
+    }
+
+    /// Method to queue a write transfer of the bytes in the current write buffer.
+    /**
+    The write buffer is moved (not copied) to the write buffer queue, where it stays
+    until the transaction has been performed.  Any error is thrown.
+    */
+    void _queueWriteBuffer()
+    {
+        HRESULT hr;
+
+        if (m_writeBuff.size() > 0)
+        {
+            // Move the buffer to the write buffer queue for the transfer.
+            m_writeBuffs.push_back(std::move(m_writeBuff));
+
+            // Start a new write buffer now that the old one's contents are queued.
+            m_writeBuff.clear();
+            m_writeBuff.reserve(m_bufferCapacity);
+
+            // Queue a write from the buffer.
+            hr = m_i2cTransaction.queueWrite(m_writeBuffs.back().data(), (ULONG)m_writeBuffs.back().size());
+
+            if (FAILED(hr))
+            {
+                _cleanTransaction();
+                ThrowError(hr, "An error occurred queueing an I2C write of %d bytes.  Error: 0x%08X", m_writeBuffs.back().size(), hr);
+            }
+        }
+    }
+
+    /// Method to queue a read, and perform the transaction if requested.
+    /**
+    \param[in] address The address of the I2C slave to read from.
+    \param[out] buffer The buffer to receive the data.
+    \param[in] quantity The number of bytes to read.
+    \param[in] sendStop TRUE - perform all queued transfers, FALSE - just queue the read.
+    \return The number of bytes read (or queued to be read).  Any error is thrown.
+    */
+    ULONG _queueRead(ULONG address, PUCHAR buffer, ULONG quantity, BOOL sendStop)
+    {
+        HRESULT hr;
+
+        // Queue a read into the buffer.
+        hr = m_i2cTransaction.queueRead(buffer, quantity);
+
+        if (FAILED(hr))
+        {
+            _cleanTransaction();
+            ThrowError(hr, "An error occurred queueing an I2C read of %d bytes to address: 0x%02X.  Error: 0x%08X", quantity, address, hr);
+        }
+
+        // Perform all queued transfers if a STOP was specified.
+        if (sendStop)
+        {
+            hr = m_i2cTransaction.execute(g_i2c.getController());
+
+            if (FAILED(hr))
+            {
+                _cleanTransaction();
+                ThrowError(hr, "Error encountered performing queued I2C transfers to address: 0x%02X, Error: 0x%08X", address, hr);
+            }
+
+            // Clear out queued transfers now that we are done with them.
+            m_writeBuffs.clear();
+
+            // Clean out the transaction so it can be used again in the future.
+            m_i2cTransaction.reset();
+
+            // Get the current count of bytes available in the read buffer.
+            _calculateReadBytesInBuffer();
+        }
+
+        return quantity;
+    }
+
     /// Method to count the total number of read bytes in read buffers.
     void _calculateReadBytesInBuffer()
     {
@@ -446,6 +630,7 @@ private:
         m_readBuffIndex = 0;
         m_readByteIndex = 0;
         m_readBytesAvailable = 0;
+        m_transmissionBytes = 0;
     }
 };
 
@@ -4,28 +4,34 @@
 
 #include "pch.h"
 
+#include <string.h>
+
 #include "EEPROM.h"
 #include "wire.h"
 
 // I2C transaction code(s):
 namespace {
     const uint8_t EEPROM_ADDR7 = 0x50;
+
+    // Longest time to poll for the end of a write cycle (datasheet maximum is 5 ms).
+    const ULONGLONG WRITE_CYCLE_TIMEOUT_MS = 20;
+
+    inline bool
+    isCached (
+        const uint8_t * valid,
+        const size_t index
+    ) {
+        return ((valid[index / 8] & (1 << (index % 8))) != 0);
+    }
 }
 
 uint8_t
 EEPROMClass::read (
     const int address
 ) const {
-    // Request data from EEPROM
-    Wire.begin();
-    Wire.beginTransmission(EEPROM_ADDR7);
-    Wire.write(static_cast<uint8_t>(address >> 8));  // high-byte
-    Wire.write(static_cast<uint8_t>(address));  // low-byte
-    if ( TwoWire::ADDR_NACK_RECV == Wire.endTransmission(false) ) { return 0; }
-
-    // Return response
-    Wire.requestFrom(EEPROM_ADDR7, 1);
-    return static_cast<uint8_t>(Wire.read());
+    uint8_t value = 0;
+    readBlock(address, &value, 1);
+    return value;
 }
 
 void
@@ -33,13 +39,131 @@ EEPROMClass::write (
     const int address,
     const uint8_t value
 ) const {
-    // Write data to EEPROM
+    writeBlock(address, &value, 1);
+}
+
+size_t
+EEPROMClass::readBlock (
+    const int address,
+    uint8_t * buffer,
+    const size_t length
+) const {
+    size_t count = length;
+    size_t first = 0;
+    size_t last = 0;
+    uint8_t * dest = buffer;
+
+    if ( (address < 0) || (static_cast<size_t>(address) >= SIZE_BYTES) || (buffer == nullptr) ) { return 0; }
+    if ( count > (SIZE_BYTES - address) ) { count = SIZE_BYTES - address; }
+    if ( count == 0 ) { return 0; }
+
+    // Only read the span of bytes that are not already cached
+    first = address;
+    last = address + count - 1;
+    if ( _cacheEnabled ) {
+        while ( (first <= last) && isCached(_cacheValid, first) ) { ++first; }
+        while ( (last > first) && isCached(_cacheValid, last) ) { --last; }
+        dest = &_cache[first];
+    }
+
+    if ( first <= last ) {
+        // Request data from EEPROM
+        Wire.begin();
+        Wire.beginTransmission(EEPROM_ADDR7);
+        Wire.write(static_cast<uint8_t>(first >> 8));  // high-byte
+        Wire.write(static_cast<uint8_t>(first));  // low-byte
+        if ( TwoWire::ADDR_NACK_RECV == Wire.endTransmission(false) ) { Wire.end(); return 0; }
+
+        // Read the whole span in one sequential read
+        Wire.requestFrom(EEPROM_ADDR7, dest, static_cast<ULONG>(last - first + 1));
+        Wire.end();
+        if ( _cacheEnabled ) { _fillCache(static_cast<int>(first), dest, last - first + 1); }
+    }
+
+    // Return response
+    if ( _cacheEnabled ) { memcpy(buffer, &_cache[address], count); }
+    return count;
+}
+
+size_t
+EEPROMClass::writeBlock (
+    const int address,
+    const uint8_t * buffer,
+    const size_t length
+) const {
+    size_t count = length;
+    size_t written = 0;
+
+    if ( (address < 0) || (static_cast<size_t>(address) >= SIZE_BYTES) || (buffer == nullptr) ) { return 0; }
+    if ( count > (SIZE_BYTES - address) ) { count = SIZE_BYTES - address; }
+
     Wire.begin();
-    Wire.beginTransmission(EEPROM_ADDR7);
-    Wire.write(static_cast<uint8_t>(address >> 8));  // high-byte
-    Wire.write(static_cast<uint8_t>(address));  // low-byte
-    Wire.write(value);
-    Wire.endTransmission(true);
+    while ( written < count ) {
+        // A write must not cross a page boundary, or it wraps to the start of the page
+        const size_t pageAddress = address + written;
+        size_t chunk = PAGE_BYTES - (pageAddress % PAGE_BYTES);
+        if ( chunk > (count - written) ) { chunk = count - written; }
+
+        // Write data to EEPROM
+        Wire.beginTransmission(EEPROM_ADDR7);
+        Wire.write(static_cast<uint8_t>(pageAddress >> 8));  // high-byte
+        Wire.write(static_cast<uint8_t>(pageAddress));  // low-byte
+        Wire.writeBuffer(buffer + written, chunk);
+        if ( TwoWire::SUCCESS != Wire.endTransmission(true) ) { break; }
+        if ( !_waitForWriteCycle(static_cast<int>(pageAddress)) ) { break; }
+
+        if ( _cacheEnabled ) { _fillCache(static_cast<int>(pageAddress), buffer + written, chunk); }
+        written += chunk;
+    }
+    Wire.end();
+
+    return written;
+}
+
+void
+EEPROMClass::enableCache (
+    const bool enable
+) {
+    _cacheEnabled = enable;
+    invalidateCache();
+}
+
+void
+EEPROMClass::invalidateCache (
+    void
+) {
+    memset(_cacheValid, 0, sizeof(_cacheValid));
+}
+
+bool
+EEPROMClass::_waitForWriteCycle (
+    const int address
+) const {
+    const ULONGLONG startTicks = GetTickCount64();
+
+    // The EEPROM does not acknowledge its address until the write cycle is done.
+    // Polling with the address of the page just written leaves the address pointer
+    // where it was, and does not start another write cycle.
+    do {
+        Wire.beginTransmission(EEPROM_ADDR7);
+        Wire.write(static_cast<uint8_t>(address >> 8));  // high-byte
+        Wire.write(static_cast<uint8_t>(address));  // low-byte
+        if ( TwoWire::SUCCESS == Wire.endTransmission(true) ) { return true; }
+    } while ( (GetTickCount64() - startTicks) < WRITE_CYCLE_TIMEOUT_MS );
+
+    return false;
+}
+
+void
+EEPROMClass::_fillCache (
+    const int address,
+    const uint8_t * buffer,
+    const size_t length
+) const {
+    if ( &_cache[address] != buffer ) { memcpy(&_cache[address], buffer, length); }
+    for ( size_t i = address; i < (address + length); ++i ) {
+        _cacheValid[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+    }
 }
 
 EEPROMClass EEPROM;
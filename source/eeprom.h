@@ -6,6 +6,7 @@
 #define EEPROM_H
 
 #include <inttypes.h> 
+#include <stddef.h>
 #include "Lightning.h"
 
 /// \brief A pseudo static class to support EEPROM usage
@@ -37,6 +38,84 @@ class EEPROMClass
         const int address,
         const uint8_t value
     ) const;
+
+    /// \brief Reads a block of bytes from the EEPROM.
+    /// \param [in] address The location to start reading from, starting from 0 (int)
+    /// \param [out] buffer The buffer to receive the bytes read
+    /// \param [in] length The number of bytes to read
+    /// \returns the number of bytes read
+    /// \details The bytes are read sequentially in a single I2C transaction.
+    /// If the read cache is on, bytes already held in it are not read from the
+    /// EEPROM again.
+    LIGHTNING_DLL_API size_t
+    readBlock (
+        const int address,
+        uint8_t * buffer,
+        const size_t length
+    ) const;
+
+    /// \brief Writes a block of bytes to the EEPROM.
+    /// \param [in] address The location to start writing to, starting from 0 (int)
+    /// \param [in] buffer The bytes to write
+    /// \param [in] length The number of bytes to write
+    /// \returns the number of bytes written, which is less than length if the
+    /// EEPROM stopped responding
+    /// \details The block is written one EEPROM page at a time.  After each page
+    /// the EEPROM is polled until it acknowledges its address again, which it does
+    /// as soon as its internal write cycle is complete, so no fixed delay is needed.
+    /// When this method returns the data has been committed to the EEPROM.
+    LIGHTNING_DLL_API size_t
+    writeBlock (
+        const int address,
+        const uint8_t * buffer,
+        const size_t length
+    ) const;
+
+    /// \brief Returns the size of the EEPROM in bytes.
+    size_t
+    length (
+        void
+    ) const {
+        return SIZE_BYTES;
+    }
+
+    /// \brief Turns the read cache on or off.
+    /// \param [in] enable true to cache bytes read from (or written to) the EEPROM
+    /// \note The cache is off by default.  Only turn it on if nothing but this
+    /// class writes the EEPROM, or invalidate it after anything else does.
+    LIGHTNING_DLL_API void
+    enableCache (
+        const bool enable
+    );
+
+    /// \brief Discards the contents of the read cache.
+    LIGHTNING_DLL_API void
+    invalidateCache (
+        void
+    );
+
+    static const size_t SIZE_BYTES = 4096;  ///< Size of the EEPROM (24xx32)
+    static const size_t PAGE_BYTES = 32;    ///< Size of an EEPROM write page
+
+  private:
+    /// \brief Waits for the EEPROM to finish an internal write cycle.
+    /// \returns true if the EEPROM acknowledged its address before the timeout
+    bool
+    _waitForWriteCycle (
+        const int address
+    ) const;
+
+    /// \brief Copies bytes into the read cache and marks them valid.
+    void
+    _fillCache (
+        const int address,
+        const uint8_t * buffer,
+        const size_t length
+    ) const;
+
+    bool _cacheEnabled = false;                         ///< true if the read cache is in use
+    mutable uint8_t _cache[SIZE_BYTES];                 ///< Bytes read from the EEPROM
+    mutable uint8_t _cacheValid[SIZE_BYTES / 8] = {};   ///< Bit set for each valid byte in _cache
 };
 
 LIGHTNING_DLL_API  extern EEPROMClass EEPROM;  ///< This variable will provide global access to
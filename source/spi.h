@@ -6,6 +6,7 @@
 #define _SPI_H_
 
 #include <Windows.h>
+#include <memory>
 
 #include "ArduinoCommon.h"
 #include "ArduinoError.h"
@@ -44,6 +45,7 @@ public:
     SPIClass()
     {
         m_controller = nullptr;
+        m_ownsController = TRUE;
         m_bitOrder = MSBFIRST;             // Default bit order is MSB First
         m_clockKHz = 4000;                 // Default clock rate is 4 MHz
         m_mode = SPI_MODE0;                // Default to Mode 0
@@ -163,7 +165,7 @@ public:
     {
         HRESULT hr;
 
-        if (m_controller != nullptr)
+        if ((m_controller != nullptr) && m_ownsController)
         {
             // Set all SPI pins as digital I/O.
             hr = m_controller->revertPinsToGpio();
@@ -176,7 +178,35 @@ public:
             // Get rid of the underlying SPI Controller object.  This closes the handle
             // we have open to the SPI controller.
             delete m_controller;
-            m_controller = nullptr;
+        }
+        m_controller = nullptr;
+        m_ownsController = TRUE;
+    }
+
+    /// Run this SPI bus on a controller object supplied by the caller.
+    /**
+    The caller keeps ownership of the controller, and must have initialized it with its
+    own begin() method.  This lets a sketch run against a software register model.
+    \param[in] controller The controller to use, or nullptr to have begin() create one.
+    \return None.
+    */
+    void useController(SpiControllerClass* controller)
+    {
+        end();
+
+        m_controller = controller;
+        m_ownsController = (controller == nullptr);
+
+        if (m_controller != nullptr)
+        {
+            if (m_bitOrder == MSBFIRST)
+            {
+                m_controller->setMsbFirstBitOrder();
+            }
+            else
+            {
+                m_controller->setLsbFirstBitOrder();
+            }
         }
     }
 
@@ -389,11 +419,132 @@ public:
         return dataReturn;
     }
 
+    /// Transfer a buffer of bytes in each direction on the SPI bus, in place.
+    /**
+    \param[in,out] buf The bytes to send, replaced by the bytes received.
+    \param[in] count The number of bytes to transfer.
+    \return None.
+    */
+    inline void transfer(void* buf, size_t count)
+    {
+        _transferBuffer((PBYTE)buf, (PBYTE)buf, count);
+    }
+
+    /// Transfer a buffer of bytes in each direction on the SPI bus.
+    /**
+    \param[in] txBuf The bytes to send, or nullptr to send zeros.
+    \param[out] rxBuf Buffer for the bytes received, or nullptr to ignore them.
+    \param[in] count The number of bytes to transfer.
+    \return None.
+    */
+    inline void transfer(const void* txBuf, void* rxBuf, size_t count)
+    {
+        _transferBuffer((PBYTE)txBuf, (PBYTE)rxBuf, count);
+    }
+
+    /// Transfer an array of 16-bit words in each direction on the SPI bus, in place.
+    /**
+    Each word is sent the same way as by transfer16(ULONG), in one buffer transfer.
+    \param[in,out] buf The words to send, replaced by the words received.
+    \param[in] count The number of words to transfer.
+    \return None.
+    */
+    inline void transfer16(uint16_t* buf, size_t count)
+    {
+        // The words are sent MS byte first, the opposite of their order in memory.
+        // (LSB first sends the whole word reversed, so the memory order is right.)
+        if (m_bitOrder == MSBFIRST)
+        {
+            _swapWordBytes(buf, buf, count);
+        }
+
+        _transferBuffer((PBYTE)buf, (PBYTE)buf, count * sizeof(uint16_t));
+
+        if (m_bitOrder == MSBFIRST)
+        {
+            _swapWordBytes(buf, buf, count);
+        }
+    }
+
+    /// Transfer an array of 16-bit words in each direction on the SPI bus.
+    /**
+    \param[in] txBuf The words to send, or nullptr to send zeros.
+    \param[out] rxBuf Buffer for the words received, or nullptr to ignore them.
+    \param[in] count The number of words to transfer.
+    \return None.
+    */
+    inline void transfer16(const uint16_t* txBuf, uint16_t* rxBuf, size_t count)
+    {
+        std::unique_ptr<uint16_t[]> scratch;
+        uint16_t* words = rxBuf;
+
+        // Build the outgoing data in the receive buffer, so no copy is needed unless
+        // the received data is not wanted.
+        if (words == nullptr)
+        {
+            scratch.reset(new uint16_t[count]);
+            words = scratch.get();
+        }
+
+        if (txBuf == nullptr)
+        {
+            memset(words, 0, count * sizeof(uint16_t));
+        }
+        else if (m_bitOrder == MSBFIRST)
+        {
+            _swapWordBytes(words, txBuf, count);
+        }
+        else if (words != txBuf)
+        {
+            memcpy(words, txBuf, count * sizeof(uint16_t));
+        }
+
+        _transferBuffer((PBYTE)words, (PBYTE)words, count * sizeof(uint16_t));
+
+        if (m_bitOrder == MSBFIRST)
+        {
+            _swapWordBytes(words, words, count);
+        }
+    }
+
+    /// Turn the performance counters of the SPI controller on or off.
+    /**
+    The counters are kept until end() is called.
+    \param[in] enable TRUE to start counting transfers, FALSE to stop.
+    \param[in] dumpIntervalMs If not 0, the counters are written to the debugger output
+    this often (in milliseconds) while transfers are being made.
+    \return None.
+    */
+    void enableCounters(BOOL enable, ULONG dumpIntervalMs = 0)
+    {
+        _getCounters()->setDumpInterval(enable ? dumpIntervalMs : 0);
+        _getCounters()->enable(enable);
+    }
+
+    /// Get the performance counters of the SPI controller.
+    /**
+    \param[out] counters The counters.
+    \return None.
+    */
+    void getCounters(SPI_BUS_COUNTERS & counters)
+    {
+        _getCounters()->getCounters(counters);
+    }
+
+    /// Zero the performance counters of the SPI controller.
+    void resetCounters()
+    {
+        _getCounters()->reset();
+    }
+
 private:
 
     /// Underlying SPI Controller object that really does the work.
     SpiControllerClass *m_controller;
 
+    /// TRUE if m_controller was created by begin() and is deleted by end().
+    BOOL m_ownsController;
+
     /// Bit order (LSBFIRST or MSBFIRST)
     ULONG m_bitOrder;
 
@@ -405,6 +556,44 @@ private:
 
     /// SPI mode to use.
     ULONG m_mode;
+
+    /// Transfer a buffer on the SPI bus, throwing an exception on failure.
+    inline void _transferBuffer(PBYTE dataOut, PBYTE dataIn, size_t bufferBytes)
+    {
+        HRESULT hr;
+
+        if (m_controller == nullptr)
+        {
+            ThrowError(HRESULT_FROM_WIN32(ERROR_INVALID_STATE), "Can't transfer on SPI bus until an SPI.begin() has been done.");
+        }
+
+        hr = m_controller->transferBuffer(dataOut, dataIn, bufferBytes);
+
+        if (FAILED(hr))
+        {
+            ThrowError(hr, "An error occurred atempting to transfer SPI data: %d", hr);
+        }
+    }
+
+    /// Get the performance counters of the SPI controller, throwing an exception if there is none.
+    inline SpiCountersClass* _getCounters()
+    {
+        if (m_controller == nullptr)
+        {
+            ThrowError(HRESULT_FROM_WIN32(ERROR_INVALID_STATE), "Can't use SPI counters until an SPI.begin() has been done.");
+        }
+
+        return m_controller->getCounters();
+    }
+
+    /// Copy 16-bit words, swapping the order of the two bytes in each.
+    static inline void _swapWordBytes(uint16_t* to, const uint16_t* from, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            to[i] = (uint16_t)((from[i] >> 8) | (from[i] << 8));
+        }
+    }
 };
 
 /// The global SPI bus object.